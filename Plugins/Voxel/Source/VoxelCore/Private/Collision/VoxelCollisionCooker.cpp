@@ -4,6 +4,7 @@
 #include "Collision/VoxelTriangleMeshCollider.h"
 #include "Chaos/CollisionConvexMesh.h"
 #include "VoxelAABBTree.h"
+#include "VoxelBenchmarkStats.h"
 
 VOXEL_CONSOLE_VARIABLE(
 	VOXELCORE_API, bool, GVoxelCollisionFastCooking, true,
@@ -171,6 +172,7 @@ TSharedPtr<FVoxelTriangleMeshCollider> FVoxelCollisionCooker::CookTriangleMesh(
 	const TConstVoxelArrayView<uint16> FaceMaterials)
 {
 	VOXEL_FUNCTION_COUNTER();
+	VOXEL_BENCHMARK_SCOPE("CollisionCooking");
 
 	if (Indices.Num() == 0 ||
 		!ensure(Indices.Num() % 3 == 0))
@@ -203,5 +205,13 @@ TSharedPtr<FVoxelTriangleMeshCollider> FVoxelCollisionCooker::CookTriangleMesh(
 		Collider->LocalBounds = FVoxelBox::FromPositions(Vertices);
 	}
 
+	{
+		VOXEL_SCOPE_COUNTER("Compute hash");
+		Collider->GeometryHash = FVoxelUtilities::MurmurHashMulti(
+			FVoxelUtilities::MurmurHashBytes(MakeByteVoxelArrayView(Indices)),
+			FVoxelUtilities::MurmurHashBytes(MakeByteVoxelArrayView(Vertices)),
+			FVoxelUtilities::MurmurHashBytes(MakeByteVoxelArrayView(FaceMaterials)));
+	}
+
 	return Collider;
 }
\ No newline at end of file
@@ -58,6 +58,21 @@ int64 FVoxelTriangleMeshCollider::GetAllocatedSize() const
 	return AllocatedSize;
 }
 
+uint64 FVoxelTriangleMeshCollider::GetContentHash() const
+{
+	if (GeometryHash == 0)
+	{
+		return 0;
+	}
+
+	uint64 Hash = FVoxelUtilities::MurmurHashMulti(GeometryHash, Offset);
+	for (const TWeakObjectPtr<UPhysicalMaterial>& PhysicalMaterial : PhysicalMaterials)
+	{
+		Hash = FVoxelUtilities::MurmurHash64(Hash ^ GetTypeHash(PhysicalMaterial));
+	}
+	return Hash;
+}
+
 void FVoxelTriangleMeshCollider::AddToBodySetup(UBodySetup& BodySetup) const
 {
 	VOXEL_FUNCTION_COUNTER();
@@ -29,13 +29,15 @@ FVoxelMeshSceneProxy::FVoxelMeshSceneProxy(const UVoxelMeshComponent& Component)
 	: FPrimitiveSceneProxy(&Component)
 	, MaterialRelevance(Component.GetMaterialRelevance(GetScene().GetFeatureLevel()))
 	, Mesh(Component.Mesh.Get().ToSharedRef())
+	, CardRepresentationData(Mesh->GetCardRepresentationData())
+	, DistanceFieldVolumeData(Mesh->GetDistanceFieldVolumeData())
 	, bShouldDrawVelocity(Mesh->ShouldDrawVelocity())
 	, bOnlyDrawIfSelected(Component.bOnlyDrawIfSelected)
 	, OwnerForSelectionCheck(Component.GetOwner())
 {
 	// Mesh can't be deformed, required for VSM caching
 	bHasDeformableMesh = false;
-	bVisibleInLumenScene = Mesh->GetCardRepresentationData() != nullptr;
+	bVisibleInLumenScene = CardRepresentationData.IsValid();
 	bSupportsDistanceFieldRepresentation = MaterialRelevance.bOpaque && !MaterialRelevance.bUsesSingleLayerWaterMaterial;
 
 	EnableGPUSceneSupportFlags();
@@ -294,7 +296,7 @@ SIZE_T FVoxelMeshSceneProxy::GetTypeHash() const
 
 void FVoxelMeshSceneProxy::GetDistanceFieldAtlasData(const FDistanceFieldVolumeData*& OutDistanceFieldData, float& SelfShadowBias) const
 {
-	OutDistanceFieldData = Mesh->GetDistanceFieldVolumeData();
+	OutDistanceFieldData = DistanceFieldVolumeData.Get();
 }
 
 void FVoxelMeshSceneProxy::GetDistanceFieldInstanceData(TArray<FRenderTransform>& ObjectLocalToWorldTransforms) const
@@ -307,7 +309,7 @@ void FVoxelMeshSceneProxy::GetDistanceFieldInstanceData(TArray<FRenderTransform>
 
 const FCardRepresentationData* FVoxelMeshSceneProxy::GetMeshCardRepresentation() const
 {
-	return Mesh->GetCardRepresentationData();
+	return CardRepresentationData.Get();
 }
 
 bool FVoxelMeshSceneProxy::HasDistanceFieldRepresentation() const
@@ -318,7 +320,7 @@ bool FVoxelMeshSceneProxy::HasDistanceFieldRepresentation() const
 		return false;
 	}
 
-	return Mesh->GetDistanceFieldVolumeData() != nullptr;
+	return DistanceFieldVolumeData.IsValid();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -41,6 +41,10 @@ public:
 private:
 	const FMaterialRelevance MaterialRelevance;
 	const TSharedRef<const FVoxelMesh> Mesh;
+	// The mesh might get a new distance field while this proxy is alive
+	// Keep our own refs so that the scene never sees them change or get freed
+	const TSharedPtr<const FCardRepresentationData> CardRepresentationData;
+	const TSharedPtr<const FDistanceFieldVolumeData> DistanceFieldVolumeData;
 	const bool bShouldDrawVelocity;
 	const bool bOnlyDrawIfSelected;
 	const FObjectKey OwnerForSelectionCheck;
@@ -0,0 +1,30 @@
+// Copyright Voxel Plugin, Inc. All Rights Reserved.
+
+#include "VoxelBenchmarkStats.h"
+
+bool GVoxelBenchmarkStatsEnabled = false;
+
+static FVoxelFastCriticalSection GVoxelBenchmarkStatsCriticalSection;
+static TVoxelMap<FName, TVoxelArray<double>> GVoxelBenchmarkStatsSamples;
+
+void FVoxelBenchmarkStats::SetEnabled(const bool bEnabled)
+{
+	check(IsInGameThread());
+	GVoxelBenchmarkStatsEnabled = bEnabled;
+}
+
+void FVoxelBenchmarkStats::AddSample(const FName Stage, const double Seconds)
+{
+	VOXEL_ALLOW_MALLOC_SCOPE();
+	VOXEL_SCOPE_LOCK(GVoxelBenchmarkStatsCriticalSection);
+
+	GVoxelBenchmarkStatsSamples.FindOrAdd(Stage).Add(Seconds);
+}
+
+TVoxelMap<FName, TVoxelArray<double>> FVoxelBenchmarkStats::FlushSamples()
+{
+	VOXEL_FUNCTION_COUNTER();
+	VOXEL_SCOPE_LOCK(GVoxelBenchmarkStatsCriticalSection);
+
+	return MoveTemp(GVoxelBenchmarkStatsSamples);
+}
\ No newline at end of file
@@ -35,6 +35,11 @@ FVoxelDistanceFieldWrapper::FBrick& FVoxelDistanceFieldWrapper::FMip::FindOrAddB
 	return *Ptr;
 }
 
+void FVoxelDistanceFieldWrapper::FMip::SetBrick(const FIntVector& Position, const TSharedPtr<FBrick>& Brick)
+{
+	Bricks[FVoxelUtilities::Get3DIndex<int32>(IndirectionSize, Position)] = Brick;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -61,112 +66,95 @@ TSharedRef<FDistanceFieldVolumeData> FVoxelDistanceFieldWrapper::Build() const
 
 	const TSharedRef<FDistanceFieldVolumeData> OutData = MakeVoxelShared<FDistanceFieldVolumeData>();
 
-	TArray<uint8> StreamableMipData;
+	const uint32 BrickSizeBytes = DistanceField::BrickSize * DistanceField::BrickSize * DistanceField::BrickSize * GPixelFormats[DistanceField::DistanceFieldFormat].BlockBytes;
 
-	for (int32 MipIndex = 0; MipIndex < DistanceField::NumMips; MipIndex++)
+	// Mips are independent: build their indirection table & brick data in parallel, then concatenate the streamable ones
+	TVoxelStaticArray<TVoxelArray<uint8>, DistanceField::NumMips> MipsData;
+
+	ParallelFor(DistanceField::NumMips, [&](const int32 MipIndex)
 	{
 		VOXEL_SCOPE_COUNTER("Mip");
 
 		const FMip& Mip = Mips[MipIndex];
+		const int32 NumIndirections = Mip.IndirectionSize.X * Mip.IndirectionSize.Y * Mip.IndirectionSize.Z;
+		check(Mip.Bricks.Num() == NumIndirections);
 
-		FSparseDistanceFieldMip& OutMip = OutData->Mips[MipIndex];
-		TVoxelArray<uint32> IndirectionTable;
-		IndirectionTable.Empty(Mip.IndirectionSize.X * Mip.IndirectionSize.Y * Mip.IndirectionSize.Z);
-		IndirectionTable.AddUninitialized(Mip.IndirectionSize.X * Mip.IndirectionSize.Y * Mip.IndirectionSize.Z);
+		// Bricks are stored in indirection order
+		TVoxelArray<int32> BrickIndices;
+		FVoxelUtilities::SetNumFast(BrickIndices, NumIndirections);
 
-		for (int32 i = 0; i < IndirectionTable.Num(); i++)
+		int32 NumBricks = 0;
+		for (int32 IndirectionIndex = 0; IndirectionIndex < NumIndirections; IndirectionIndex++)
 		{
-			IndirectionTable[i] = DistanceField::InvalidBrickIndex;
+			BrickIndices[IndirectionIndex] = Mip.Bricks[IndirectionIndex] ? NumBricks++ : -1;
 		}
 
-		uint32 NumBricks = 0;
-		for (const TSharedPtr<FBrick>& Brick : Mip.Bricks)
-		{
-			if (Brick)
-			{
-				NumBricks++;
-			}
-		}
+		const int32 IndirectionTableBytes = NumIndirections * sizeof(uint32);
+		const int32 MipDataBytes = IndirectionTableBytes + NumBricks * BrickSizeBytes;
 
-		const uint32 BrickSizeBytes = DistanceField::BrickSize * DistanceField::BrickSize * DistanceField::BrickSize * GPixelFormats[DistanceField::DistanceFieldFormat].BlockBytes;
+		TVoxelArray<uint8>& MipData = MipsData[MipIndex];
+		FVoxelUtilities::SetNumFast(MipData, MipDataBytes);
 
-		TVoxelArray<uint8> DistanceFieldBrickData;
-		DistanceFieldBrickData.Empty(BrickSizeBytes * NumBricks);
-		DistanceFieldBrickData.AddUninitialized(BrickSizeBytes * NumBricks);
+		uint32* IndirectionTable = reinterpret_cast<uint32*>(MipData.GetData());
+		uint8* DistanceFieldBrickData = MipData.GetData() + IndirectionTableBytes;
 
-		int32 BrickIndex = 0;
-		for (int32 X = 0; X < Mip.IndirectionSize.X; X++)
+		ParallelFor(NumIndirections, [&](const int32 IndirectionIndex)
 		{
-			for (int32 Y = 0; Y < Mip.IndirectionSize.X; Y++)
+			const int32 BrickIndex = BrickIndices[IndirectionIndex];
+			if (BrickIndex == -1)
 			{
-				for (int32 Z = 0; Z < Mip.IndirectionSize.X; Z++)
-				{
-					const int32 IndirectionIndex = FVoxelUtilities::Get3DIndex<int32>(Mip.IndirectionSize, X, Y, Z);
-					const TSharedPtr<FBrick>& Brick = Mip.Bricks[IndirectionIndex];
-
-					if (!Brick)
-					{
-						IndirectionTable[IndirectionIndex] = DistanceField::InvalidBrickIndex;
-						continue;
-					}
-
-					IndirectionTable[IndirectionIndex] = BrickIndex;
-					FMemory::Memcpy(&DistanceFieldBrickData[BrickIndex * BrickSizeBytes], Brick->GetData(), Brick->Num() * Brick->GetTypeSize());
-
-					BrickIndex++;
-				}
+				IndirectionTable[IndirectionIndex] = DistanceField::InvalidBrickIndex;
+				return;
 			}
-		}
-		check(BrickIndex == NumBricks);
 
-		const int32 IndirectionTableBytes = IndirectionTable.Num() * IndirectionTable.GetTypeSize();
-		const int32 MipDataBytes = IndirectionTableBytes + DistanceFieldBrickData.Num();
+			const FBrick& Brick = *Mip.Bricks[IndirectionIndex];
+			checkVoxelSlow(Brick.Num() * Brick.GetTypeSize() == BrickSizeBytes);
 
-		if (MipIndex == DistanceField::NumMips - 1)
-		{
-			VOXEL_SCOPE_COUNTER("Copy");
+			IndirectionTable[IndirectionIndex] = BrickIndex;
+			FMemory::Memcpy(DistanceFieldBrickData + BrickIndex * BrickSizeBytes, Brick.GetData(), BrickSizeBytes);
+		}, NumIndirections < 64 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
 
-			OutData->AlwaysLoadedMip.Empty(MipDataBytes);
-			OutData->AlwaysLoadedMip.AddUninitialized(MipDataBytes);
+		FSparseDistanceFieldMip& OutMip = OutData->Mips[MipIndex];
+		OutMip.IndirectionDimensions = Mip.IndirectionSize;
+		OutMip.DistanceFieldToVolumeScaleBias = Mip.DistanceFieldToVolumeScaleBias;
+		OutMip.NumDistanceFieldBricks = NumBricks;
 
-			FPlatformMemory::Memcpy(&OutData->AlwaysLoadedMip[0], IndirectionTable.GetData(), IndirectionTableBytes);
+		// Account for the border voxels we added
+		const FVector VirtualUVMin = FVector(DistanceField::MeshDistanceFieldObjectBorder) / FVector(Mip.IndirectionSize * DistanceField::UniqueDataBrickSize);
+		const FVector VirtualUVSize = FVector(Mip.IndirectionSize * DistanceField::UniqueDataBrickSize - FIntVector(2 * DistanceField::MeshDistanceFieldObjectBorder)) / FVector(Mip.IndirectionSize * DistanceField::UniqueDataBrickSize);
 
-			if (DistanceFieldBrickData.Num() > 0)
-			{
-				FPlatformMemory::Memcpy(&OutData->AlwaysLoadedMip[IndirectionTableBytes], DistanceFieldBrickData.GetData(), DistanceFieldBrickData.Num());
-			}
+		// [-1, 1] -> [VirtualUVMin, VirtualUVMin + VirtualUVSize]
+		OutMip.VolumeToVirtualUVScale = VirtualUVSize / 2.f;
+		OutMip.VolumeToVirtualUVAdd = VirtualUVSize / 2.f + VirtualUVMin;
+	});
+
+	TArray<uint8> StreamableMipData;
+	{
+		VOXEL_SCOPE_COUNTER("Copy");
+
+		int64 NumStreamableBytes = 0;
+		for (int32 MipIndex = 0; MipIndex < DistanceField::NumMips - 1; MipIndex++)
+		{
+			NumStreamableBytes += MipsData[MipIndex].Num();
 		}
-		else
+		StreamableMipData.Reserve(NumStreamableBytes);
+
+		for (int32 MipIndex = 0; MipIndex < DistanceField::NumMips - 1; MipIndex++)
 		{
-			VOXEL_SCOPE_COUNTER("Copy");
+			FSparseDistanceFieldMip& OutMip = OutData->Mips[MipIndex];
 
 			OutMip.BulkOffset = StreamableMipData.Num();
-			StreamableMipData.AddUninitialized(MipDataBytes);
+			StreamableMipData.Append(MipsData[MipIndex].GetData(), MipsData[MipIndex].Num());
 			OutMip.BulkSize = StreamableMipData.Num() - OutMip.BulkOffset;
 			check(OutMip.BulkSize > 0);
 
-			FPlatformMemory::Memcpy(&StreamableMipData[OutMip.BulkOffset], IndirectionTable.GetData(), IndirectionTableBytes);
-
-			if (DistanceFieldBrickData.Num() > 0)
-			{
-				FPlatformMemory::Memcpy(&StreamableMipData[OutMip.BulkOffset + IndirectionTableBytes], DistanceFieldBrickData.GetData(), DistanceFieldBrickData.Num());
-			}
-
 			// HACK: set BulkSize to 0 so no read request is ever emitted as they crash in packaged
 			OutMip.BulkSize = 0;
 		}
 
-		OutMip.IndirectionDimensions = Mip.IndirectionSize;
-		OutMip.DistanceFieldToVolumeScaleBias = Mip.DistanceFieldToVolumeScaleBias;
-		OutMip.NumDistanceFieldBricks = NumBricks;
-
-		// Account for the border voxels we added
-		const FVector VirtualUVMin = FVector(DistanceField::MeshDistanceFieldObjectBorder) / FVector(Mip.IndirectionSize * DistanceField::UniqueDataBrickSize);
-		const FVector VirtualUVSize = FVector(Mip.IndirectionSize * DistanceField::UniqueDataBrickSize - FIntVector(2 * DistanceField::MeshDistanceFieldObjectBorder)) / FVector(Mip.IndirectionSize * DistanceField::UniqueDataBrickSize);
-
-		// [-1, 1] -> [VirtualUVMin, VirtualUVMin + VirtualUVSize]
-		OutMip.VolumeToVirtualUVScale = VirtualUVSize / 2.f;
-		OutMip.VolumeToVirtualUVAdd = VirtualUVSize / 2.f + VirtualUVMin;
+		const TVoxelArray<uint8>& AlwaysLoadedMipData = MipsData[DistanceField::NumMips - 1];
+		OutData->AlwaysLoadedMip.Empty(AlwaysLoadedMipData.Num());
+		OutData->AlwaysLoadedMip.Append(AlwaysLoadedMipData.GetData(), AlwaysLoadedMipData.Num());
 	}
 
 	OutData->LocalSpaceMeshBounds = LocalSpaceMeshBounds;
@@ -14,6 +14,14 @@ VOXEL_CONSOLE_VARIABLE(
 	"voxel.FreezeCamera",
 	"");
 
+struct FVoxelCameraViewOverride
+{
+	FVector Position;
+	FRotator Rotation;
+	float FOV = 0.f;
+};
+static TMap<FObjectKey, FVoxelCameraViewOverride> GVoxelCameraViewOverrides;
+
 FViewport* FVoxelGameUtilities::GetViewport(const UWorld* World)
 {
 	VOXEL_FUNCTION_COUNTER();
@@ -74,6 +82,14 @@ bool FVoxelGameUtilities::GetCameraView(const UWorld* World, FVector& OutPositio
 		return false;
 	}
 
+	if (const FVoxelCameraViewOverride* Override = GVoxelCameraViewOverrides.Find(World))
+	{
+		OutPosition = Override->Position;
+		OutRotation = Override->Rotation;
+		OutFOV = Override->FOV;
+		return true;
+	}
+
 	if (World->GetNetMode() == NM_DedicatedServer)
 	{
 		// Never allow accessing the camera position on servers
@@ -190,6 +206,19 @@ bool FVoxelGameUtilities::GetCameraView(const UWorld* World, FVector& OutPositio
 	return true;
 }
 
+void FVoxelGameUtilities::SetCameraViewOverride(const UWorld* World, const TOptional<FTransform>& Transform, const float FOV)
+{
+	ensure(IsInGameThread());
+
+	if (!Transform)
+	{
+		GVoxelCameraViewOverrides.Remove(World);
+		return;
+	}
+
+	GVoxelCameraViewOverrides.Add(World, { Transform->GetLocation(), Transform->Rotator(), FOV });
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
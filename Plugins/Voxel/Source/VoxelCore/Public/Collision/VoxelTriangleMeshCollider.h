@@ -21,7 +21,10 @@ struct VOXELCORE_API FVoxelTriangleMeshCollider : public FVoxelCollider
 	FVoxelBox LocalBounds;
 	TSharedPtr<Chaos::FTriangleMeshImplicitObject> TriangleMesh;
 	TArray<TWeakObjectPtr<UPhysicalMaterial>> PhysicalMaterials;
+	// Hash of the cooked geometry, 0 if unknown
+	uint64 GeometryHash = 0;
 
+	virtual uint64 GetContentHash() const override;
 	virtual FVector GetOffset() const override { return Offset; }
 	virtual FVoxelBox GetLocalBounds() const override { return LocalBounds.Extend(0.0001); }
 	virtual int64 GetAllocatedSize() const override;
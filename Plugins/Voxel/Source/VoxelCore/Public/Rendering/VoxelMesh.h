@@ -44,8 +44,9 @@ public:
 	virtual bool Draw_RenderThread(const FPrimitiveSceneProxy& Proxy, FMeshBatch& MeshBatch) const { return false; }
 	virtual const FRayTracingGeometry* DrawRaytracing_RenderThread(const FPrimitiveSceneProxy& Proxy, FMeshBatch& MeshBatch) const { return nullptr; }
 
-	virtual const FCardRepresentationData* GetCardRepresentationData() const { return nullptr; }
-	virtual const FDistanceFieldVolumeData* GetDistanceFieldVolumeData() const { return nullptr; }
+	// Game thread only, scene proxies keep a ref to the data they were created with
+	virtual TSharedPtr<const FCardRepresentationData> GetCardRepresentationData() const { return nullptr; }
+	virtual TSharedPtr<const FDistanceFieldVolumeData> GetDistanceFieldVolumeData() const { return nullptr; }
 
 	virtual bool ShouldDrawVelocity() const { return true; }
 
@@ -0,0 +1,54 @@
+// Copyright Voxel Plugin, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "VoxelMinimal.h"
+
+extern VOXELCORE_API bool GVoxelBenchmarkStatsEnabled;
+
+// Wall time samples of the main pipeline stages (graph, marching cubes, collision cooking, point scatter)
+// Unlike stats & traces, these are recorded in every build configuration, so that headless benchmarks can report them
+// Disabled by default: when disabled a scope costs a single branch
+class VOXELCORE_API FVoxelBenchmarkStats
+{
+public:
+	FORCEINLINE static bool IsEnabled()
+	{
+		return GVoxelBenchmarkStatsEnabled;
+	}
+
+	static void SetEnabled(bool bEnabled);
+
+	// Thread safe
+	static void AddSample(FName Stage, double Seconds);
+
+	// Returns all the samples recorded since the last call, in seconds
+	static TVoxelMap<FName, TVoxelArray<double>> FlushSamples();
+};
+
+class FVoxelBenchmarkScope
+{
+public:
+	FORCEINLINE explicit FVoxelBenchmarkScope(const FName Stage)
+	{
+		if (FVoxelBenchmarkStats::IsEnabled())
+		{
+			StageName = Stage;
+			StartTime = FPlatformTime::Seconds();
+		}
+	}
+	FORCEINLINE ~FVoxelBenchmarkScope()
+	{
+		if (StartTime != 0.)
+		{
+			FVoxelBenchmarkStats::AddSample(StageName, FPlatformTime::Seconds() - StartTime);
+		}
+	}
+	UE_NONCOPYABLE(FVoxelBenchmarkScope);
+
+private:
+	FName StageName;
+	double StartTime = 0.;
+};
+
+#define VOXEL_BENCHMARK_SCOPE(Stage) FVoxelBenchmarkScope VOXEL_APPEND_LINE(__VoxelBenchmarkScope)(STATIC_FNAME(Stage));
\ No newline at end of file
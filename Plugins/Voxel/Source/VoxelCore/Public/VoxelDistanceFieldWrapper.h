@@ -17,6 +17,8 @@ public:
 
 		FBrick* FindBrick(const FIntVector& Position);
 		FBrick& FindOrAddBrick(const FIntVector& Position);
+		// Bricks are immutable once set and can be shared between wrappers
+		void SetBrick(const FIntVector& Position, const TSharedPtr<FBrick>& Brick);
 
 		FORCEINLINE uint8 QuantizeDistance(const float Distance) const
 		{
@@ -19,6 +19,10 @@ public:
 		return GetCameraView(World, OutPosition, Rotation, FOV);
 	}
 
+	// Force the camera view of World, eg for headless worlds that have no player nor viewport
+	// Pass an unset optional to remove the override
+	static void SetCameraViewOverride(const UWorld* World, const TOptional<FTransform>& Transform, float FOV = 90.f);
+
 public:
 #if WITH_EDITOR
 	static bool IsActorSelected_AnyThread(FObjectKey Actor);
@@ -19,6 +19,8 @@ struct VOXELCORE_API FVoxelDynamicMaterialParameter : public FVoxelVirtualStruct
 
 	virtual void Apply(FName Name, UMaterialInstanceDynamic& Instance) const VOXEL_PURE_VIRTUAL()
 	virtual void AddOnChanged(const FSimpleDelegate& OnChanged) {}
+	// Hash of the value this parameter applies, 0 if unknown
+	virtual uint64 GetContentHash() const { return 0; }
 };
 
 class VOXELCORE_API FVoxelMaterialRef
@@ -31,6 +31,10 @@ public:
 	virtual void PreSerialize() {}
 	virtual void PostSerialize() {}
 
+	// Cheap hash of the struct content, used to skip no-op updates of dynamic values
+	// 0 means unknown: two structs with a 0 hash are always considered different
+	virtual uint64 GetContentHash() const { return 0; }
+
 #if WITH_EDITOR
 	// When editing an instanced struct, a copy of the struct is used and is then copied over to the original source
 	// This needs to be customized when the struct stores delegates
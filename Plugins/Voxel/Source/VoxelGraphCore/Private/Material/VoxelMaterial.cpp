@@ -11,6 +11,76 @@ void FVoxelComputedMaterialParameter::Append(const FVoxelComputedMaterialParamet
 	TextureParameters.Append(Other.TextureParameters);
 	DynamicParameters.Append(Other.DynamicParameters);
 	Resources.Append(Other.Resources);
+	ResourceHashes.Append(Other.ResourceHashes);
+	AllocationParameters.Append(Other.AllocationParameters);
+}
+
+uint64 FVoxelComputedMaterialParameter::GetContentHash() const
+{
+	if (ResourceHashes.Num() != Resources.Num())
+	{
+		return 0;
+	}
+
+	// Parameters are appended in the order they completed in, combine them with a xor
+	uint64 ParametersHash = 0;
+	for (const auto& It : ScalarParameters)
+	{
+		if (AllocationParameters.Contains(It.Key))
+		{
+			continue;
+		}
+
+		ParametersHash ^= FVoxelUtilities::MurmurHashMulti(It.Key, It.Value);
+	}
+	for (const auto& It : VectorParameters)
+	{
+		ParametersHash ^= FVoxelUtilities::MurmurHashMulti(It.Key, It.Value);
+	}
+	for (const auto& It : TextureParameters)
+	{
+		ParametersHash ^= FVoxelUtilities::MurmurHashMulti(It.Key, It.Value);
+	}
+	for (const auto& It : DynamicParameters)
+	{
+		const uint64 DynamicParameterHash = It.Value ? It.Value->GetContentHash() : 0;
+		if (DynamicParameterHash == 0)
+		{
+			return 0;
+		}
+
+		ParametersHash ^= FVoxelUtilities::MurmurHashMulti(It.Key, DynamicParameterHash);
+	}
+
+	uint64 ResourcesHash = 0;
+	for (const uint64 ResourceHash : ResourceHashes)
+	{
+		if (ResourceHash == 0)
+		{
+			return 0;
+		}
+		ResourcesHash ^= ResourceHash;
+	}
+
+	return FVoxelUtilities::MurmurHashMulti(
+		ScalarParameters.Num(),
+		VectorParameters.Num(),
+		TextureParameters.Num(),
+		DynamicParameters.Num(),
+		ParametersHash,
+		Resources.Num(),
+		ResourcesHash);
+}
+
+uint64 FVoxelComputedMaterial::GetContentHash() const
+{
+	const uint64 ParametersHash = Parameters.GetContentHash();
+	if (ParametersHash == 0)
+	{
+		return 0;
+	}
+
+	return FVoxelUtilities::MurmurHashMulti(ParentMaterial.Get(), ParametersHash);
 }
 
 TSharedRef<FVoxelMaterialRef> FVoxelComputedMaterial::MakeMaterial_GameThread() const
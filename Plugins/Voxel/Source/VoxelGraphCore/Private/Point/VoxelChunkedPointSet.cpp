@@ -4,8 +4,113 @@
 #include "VoxelDebugNode.h"
 #include "VoxelTaskGroup.h"
 #include "VoxelDependency.h"
+#include "VoxelBufferUtilities.h"
 #include "Buffer/VoxelStaticMeshBuffer.h"
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, int32, GVoxelPointInBoundsCacheSize, 256,
+	"voxel.point.InBoundsCacheSize",
+	"Number of point chunks computed by GetPointsInBounds to keep cached. Least recently used chunks are evicted first. 0 to disable");
+
+class FVoxelPointsInBoundsCache : public FVoxelSingleton
+{
+public:
+	//~ Begin FVoxelSingleton Interface
+	virtual void Tick() override
+	{
+		VOXEL_FUNCTION_COUNTER();
+		VOXEL_SCOPE_LOCK(CriticalSection);
+
+		for (auto It = ChunkRefToData_RequiresLock.CreateIterator(); It; ++It)
+		{
+			if (It.Value().DependencyTracker->IsInvalidated() ||
+				GVoxelPointInBoundsCacheSize <= 0)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+	//~ End FVoxelSingleton Interface
+
+	TSharedPtr<const FVoxelPointSet> Find(const FVoxelPointChunkRef& ChunkRef)
+	{
+		VOXEL_SCOPE_LOCK(CriticalSection);
+
+		FData* Data = ChunkRefToData_RequiresLock.Find(ChunkRef);
+		if (!Data)
+		{
+			return nullptr;
+		}
+
+		if (Data->DependencyTracker->IsInvalidated())
+		{
+			ChunkRefToData_RequiresLock.Remove(ChunkRef);
+			return nullptr;
+		}
+
+		Data->LastAccess = ++AccessCounter_RequiresLock;
+		return Data->PointSet;
+	}
+	void Add(
+		const FVoxelPointChunkRef& ChunkRef,
+		const TSharedRef<const FVoxelPointSet>& PointSet,
+		const TSharedRef<FVoxelDependencyTracker>& DependencyTracker)
+	{
+		if (GVoxelPointInBoundsCacheSize <= 0 ||
+			DependencyTracker->IsInvalidated())
+		{
+			return;
+		}
+
+		VOXEL_SCOPE_LOCK(CriticalSection);
+
+		FData& Data = ChunkRefToData_RequiresLock.FindOrAdd(ChunkRef);
+		Data.PointSet = PointSet;
+		Data.DependencyTracker = DependencyTracker;
+		Data.LastAccess = ++AccessCounter_RequiresLock;
+
+		while (ChunkRefToData_RequiresLock.Num() > GVoxelPointInBoundsCacheSize)
+		{
+			const FVoxelPointChunkRef* LeastRecentlyUsed = nullptr;
+			uint64 LeastRecentAccess = MAX_uint64;
+			for (const auto& It : ChunkRefToData_RequiresLock)
+			{
+				if (It.Value.LastAccess < LeastRecentAccess)
+				{
+					LeastRecentlyUsed = &It.Key;
+					LeastRecentAccess = It.Value.LastAccess;
+				}
+			}
+
+			if (!ensure(LeastRecentlyUsed))
+			{
+				break;
+			}
+
+			const FVoxelPointChunkRef ChunkRefToRemove = *LeastRecentlyUsed;
+			ChunkRefToData_RequiresLock.Remove(ChunkRefToRemove);
+		}
+	}
+
+private:
+	struct FData
+	{
+		TSharedPtr<const FVoxelPointSet> PointSet;
+		TSharedPtr<FVoxelDependencyTracker> DependencyTracker;
+		uint64 LastAccess = 0;
+	};
+
+	FVoxelFastCriticalSection CriticalSection;
+	uint64 AccessCounter_RequiresLock = 0;
+	TVoxelMap<FVoxelPointChunkRef, FData> ChunkRefToData_RequiresLock;
+};
+
+FVoxelPointsInBoundsCache* GVoxelPointsInBoundsCache = MakeVoxelSingleton(FVoxelPointsInBoundsCache);
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 FVoxelChunkedPointSet::FVoxelChunkedPointSet(
 	const int32 ChunkSize,
 	const FVoxelPointChunkProviderRef& ChunkProviderRef,
@@ -29,14 +134,9 @@ TVoxelFutureValue<FVoxelPointSet> FVoxelChunkedPointSet::GetPoints(
 
 	const TSharedRef<FVoxelDebugQueryParameter> DebugParameter = MakeVoxelShared<FVoxelDebugQueryParameter>();
 
-	FVoxelPointChunkRef ChunkRef;
-	ChunkRef.ChunkProviderRef = ChunkProviderRef;
-	ChunkRef.ChunkMin = ChunkMin;
-	ChunkRef.ChunkSize = ChunkSize;
-
 	const TSharedRef<FVoxelQueryParameters> Parameters = MakeVoxelShared<FVoxelQueryParameters>();
 	Parameters->Add(DebugParameter);
-	Parameters->Add<FVoxelPointChunkRefQueryParameter>().ChunkRef = ChunkRef;
+	Parameters->Add<FVoxelPointChunkRefQueryParameter>().ChunkRef = GetChunkRef(ChunkMin);
 
 	const FVoxelQuery Query = FVoxelQuery::Make(
 		Context.ToSharedRef(),
@@ -145,8 +245,11 @@ void FVoxelChunkedPointSet::GetPointsInBounds(
 				return {};
 			}
 
-			const TSharedRef<FVoxelDependencyTracker> DependencyTracker = FVoxelDependencyTracker::Create("GetPointsInBounds");
+			// Chunks computed by previous queries are reused as long as their dependencies are not invalidated
+			TVoxelArray<TSharedRef<const FVoxelPointSet>> CachedPointSets;
 
+			TVoxelArray<FVoxelPointChunkRef> ChunkRefs;
+			TVoxelArray<TSharedRef<FVoxelDependencyTracker>> DependencyTrackers;
 			TVoxelArray<TVoxelFutureValue<FVoxelPointSet>> FuturePointSets;
 			for (int32 X = Min.X; X < Max.X; X++)
 			{
@@ -161,11 +264,24 @@ void FVoxelChunkedPointSet::GetPointsInBounds(
 							continue;
 						}
 
+						const FVoxelPointChunkRef ChunkRef = This->GetChunkRef(ChunkMin);
+						if (const TSharedPtr<const FVoxelPointSet> CachedPointSet = GVoxelPointsInBoundsCache->Find(ChunkRef))
+						{
+							CachedPointSets.Add(CachedPointSet.ToSharedRef());
+							continue;
+						}
+
+						// One tracker per chunk so that chunks are invalidated separately
+						const TSharedRef<FVoxelDependencyTracker> DependencyTracker = FVoxelDependencyTracker::Create("GetPointsInBounds");
+
 						const TVoxelFutureValue<FVoxelPointSet> FuturePointSet = This->GetPoints(*DependencyTracker, ChunkMin);
 						if (!FuturePointSet.IsValid())
 						{
 							continue;
 						}
+
+						ChunkRefs.Add(ChunkRef);
+						DependencyTrackers.Add(DependencyTracker);
 						FuturePointSets.Add(FuturePointSet);
 					}
 				}
@@ -176,33 +292,44 @@ void FVoxelChunkedPointSet::GetPointsInBounds(
 				.Dependencies(FuturePointSets)
 				.Execute<FVoxelPointSet>([=]
 				{
+					TVoxelArray<TSharedRef<const FVoxelPointSet>> ChunkPointSets = CachedPointSets;
+					for (int32 Index = 0; Index < FuturePointSets.Num(); Index++)
+					{
+						const TSharedRef<const FVoxelPointSet> PointSet = FuturePointSets[Index].GetShared_CheckCompleted();
+						GVoxelPointsInBoundsCache->Add(ChunkRefs[Index], PointSet, DependencyTrackers[Index]);
+						ChunkPointSets.Add(PointSet);
+					}
+
 					TVoxelArray<TSharedRef<const FVoxelPointSet>> PointSets;
-					for (const TVoxelFutureValue<FVoxelPointSet>& FuturePointSet : FuturePointSets)
+					for (const TSharedRef<const FVoxelPointSet>& PointSet : ChunkPointSets)
 					{
-						const FVoxelPointSet& PointSet = FuturePointSet.Get_CheckCompleted();
-						if (PointSet.Num() == 0)
+						if (PointSet->Num() == 0)
 						{
 							continue;
 						}
 
-						const TSharedPtr<const FVoxelBuffer> PositionsPtr = PointSet.Find(FVoxelPointAttributes::Position);
+						const TSharedPtr<const FVoxelBuffer> PositionsPtr = PointSet->Find(FVoxelPointAttributes::Position);
 						if (!ensure(PositionsPtr) ||
 							!ensure(PositionsPtr->IsA<FVoxelVectorBuffer>()))
 						{
 							continue;
 						}
 
-						const FVoxelVectorBuffer Positions = CastChecked<FVoxelVectorBuffer>(*PositionsPtr);
+						const FVoxelVectorBuffer& Positions = CastChecked<FVoxelVectorBuffer>(*PositionsPtr);
+						const FVoxelInt32Buffer Indices = FVoxelBufferUtilities::GetIndicesInBounds(Positions, Bounds);
+						if (Indices.Num() == 0)
+						{
+							continue;
+						}
 
-						FVoxelInt32BufferStorage Indices;
-						for (int32 Index = 0; Index < PointSet.Num(); Index++)
+						if (Indices.Num() == PointSet->Num())
 						{
-							if (Bounds.Contains(Positions[Index]))
-							{
-								Indices.Add(Index);
-							}
+							// All the points are in bounds, no need to copy them
+							PointSets.Add(PointSet);
+							continue;
 						}
-						PointSets.Add(PointSet.Gather(FVoxelInt32Buffer::Make(Indices)));
+
+						PointSets.Add(PointSet->Gather(Indices));
 					}
 					return FVoxelPointSet::Merge(PointSets);
 				});
@@ -211,4 +338,13 @@ void FVoxelChunkedPointSet::GetPointsInBounds(
 		{
 			Callback(PointSet);
 		});
+}
+
+FVoxelPointChunkRef FVoxelChunkedPointSet::GetChunkRef(const FIntVector& ChunkMin) const
+{
+	FVoxelPointChunkRef ChunkRef;
+	ChunkRef.ChunkProviderRef = ChunkProviderRef;
+	ChunkRef.ChunkMin = ChunkMin;
+	ChunkRef.ChunkSize = ChunkSize;
+	return ChunkRef;
 }
\ No newline at end of file
@@ -171,6 +171,24 @@ int64 FVoxelPointSet::GetAllocatedSize() const
 	return AllocatedSize;
 }
 
+uint64 FVoxelPointSet::GetContentHash() const
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Num(), 1024);
+
+	// Attributes order isn't deterministic, combine them with a xor
+	uint64 AttributesHash = 0;
+	for (const auto& It : Attributes)
+	{
+		const uint64 BufferHash = It.Value->GetContentHash();
+		if (BufferHash == 0)
+		{
+			return 0;
+		}
+		AttributesHash ^= FVoxelUtilities::MurmurHashMulti(GetTypeHash(It.Key), BufferHash);
+	}
+	return FVoxelUtilities::MurmurHashMulti(Num(), Attributes.Num(), AttributesHash);
+}
+
 const TVoxelAddOnlySet<FVoxelPointId>& FVoxelPointSet::GetPointIdToIndex() const
 {
 	VOXEL_SCOPE_LOCK(PointIdToIndexCriticalSection);
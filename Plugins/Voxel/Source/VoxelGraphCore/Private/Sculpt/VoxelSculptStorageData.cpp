@@ -2,6 +2,7 @@
 
 #include "Sculpt/VoxelSculptStorageData.h"
 #include "VoxelDependency.h"
+#include "Hash/CityHash.h"
 #include "Serialization/LargeMemoryWriter.h"
 #include "Serialization/LargeMemoryReader.h"
 #include "Compression/OodleDataCompressionUtil.h"
@@ -101,6 +102,46 @@ void FVoxelSculptStorageData::ClearData()
 	Dependency->Invalidate();
 }
 
+uint64 FVoxelSculptStorageData::GetContentHash() const
+{
+	VOXEL_FUNCTION_COUNTER();
+	FVoxelScopeLock_Read Lock(CriticalSection);
+
+	TVoxelArray<FIntVector> Keys;
+	Keys.Reserve(Chunks.Num());
+	for (const auto& It : Chunks)
+	{
+		if (It.Value)
+		{
+			Keys.Add(It.Key);
+		}
+	}
+
+	// Map order depends on the edit history
+	Keys.Sort([](const FIntVector& A, const FIntVector& B)
+	{
+		if (A.X != B.X)
+		{
+			return A.X < B.X;
+		}
+		if (A.Y != B.Y)
+		{
+			return A.Y < B.Y;
+		}
+		return A.Z < B.Z;
+	});
+
+	uint64 Hash = 0;
+	for (const FIntVector& Key : Keys)
+	{
+		const FChunk& Chunk = *Chunks[Key];
+
+		Hash = CityHash64WithSeed(reinterpret_cast<const char*>(&Key), sizeof(Key), Hash);
+		Hash = CityHash64WithSeed(reinterpret_cast<const char*>(Chunk.GetData()), sizeof(FChunk), Hash);
+	}
+	return Hash;
+}
+
 void FVoxelSculptStorageData::Serialize(FArchive& Ar)
 {
 	VOXEL_FUNCTION_COUNTER();
@@ -0,0 +1,344 @@
+// Copyright Voxel Plugin, Inc. All Rights Reserved.
+
+#include "VoxelBenchmarkCommandlet.h"
+#include "VoxelActor.h"
+#include "VoxelGraphInterface.h"
+#include "VoxelTaskExecutor.h"
+#include "VoxelBenchmarkStats.h"
+#include "Engine/Engine.h"
+#include "Misc/FileHelper.h"
+#include "RenderGraphBuilder.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+
+// Chunk spawners & runtimes only queue new tasks on their next tick:
+// wait a few frames without any task before considering a waypoint done
+constexpr int32 GVoxelBenchmarkIdleFrames = 10;
+// Fixed time step so that the number of frames & camera positions don't depend on the machine
+constexpr float GVoxelBenchmarkDeltaTime = 1.f / 30.f;
+
+UVoxelBenchmarkCommandlet::UVoxelBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UVoxelBenchmarkCommandlet::Main(const FString& Params)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	int32 NumThreads = 0;
+	if (FParse::Value(*Params, TEXT("Threads="), NumThreads))
+	{
+		IConsoleManager::Get().FindConsoleVariable(TEXT("voxel.NumThreads"))->Set(NumThreads);
+	}
+
+	float Timeout = 600.f;
+	FParse::Value(*Params, TEXT("Timeout="), Timeout);
+
+	int32 NumRepeats = 1;
+	FParse::Value(*Params, TEXT("Repeat="), NumRepeats);
+	NumRepeats = FMath::Max(NumRepeats, 1);
+
+	FString OutputPath = FPaths::ProjectSavedDir() / "VoxelBenchmark.json";
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	TVoxelArray<FVector> Path;
+	{
+		FString PathString;
+		if (FParse::Value(*Params, TEXT("Path="), PathString, false))
+		{
+			TArray<FString> Points;
+			PathString.ParseIntoArray(Points, TEXT(";"));
+
+			for (const FString& Point : Points)
+			{
+				TArray<FString> Coordinates;
+				Point.ParseIntoArray(Coordinates, TEXT(","));
+
+				if (Coordinates.Num() != 3)
+				{
+					LOG_VOXEL(Error, "Invalid path point %s: expected X,Y,Z", *Point);
+					return 1;
+				}
+
+				Path.Add(FVector(
+					FCString::Atod(*Coordinates[0]),
+					FCString::Atod(*Coordinates[1]),
+					FCString::Atod(*Coordinates[2])));
+			}
+		}
+	}
+
+	if (Path.Num() == 0)
+	{
+		// Fixed chunk set around the origin
+		Path.Add(FVector::ZeroVector);
+	}
+
+	UWorld* World = CreateWorld(Params);
+	if (!World)
+	{
+		return 1;
+	}
+
+	FVoxelBenchmarkStats::SetEnabled(true);
+	// Discard anything recorded while loading
+	(void)FVoxelBenchmarkStats::FlushSamples();
+
+	uint64 PeakUsedPhysical = 0;
+	uint64 PeakUsedVirtual = 0;
+	const auto UpdatePeakMemory = [&]
+	{
+		const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+		PeakUsedPhysical = FMath::Max<uint64>(PeakUsedPhysical, MemoryStats.UsedPhysical);
+		PeakUsedVirtual = FMath::Max<uint64>(PeakUsedVirtual, MemoryStats.UsedVirtual);
+	};
+
+	const double StartTime = FPlatformTime::Seconds();
+	int32 NumFrames = 0;
+	bool bTimedOut = false;
+	TArray<TSharedPtr<FJsonValue>> WaypointValues;
+
+	for (int32 Repeat = 0; Repeat < NumRepeats && !bTimedOut; Repeat++)
+	{
+		for (int32 Index = 0; Index < Path.Num() && !bTimedOut; Index++)
+		{
+			const FVector Position = Path[Index];
+			const FVector Direction = Path.IsValidIndex(Index + 1) ? (Path[Index + 1] - Position).GetSafeNormal() : FVector::ForwardVector;
+			FVoxelGameUtilities::SetCameraViewOverride(World, FTransform(Direction.Rotation(), Position));
+
+			const double WaypointStartTime = FPlatformTime::Seconds();
+			double LastBusyTime = WaypointStartTime;
+			int32 WaypointFrames = 0;
+			int32 NumIdleFrames = 0;
+
+			while (NumIdleFrames < GVoxelBenchmarkIdleFrames)
+			{
+				TickWorld(*World, GVoxelBenchmarkDeltaTime);
+				UpdatePeakMemory();
+
+				NumFrames++;
+				WaypointFrames++;
+
+				if (GVoxelTaskExecutor->NumTasks() > 0)
+				{
+					LastBusyTime = FPlatformTime::Seconds();
+					NumIdleFrames = 0;
+				}
+				else
+				{
+					NumIdleFrames++;
+				}
+
+				if (FPlatformTime::Seconds() - WaypointStartTime > Timeout)
+				{
+					LOG_VOXEL(Error, "Waypoint %d timed out after %.1fs with %d voxel tasks left", Index, Timeout, GVoxelTaskExecutor->NumTasks());
+					bTimedOut = true;
+					break;
+				}
+			}
+
+			// Don't count the idle frames
+			const double WaypointTime = LastBusyTime - WaypointStartTime;
+			LOG_VOXEL(Display, "Waypoint %d (%s) took %.3fs", Index, *Position.ToString(), WaypointTime);
+
+			const TSharedRef<FJsonObject> WaypointObject = MakeShared<FJsonObject>();
+			WaypointObject->SetNumberField("index", Index);
+			WaypointObject->SetNumberField("repeat", Repeat);
+			WaypointObject->SetArrayField("position",
+			{
+				MakeShared<FJsonValueNumber>(Position.X),
+				MakeShared<FJsonValueNumber>(Position.Y),
+				MakeShared<FJsonValueNumber>(Position.Z)
+			});
+			WaypointObject->SetNumberField("seconds", WaypointTime);
+			WaypointObject->SetNumberField("frames", WaypointFrames);
+			WaypointObject->SetBoolField("timedOut", bTimedOut);
+			WaypointValues.Add(MakeShared<FJsonValueObject>(WaypointObject));
+		}
+	}
+
+	const double TotalTime = FPlatformTime::Seconds() - StartTime;
+
+	FVoxelBenchmarkStats::SetEnabled(false);
+	TVoxelMap<FName, TVoxelArray<double>> StageToSamples = FVoxelBenchmarkStats::FlushSamples();
+	StageToSamples.KeySort(FNameLexicalLess());
+
+	const TSharedRef<FJsonObject> StagesObject = MakeShared<FJsonObject>();
+	for (auto& It : StageToSamples)
+	{
+		TVoxelArray<double>& Samples = It.Value;
+		if (Samples.Num() == 0)
+		{
+			continue;
+		}
+		Samples.Sort();
+
+		double Sum = 0.;
+		for (const double Sample : Samples)
+		{
+			Sum += Sample;
+		}
+
+		// Nearest-rank percentile
+		const auto GetPercentile = [&](const double Percentile)
+		{
+			const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * Samples.Num()) - 1, 0, Samples.Num() - 1);
+			return Samples[Index] * 1000.;
+		};
+
+		const TSharedRef<FJsonObject> StageObject = MakeShared<FJsonObject>();
+		StageObject->SetNumberField("count", Samples.Num());
+		StageObject->SetNumberField("totalMs", Sum * 1000.);
+		StageObject->SetNumberField("meanMs", Sum / Samples.Num() * 1000.);
+		StageObject->SetNumberField("p50Ms", GetPercentile(0.50));
+		StageObject->SetNumberField("p90Ms", GetPercentile(0.90));
+		StageObject->SetNumberField("p99Ms", GetPercentile(0.99));
+		StageObject->SetNumberField("maxMs", Samples.Last() * 1000.);
+		StageObject->SetNumberField("throughputPerSecond", TotalTime > 0. ? Samples.Num() / TotalTime : 0.);
+		StagesObject->SetObjectField(It.Key.ToString(), StageObject);
+
+		LOG_VOXEL(Display, "%s: %d samples, p50 %.3fms p90 %.3fms p99 %.3fms",
+			*It.Key.ToString(),
+			Samples.Num(),
+			GetPercentile(0.50),
+			GetPercentile(0.90),
+			GetPercentile(0.99));
+	}
+
+	const TSharedRef<FJsonObject> RootObject = MakeShared<FJsonObject>();
+	RootObject->SetNumberField("version", 1);
+	RootObject->SetStringField("world", World->GetPathName());
+	RootObject->SetNumberField("numThreads", IConsoleManager::Get().FindConsoleVariable(TEXT("voxel.NumThreads"))->GetInt());
+	RootObject->SetNumberField("totalSeconds", TotalTime);
+	RootObject->SetNumberField("frames", NumFrames);
+	RootObject->SetBoolField("timedOut", bTimedOut);
+	RootObject->SetNumberField("peakUsedPhysicalMB", PeakUsedPhysical / double(1 << 20));
+	RootObject->SetNumberField("peakUsedVirtualMB", PeakUsedVirtual / double(1 << 20));
+	RootObject->SetNumberField("processPeakUsedPhysicalMB", FPlatformMemory::GetStats().PeakUsedPhysical / double(1 << 20));
+	RootObject->SetArrayField("waypoints", WaypointValues);
+	RootObject->SetObjectField("stages", StagesObject);
+
+	DestroyWorld(*World);
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	if (!FJsonSerializer::Serialize(RootObject, Writer) ||
+		!FFileHelper::SaveStringToFile(Json, *OutputPath))
+	{
+		LOG_VOXEL(Error, "Failed to write %s", *OutputPath);
+		return 1;
+	}
+
+	LOG_VOXEL(Display, "Benchmark took %.3fs, results written to %s", TotalTime, *OutputPath);
+
+	return bTimedOut ? 1 : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+UWorld* UVoxelBenchmarkCommandlet::CreateWorld(const FString& Params) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	FString MapName;
+	FString GraphName;
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("Graph="), GraphName);
+
+	UWorld* World = nullptr;
+	if (!MapName.IsEmpty())
+	{
+		const UPackage* Package = LoadPackage(nullptr, *MapName, LOAD_None);
+		World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+		if (!World)
+		{
+			LOG_VOXEL(Error, "Failed to load map %s", *MapName);
+			return nullptr;
+		}
+
+		World->WorldType = EWorldType::Game;
+		World->AddToRoot();
+
+		if (!World->bIsWorldInitialized)
+		{
+			World->InitWorld(UWorld::InitializationValues()
+				.AllowAudioPlayback(false)
+				.RequiresHitProxies(false)
+				.CreateNavigation(false)
+				.CreateAISystem(false)
+				.SetTransactional(false));
+		}
+	}
+	else if (!GraphName.IsEmpty())
+	{
+		UVoxelGraphInterface* Graph = LoadObject<UVoxelGraphInterface>(nullptr, *GraphName);
+		if (!Graph)
+		{
+			LOG_VOXEL(Error, "Failed to load graph %s", *GraphName);
+			return nullptr;
+		}
+
+		World = UWorld::CreateWorld(EWorldType::Game, false, "VoxelBenchmark");
+
+		AVoxelActor* Actor = World->SpawnActor<AVoxelActor>();
+		Actor->SetGraph(Graph);
+	}
+	else
+	{
+		LOG_VOXEL(Error, "Either -Map= or -Graph= must be specified");
+		return nullptr;
+	}
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	World->UpdateWorldComponents(true, false);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	return World;
+}
+
+void UVoxelBenchmarkCommandlet::TickWorld(UWorld& World, const float DeltaTime) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	FApp::SetDeltaTime(DeltaTime);
+	FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+
+	// Voxel singletons & tickers run from the core ticker
+	FTSTicker::GetCoreTicker().Tick(DeltaTime);
+	World.Tick(LEVELTICK_All, DeltaTime);
+	FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+
+	// Nothing is rendered without a viewport: manually broadcast the pre-render delegate voxel render tasks run from
+	ENQUEUE_RENDER_COMMAND(VoxelBenchmarkPreRender)([](FRHICommandListImmediate& RHICmdList)
+	{
+		FRDGBuilder GraphBuilder(RHICmdList);
+		GEngine->GetPreRenderDelegateEx().Broadcast(GraphBuilder);
+		GraphBuilder.Execute();
+	});
+
+	// Don't let the render thread fall behind, its tasks are part of the benchmark
+	FlushRenderingCommands();
+
+	GFrameCounter++;
+}
+
+void UVoxelBenchmarkCommandlet::DestroyWorld(UWorld& World) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	FVoxelGameUtilities::SetCameraViewOverride(&World, {});
+
+	GEngine->DestroyWorldContext(&World);
+	World.DestroyWorld(false);
+	World.RemoveFromRoot();
+
+	CollectGarbage(RF_NoFlags);
+}
\ No newline at end of file
@@ -128,6 +128,21 @@ int32 FVoxelBuffer::Num_Slow() const
 	return NewNum;
 }
 
+uint64 FVoxelBuffer::GetContentHash() const
+{
+	uint64 Hash = NumTerminalBuffers();
+	for (const FVoxelTerminalBuffer& Buffer : GetTerminalBuffers())
+	{
+		const uint64 BufferHash = Buffer.GetContentHash();
+		if (BufferHash == 0)
+		{
+			return 0;
+		}
+		Hash = FVoxelUtilities::MurmurHash64(Hash ^ BufferHash);
+	}
+	return Hash;
+}
+
 bool FVoxelBuffer::IsValid_Slow() const
 {
 	if (NumTerminalBuffers() == 1)
@@ -258,6 +273,11 @@ int32 FVoxelSimpleTerminalBuffer::Num_Slow() const
 	return GetStorage().Num();
 }
 
+uint64 FVoxelSimpleTerminalBuffer::GetContentHash() const
+{
+	return GetStorage().GetHash();
+}
+
 TSharedRef<FVoxelBufferStorage> FVoxelSimpleTerminalBuffer::MakeNewStorage() const
 {
 	return MakeVoxelShared<FVoxelBufferStorage>(GetTypeSize());
@@ -313,6 +333,12 @@ int32 FVoxelComplexTerminalBuffer::Num_Slow() const
 	return GetStorage().Num();
 }
 
+uint64 FVoxelComplexTerminalBuffer::GetContentHash() const
+{
+	// Complex structs can't be hashed safely
+	return 0;
+}
+
 void FVoxelComplexTerminalBuffer::InitializeFromConstant(const FVoxelRuntimePinValue& Constant)
 {
 	const TSharedRef<FVoxelComplexBufferStorage> Storage = MakeVoxelShared<FVoxelComplexBufferStorage>(GetInnerStruct());
@@ -463,6 +463,26 @@ void FVoxelBufferStorage::CopyTo(const TVoxelArrayView<uint8> OtherData) const
 	});
 }
 
+uint64 FVoxelBufferStorage::GetHash() const
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Num(), 1024);
+
+	uint64 Hash = FVoxelUtilities::MurmurHashMulti(TypeSize, ArrayNum);
+
+	if (IsConstant())
+	{
+		return FVoxelUtilities::MurmurHash64(Hash ^ FVoxelUtilities::MurmurHashBytes(TConstArrayView<uint8>(static_cast<const uint8*>(Chunks[0]), TypeSize)));
+	}
+
+	// Not ForeachVoxelBufferChunk: chunks must be hashed serially & in order
+	for (const FVoxelBufferIterator& Iterator : MakeVoxelBufferIterator(Num()))
+	{
+		Hash = FVoxelUtilities::MurmurHash64(Hash ^ FVoxelUtilities::MurmurHashBytes(GetByteRawView_NotConstant(Iterator)));
+	}
+
+	return Hash;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
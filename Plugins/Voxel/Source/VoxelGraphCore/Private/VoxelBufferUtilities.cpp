@@ -650,6 +650,59 @@ FVoxelQuaternionBuffer FVoxelBufferUtilities::Combine(const FVoxelQuaternionBuff
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+FVoxelInt32Buffer FVoxelBufferUtilities::GetIndicesInBounds(const FVoxelVectorBuffer& Positions, const FVoxelBox& Bounds)
+{
+	const FVoxelBufferAccessor BufferAccessor(Positions.X, Positions.Y, Positions.Z);
+	if (!ensure(BufferAccessor.IsValid()))
+	{
+		return {};
+	}
+
+	VOXEL_FUNCTION_COUNTER_NUM(BufferAccessor.Num(), 1024);
+
+	// Positions are floats: rounding the bounds up to the next float gives the same results as comparing in double
+	const auto RoundUp = [](const double Value)
+	{
+		float Result = float(Value);
+		if (double(Result) < Value)
+		{
+			Result = std::nextafter(Result, MAX_flt);
+		}
+		return Result;
+	};
+
+	const FVector3f Min(RoundUp(Bounds.Min.X), RoundUp(Bounds.Min.Y), RoundUp(Bounds.Min.Z));
+	const FVector3f Max(RoundUp(Bounds.Max.X), RoundUp(Bounds.Max.Y), RoundUp(Bounds.Max.Z));
+
+	TVoxelArray<int32> ChunkIndices;
+	FVoxelUtilities::SetNumFast(ChunkIndices, FMath::Min(BufferAccessor.Num(), FVoxelBufferDefinitions::NumPerChunk));
+
+	FVoxelInt32BufferStorage Indices;
+	ForeachVoxelBufferChunk(BufferAccessor.Num(), [&](const FVoxelBufferIterator& Iterator)
+	{
+		const int32 NumIndices = ispc::VoxelBufferUtilities_GetIndicesInBounds(
+			Positions.X.GetData(Iterator), Positions.X.IsConstant(),
+			Positions.Y.GetData(Iterator), Positions.Y.IsConstant(),
+			Positions.Z.GetData(Iterator), Positions.Z.IsConstant(),
+			Iterator.Num(),
+			Iterator.GetIndex(),
+			GetISPCValue(Min),
+			GetISPCValue(Max),
+			ChunkIndices.GetData());
+
+		for (int32 Index = 0; Index < NumIndices; Index++)
+		{
+			Indices.Add(ChunkIndices[Index]);
+		}
+	});
+
+	return FVoxelInt32Buffer::Make(Indices);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 void FVoxelBufferUtilities::MakePalette(
 	const FVoxelTerminalBuffer& Buffer,
 	FVoxelInt32Buffer& OutIndices,
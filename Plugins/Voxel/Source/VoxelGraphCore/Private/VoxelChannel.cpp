@@ -9,6 +9,7 @@
 #include "VoxelPositionQueryParameter.h"
 #include "Engine/Engine.h"
 #include "Engine/AssetManager.h"
+#include "Hash/CityHash.h"
 #include "AssetRegistry/ARFilter.h"
 #include "AssetRegistry/AssetData.h"
 #include "AssetRegistry/AssetRegistryModule.h"
@@ -547,6 +548,72 @@ TArray<FName> FVoxelWorldChannelManager::GetValidChannelNames() const
 	return TSet<FName>(Result).Array();
 }
 
+bool FVoxelWorldChannelManager::GetPersistentBrushesHash(
+	const FVoxelBox& WorldBounds,
+	uint64& OutHash) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	TVoxelArray<TSharedPtr<FVoxelWorldChannel>> Channels;
+	{
+		VOXEL_SCOPE_LOCK(CriticalSection);
+		Channels_RequiresLock.GenerateValueArray(Channels);
+	}
+
+	// Registration order isn't stable across sessions, sort the brush hashes instead
+	TVoxelArray<uint64> BrushHashes;
+	for (const TSharedPtr<FVoxelWorldChannel>& Channel : Channels)
+	{
+		const FString ChannelName = Channel->Definition.Name.ToString();
+		const uint64 ChannelHash = CityHash64(
+			reinterpret_cast<const char*>(*ChannelName),
+			ChannelName.Len() * sizeof(TCHAR));
+
+		VOXEL_SCOPE_LOCK(Channel->CriticalSection);
+
+		for (const TSharedPtr<const FVoxelBrush>& Brush : Channel->Brushes_RequiresLock)
+		{
+			const FMatrix LocalToWorld = Brush->LocalToWorld.Get_NoDependency();
+
+			if (!Brush->LocalBounds.IsInfinite() &&
+				!Brush->LocalBounds.TransformBy(LocalToWorld).Intersect(WorldBounds))
+			{
+				continue;
+			}
+
+			if (Brush->PersistentHash == 0)
+			{
+				return false;
+			}
+
+			struct FBrushKey
+			{
+				uint64 ChannelHash;
+				uint64 PersistentHash;
+				uint64 Priority;
+				FMatrix LocalToWorld;
+			};
+
+			FBrushKey BrushKey;
+			FMemory::Memzero(BrushKey);
+			BrushKey.ChannelHash = ChannelHash;
+			BrushKey.PersistentHash = Brush->PersistentHash;
+			BrushKey.Priority = Brush->Priority.Raw;
+			BrushKey.LocalToWorld = LocalToWorld;
+
+			BrushHashes.Add(CityHash64(reinterpret_cast<const char*>(&BrushKey), sizeof(BrushKey)));
+		}
+	}
+
+	BrushHashes.Sort();
+
+	OutHash = CityHash64(
+		reinterpret_cast<const char*>(BrushHashes.GetData()),
+		BrushHashes.Num() * sizeof(uint64));
+
+	return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -72,6 +72,10 @@ void FVoxelDependencyInvalidationScope::Invalidate()
 			Tracker->bIsInvalidated.Store(true);
 			Tracker->Unregister_RequiresLock();
 
+			if (Tracker->OnInvalidatedWhileComputing)
+			{
+				OnInvalidatedArray.Add(MoveTemp(Tracker->OnInvalidatedWhileComputing));
+			}
 			if (Tracker->OnInvalidated)
 			{
 				OnInvalidatedArray.Add(MoveTemp(Tracker->OnInvalidated));
@@ -231,6 +235,20 @@ bool FVoxelDependencyTracker::TrySetOnInvalidated(TVoxelUniqueFunction<void()>&&
 	return true;
 }
 
+bool FVoxelDependencyTracker::TrySetOnInvalidatedWhileComputing(TVoxelUniqueFunction<void()>&& NewOnInvalidatedWhileComputing)
+{
+	VOXEL_SCOPE_LOCK(CriticalSection);
+	ensure(!OnInvalidatedWhileComputing);
+
+	if (IsInvalidated())
+	{
+		return false;
+	}
+
+	OnInvalidatedWhileComputing = MoveTemp(NewOnInvalidatedWhileComputing);
+	return true;
+}
+
 FVoxelDependencyTracker::FVoxelDependencyTracker(const FName& Name)
 	: Name(Name)
 {
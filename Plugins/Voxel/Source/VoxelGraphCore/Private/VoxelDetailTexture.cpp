@@ -5,6 +5,7 @@
 #include "VoxelDependency.h"
 #include "TextureResource.h"
 #include "Engine/Texture2D.h"
+#include "Algo/BinarySearch.h"
 #include "Materials/MaterialInstanceDynamic.h"
 
 DEFINE_VOXEL_FACTORY(UVoxelFloatDetailTexture);
@@ -14,6 +15,11 @@ DEFINE_VOXEL_FACTORY(UVoxelNormalDetailTexture);
 
 DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelDetailTextureMemory);
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, bool, GVoxelDetailTextureEnableShrinking, true,
+	"voxel.detailtexture.EnableShrinking",
+	"If true, detail texture atlases will be halved when all their allocations fit in their top-left quadrant");
+
 FVoxelDetailTextureManager* GVoxelDetailTextureManager = MakeVoxelSingleton(FVoxelDetailTextureManager);
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -135,6 +141,12 @@ FVoxelDetailTextureAllocator::FVoxelDetailTextureAllocator(
 	, Name(Pool.Name)
 {
 	Textures_GameThread.SetNumZeroed(NumTextures);
+
+	DynamicParameter->ContentHash = FVoxelUtilities::MurmurHashMulti(
+		Name,
+		TextureSize,
+		PixelFormat,
+		NumTextures);
 }
 
 FVoxelDetailTextureAllocator::~FVoxelDetailTextureAllocator()
@@ -166,63 +178,40 @@ TSharedRef<FVoxelDetailTextureAllocation> FVoxelDetailTextureAllocator::Allocate
 
 	const TSharedRef<FVoxelDetailTextureAllocation> Allocation(new FVoxelDetailTextureAllocation(*this, Num));
 
-	if (SizeInBlocks_RequiresLock == 0)
+	if (SizeInBlocks_RequiresLock == 0 &&
+		!Grow())
 	{
-		ensure(FreeRanges_RequiresLock.Num() == 0);
-
-		SizeInBlocks_RequiresLock = 512;
-		GVoxelDetailTextureManager->AllocatorsToUpdate.Enqueue(AsWeak());
-
-		for (int32 Y = 0; Y < SizeInBlocks_RequiresLock; Y++)
-		{
-			FreeRanges_RequiresLock.Add(
-			{
-				0,
-				Y,
-				SizeInBlocks_RequiresLock
-			});
-		}
+		return Allocation;
 	}
 
 	int32 NumLeft = Num;
 	while (NumLeft > 0)
 	{
-		if (FreeRanges_RequiresLock.Num() == 0)
+		FVoxelDetailTextureAllocationRange Range;
+		if (!PopFreeRange(NumLeft, false, Range))
 		{
-			// Reallocate
-
-			if (!ensure(2 * SizeInBlocks_RequiresLock * TextureSize <= 16384))
+			if (PendingFreeRanges_RequiresLock.Num() > 0)
 			{
-				return Allocation;
+				CoalesceFreeRanges();
+				continue;
 			}
 
-			for (int32 Y = 0; Y < SizeInBlocks_RequiresLock; Y++)
+			if (!PopFreeRange(NumLeft, true, Range))
 			{
-				FreeRanges_RequiresLock.Add(
+				if (!Grow())
 				{
-					SizeInBlocks_RequiresLock,
-					Y,
-					SizeInBlocks_RequiresLock
-				});
-				FreeRanges_RequiresLock.Add(
-				{
-					0,
-					SizeInBlocks_RequiresLock + Y,
-					2 * SizeInBlocks_RequiresLock
-				});
+					return Allocation;
+				}
+				continue;
 			}
-
-			SizeInBlocks_RequiresLock *= 2;
-			GVoxelDetailTextureManager->AllocatorsToUpdate.Enqueue(AsWeak());
 		}
-
-		const FVoxelDetailTextureAllocationRange Range = FreeRanges_RequiresLock.Pop(false);
 		CheckRange(Range);
 
 		const int32 NumInRange = FMath::Min(NumLeft, Range.Num);
 		Allocation->Ranges.Add({ Range.X, Range.Y, NumInRange });
 
 		NumLeft -= NumInRange;
+		NumAllocatedBlocks_RequiresLock += NumInRange;
 
 		if (NumInRange < Range.Num)
 		{
@@ -233,7 +222,7 @@ TSharedRef<FVoxelDetailTextureAllocation> FVoxelDetailTextureAllocator::Allocate
 				Range.Num - NumInRange
 			};
 			CheckRange(NewRange);
-			FreeRanges_RequiresLock.Add(NewRange);
+			AddFreeRange(NewRange);
 		}
 	}
 	ensure(NumLeft == 0);
@@ -247,6 +236,15 @@ void FVoxelDetailTextureAllocator::Update_GameThread()
 	check(IsInGameThread());
 	VOXEL_SCOPE_LOCK(CriticalSection);
 
+	if (bShrinkQueued_RequiresLock)
+	{
+		bShrinkQueued_RequiresLock = false;
+
+		while (TryShrink())
+		{
+		}
+	}
+
 	const int32 Size = SizeInBlocks_RequiresLock * TextureSize;
 	{
 		bool bNeedUpdate = false;
@@ -304,8 +302,14 @@ void FVoxelDetailTextureAllocator::Update_GameThread()
 		FTextureResource* OldResource = OldTexture->GetResource();
 		FTextureResource* NewResource = NewTexture->GetResource();
 
+		// When shrinking, all the allocations are in the top-left corner
 		FRHICopyTextureInfo CopyInfo;
-		CopyInfo.Size = { OldTexture->GetSizeX(), OldTexture->GetSizeY(), 1 };
+		CopyInfo.Size =
+		{
+			FMath::Min(OldTexture->GetSizeX(), NewTexture->GetSizeX()),
+			FMath::Min(OldTexture->GetSizeY(), NewTexture->GetSizeY()),
+			1
+		};
 
 		VOXEL_ENQUEUE_RENDER_COMMAND(FVoxelDetailTextureAllocator_Reallocate)([OldResource, NewResource, CopyInfo](FRHICommandListImmediate& RHICmdList)
 		{
@@ -317,6 +321,307 @@ void FVoxelDetailTextureAllocator::Update_GameThread()
 	}
 }
 
+int32 FVoxelDetailTextureAllocator::GetMinSizeInBlocks() const
+{
+	return FMath::Clamp(16384 / TextureSize, 1, 512);
+}
+
+TVoxelArray<FVoxelDetailTextureAllocationRange>& FVoxelDetailTextureAllocator::GetFreeRanges(const int32 SizeClass)
+{
+	checkVoxelSlow(CriticalSection.IsLocked());
+
+	if (SizeClassToFreeRanges_RequiresLock.Num() <= SizeClass)
+	{
+		SizeClassToFreeRanges_RequiresLock.SetNum(SizeClass + 1);
+	}
+	return SizeClassToFreeRanges_RequiresLock[SizeClass];
+}
+
+void FVoxelDetailTextureAllocator::AddFreeRange(const FVoxelDetailTextureAllocationRange& Range)
+{
+	checkVoxelSlow(CriticalSection.IsLocked());
+	CheckRange(Range);
+
+	TVoxelArray<FVoxelDetailTextureAllocationRange>& FreeRanges = GetFreeRanges(FMath::FloorLog2(Range.Num));
+
+	const int64 Priority = GetRangePriority(Range);
+	const int32 Index = Algo::LowerBoundBy(FreeRanges, -Priority, [](const FVoxelDetailTextureAllocationRange& Other)
+	{
+		return -GetRangePriority(Other);
+	});
+	FreeRanges.Insert(Range, Index);
+}
+
+void FVoxelDetailTextureAllocator::AddFreeRanges(const TConstVoxelArrayView<FVoxelDetailTextureAllocationRange> Ranges)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Ranges.Num(), 128);
+	checkVoxelSlow(CriticalSection.IsLocked());
+
+	TVoxelArray<int32, TVoxelInlineAllocator<32>> DirtySizeClasses;
+	for (const FVoxelDetailTextureAllocationRange& Range : Ranges)
+	{
+		CheckRange(Range);
+
+		const int32 SizeClass = FMath::FloorLog2(Range.Num);
+		GetFreeRanges(SizeClass).Add(Range);
+		DirtySizeClasses.AddUnique(SizeClass);
+	}
+
+	for (const int32 SizeClass : DirtySizeClasses)
+	{
+		SizeClassToFreeRanges_RequiresLock[SizeClass].Sort([](const FVoxelDetailTextureAllocationRange& A, const FVoxelDetailTextureAllocationRange& B)
+		{
+			return GetRangePriority(A) > GetRangePriority(B);
+		});
+	}
+}
+
+bool FVoxelDetailTextureAllocator::PopFreeRange(
+	const int32 Num,
+	const bool bAllowPartial,
+	FVoxelDetailTextureAllocationRange& OutRange)
+{
+	checkVoxelSlow(CriticalSection.IsLocked());
+	checkVoxelSlow(Num > 0);
+
+	// Ranges in size classes >= CeilLogTwo(Num) can always fit the whole allocation
+	const int32 MinSizeClass = bAllowPartial ? 0 : FMath::CeilLogTwo(Num);
+
+	int32 BestSizeClass = -1;
+	int64 BestPriority = MAX_int64;
+	for (int32 SizeClass = MinSizeClass; SizeClass < SizeClassToFreeRanges_RequiresLock.Num(); SizeClass++)
+	{
+		const TVoxelArray<FVoxelDetailTextureAllocationRange>& FreeRanges = SizeClassToFreeRanges_RequiresLock[SizeClass];
+		if (FreeRanges.Num() == 0)
+		{
+			continue;
+		}
+
+		const int64 Priority = GetRangePriority(FreeRanges.Last());
+		if (Priority < BestPriority)
+		{
+			BestSizeClass = SizeClass;
+			BestPriority = Priority;
+		}
+	}
+
+	if (BestSizeClass == -1)
+	{
+		return false;
+	}
+
+	OutRange = SizeClassToFreeRanges_RequiresLock[BestSizeClass].Pop(false);
+	return true;
+}
+
+void FVoxelDetailTextureAllocator::CoalesceFreeRanges()
+{
+	VOXEL_FUNCTION_COUNTER();
+	checkVoxelSlow(CriticalSection.IsLocked());
+
+	TVoxelArray<FVoxelDetailTextureAllocationRange> Ranges = MoveTemp(PendingFreeRanges_RequiresLock);
+	for (TVoxelArray<FVoxelDetailTextureAllocationRange>& FreeRanges : SizeClassToFreeRanges_RequiresLock)
+	{
+		Ranges.Append(FreeRanges);
+		FreeRanges.Reset();
+	}
+
+	Ranges.Sort([](const FVoxelDetailTextureAllocationRange& A, const FVoxelDetailTextureAllocationRange& B)
+	{
+		if (A.Y != B.Y)
+		{
+			return A.Y < B.Y;
+		}
+		return A.X < B.X;
+	});
+
+	TVoxelArray<FVoxelDetailTextureAllocationRange> MergedRanges;
+	MergedRanges.Reserve(Ranges.Num());
+
+	for (const FVoxelDetailTextureAllocationRange& Range : Ranges)
+	{
+		CheckRange(Range);
+
+		if (MergedRanges.Num() > 0)
+		{
+			FVoxelDetailTextureAllocationRange& LastRange = MergedRanges.Last();
+			ensureVoxelSlow(LastRange.Y != Range.Y || LastRange.X + LastRange.Num <= Range.X);
+
+			if (LastRange.Y == Range.Y &&
+				LastRange.X + LastRange.Num == Range.X)
+			{
+				LastRange.Num += Range.Num;
+				continue;
+			}
+		}
+
+		MergedRanges.Add(Range);
+	}
+
+	// Never merge across the middle of the atlas so that the right half can be freed when shrinking
+	const int32 HalfSize = SizeInBlocks_RequiresLock / 2;
+
+	TVoxelArray<FVoxelDetailTextureAllocationRange> FinalRanges;
+	FinalRanges.Reserve(MergedRanges.Num() + SizeInBlocks_RequiresLock);
+
+	for (const FVoxelDetailTextureAllocationRange& Range : MergedRanges)
+	{
+		if (Range.X < HalfSize &&
+			HalfSize < Range.X + Range.Num)
+		{
+			FinalRanges.Add({ Range.X, Range.Y, HalfSize - Range.X });
+			FinalRanges.Add({ HalfSize, Range.Y, Range.X + Range.Num - HalfSize });
+			continue;
+		}
+
+		FinalRanges.Add(Range);
+	}
+
+	AddFreeRanges(FinalRanges);
+}
+
+bool FVoxelDetailTextureAllocator::Grow()
+{
+	VOXEL_FUNCTION_COUNTER();
+	checkVoxelSlow(CriticalSection.IsLocked());
+
+	if (SizeInBlocks_RequiresLock == 0)
+	{
+		SizeInBlocks_RequiresLock = GetMinSizeInBlocks();
+
+		for (int32 Y = 0; Y < SizeInBlocks_RequiresLock; Y++)
+		{
+			PendingFreeRanges_RequiresLock.Add(
+			{
+				0,
+				Y,
+				SizeInBlocks_RequiresLock
+			});
+		}
+	}
+	else
+	{
+		if (!ensure(2 * SizeInBlocks_RequiresLock * TextureSize <= 16384))
+		{
+			return false;
+		}
+
+		for (int32 Y = 0; Y < SizeInBlocks_RequiresLock; Y++)
+		{
+			PendingFreeRanges_RequiresLock.Add(
+			{
+				SizeInBlocks_RequiresLock,
+				Y,
+				SizeInBlocks_RequiresLock
+			});
+			PendingFreeRanges_RequiresLock.Add(
+			{
+				0,
+				SizeInBlocks_RequiresLock + Y,
+				2 * SizeInBlocks_RequiresLock
+			});
+		}
+
+		SizeInBlocks_RequiresLock *= 2;
+	}
+
+	GVoxelDetailTextureManager->AllocatorsToUpdate.Enqueue(AsWeak());
+
+	CoalesceFreeRanges();
+	return true;
+}
+
+bool FVoxelDetailTextureAllocator::TryShrink()
+{
+	VOXEL_FUNCTION_COUNTER();
+	checkVoxelSlow(CriticalSection.IsLocked());
+
+	const int32 NewSize = SizeInBlocks_RequiresLock / 2;
+	if (!GVoxelDetailTextureEnableShrinking ||
+		NewSize < GetMinSizeInBlocks() ||
+		// Keep some slack to not immediately grow again
+		NumAllocatedBlocks_RequiresLock > FMath::Square(NewSize) / 2)
+	{
+		return false;
+	}
+
+	CoalesceFreeRanges();
+
+	int64 NumFreeOutside = 0;
+	for (const TVoxelArray<FVoxelDetailTextureAllocationRange>& FreeRanges : SizeClassToFreeRanges_RequiresLock)
+	{
+		for (const FVoxelDetailTextureAllocationRange& Range : FreeRanges)
+		{
+			if (Range.Y >= NewSize)
+			{
+				NumFreeOutside += Range.Num;
+			}
+			else
+			{
+				NumFreeOutside += FMath::Max(0, Range.X + Range.Num - FMath::Max(int32(Range.X), NewSize));
+			}
+		}
+	}
+
+	// Live allocations are not relocated: only shrink once all of them are in the top-left quadrant
+	if (NumFreeOutside != 3 * int64(NewSize) * int64(NewSize))
+	{
+		return false;
+	}
+
+	TVoxelArray<FVoxelDetailTextureAllocationRange> Ranges;
+	for (TVoxelArray<FVoxelDetailTextureAllocationRange>& FreeRanges : SizeClassToFreeRanges_RequiresLock)
+	{
+		for (const FVoxelDetailTextureAllocationRange& Range : FreeRanges)
+		{
+			if (Range.Y >= NewSize ||
+				Range.X >= NewSize)
+			{
+				continue;
+			}
+
+			Ranges.Add({ Range.X, Range.Y, FMath::Min(int32(Range.Num), NewSize - Range.X) });
+		}
+		FreeRanges.Reset();
+	}
+
+	LOG_VOXEL(Verbose, "Shrinking detail texture %s TextureSize=%d from %d to %d blocks",
+		*Name.ToString(),
+		TextureSize,
+		SizeInBlocks_RequiresLock,
+		NewSize);
+
+	SizeInBlocks_RequiresLock = NewSize;
+	PendingFreeRanges_RequiresLock = MoveTemp(Ranges);
+	CoalesceFreeRanges();
+
+	return true;
+}
+
+void FVoxelDetailTextureAllocator::Deallocate(const TConstVoxelArrayView<FVoxelDetailTextureAllocationRange> Ranges)
+{
+	VOXEL_FUNCTION_COUNTER();
+	VOXEL_SCOPE_LOCK(CriticalSection);
+
+	for (const FVoxelDetailTextureAllocationRange& Range : Ranges)
+	{
+		CheckRange(Range);
+		NumAllocatedBlocks_RequiresLock -= Range.Num;
+	}
+	ensure(NumAllocatedBlocks_RequiresLock >= 0);
+
+	PendingFreeRanges_RequiresLock.Append(Ranges);
+
+	if (!bShrinkQueued_RequiresLock &&
+		GVoxelDetailTextureEnableShrinking &&
+		SizeInBlocks_RequiresLock / 2 >= GetMinSizeInBlocks() &&
+		NumAllocatedBlocks_RequiresLock <= FMath::Square(SizeInBlocks_RequiresLock / 2) / 2)
+	{
+		bShrinkQueued_RequiresLock = true;
+		GVoxelDetailTextureManager->AllocatorsToUpdate.Enqueue(AsWeak());
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -374,14 +679,7 @@ FVoxelDetailTextureAllocation::~FVoxelDetailTextureAllocation()
 		return;
 	}
 
-	VOXEL_SCOPE_LOCK(Allocator->CriticalSection);
-
-	for (const FVoxelDetailTextureAllocationRange& Range : Ranges)
-	{
-		Allocator->CheckRange(Range);
-	}
-
-	Allocator->FreeRanges_RequiresLock.Append(Ranges);
+	Allocator->Deallocate(Ranges);
 }
 
 TSharedRef<FVoxelDetailTextureDynamicMaterialParameter> FVoxelDetailTextureAllocation::GetTexture() const
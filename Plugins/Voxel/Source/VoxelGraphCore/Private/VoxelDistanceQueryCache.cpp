@@ -0,0 +1,425 @@
+// Copyright Voxel Plugin, Inc. All Rights Reserved.
+
+#include "VoxelDistanceQueryCache.h"
+#include "VoxelQuery.h"
+#include "VoxelChannel.h"
+#include "VoxelSurface.h"
+#include "VoxelTaskGroup.h"
+#include "VoxelDependency.h"
+#include "Buffer/VoxelFloatBuffers.h"
+#include "VoxelPositionQueryParameter.h"
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, bool, GVoxelDistanceQueryCacheDisable, false,
+	"voxel.DistanceQueryCache.Disable",
+	"If true, distance query caches will not compute any cell and all queries will fail");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, float, GVoxelDistanceQueryCacheMaxRetryDelay, 30.f,
+	"voxel.DistanceQueryCache.MaxRetryDelay",
+	"Max delay in seconds before retrying after a failed query. The delay starts at 1s and doubles after every failure");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, float, GVoxelDistanceQueryCacheBatchTimeout, 10.f,
+	"voxel.DistanceQueryCache.BatchTimeout",
+	"Batches that haven't completed after this many seconds are discarded and treated as failures");
+
+FVoxelDistanceQueryCache::FVoxelDistanceQueryCache(
+	UWorld* InWorld,
+	const FName InChannelName,
+	const float InCellSize,
+	const int32 InMaxCellsPerFrame,
+	const int32 InMaxCachedCells)
+	: World(InWorld)
+	, ChannelName(InChannelName)
+	, CellSize(FMath::Max(InCellSize, 1.f))
+	, MaxCellsPerFrame(FMath::Max(InMaxCellsPerFrame, 1))
+	, MaxCachedCells(FMath::Max(InMaxCachedCells, MaxCellsPerFrame))
+{
+}
+
+FVoxelDistanceQueryCache::~FVoxelDistanceQueryCache()
+{
+	if (InFlightBatch)
+	{
+		// Its result will be ignored
+		EndBatch(*InFlightBatch);
+	}
+}
+
+bool FVoxelDistanceQueryCache::Query(
+	const FVector& Position,
+	float& OutDistance,
+	FVector& OutGradient)
+{
+	ensure(IsInGameThread());
+
+	FlushIfNeeded();
+
+	FIntVector Key;
+	const FCell& Cell = FindOrQueueCell(Position, Key);
+	if (!Cell.bIsValid)
+	{
+		return false;
+	}
+
+	// First order extrapolation from the cell center, good enough for smooth distance fields
+	const FVector CellCenter = (FVector(Key) + 0.5) * CellSize;
+	OutGradient = FVector(Cell.Gradient);
+	OutDistance = Cell.Distance + FVector::DotProduct(OutGradient, Position - CellCenter);
+	return true;
+}
+
+void FVoxelDistanceQueryCache::Prefetch(const FVector& Position)
+{
+	ensure(IsInGameThread());
+
+	FlushIfNeeded();
+
+	FIntVector Key;
+	FindOrQueueCell(Position, Key);
+}
+
+void FVoxelDistanceQueryCache::Flush()
+{
+	VOXEL_FUNCTION_COUNTER();
+	ensure(IsInGameThread());
+
+	LastFlushFrame = GFrameCounter;
+
+	ProcessBatchResults();
+
+	if (InFlightBatch &&
+		FPlatformTime::Seconds() > InFlightBatch->StartTime + GVoxelDistanceQueryCacheBatchTimeout)
+	{
+		VOXEL_MESSAGE(Error, "Query of {0} timed out", ChannelName);
+
+		// Its result will be ignored
+		EndBatch(*InFlightBatch);
+		InFlightBatch.Reset();
+
+		OnBatchResult(false);
+	}
+
+	if (InFlightBatch ||
+		PendingCells.Num() == 0 ||
+		GVoxelDistanceQueryCacheDisable)
+	{
+		Trim();
+		return;
+	}
+
+	// Don't retry (and log) failures every frame
+	if (FPlatformTime::Seconds() < NextRetryTime)
+	{
+		return;
+	}
+
+	// Oldest requests first, the rest will be computed by the next batches
+	const int32 NumToCompute = FMath::Min(PendingCells.Num(), MaxCellsPerFrame);
+	const TVoxelArray<FIntVector> Keys(PendingCells.GetData(), NumToCompute);
+	PendingCells.RemoveAt(0, NumToCompute);
+
+	if (!StartBatch(Keys))
+	{
+		for (const FIntVector& Key : Keys)
+		{
+			if (FCell* Cell = Cells.Find(Key))
+			{
+				Cell->bIsPending = false;
+			}
+		}
+
+		OnBatchResult(false);
+	}
+
+	Trim();
+}
+
+void FVoxelDistanceQueryCache::Reset()
+{
+	ensure(IsInGameThread());
+
+	if (InFlightBatch)
+	{
+		// Its result will be ignored
+		EndBatch(*InFlightBatch);
+		InFlightBatch.Reset();
+	}
+
+	Cells.Empty();
+	PendingCells.Empty();
+
+	NextRetryTime = 0.;
+	RetryDelay = 0.;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+FVoxelDistanceQueryCache::FCell& FVoxelDistanceQueryCache::FindOrQueueCell(const FVector& Position, FIntVector& OutKey)
+{
+	OutKey = FIntVector(
+		FMath::FloorToInt(Position.X / CellSize),
+		FMath::FloorToInt(Position.Y / CellSize),
+		FMath::FloorToInt(Position.Z / CellSize));
+
+	FCell& Cell = Cells.FindOrAdd(OutKey);
+	Cell.LastUsedFrame = GFrameCounter;
+
+	const bool bNeedsCompute =
+		!Cell.bIsValid ||
+		!Cell.DependencyTracker ||
+		Cell.DependencyTracker->IsInvalidated();
+
+	if (bNeedsCompute &&
+		!Cell.bIsPending)
+	{
+		Cell.bIsPending = true;
+		PendingCells.Add(OutKey);
+	}
+
+	return Cell;
+}
+
+void FVoxelDistanceQueryCache::FlushIfNeeded()
+{
+	if (LastFlushFrame != GFrameCounter)
+	{
+		Flush();
+	}
+}
+
+bool FVoxelDistanceQueryCache::StartBatch(const TConstVoxelArrayView<FIntVector> Keys)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Keys.Num(), 1);
+	check(!InFlightBatch);
+
+	UWorld* WorldObject = World.Get();
+	if (!WorldObject)
+	{
+		return false;
+	}
+
+	const TSharedRef<FVoxelWorldChannelManager> ChannelManager = FVoxelWorldChannelManager::Get(WorldObject);
+	const TSharedPtr<FVoxelWorldChannel> WorldChannel = ChannelManager->FindChannel(ChannelName);
+	if (!WorldChannel)
+	{
+		VOXEL_MESSAGE(Error, "No channel {0} found. Valid channels: {1}",
+			ChannelName,
+			ChannelManager->GetValidChannelNames());
+
+		return false;
+	}
+
+	const bool bIsSurface = WorldChannel->Definition.Type.Is<FVoxelSurface>();
+	if (!bIsSurface &&
+		!WorldChannel->Definition.Type.Is<FVoxelFloatBuffer>())
+	{
+		VOXEL_MESSAGE(Error, "Channel {0} has type {1}: only surface and float channels can be used for distance queries",
+			ChannelName,
+			WorldChannel->Definition.Type.ToString());
+
+		return false;
+	}
+
+	const TSharedRef<FVoxelRuntimeChannelCache> ChannelCache = FVoxelRuntimeChannelCache::Create();
+	const TSharedRef<FVoxelRuntimeChannel> RuntimeChannel = WorldChannel->GetRuntimeChannel(FVoxelTransformRef::Identity(), *ChannelCache);
+
+	FBatch& Batch = InFlightBatch.Emplace();
+	Batch.Id = ++LastBatchId;
+	Batch.StartTime = FPlatformTime::Seconds();
+	// Each cell is sampled at its center & at its center offset by GradientStep along each axis
+	// Forward differences are less precise than central ones, but need 4 samples instead of 7
+	Batch.GradientStep = CellSize / 2.f;
+	Batch.Keys = TVoxelArray<FIntVector>(Keys);
+	Batch.RuntimeInfo =
+		FVoxelRuntimeInfoBase::MakeFromWorld(WorldObject)
+		.EnableParallelTasks()
+		.MakeRuntimeInfo();
+	Batch.DependencyTracker = FVoxelDependencyTracker::Create(STATIC_FNAME("FVoxelDistanceQueryCache"));
+
+	const int32 NumPositions = 4 * Keys.Num();
+
+	FVoxelFloatBufferStorage X; X.Allocate(NumPositions);
+	FVoxelFloatBufferStorage Y; Y.Allocate(NumPositions);
+	FVoxelFloatBufferStorage Z; Z.Allocate(NumPositions);
+	for (int32 Index = 0; Index < Keys.Num(); Index++)
+	{
+		const FVector3f CellCenter = (FVector3f(Keys[Index]) + 0.5f) * CellSize;
+
+		for (int32 Sample = 0; Sample < 4; Sample++)
+		{
+			FVector3f Position = CellCenter;
+			if (Sample > 0)
+			{
+				Position[Sample - 1] += Batch.GradientStep;
+			}
+
+			X[4 * Index + Sample] = Position.X;
+			Y[4 * Index + Sample] = Position.Y;
+			Z[4 * Index + Sample] = Position.Z;
+		}
+	}
+
+	const TSharedRef<FVoxelQueryContext> Context = FVoxelQueryContext::Make(Batch.RuntimeInfo.ToSharedRef());
+
+	FVoxelTaskGroup::StartAsyncTask<FVoxelFloatBuffer>(
+		STATIC_FNAME("FVoxelDistanceQueryCache"),
+		Context,
+		[=, GradientStep = Batch.GradientStep, DependencyTracker = Batch.DependencyTracker.ToSharedRef()]() -> TVoxelFutureValue<FVoxelFloatBuffer>
+		{
+			const TSharedRef<FVoxelQueryParameters> Parameters = MakeVoxelShared<FVoxelQueryParameters>();
+			Parameters->Add<FVoxelPositionQueryParameter>().Initialize(FVoxelVectorBuffer::Make(X, Y, Z));
+			Parameters->Add<FVoxelLODQueryParameter>().LOD = 0;
+			Parameters->Add<FVoxelGradientStepQueryParameter>().Step = GradientStep;
+
+			const FVoxelQuery Query = FVoxelQuery::Make(
+				Context,
+				Parameters,
+				DependencyTracker);
+
+			if (!bIsSurface)
+			{
+				return RuntimeChannel->Get<FVoxelFloatBuffer>(Query);
+			}
+
+			const TVoxelFutureValue<FVoxelSurface> Surface = RuntimeChannel->Get<FVoxelSurface>(Query);
+			return
+				MakeVoxelTask()
+				.Dependency(Surface)
+				.Execute<FVoxelFloatBuffer>([=]
+				{
+					return Surface.Get_CheckCompleted().GetDistance(Query);
+				});
+		},
+		[BatchResults = BatchResults, BatchId = Batch.Id](const TSharedRef<const FVoxelFloatBuffer>& Distances)
+		{
+			BatchResults->Enqueue(FBatchResult
+			{
+				BatchId,
+				Distances
+			});
+		});
+
+	return true;
+}
+
+void FVoxelDistanceQueryCache::ProcessBatchResults()
+{
+	FBatchResult Result;
+	while (BatchResults->Dequeue(Result))
+	{
+		if (!InFlightBatch ||
+			InFlightBatch->Id != Result.BatchId)
+		{
+			// Batch was discarded by Reset
+			continue;
+		}
+
+		FBatch Batch = MoveTemp(InFlightBatch.GetValue());
+		InFlightBatch.Reset();
+
+		const bool bSuccess = FinishBatch(Batch, *Result.Distances);
+		EndBatch(Batch);
+		OnBatchResult(bSuccess);
+	}
+}
+
+bool FVoxelDistanceQueryCache::FinishBatch(const FBatch& Batch, const FVoxelFloatBuffer& Distances)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Batch.Keys.Num(), 1);
+
+	const int32 NumPositions = 4 * Batch.Keys.Num();
+	if (Distances.Num() != 1 &&
+		Distances.Num() != NumPositions)
+	{
+		VOXEL_MESSAGE(Error, "Channel {0} returned a buffer with a different size than Positions", ChannelName);
+		return false;
+	}
+
+	for (int32 Index = 0; Index < Batch.Keys.Num(); Index++)
+	{
+		FCell* Cell = Cells.Find(Batch.Keys[Index]);
+		if (!Cell)
+		{
+			continue;
+		}
+
+		const float Distance = Distances[4 * Index + 0];
+
+		Cell->Distance = Distance;
+		Cell->Gradient = FVector3f(
+			Distances[4 * Index + 1] - Distance,
+			Distances[4 * Index + 2] - Distance,
+			Distances[4 * Index + 3] - Distance) / Batch.GradientStep;
+		Cell->bIsValid = true;
+		Cell->DependencyTracker = Batch.DependencyTracker;
+	}
+
+	return true;
+}
+
+void FVoxelDistanceQueryCache::EndBatch(FBatch& Batch)
+{
+	for (const FIntVector& Key : Batch.Keys)
+	{
+		if (FCell* Cell = Cells.Find(Key))
+		{
+			Cell->bIsPending = false;
+		}
+	}
+
+	if (Batch.RuntimeInfo)
+	{
+		Batch.RuntimeInfo->Destroy();
+		Batch.RuntimeInfo.Reset();
+	}
+}
+
+void FVoxelDistanceQueryCache::OnBatchResult(const bool bSuccess)
+{
+	if (bSuccess)
+	{
+		RetryDelay = 0.;
+		NextRetryTime = 0.;
+		return;
+	}
+
+	RetryDelay = FMath::Clamp(2. * RetryDelay, 1., FMath::Max<double>(GVoxelDistanceQueryCacheMaxRetryDelay, 1.));
+	NextRetryTime = FPlatformTime::Seconds() + RetryDelay;
+}
+
+void FVoxelDistanceQueryCache::Trim()
+{
+	if (Cells.Num() <= MaxCachedCells)
+	{
+		return;
+	}
+
+	VOXEL_FUNCTION_COUNTER();
+
+	TVoxelArray<TPair<uint64, FIntVector>> LastUsedFrameToKey;
+	LastUsedFrameToKey.Reserve(Cells.Num());
+
+	for (const auto& It : Cells)
+	{
+		// Never evict pending cells, they are referenced by PendingCells
+		if (!It.Value.bIsPending)
+		{
+			LastUsedFrameToKey.Add({ It.Value.LastUsedFrame, It.Key });
+		}
+	}
+
+	LastUsedFrameToKey.Sort([](const TPair<uint64, FIntVector>& A, const TPair<uint64, FIntVector>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	const int32 NumToRemove = FMath::Min(Cells.Num() - MaxCachedCells, LastUsedFrameToKey.Num());
+	for (int32 Index = 0; Index < NumToRemove; Index++)
+	{
+		Cells.Remove(LastUsedFrameToKey[Index].Value);
+	}
+}
\ No newline at end of file
@@ -4,6 +4,34 @@
 #include "VoxelDependency.h"
 #include "VoxelTaskGroup.h"
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, bool, GVoxelDynamicValueCancelOutdatedComputes, true,
+	"voxel.DynamicValue.CancelOutdatedComputes",
+	"If true, dynamic values will cancel their in-flight computation when one of its dependencies is invalidated, instead of finishing it and then recomputing");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, int32, GVoxelDynamicValueMaxConsecutiveCancels, 4,
+	"voxel.DynamicValue.MaxConsecutiveCancels",
+	"Max number of times in a row a dynamic value computation can be cancelled. Past this, it is finished so that a value is still published during continuous edits");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, float, GVoxelDynamicValueMinRecomputeInterval, 0.f,
+	"voxel.DynamicValue.MinRecomputeInterval",
+	"Min time in seconds between two computations of the same dynamic value. Invalidations received in-between are coalesced into a single recompute");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, bool, GVoxelDynamicValueSkipUnchangedValues, true,
+	"voxel.DynamicValue.SkipUnchangedValues",
+	"If true, dynamic values will hash their new value and skip OnChanged if it's identical to the previous one. Only types implementing GetContentHash are deduplicated");
+
+DECLARE_VOXEL_FRAME_COUNTER(VOXELGRAPHCORE_API, STAT_VoxelNumDynamicValueComputesCancelled, "Num Dynamic Value Computes Cancelled");
+DECLARE_VOXEL_FRAME_COUNTER(VOXELGRAPHCORE_API, STAT_VoxelNumDynamicValueComputesDelayed, "Num Dynamic Value Computes Delayed");
+DECLARE_VOXEL_FRAME_COUNTER(VOXELGRAPHCORE_API, STAT_VoxelNumDynamicValueUpdatesSkipped, "Num Dynamic Value Updates Skipped");
+
+DEFINE_VOXEL_COUNTER(STAT_VoxelNumDynamicValueComputesCancelled);
+DEFINE_VOXEL_COUNTER(STAT_VoxelNumDynamicValueComputesDelayed);
+DEFINE_VOXEL_COUNTER(STAT_VoxelNumDynamicValueUpdatesSkipped);
+
 class VOXELGRAPHCORE_API FVoxelDynamicValueState final
 	: public FVoxelDynamicValueStateBase
 	, public TSharedFromThis<FVoxelDynamicValueState>
@@ -56,6 +84,13 @@ private:
 	TSharedPtr<FVoxelTaskGroup> Group;
 	TSharedPtr<FVoxelDependencyTracker> DependencyTracker;
 	int32 ValueCounter = 0;
+	// Incremented by every compute, used to discard the results of cancelled ones
+	int32 ComputeCounter = 0;
+	int32 NumConsecutiveCancels = 0;
+	double LastComputeTime = 0;
+	bool bIsComputeDelayed = false;
+	// Content hash of the last value sent to OnChanged, 0 if unknown
+	uint64 LastValueHash = 0;
 
 	class FOnChangedImpl : public TSharedFromThis<FOnChangedImpl>
 	{
@@ -79,9 +114,11 @@ private:
 	const TSharedRef<FOnChangedImpl> OnChangedImpl;
 
 	void Compute_RequiresLock_WillUnlock();
+	void CancelCompute(int32 ComputeIndex);
 	void OnComputed(
 		FVoxelRuntimePinValue NewValue,
-		const TSharedRef<FVoxelDependencyTracker>& NewDependencyTracker);
+		const TSharedRef<FVoxelDependencyTracker>& NewDependencyTracker,
+		int32 ComputeIndex);
 
 	friend class FVoxelDynamicValueFactoryBase;
 };
@@ -145,6 +182,43 @@ void FVoxelDynamicValueState::Compute_RequiresLock_WillUnlock()
 		State = EState::Outdated;
 	}
 
+	if (bIsComputeDelayed)
+	{
+		// Will be computed once the delay is elapsed
+		CriticalSection.Unlock();
+		return;
+	}
+
+	const double Time = FPlatformTime::Seconds();
+	const double Delay = LastComputeTime + GVoxelDynamicValueMinRecomputeInterval - Time;
+	if (State != EState::NotComputed &&
+		Delay > 0)
+	{
+		INC_VOXEL_COUNTER(STAT_VoxelNumDynamicValueComputesDelayed);
+
+		// Discard the results of any compute still in flight, the delayed compute will replace them
+		ComputeCounter++;
+		bIsComputeDelayed = true;
+		CriticalSection.Unlock();
+
+		FVoxelSystemUtilities::DelayedCall(MakeWeakPtrLambda(this, [this]
+		{
+			// Don't compute on the game thread, Group would be synchronous
+			AsyncVoxelTask(MakeWeakPtrLambda(this, [this]
+			{
+				CriticalSection.Lock();
+				ensure(bIsComputeDelayed);
+				bIsComputeDelayed = false;
+				LastComputeTime = 0;
+				Compute_RequiresLock_WillUnlock();
+			}));
+		}), Delay);
+		return;
+	}
+	LastComputeTime = Time;
+
+	const int32 ComputeIndex = ++ComputeCounter;
+
 	ensure(!Group);
 	if (Thread == EVoxelTaskThread::GameThread &&
 		IsInGameThread())
@@ -170,9 +244,16 @@ void FVoxelDynamicValueState::Compute_RequiresLock_WillUnlock()
 
 	MakeVoxelTask(STATIC_FNAME("FVoxelDynamicValueState_Setup"))
 	.Thread(Thread)
-	.Execute(MakeWeakPtrLambda(this, [this]
+	.Execute(MakeWeakPtrLambda(this, [this, ComputeIndex]
 	{
 		const TSharedRef<FVoxelDependencyTracker> NewDependencyTracker = FVoxelDependencyTracker::Create(Name);
+		if (GVoxelDynamicValueCancelOutdatedComputes)
+		{
+			ensure(NewDependencyTracker->TrySetOnInvalidatedWhileComputing(MakeWeakPtrLambda(this, [this, ComputeIndex]
+			{
+				CancelCompute(ComputeIndex);
+			})));
+		}
 		const FVoxelQuery Query = FVoxelQuery::Make(
 			Context,
 			Parameters,
@@ -187,9 +268,9 @@ void FVoxelDynamicValueState::Compute_RequiresLock_WillUnlock()
 		MakeVoxelTask(STATIC_FNAME("FVoxelDynamicValueState_Wait"))
 		.Thread(Thread)
 		.Dependency(FutureValue)
-		.Execute(MakeWeakPtrLambda(this, [this, NewDependencyTracker, FutureValue]
+		.Execute(MakeWeakPtrLambda(this, [this, NewDependencyTracker, FutureValue, ComputeIndex]
 		{
-			OnComputed(FutureValue.GetValue_CheckCompleted(), NewDependencyTracker);
+			OnComputed(FutureValue.GetValue_CheckCompleted(), NewDependencyTracker, ComputeIndex);
 		}));
 	}));
 
@@ -199,16 +280,57 @@ void FVoxelDynamicValueState::Compute_RequiresLock_WillUnlock()
 	}
 }
 
+void FVoxelDynamicValueState::CancelCompute(const int32 ComputeIndex)
+{
+	VOXEL_FUNCTION_COUNTER();
+	CriticalSection.Lock();
+
+	if (ComputeIndex != ComputeCounter ||
+		!Group ||
+		Group->bIsSynchronous ||
+		NumConsecutiveCancels >= GVoxelDynamicValueMaxConsecutiveCancels)
+	{
+		// Already done, or let it finish: it will be recomputed by OnComputed
+		CriticalSection.Unlock();
+		return;
+	}
+
+	INC_VOXEL_COUNTER(STAT_VoxelNumDynamicValueComputesCancelled);
+	NumConsecutiveCancels++;
+
+	// The recompute might be delayed: make sure a late OnComputed from the cancelled group is discarded
+	ComputeCounter++;
+
+	// Releasing the last reference to the group will make its tasks exit, see FVoxelTaskGroup::ShouldExit
+	// The group might be destroyed in-between, do it outside the lock
+	const TSharedPtr<FVoxelTaskGroup> GroupToCancel = MoveTemp(Group);
+	Compute_RequiresLock_WillUnlock();
+}
+
 void FVoxelDynamicValueState::OnComputed(
 	FVoxelRuntimePinValue NewValue,
-	const TSharedRef<FVoxelDependencyTracker>& NewDependencyTracker)
+	const TSharedRef<FVoxelDependencyTracker>& NewDependencyTracker,
+	const int32 ComputeIndex)
 {
 	VOXEL_FUNCTION_COUNTER();
+
+	// Hash outside of the lock, this can be expensive for big buffers
+	uint64 NewValueHash = GVoxelDynamicValueSkipUnchangedValues ? NewValue.GetContentHash() : 0;
+
 	CriticalSection.Lock();
 
+	if (ComputeIndex != ComputeCounter)
+	{
+		// Cancelled while finishing
+		CriticalSection.Unlock();
+		return;
+	}
+	NumConsecutiveCancels = 0;
+
 	if (!ensure(NewValue.GetType().CanBeCastedTo(Type)))
 	{
 		NewValue = FVoxelRuntimePinValue(Type);
+		NewValueHash = 0;
 	}
 
 	ensure(State != EState::UpToDate);
@@ -220,7 +342,17 @@ void FVoxelDynamicValueState::OnComputed(
 	ensure(!DependencyTracker);
 	DependencyTracker = NewDependencyTracker;
 
-	OnChangedImpl->Execute(NewValue, ValueCounter++);
+	if (NewValueHash != 0 &&
+		NewValueHash == LastValueHash)
+	{
+		// Same content as the value already sent, no need to update downstream
+		INC_VOXEL_COUNTER(STAT_VoxelNumDynamicValueUpdatesSkipped);
+	}
+	else
+	{
+		OnChangedImpl->Execute(NewValue, ValueCounter++);
+	}
+	LastValueHash = NewValueHash;
 
 	if (!DependencyTracker->TrySetOnInvalidated(MakeWeakPtrLambda(this,
 		[this]
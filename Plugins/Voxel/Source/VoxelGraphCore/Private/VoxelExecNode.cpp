@@ -1,8 +1,14 @@
 // Copyright Voxel Plugin, Inc. All Rights Reserved.
 
 #include "VoxelExecNode.h"
+#include "VoxelGraph.h"
 #include "VoxelRuntime.h"
+#include "VoxelRuntimeGraph.h"
+#include "VoxelParameterContainer.h"
 #include "VoxelExecNodeRuntimeWrapper.h"
+#include "Hash/CityHash.h"
+#include "UObject/GarbageCollection.h"
+#include "Serialization/ArchiveObjectCrc32.h"
 
 DEFINE_VOXEL_INSTANCE_COUNTER(FVoxelExecNodeRuntime);
 
@@ -73,6 +79,124 @@ USceneComponent* FVoxelExecNodeRuntime::GetRootComponent() const
 	return RootComponent;
 }
 
+uint64 FVoxelExecNodeRuntime::ComputePersistentHash() const
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(IsInGameThread());
+
+	const UVoxelGraph* Graph = GetNodeRef().GetGraph();
+	if (!Graph)
+	{
+		return 0;
+	}
+
+	// Text exports are stable across sessions, unlike pointers & FName indices
+	FString Text = GetGraphPath() + TEXT(" ") + GetNodeRef().NodeId.ToString() + TEXT(" ");
+
+	FVoxelRuntimeGraphData::StaticStruct()->ExportText(
+		Text,
+		&Graph->GetRuntimeGraph().GetData(),
+		nullptr,
+		nullptr,
+		PPF_None,
+		nullptr);
+
+	TVoxelArray<UObject*> Roots;
+	Roots.Add(ConstCast(Graph));
+
+	if (const UObject* Instance = GetInstance().Get())
+	{
+		TArray<UObject*> Subobjects;
+		GetObjectsWithOuter(Instance, Subobjects, false);
+
+		for (UObject* Subobject : Subobjects)
+		{
+			if (!Subobject->IsA<UVoxelParameterContainer>())
+			{
+				continue;
+			}
+			Roots.Add(Subobject);
+
+			for (const FProperty& Property : GetClassProperties(Subobject->GetClass()))
+			{
+				if (Property.HasAnyPropertyFlags(CPF_Transient))
+				{
+					continue;
+				}
+
+				Text += Property.GetName();
+				Property.ExportText_InContainer(0, Text, Subobject, nullptr, nullptr, PPF_None);
+			}
+		}
+	}
+
+	// Asset paths don't change when the assets are edited: also hash the content of the assets referenced
+	// by the graph & its parameters, eg heightmaps, function graphs or curves, and recursively of the assets they reference
+	{
+		VOXEL_SCOPE_COUNTER("Hash referenced assets");
+
+		TVoxelSet<UObject*> VisitedObjects;
+		VisitedObjects.Append(Roots);
+
+		TVoxelArray<UObject*> ObjectsToVisit = Roots;
+		TVoxelArray<UObject*> Assets;
+		while (ObjectsToVisit.Num() > 0)
+		{
+			UObject* Object = ObjectsToVisit.Pop(false);
+
+			TArray<UObject*> References;
+			FReferenceFinder ReferenceFinder(References);
+			ReferenceFinder.FindReferences(Object);
+
+			for (UObject* Reference : References)
+			{
+				if (!Reference ||
+					VisitedObjects.Contains(Reference))
+				{
+					continue;
+				}
+
+				const UPackage* Package = Reference->GetOutermost();
+				if (Package == GetTransientPackage() ||
+					Package->HasAnyPackageFlags(PKG_CompiledIn) ||
+					// Don't walk into levels through actor references
+					Package->ContainsMap())
+				{
+					continue;
+				}
+
+				VisitedObjects.Add(Reference);
+				ObjectsToVisit.Add(Reference);
+
+				if (Reference->IsAsset())
+				{
+					Assets.Add(Reference);
+				}
+			}
+		}
+
+		Assets.Sort([](const UObject& A, const UObject& B)
+		{
+			return A.GetPathName() < B.GetPathName();
+		});
+
+		for (UObject* Asset : Assets)
+		{
+			// Serialized properties only: stable across sessions
+			Text += FString::Printf(TEXT(" %s %08x"), *Asset->GetPathName(), FArchiveObjectCrc32().Crc32(Asset));
+		}
+	}
+
+	if (const USceneComponent* RootComponent = PrivateContext->RuntimeInfo->GetRootComponent())
+	{
+		Text += RootComponent->GetComponentTransform().ToString();
+	}
+
+	return FMath::Max<uint64>(CityHash64(
+		reinterpret_cast<const char*>(*Text),
+		Text.Len() * sizeof(TCHAR)), 1);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
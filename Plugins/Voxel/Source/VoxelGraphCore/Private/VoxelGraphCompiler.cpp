@@ -15,6 +15,11 @@
 #include "Preview/VoxelPreviewNode.h"
 #include "FunctionLibrary/VoxelBasicFunctionLibrary.h"
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, bool, GVoxelGraphRemoveDuplicatedNodes, true,
+	"voxel.graph.RemoveDuplicatedNodes",
+	"If true, identical pure nodes with identical inputs will be merged when compiling graphs");
+
 TSharedPtr<Voxel::Graph::FGraph> FVoxelGraphCompiler::TranslateRuntimeGraph(const UVoxelRuntimeGraph& RuntimeGraph)
 {
 	VOXEL_FUNCTION_COUNTER();
@@ -1153,6 +1158,205 @@ void FVoxelGraphCompiler::CheckForLoops(FGraph& Graph)
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+void FVoxelGraphCompiler::RemoveDuplicatedNodes(FGraph& Graph, const UVoxelGraph& VoxelGraph)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (!GVoxelGraphRemoveDuplicatedNodes)
+	{
+		return;
+	}
+
+	// Sort nodes so that the inputs of a node are always deduplicated before the node itself
+	// Needs to run after CheckForLoops
+	TVoxelArray<FNode*> SortedNodes;
+	{
+		VOXEL_SCOPE_COUNTER("Sort nodes");
+
+		TVoxelMap<const FNode*, int32> NodeToNumLinkedInputs;
+		NodeToNumLinkedInputs.Reserve(Graph.GetNodes().Num());
+		SortedNodes.Reserve(Graph.GetNodes().Num());
+
+		for (FNode& Node : Graph.GetNodes())
+		{
+			int32 NumLinkedInputs = 0;
+			for (const FPin& Pin : Node.GetInputPins())
+			{
+				NumLinkedInputs += Pin.GetLinkedTo().Num();
+			}
+
+			if (NumLinkedInputs == 0)
+			{
+				SortedNodes.Add(&Node);
+			}
+			NodeToNumLinkedInputs.Add(&Node, NumLinkedInputs);
+		}
+
+		for (int32 Index = 0; Index < SortedNodes.Num(); Index++)
+		{
+			for (const FPin& Pin : SortedNodes[Index]->GetOutputPins())
+			{
+				for (FPin& LinkedTo : Pin.GetLinkedTo())
+				{
+					int32& NumLinkedInputs = NodeToNumLinkedInputs[&LinkedTo.Node];
+					ensure(NumLinkedInputs > 0);
+
+					if (--NumLinkedInputs == 0)
+					{
+						SortedNodes.Add(&LinkedTo.Node);
+					}
+				}
+			}
+		}
+
+		if (!ensure(SortedNodes.Num() == Graph.GetNodes().Num()))
+		{
+			return;
+		}
+	}
+
+	const auto CanBeDeduplicated = [](const FNode& Node)
+	{
+		if (Node.Type != ENodeType::Struct ||
+			!Node.GetVoxelNode().IsPureNode())
+		{
+			return false;
+		}
+
+		for (const FPin& Pin : Node.GetInputPins())
+		{
+			// Virtual pins create their own executors from the node ref, don't touch these
+			const TSharedPtr<const FVoxelPin> VoxelPin = Node.GetVoxelNode().FindPin(Pin.Name);
+			if (!ensure(VoxelPin) ||
+				VoxelPin->Metadata.bVirtualPin)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	const auto GetNodeHash = [](const FNode& Node)
+	{
+		uint32 Hash = Node.GetVoxelNode().GetNodeHash();
+		for (const FPin& Pin : Node.GetInputPins())
+		{
+			Hash = HashCombine(Hash, GetTypeHash(Pin.Name));
+
+			if (Pin.GetLinkedTo().Num() == 0)
+			{
+				Hash = HashCombine(Hash, GetTypeHash(Pin.GetDefaultValue()));
+				continue;
+			}
+
+			for (const FPin& LinkedTo : Pin.GetLinkedTo())
+			{
+				Hash = HashCombine(Hash, GetTypeHash(&LinkedTo));
+			}
+		}
+		return Hash;
+	};
+
+	const auto AreNodesIdentical = [](const FNode& NodeA, const FNode& NodeB)
+	{
+		if (NodeA.GetInputPins().Num() != NodeB.GetInputPins().Num() ||
+			NodeA.GetOutputPins().Num() != NodeB.GetOutputPins().Num() ||
+			!NodeA.GetVoxelNode().IsNodeIdentical(NodeB.GetVoxelNode()))
+		{
+			return false;
+		}
+
+		for (const FPin& PinA : NodeA.GetInputPins())
+		{
+			const FPin* PinB = NodeB.FindInput(PinA.Name);
+			if (!PinB ||
+				PinA.Type != PinB->Type ||
+				PinA.GetLinkedTo().Num() != PinB->GetLinkedTo().Num())
+			{
+				return false;
+			}
+
+			if (PinA.GetLinkedTo().Num() == 0)
+			{
+				if (PinA.GetDefaultValue() != PinB->GetDefaultValue())
+				{
+					return false;
+				}
+				continue;
+			}
+
+			for (int32 Index = 0; Index < PinA.GetLinkedTo().Num(); Index++)
+			{
+				// Inputs are already deduplicated, so comparing pointers is enough
+				if (&PinA.GetLinkedTo()[Index] != &PinB->GetLinkedTo()[Index])
+				{
+					return false;
+				}
+			}
+		}
+
+		for (const FPin& PinA : NodeA.GetOutputPins())
+		{
+			const FPin* PinB = NodeB.FindOutput(PinA.Name);
+			if (!PinB ||
+				PinA.Type != PinB->Type)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	int32 NumRemovedNodes = 0;
+	TVoxelMap<uint32, TVoxelArray<FNode*, TVoxelInlineAllocator<1>>> HashToNodes;
+	HashToNodes.Reserve(SortedNodes.Num());
+
+	for (FNode* Node : SortedNodes)
+	{
+		if (!CanBeDeduplicated(*Node))
+		{
+			continue;
+		}
+
+		TVoxelArray<FNode*, TVoxelInlineAllocator<1>>& Candidates = HashToNodes.FindOrAdd(GetNodeHash(*Node));
+
+		FNode* ExistingNode = nullptr;
+		for (FNode* Candidate : Candidates)
+		{
+			if (AreNodesIdentical(*Candidate, *Node))
+			{
+				ExistingNode = Candidate;
+				break;
+			}
+		}
+
+		if (!ExistingNode)
+		{
+			Candidates.Add(Node);
+			continue;
+		}
+
+		for (const FPin& OutputPin : Node->GetOutputPins())
+		{
+			OutputPin.CopyOutputPinTo(ExistingNode->FindOutputChecked(OutputPin.Name));
+		}
+
+		Graph.RemoveNode(*Node);
+		NumRemovedNodes++;
+	}
+
+	if (NumRemovedNodes > 0)
+	{
+		LOG_VOXEL(Log, "%s: %d duplicated nodes removed", *VoxelGraph.GetPathName(), NumRemovedNodes);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 bool FVoxelGraphCompiler::ReplaceTemplatesImpl(FGraph& Graph)
 {
 	VOXEL_FUNCTION_COUNTER();
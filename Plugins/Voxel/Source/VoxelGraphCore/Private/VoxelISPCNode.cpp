@@ -4,6 +4,46 @@
 #include "VoxelISPCNodeImpl.h"
 #include "VoxelBuffer.h"
 #include "VoxelQueryCache.h"
+#include "VoxelPositionQueryParameter.h"
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, bool, GVoxelFuseISPCNodes, true,
+	"voxel.graph.FuseISPCNodes",
+	"If true, chains of ISPC nodes will be run in a single task without allocating intermediate buffers");
+
+struct FVoxelISPCNode::FFusedContext
+{
+	struct FSlot
+	{
+		// Set for inputs and for the outputs of the root node
+		const FVoxelSimpleTerminalBuffer* Buffer = nullptr;
+		// Set for the outputs of fused nodes
+		int32 ScratchOffset = -1;
+		bool bIsConstant = false;
+	};
+	struct FKernel
+	{
+		const FVoxelISPCNode* Node = nullptr;
+		bool bIsConstant = false;
+		TVoxelArray<int32, TVoxelInlineAllocator<16>> Slots;
+	};
+
+	int32 Num = 0;
+	int32 InputIndex = 0;
+	TConstVoxelArrayView<FVoxelFutureValue> InputValues;
+
+	TVoxelArray<FSlot> Slots;
+	// Sorted so that kernels always run after the kernels they depend on
+	TVoxelArray<FKernel, TVoxelInlineAllocator<8>> Kernels;
+	TVoxelArray<TSharedRef<FVoxelBuffer>, TVoxelInlineAllocator<8>> ConstantInputBuffers;
+
+	int32 ChunkScratchSize = 0;
+	int32 ConstantScratchSize = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
 
 void FVoxelISPCNode::PreCompile()
 {
@@ -45,15 +85,17 @@ FVoxelComputeValue FVoxelISPCNode::CompileCompute(const FName ReturnPinName) con
 
 		using FAllocatorType = TVoxelInlineAllocator<16>;
 
+		// Intermediate values are needed to propagate gradients, don't fuse
+		const TSharedPtr<const FVoxelAnalyticGradientQueryParameter> GradientQueryParameter = Query.GetParameters().FindShared<FVoxelAnalyticGradientQueryParameter>();
+		const bool bFuse = bHasFusedInputs && !GradientQueryParameter;
+
 		TVoxelArray<FVoxelFutureValue, FAllocatorType> InputValues;
+		GatherInputs(Query, bFuse, InputValues);
+
 		TVoxelArray<TSharedRef<FVoxelFutureValueStateImpl>, FAllocatorType> OutputStates;
 		for (const FCachedPin& CachedPin : CachedPins)
 		{
-			if (CachedPin.bIsInput)
-			{
-				InputValues.Add(GetNodeRuntime().Get(FVoxelPinRef(CachedPin.Name), Query));
-			}
-			else
+			if (!CachedPin.bIsInput)
 			{
 				FVoxelQueryCache::FEntry& Entry = Query.GetQueryCache().FindOrAddEntry(CachedPin.PinId);
 				VOXEL_SCOPE_LOCK(Entry.CriticalSection);
@@ -115,6 +157,12 @@ FVoxelComputeValue FVoxelISPCNode::CompileCompute(const FName ReturnPinName) con
 				return;
 			}
 
+			if (bFuse)
+			{
+				ExecuteFused(Num, InputValues, OutputStates);
+				return;
+			}
+
 			TVoxelArray<TSharedRef<FVoxelBuffer>, FAllocatorType> InputBuffers;
 			TVoxelArray<TSharedRef<FVoxelBuffer>, FAllocatorType> OutputBuffers;
 			InputBuffers.Reserve(CachedPins.Num());
@@ -190,6 +238,11 @@ FVoxelComputeValue FVoxelISPCNode::CompileCompute(const FName ReturnPinName) con
 				});
 			}
 
+			if (GradientQueryParameter)
+			{
+				PropagateGradients(*GradientQueryParameter, Num, Buffers);
+			}
+
 			check(OutputStates.Num() == OutputBuffers.Num());
 			for (int32 Index = 0; Index < OutputStates.Num(); Index++)
 			{
@@ -216,4 +269,562 @@ FVoxelComputeValue FVoxelISPCNode::CompileCompute(const FName ReturnPinName) con
 		ensure(Entry.Value.IsValid());
 		return Entry.Value;
 	};
-}
\ No newline at end of file
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelISPCNode::FuseInput(const FName PinName, const TSharedRef<FVoxelISPCNode>& InputNode)
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(IsInGameThread());
+
+	FCachedPin* CachedPin = CachedPins.FindByPredicate([&](const FCachedPin& Pin)
+	{
+		return Pin.Name == PinName;
+	});
+
+	if (!ensure(CachedPin) ||
+		!ensure(CachedPin->bIsInput) ||
+		!ensure(!CachedPin->FusedNode) ||
+		!ensure(&InputNode.Get() != this))
+	{
+		return;
+	}
+
+	int32 NumOutputPins = 0;
+	for (FCachedPin& InputNodePin : InputNode->CachedPins)
+	{
+		if (InputNodePin.bIsInput)
+		{
+			continue;
+		}
+		NumOutputPins++;
+
+		// Cache the terminal types sizes to be able to allocate scratch memory without creating buffers
+		InputNodePin.TerminalTypeSizes.Reset();
+
+		const TSharedRef<FVoxelBuffer> Buffer = FVoxelBuffer::Make(InputNodePin.PinType.GetInnerType());
+		for (const FVoxelTerminalBuffer& TerminalBuffer : Buffer->GetTerminalBuffers())
+		{
+			InputNodePin.TerminalTypeSizes.Add(CastChecked<FVoxelSimpleTerminalBuffer>(TerminalBuffer).MakeNewStorage()->GetTypeSize());
+		}
+	}
+
+	if (!ensure(NumOutputPins == 1))
+	{
+		return;
+	}
+
+	CachedPin->FusedNode = InputNode;
+	bHasFusedInputs = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelISPCNode::GatherInputs(
+	const FVoxelQuery& Query,
+	const bool bFuse,
+	TVoxelArray<FVoxelFutureValue, TVoxelInlineAllocator<16>>& OutInputValues) const
+{
+	for (const FCachedPin& CachedPin : CachedPins)
+	{
+		if (!CachedPin.bIsInput)
+		{
+			continue;
+		}
+
+		if (bFuse &&
+			CachedPin.FusedNode)
+		{
+			CachedPin.FusedNode->GatherInputs(Query, true, OutInputValues);
+			continue;
+		}
+
+		OutInputValues.Add(GetNodeRuntime().Get(FVoxelPinRef(CachedPin.Name), Query));
+	}
+}
+
+void FVoxelISPCNode::PropagateGradients(
+	const FVoxelAnalyticGradientQueryParameter& GradientQueryParameter,
+	const int32 Num,
+	const TConstVoxelArrayView<const FVoxelBuffer*> Buffers) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	FPartialDerivatives Derivatives(*this, Num, Buffers);
+	if (!ComputePartialDerivatives(Derivatives))
+	{
+		return;
+	}
+
+	// Float outputs without any term have a zero gradient
+	TVoxelArray<const FVoxelFloatBuffer*, TVoxelInlineAllocator<4>> Outputs;
+	for (int32 Index = 0; Index < CachedPins.Num(); Index++)
+	{
+		if (!CachedPins[Index].bIsInput &&
+			Buffers[Index]->IsA<FVoxelFloatBuffer>())
+		{
+			Outputs.Add(static_cast<const FVoxelFloatBuffer*>(Buffers[Index]));
+		}
+	}
+	for (const FPartialDerivatives::FTerm& Term : Derivatives.Terms)
+	{
+		Outputs.AddUnique(Term.Output);
+	}
+
+	for (const FVoxelFloatBuffer* Output : Outputs)
+	{
+		struct FGradientTerm
+		{
+			const FVoxelFloatBuffer* Derivative = nullptr;
+			FVoxelVectorBuffer InputGradient;
+		};
+		TVoxelArray<FGradientTerm, TVoxelInlineAllocator<6>> GradientTerms;
+
+		bool bIsValid = true;
+		for (const FPartialDerivatives::FTerm& Term : Derivatives.Terms)
+		{
+			if (Term.Output != Output)
+			{
+				continue;
+			}
+
+			FVoxelVectorBuffer InputGradient;
+			if (!GradientQueryParameter.FindGradient(*Term.Input, InputGradient))
+			{
+				bIsValid = false;
+				break;
+			}
+
+			if (InputGradient.IsConstant() &&
+				InputGradient[0] == FVector3f::ZeroVector)
+			{
+				continue;
+			}
+
+			GradientTerms.Add(FGradientTerm
+			{
+				&Term.Derivative,
+				InputGradient
+			});
+		}
+
+		if (!bIsValid)
+		{
+			continue;
+		}
+
+		if (GradientTerms.Num() == 0)
+		{
+			GradientQueryParameter.AddGradient(*Output, FVoxelVectorBuffer::Make(FVector3f::ZeroVector));
+			continue;
+		}
+
+		if (GradientTerms.Num() == 1 &&
+			GradientTerms[0].Derivative->IsConstant() &&
+			GradientTerms[0].Derivative->GetConstant() == 1.f)
+		{
+			// Passthrough, typically adding a constant
+			GradientQueryParameter.AddGradient(*Output, GradientTerms[0].InputGradient);
+			continue;
+		}
+
+		FVoxelFloatBufferStorage X; X.Allocate(Num);
+		FVoxelFloatBufferStorage Y; Y.Allocate(Num);
+		FVoxelFloatBufferStorage Z; Z.Allocate(Num);
+
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			FVector3f Gradient = FVector3f::ZeroVector;
+			for (const FGradientTerm& GradientTerm : GradientTerms)
+			{
+				Gradient += (*GradientTerm.Derivative)[Index] * GradientTerm.InputGradient[Index];
+			}
+
+			X[Index] = Gradient.X;
+			Y[Index] = Gradient.Y;
+			Z[Index] = Gradient.Z;
+		}
+
+		GradientQueryParameter.AddGradient(*Output, FVoxelVectorBuffer::Make(X, Y, Z));
+	}
+}
+
+void FVoxelISPCNode::ExecuteFused(
+	const int32 Num,
+	const TConstVoxelArrayView<FVoxelFutureValue> InputValues,
+	const TConstVoxelArrayView<TSharedRef<FVoxelFutureValueStateImpl>> OutputStates) const
+{
+	FFusedContext Context;
+	Context.Num = Num;
+	Context.InputValues = InputValues;
+
+	TVoxelArray<TSharedRef<FVoxelBuffer>, TVoxelInlineAllocator<4>> OutputBuffers;
+	AddFusedKernel(Context, &OutputBuffers);
+	check(Context.InputIndex == InputValues.Num());
+
+	using FISPCBuffers = TVoxelArray<ispc::FVoxelBuffer, TVoxelInlineAllocator<16>>;
+
+	const auto GetISPCBuffers = [&](
+		const FFusedContext::FKernel& Kernel,
+		const FVoxelBufferIterator& Iterator,
+		uint8* ChunkScratch,
+		uint8* ConstantScratch,
+		FISPCBuffers& OutBuffers)
+	{
+		OutBuffers.Reset();
+		for (const int32 SlotIndex : Kernel.Slots)
+		{
+			const FFusedContext::FSlot& Slot = Context.Slots[SlotIndex];
+
+			ispc::FVoxelBuffer& ISPCBuffer = OutBuffers.Emplace_GetRef();
+			if (Slot.Buffer)
+			{
+				check(Slot.Buffer->IsConstant() || Slot.Buffer->Num() == Num);
+				ISPCBuffer.Data = ConstCast(Slot.Buffer->GetStorage().GetByteData(Iterator));
+				ISPCBuffer.bIsConstant = Slot.Buffer->Num() == 1;
+			}
+			else
+			{
+				checkVoxelSlow(Slot.ScratchOffset != -1);
+				ISPCBuffer.Data = (Slot.bIsConstant ? ConstantScratch : ChunkScratch) + Slot.ScratchOffset;
+				ISPCBuffer.bIsConstant = Slot.bIsConstant;
+			}
+		}
+	};
+
+	{
+		VOXEL_SCOPE_COUNTER_FORMAT("%s Num=%d NumFused=%d", *GetStruct()->GetName(), Num, Context.Kernels.Num());
+		FVoxelNodeStatScope StatScope(*this, Num);
+
+		// Fused nodes don't have their own stat scope: when sampled, time each kernel to attribute it to its node
+		TVoxelArray<int64, TVoxelInlineAllocator<8>> KernelCycles;
+		if (StatScope.IsEnabled())
+		{
+			KernelCycles.SetNumZeroed(Context.Kernels.Num());
+		}
+
+		const auto RunKernel = [&](const int32 KernelIndex, const ispc::FVoxelBuffer* Buffers, const int32 NumToProcess)
+		{
+			const FFusedContext::FKernel& Kernel = Context.Kernels[KernelIndex];
+			if (KernelCycles.Num() == 0)
+			{
+				(*Kernel.Node->CachedPtr)(Buffers, NumToProcess);
+				return;
+			}
+
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			(*Kernel.Node->CachedPtr)(Buffers, NumToProcess);
+			FPlatformAtomics::InterlockedAdd(&KernelCycles[KernelIndex], int64(FPlatformTime::Cycles64() - StartCycles));
+		};
+
+		uint8* ConstantScratch = nullptr;
+		if (Context.ConstantScratchSize > 0)
+		{
+			ConstantScratch = static_cast<uint8*>(FVoxelMemory::Malloc(Context.ConstantScratchSize, FVoxelBufferDefinitions::Alignment));
+		}
+		ON_SCOPE_EXIT
+		{
+			if (ConstantScratch)
+			{
+				FVoxelMemory::Free(ConstantScratch);
+			}
+		};
+
+		// Constant kernels only need to run once
+		{
+			FVoxelBufferIterator Iterator;
+			Iterator.Initialize(1, 0);
+
+			FISPCBuffers ISPCBuffers;
+			for (int32 KernelIndex = 0; KernelIndex < Context.Kernels.Num(); KernelIndex++)
+			{
+				const FFusedContext::FKernel& Kernel = Context.Kernels[KernelIndex];
+				if (!Kernel.bIsConstant)
+				{
+					continue;
+				}
+
+				GetISPCBuffers(Kernel, Iterator, nullptr, ConstantScratch, ISPCBuffers);
+				RunKernel(KernelIndex, ISPCBuffers.GetData(), 1);
+			}
+		}
+
+		const auto ProcessChunk = [&](const FVoxelBufferIterator& Iterator, uint8* ChunkScratch)
+		{
+			FISPCBuffers ISPCBuffers;
+			for (int32 KernelIndex = 0; KernelIndex < Context.Kernels.Num(); KernelIndex++)
+			{
+				const FFusedContext::FKernel& Kernel = Context.Kernels[KernelIndex];
+				if (Kernel.bIsConstant)
+				{
+					continue;
+				}
+
+				GetISPCBuffers(Kernel, Iterator, ChunkScratch, ConstantScratch, ISPCBuffers);
+				RunKernel(KernelIndex, ISPCBuffers.GetData(), Iterator.Num());
+			}
+		};
+
+		// Scratch is allocated once: a single slice reused by every chunk when running serially,
+		// one slice per chunk when running in parallel
+		const bool bParallel = ShouldRunVoxelTaskInParallel();
+		const int32 NumChunks = FVoxelUtilities::DivideCeil_Positive(Num, FVoxelBufferDefinitions::NumPerChunk);
+		const int32 NumScratchSlices = bParallel ? NumChunks : 1;
+
+		uint8* ChunkScratch = nullptr;
+		if (Context.ChunkScratchSize > 0)
+		{
+			ChunkScratch = static_cast<uint8*>(FVoxelMemory::Malloc(int64(Context.ChunkScratchSize) * NumScratchSlices, FVoxelBufferDefinitions::Alignment));
+		}
+		ON_SCOPE_EXIT
+		{
+			if (ChunkScratch)
+			{
+				FVoxelMemory::Free(ChunkScratch);
+			}
+		};
+
+		if (bParallel)
+		{
+			ParallelFor(NumChunks, [&](const int32 ChunkIndex)
+			{
+				FVoxelBufferIterator Iterator;
+				Iterator.Initialize(Num, ChunkIndex * FVoxelBufferDefinitions::NumPerChunk);
+				ProcessChunk(Iterator, ChunkScratch ? ChunkScratch + int64(ChunkIndex) * Context.ChunkScratchSize : nullptr);
+			});
+		}
+		else
+		{
+			for (const FVoxelBufferIterator& Iterator : MakeVoxelBufferIterator(Num))
+			{
+				ProcessChunk(Iterator, ChunkScratch);
+			}
+		}
+
+		for (int32 KernelIndex = 0; KernelIndex < KernelCycles.Num(); KernelIndex++)
+		{
+			const FFusedContext::FKernel& Kernel = Context.Kernels[KernelIndex];
+			if (Kernel.Node == this)
+			{
+				// Recorded by StatScope, along with the overhead of the fused task
+				continue;
+			}
+
+			StatScope.RecordOtherNode(
+				*Kernel.Node,
+				FPlatformTime::ToSeconds64(KernelCycles[KernelIndex]),
+				Kernel.bIsConstant ? 1 : Num);
+		}
+	}
+
+	check(OutputStates.Num() == OutputBuffers.Num());
+	for (int32 Index = 0; Index < OutputStates.Num(); Index++)
+	{
+		const TSharedRef<FVoxelFutureValueStateImpl>& State = OutputStates[Index];
+		const TSharedRef<FVoxelBuffer>& Buffer = OutputBuffers[Index];
+		const FVoxelPinType& Type = State->Type;
+
+		Buffer->CheckSlow();
+
+		if (Type.IsBuffer())
+		{
+			State->SetValue(FVoxelRuntimePinValue::Make(Buffer, Type));
+		}
+		else
+		{
+			checkVoxelSlow(Buffer->Num() == 1);
+			State->SetValue(Buffer->GetGenericConstant().WithType(Type));
+		}
+	}
+}
+
+TVoxelArray<int32, TVoxelInlineAllocator<4>> FVoxelISPCNode::AddFusedKernel(
+	FFusedContext& Context,
+	TVoxelArray<TSharedRef<FVoxelBuffer>, TVoxelInlineAllocator<4>>* OutOutputBuffers) const
+{
+	checkVoxelSlow(CachedPtr);
+
+	// Inputs first, as we need to know if this kernel is constant to allocate its outputs
+	TVoxelArray<TVoxelArray<int32, TVoxelInlineAllocator<4>>, TVoxelInlineAllocator<16>> PinToSlots;
+	PinToSlots.SetNum(CachedPins.Num());
+
+	bool bIsConstant = true;
+	for (int32 PinIndex = 0; PinIndex < CachedPins.Num(); PinIndex++)
+	{
+		const FCachedPin& CachedPin = CachedPins[PinIndex];
+		if (!CachedPin.bIsInput)
+		{
+			continue;
+		}
+
+		if (CachedPin.FusedNode)
+		{
+			PinToSlots[PinIndex] = CachedPin.FusedNode->AddFusedKernel(Context, nullptr);
+		}
+		else
+		{
+			const FVoxelRuntimePinValue& Value = Context.InputValues[Context.InputIndex++].GetValue_CheckCompleted();
+			checkVoxelSlow(Value.GetType().CanBeCastedTo(CachedPin.PinType));
+
+			const FVoxelBuffer* Buffer;
+			if (CachedPin.PinType.IsBuffer())
+			{
+				Buffer = &Value.Get<FVoxelBuffer>();
+			}
+			else
+			{
+				const TSharedRef<FVoxelBuffer> InputBuffer = FVoxelBuffer::Make(CachedPin.PinType);
+				InputBuffer->InitializeFromConstant(Value);
+				Context.ConstantInputBuffers.Add(InputBuffer);
+				Buffer = &InputBuffer.Get();
+			}
+
+			for (const FVoxelTerminalBuffer& TerminalBuffer : Buffer->GetTerminalBuffers())
+			{
+				FFusedContext::FSlot Slot;
+				Slot.Buffer = &CastChecked<FVoxelSimpleTerminalBuffer>(TerminalBuffer);
+				Slot.bIsConstant = Slot.Buffer->Num() == 1;
+				PinToSlots[PinIndex].Add(Context.Slots.Add(Slot));
+			}
+		}
+
+		for (const int32 SlotIndex : PinToSlots[PinIndex])
+		{
+			bIsConstant &= Context.Slots[SlotIndex].bIsConstant;
+		}
+	}
+
+	TVoxelArray<int32, TVoxelInlineAllocator<4>> OutputSlots;
+	for (int32 PinIndex = 0; PinIndex < CachedPins.Num(); PinIndex++)
+	{
+		const FCachedPin& CachedPin = CachedPins[PinIndex];
+		if (CachedPin.bIsInput)
+		{
+			continue;
+		}
+
+		if (OutOutputBuffers)
+		{
+			// Root node: write to actual buffers
+			const TSharedRef<FVoxelBuffer> OutputBuffer = FVoxelBuffer::Make(CachedPin.PinType.GetInnerType());
+			for (FVoxelTerminalBuffer& TerminalBuffer : OutputBuffer->GetTerminalBuffers())
+			{
+				FVoxelSimpleTerminalBuffer& SimpleBuffer = CastChecked<FVoxelSimpleTerminalBuffer>(TerminalBuffer);
+				const TSharedRef<FVoxelBufferStorage> Storage = SimpleBuffer.MakeNewStorage();
+				Storage->Allocate(Context.Num);
+				SimpleBuffer.SetStorage(Storage);
+
+				FFusedContext::FSlot Slot;
+				Slot.Buffer = &SimpleBuffer;
+				Slot.bIsConstant = Context.Num == 1;
+				PinToSlots[PinIndex].Add(Context.Slots.Add(Slot));
+			}
+			OutOutputBuffers->Add(OutputBuffer);
+			continue;
+		}
+
+		// Fused node: write to scratch
+		ensure(CachedPin.TerminalTypeSizes.Num() > 0);
+		for (const int32 TypeSize : CachedPin.TerminalTypeSizes)
+		{
+			FFusedContext::FSlot Slot;
+			Slot.bIsConstant = bIsConstant;
+
+			if (bIsConstant)
+			{
+				Slot.ScratchOffset = Context.ConstantScratchSize;
+				Context.ConstantScratchSize += Align(FVoxelBufferDefinitions::MaxISPCWidth * TypeSize, FVoxelBufferDefinitions::Alignment);
+			}
+			else
+			{
+				Slot.ScratchOffset = Context.ChunkScratchSize;
+				Context.ChunkScratchSize += FVoxelBufferDefinitions::NumPerChunk * TypeSize;
+			}
+
+			const int32 SlotIndex = Context.Slots.Add(Slot);
+			PinToSlots[PinIndex].Add(SlotIndex);
+			OutputSlots.Add(SlotIndex);
+		}
+	}
+
+	FFusedContext::FKernel& Kernel = Context.Kernels.Emplace_GetRef();
+	Kernel.Node = this;
+	Kernel.bIsConstant = bIsConstant;
+	for (const TVoxelArray<int32, TVoxelInlineAllocator<4>>& Slots : PinToSlots)
+	{
+		Kernel.Slots.Append(Slots);
+	}
+
+	return OutputSlots;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+const FVoxelBuffer& FVoxelISPCNode::FPartialDerivatives::GetBuffer(const FName PinName) const
+{
+	const int32 Index = Node.CachedPins.IndexOfByPredicate([&](const FCachedPin& CachedPin)
+	{
+		return CachedPin.Name == PinName;
+	});
+	check(Node.CachedPins.IsValidIndex(Index));
+	return *Buffers[Index];
+}
+
+void FVoxelISPCNode::FPartialDerivatives::RunKernel(
+	const FVoxelNodeISPCPtr Kernel,
+	const TConstVoxelArrayView<FName> InputPins,
+	const TVoxelArrayView<FVoxelFloatBufferStorage> Outputs) const
+{
+	VOXEL_SCOPE_COUNTER_FORMAT("%s Derivatives Num=%d", *Node.GetStruct()->GetName(), Num);
+
+	for (FVoxelFloatBufferStorage& Output : Outputs)
+	{
+		Output.Allocate(Num);
+	}
+
+	ForeachVoxelBufferChunk(Num, [&](const FVoxelBufferIterator& Iterator)
+	{
+		TVoxelArray<ispc::FVoxelBuffer, TVoxelInlineAllocator<16>> ISPCBuffers;
+		for (const FName PinName : InputPins)
+		{
+			for (const FVoxelTerminalBuffer& TerminalBuffer : GetBuffer(PinName).GetTerminalBuffers())
+			{
+				const FVoxelSimpleTerminalBuffer& SimpleTerminalBuffer = CastChecked<FVoxelSimpleTerminalBuffer>(TerminalBuffer);
+
+				ispc::FVoxelBuffer& ISPCBuffer = ISPCBuffers.Emplace_GetRef();
+				ISPCBuffer.Data = ConstCast(SimpleTerminalBuffer.GetStorage().GetByteData(Iterator));
+				ISPCBuffer.bIsConstant = SimpleTerminalBuffer.IsConstant();
+			}
+		}
+		for (FVoxelFloatBufferStorage& Output : Outputs)
+		{
+			ispc::FVoxelBuffer& ISPCBuffer = ISPCBuffers.Emplace_GetRef();
+			ISPCBuffer.Data = Output.GetData(Iterator);
+			ISPCBuffer.bIsConstant = false;
+		}
+
+		(*Kernel)(ISPCBuffers.GetData(), Iterator.Num());
+	});
+}
+
+void FVoxelISPCNode::FPartialDerivatives::Add(
+	const FVoxelFloatBuffer& Output,
+	const FVoxelFloatBuffer& Input,
+	const FVoxelFloatBuffer& Derivative)
+{
+	checkVoxelSlow(Derivative.IsConstant() || Derivative.Num() == Num);
+
+	Terms.Add(FTerm
+	{
+		&Output,
+		&Input,
+		Derivative
+	});
+}
@@ -3,7 +3,11 @@
 #include "VoxelNodeStats.h"
 #include "VoxelNode.h"
 #include "VoxelCompiledGraph.h"
+#include "VoxelGraphInterface.h"
 #include "EdGraph/EdGraphNode.h"
+#include "Misc/FileHelper.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
 
 #if WITH_EDITOR
 bool GVoxelEnableNodeStats = false;
@@ -97,13 +101,271 @@ FVoxelNodeStatManager* GVoxelNodeStatManager = MakeVoxelSingleton(FVoxelNodeStat
 ///////////////////////////////////////////////////////////////////////////////
 
 #if WITH_EDITOR
-void FVoxelNodeStatScope::RecordStats(const double Duration) const
+void FVoxelNodeStatScope::RecordStats(const IVoxelNodeInterface& Node, const double Duration, const int64 Count)
 {
 	GVoxelNodeStatManager->Queue.Enqueue(
 	{
-		Node->GetNodeRef(),
+		Node.GetNodeRef(),
 		Duration,
 		Count
 	});
 }
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+#if !WITH_EDITOR
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, bool, GVoxelEnableRuntimeNodeStats, false,
+	"voxel.nodestats.Enable",
+	"If true, will time node scopes. Use voxel.nodestats.Export to write the results");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, int32, GVoxelRuntimeNodeStatsSampleRate, 16,
+	"voxel.nodestats.SampleRate",
+	"Only one in SampleRate node scopes will be timed on each thread");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, float, GVoxelRuntimeNodeStatsAggregatePeriod, 1.f,
+	"voxel.nodestats.AggregatePeriod",
+	"Per-thread node stats are merged every AggregatePeriod seconds");
+
+VOXEL_CONSOLE_COMMAND(
+	ClearRuntimeNodeStats,
+	"voxel.nodestats.Clear",
+	"")
+{
+	FVoxelRuntimeNodeStats::Clear();
+}
+
+VOXEL_CONSOLE_WORLD_COMMAND(
+	ExportRuntimeNodeStats,
+	"voxel.nodestats.Export",
+	"Write node stats to the path passed as argument, or to Saved/Profiling. Uses CSV if the path ends with .csv, JSON otherwise")
+{
+	const FString Path = Args.Num() > 0
+		? Args[0]
+		: FPaths::ProfilingDir() / "VoxelNodeStats-" + FDateTime::Now().ToString() + ".csv";
+
+	FVoxelRuntimeNodeStats::Export(Path);
+}
+
+class FVoxelRuntimeNodeStatManager : public FVoxelSingleton
+{
+public:
+	struct FStats
+	{
+		int64 NumSamples = 0;
+		double Time = 0.;
+		int64 NumElements = 0;
+
+		void Append(const FStats& Other)
+		{
+			NumSamples += Other.NumSamples;
+			Time += Other.Time;
+			NumElements += Other.NumElements;
+		}
+	};
+
+	// Only ever locked by its thread & by Aggregate, so almost never contended
+	struct FThreadStats
+	{
+		uint32 SampleCounter = 0;
+
+		FVoxelFastCriticalSection CriticalSection;
+		// Keyed by compiled node to keep the hot path cheap, the node ref is only copied on the first sample
+		TVoxelMap<const IVoxelNodeInterface*, TPair<FVoxelGraphNodeRef, FStats>> NodeToStats_RequiresLock;
+	};
+
+	FThreadStats& GetThreadStats()
+	{
+		static thread_local TSharedPtr<FThreadStats> ThreadStats;
+		if (!ThreadStats)
+		{
+			ThreadStats = MakeShared<FThreadStats>();
+
+			VOXEL_SCOPE_LOCK(CriticalSection);
+			AllThreadStats_RequiresLock.Add(ThreadStats);
+		}
+		return *ThreadStats;
+	}
+
+	void Aggregate()
+	{
+		VOXEL_FUNCTION_COUNTER();
+		check(IsInGameThread());
+
+		LastAggregateTime = FPlatformTime::Seconds();
+
+		TVoxelArray<TSharedPtr<FThreadStats>> AllThreadStats;
+		{
+			VOXEL_SCOPE_LOCK(CriticalSection);
+			AllThreadStats = AllThreadStats_RequiresLock;
+		}
+
+		for (const TSharedPtr<FThreadStats>& ThreadStats : AllThreadStats)
+		{
+			TVoxelMap<const IVoxelNodeInterface*, TPair<FVoxelGraphNodeRef, FStats>> NodeToStats;
+			{
+				VOXEL_SCOPE_LOCK(ThreadStats->CriticalSection);
+				NodeToStats = MoveTemp(ThreadStats->NodeToStats_RequiresLock);
+			}
+
+			for (const auto& It : NodeToStats)
+			{
+				NodeRefToStats.FindOrAdd(It.Value.Key).Append(It.Value.Value);
+			}
+		}
+	}
+	void Clear()
+	{
+		Aggregate();
+		NodeRefToStats.Empty();
+	}
+
+	//~ Begin FVoxelSingleton Interface
+	virtual void Tick() override
+	{
+		if (GVoxelEnableRuntimeNodeStats &&
+			LastAggregateTime + GVoxelRuntimeNodeStatsAggregatePeriod < FPlatformTime::Seconds())
+		{
+			Aggregate();
+		}
+	}
+	//~ End FVoxelSingleton Interface
+
+public:
+	TVoxelMap<FVoxelGraphNodeRef, FStats> NodeRefToStats;
+
+private:
+	double LastAggregateTime = 0.;
+
+	FVoxelFastCriticalSection CriticalSection;
+	TVoxelArray<TSharedPtr<FThreadStats>> AllThreadStats_RequiresLock;
+};
+FVoxelRuntimeNodeStatManager* GVoxelRuntimeNodeStatManager = MakeVoxelSingleton(FVoxelRuntimeNodeStatManager);
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelRuntimeNodeStats::Clear()
+{
+	GVoxelRuntimeNodeStatManager->Clear();
+}
+
+bool FVoxelRuntimeNodeStats::Export(const FString& Path)
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(IsInGameThread());
+
+	GVoxelRuntimeNodeStatManager->Aggregate();
+
+	struct FRow
+	{
+		FString Graph;
+		FString Node;
+		FVoxelRuntimeNodeStatManager::FStats Stats;
+	};
+	TVoxelArray<FRow> Rows;
+
+	const int32 SampleRate = FMath::Max(GVoxelRuntimeNodeStatsSampleRate, 1);
+	for (const auto& It : GVoxelRuntimeNodeStatManager->NodeRefToStats)
+	{
+		const UVoxelGraphInterface* Graph = It.Key.Graph.Get();
+
+		FRow& Row = Rows.Emplace_GetRef();
+		Row.Graph = Graph ? Graph->GetPathName() : "<deleted>";
+		Row.Node = It.Key.EdGraphNodeTitle.ToString();
+		if (It.Key.TemplateInstance != 0)
+		{
+			Row.Node += FString::Printf(TEXT(" (%d)"), It.Key.TemplateInstance);
+		}
+		Row.Stats = It.Value;
+	}
+
+	Rows.Sort([](const FRow& A, const FRow& B)
+	{
+		return A.Stats.Time > B.Stats.Time;
+	});
+
+	FString Result;
+	if (Path.EndsWith(".csv"))
+	{
+		Result += "Graph,Node,Samples,SampledSeconds,SampledElements,EstimatedSeconds,SecondsPerElement\n";
+
+		for (const FRow& Row : Rows)
+		{
+			Result += FString::Printf(TEXT("\"%s\",\"%s\",%lld,%f,%lld,%f,%g\n"),
+				*Row.Graph,
+				*Row.Node,
+				Row.Stats.NumSamples,
+				Row.Stats.Time,
+				Row.Stats.NumElements,
+				Row.Stats.Time * SampleRate,
+				Row.Stats.NumElements > 0 ? Row.Stats.Time / Row.Stats.NumElements : 0.);
+		}
+	}
+	else
+	{
+		TArray<TSharedPtr<FJsonValue>> NodeValues;
+		for (const FRow& Row : Rows)
+		{
+			const TSharedRef<FJsonObject> NodeObject = MakeShared<FJsonObject>();
+			NodeObject->SetStringField("graph", Row.Graph);
+			NodeObject->SetStringField("node", Row.Node);
+			NodeObject->SetNumberField("samples", Row.Stats.NumSamples);
+			NodeObject->SetNumberField("sampledSeconds", Row.Stats.Time);
+			NodeObject->SetNumberField("sampledElements", Row.Stats.NumElements);
+			NodeObject->SetNumberField("estimatedSeconds", Row.Stats.Time * SampleRate);
+			NodeObject->SetNumberField("secondsPerElement", Row.Stats.NumElements > 0 ? Row.Stats.Time / Row.Stats.NumElements : 0.);
+			NodeValues.Add(MakeShared<FJsonValueObject>(NodeObject));
+		}
+
+		const TSharedRef<FJsonObject> RootObject = MakeShared<FJsonObject>();
+		RootObject->SetNumberField("sampleRate", SampleRate);
+		RootObject->SetArrayField("nodes", NodeValues);
+
+		const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Result);
+		FJsonSerializer::Serialize(RootObject, Writer);
+	}
+
+	if (!FFileHelper::SaveStringToFile(Result, *Path))
+	{
+		LOG_VOXEL(Error, "Failed to write node stats to %s", *Path);
+		return false;
+	}
+
+	LOG_VOXEL(Log, "Node stats for %d nodes written to %s", Rows.Num(), *Path);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool FVoxelNodeStatScope::ShouldSample()
+{
+	FVoxelRuntimeNodeStatManager::FThreadStats& ThreadStats = GVoxelRuntimeNodeStatManager->GetThreadStats();
+	return ++ThreadStats.SampleCounter % FMath::Max(GVoxelRuntimeNodeStatsSampleRate, 1) == 0;
+}
+
+void FVoxelNodeStatScope::RecordStats(const IVoxelNodeInterface& Node, const double Duration, const int64 Count)
+{
+	FVoxelRuntimeNodeStatManager::FThreadStats& ThreadStats = GVoxelRuntimeNodeStatManager->GetThreadStats();
+
+	VOXEL_SCOPE_LOCK(ThreadStats.CriticalSection);
+
+	TPair<FVoxelGraphNodeRef, FVoxelRuntimeNodeStatManager::FStats>* Stats = ThreadStats.NodeToStats_RequiresLock.Find(&Node);
+	if (!Stats)
+	{
+		Stats = &ThreadStats.NodeToStats_RequiresLock.Add(&Node, { Node.GetNodeRef(), {} });
+	}
+
+	Stats->Value.NumSamples++;
+	Stats->Value.Time += Duration;
+	Stats->Value.NumElements += Count;
+}
 #endif
\ No newline at end of file
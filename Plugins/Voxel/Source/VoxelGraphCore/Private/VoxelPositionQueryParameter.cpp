@@ -223,4 +223,66 @@ void FVoxelPositionQueryParameter::CheckBounds() const
 		ensure(Position.Y <= Bounds.Max.Y + 1);
 		ensure(Position.Z <= Bounds.Max.Z + 1);
 	}
+}
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelAnalyticGradientQueryParameter::AddPositions(const FVoxelVectorBuffer& Positions) const
+{
+	{
+		VOXEL_SCOPE_LOCK(CriticalSection);
+		NumPositions_RequiresLock = Positions.Num();
+	}
+
+	AddGradient(Positions.X, FVoxelVectorBuffer::Make(FVector3f(1.f, 0.f, 0.f)));
+	AddGradient(Positions.Y, FVoxelVectorBuffer::Make(FVector3f(0.f, 1.f, 0.f)));
+	AddGradient(Positions.Z, FVoxelVectorBuffer::Make(FVector3f(0.f, 0.f, 1.f)));
+}
+
+int32 FVoxelAnalyticGradientQueryParameter::GetNumPositions() const
+{
+	VOXEL_SCOPE_LOCK(CriticalSection);
+	return NumPositions_RequiresLock;
+}
+
+void FVoxelAnalyticGradientQueryParameter::AddGradient(
+	const FVoxelFloatBuffer& Value,
+	const FVoxelVectorBuffer& Gradient) const
+{
+	ensureVoxelSlow(Gradient.IsConstant() || Gradient.Num() == Value.Num());
+
+	VOXEL_SCOPE_LOCK(CriticalSection);
+
+	FEntry& Entry = StorageToEntry_RequiresLock.FindOrAdd(&Value.GetStorage());
+	Entry.Storage = Value.GetSharedStorage();
+	Entry.Gradient = Gradient;
+}
+
+bool FVoxelAnalyticGradientQueryParameter::FindGradient(
+	const FVoxelFloatBuffer& Value,
+	FVoxelVectorBuffer& OutGradient) const
+{
+	int32 NumPositions;
+	{
+		VOXEL_SCOPE_LOCK(CriticalSection);
+
+		if (const FEntry* Entry = StorageToEntry_RequiresLock.Find(&Value.GetStorage()))
+		{
+			OutGradient = Entry->Gradient;
+			return true;
+		}
+
+		NumPositions = NumPositions_RequiresLock;
+	}
+
+	// With a single position, outputs of nodes without derivatives are constant too
+	if (Value.IsConstant() &&
+		NumPositions > 1)
+	{
+		OutGradient = FVoxelVectorBuffer::Make(FVector3f::ZeroVector);
+		return true;
+	}
+
+	return false;
 }
\ No newline at end of file
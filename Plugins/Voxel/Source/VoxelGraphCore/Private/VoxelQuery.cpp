@@ -411,6 +411,23 @@ FVoxelQuery FVoxelQuery::MakeNewQuery(const TSharedRef<const FVoxelQueryParamete
 		NewSharedCache->GetQueryCache(*Context));
 }
 
+FVoxelQuery FVoxelQuery::MakeNewQuery(
+	const TSharedRef<const FVoxelQueryParameters>& NewParameters,
+	const TSharedRef<FVoxelDependencyTracker>& NewDependencyTracker) const
+{
+	// New parameters, invalidate cache
+	const TSharedRef<FSharedCache> NewSharedCache = MakeVoxelShared<FSharedCache>();
+
+	return FVoxelQuery(
+		QueryRuntimeInfo,
+		Context,
+		NewParameters,
+		NewDependencyTracker,
+		Callstack,
+		NewSharedCache,
+		NewSharedCache->GetQueryCache(*Context));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
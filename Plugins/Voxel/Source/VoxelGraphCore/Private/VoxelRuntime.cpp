@@ -137,6 +137,8 @@ void FVoxelRuntime::Tick()
 	}
 
 	NodeRuntime->Tick(*this);
+
+	FlushChunkChanges();
 }
 
 void FVoxelRuntime::AddReferencedObjects(FReferenceCollector& Collector)
@@ -152,6 +154,45 @@ FVoxelOptionalBox FVoxelRuntime::GetBounds() const
 	return NodeRuntime->GetBounds();
 }
 
+void FVoxelRuntime::NotifyChunkChanged(const FBox& Bounds, const int32 LOD, const int32 ChunkSize)
+{
+	check(IsInGameThread());
+
+	for (const auto& It : OnChunkChangedMap)
+	{
+		if (It.Value)
+		{
+			It.Value(Bounds, LOD, ChunkSize);
+		}
+	}
+
+	if (OnChunksChangedMap.Num() > 0)
+	{
+		PendingChunkChanges.Add(FVoxelChunkChange{ Bounds, LOD, ChunkSize });
+	}
+}
+
+void FVoxelRuntime::FlushChunkChanges()
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(IsInGameThread());
+
+	if (PendingChunkChanges.Num() == 0)
+	{
+		return;
+	}
+
+	const TVoxelArray<FVoxelChunkChange> ChunkChanges = MoveTemp(PendingChunkChanges);
+
+	for (const auto& It : OnChunksChangedMap)
+	{
+		if (It.Value)
+		{
+			It.Value(ChunkChanges);
+		}
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
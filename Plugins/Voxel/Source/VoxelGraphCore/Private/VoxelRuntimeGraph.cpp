@@ -4,14 +4,24 @@
 #include "VoxelGraph.h"
 #include "VoxelBuffer.h"
 #include "VoxelRootNode.h"
+#include "VoxelISPCNode.h"
+#include "VoxelQueryCache.h"
 #include "VoxelFunctionNode.h"
 #include "VoxelGraphCompiler.h"
 #include "VoxelFunctionCallNode.h"
 #include "VoxelGraphCompileScope.h"
+#include "VoxelBufferUtilities.h"
+#include "VoxelPositionQueryParameter.h"
+#include "FunctionLibrary/VoxelPositionFunctionLibrary.h"
 #if WITH_EDITOR
 #include "EdGraph/EdGraph.h"
 #endif
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, bool, GVoxelGraphColumnEvaluation, true,
+	"voxel.graph.ColumnEvaluation",
+	"If true, subgraphs only depending on the X and Y of a grid query will be computed once per column and broadcast along Z");
+
 VOXEL_RUN_ON_STARTUP_GAME(RegisterOnNodeMessageLogged)
 {
 #if WITH_EDITOR
@@ -395,6 +405,245 @@ TSharedPtr<FVoxelGraphExecutor> UVoxelRuntimeGraph::CreateExecutor(const FVoxelG
 		}
 	}
 
+	// Input pins reading a column subgraph, see below
+	TVoxelSet<const FPin*> ColumnInputPins;
+
+	if (GVoxelGraphColumnEvaluation)
+	{
+		VOXEL_SCOPE_COUNTER("Column evaluation");
+
+		enum class EColumnType : uint8
+		{
+			// Depends on the full query position
+			Other,
+			// Same value for the whole query
+			Uniform,
+			// Only depends on the X and Y of the query position
+			Column
+		};
+
+		const UFunction* GetPosition2DFunction = UVoxelPositionFunctionLibrary::StaticClass()->FindFunctionByName(
+			GET_FUNCTION_NAME_CHECKED(UVoxelPositionFunctionLibrary, GetPosition2D));
+		ensure(GetPosition2DFunction);
+
+		TVoxelMap<const FNode*, EColumnType> NodeToColumnType;
+		NodeToColumnType.Reserve(Nodes.Num());
+
+		const TFunction<EColumnType(const FNode&)> GetColumnType = [&](const FNode& Node) -> EColumnType
+		{
+			if (const EColumnType* ColumnTypePtr = NodeToColumnType.Find(&Node))
+			{
+				return *ColumnTypePtr;
+			}
+
+			const FVoxelNode& VoxelNode = *Nodes[&Node];
+
+			EColumnType ColumnType = EColumnType::Other;
+			if (const FVoxelFunctionNode* FunctionNode = Cast<FVoxelFunctionNode>(VoxelNode))
+			{
+				if (GetPosition2DFunction &&
+					FunctionNode->GetFunction() == GetPosition2DFunction)
+				{
+					ColumnType = EColumnType::Column;
+				}
+			}
+			else if (VoxelNode.IsPositionIndependent())
+			{
+				ColumnType = EColumnType::Uniform;
+
+				for (const FPin& InputPin : Node.GetInputPins())
+				{
+					if (InputPin.GetLinkedTo().Num() == 0)
+					{
+						continue;
+					}
+
+					const EColumnType InputColumnType = GetColumnType(InputPin.GetLinkedTo()[0].Node);
+					if (InputColumnType == EColumnType::Other)
+					{
+						ColumnType = EColumnType::Other;
+						break;
+					}
+					if (InputColumnType == EColumnType::Column)
+					{
+						ColumnType = EColumnType::Column;
+					}
+				}
+
+				if (ColumnType == EColumnType::Column)
+				{
+					// Uniform outputs (eg, reductions) would not be the same on the footprint
+					for (const FPin& OutputPin : Node.GetOutputPins())
+					{
+						if (!OutputPin.Type.IsBuffer() ||
+							OutputPin.Type.IsBufferArray())
+						{
+							ColumnType = EColumnType::Other;
+							break;
+						}
+					}
+				}
+			}
+
+			NodeToColumnType.Add(&Node, ColumnType);
+			return ColumnType;
+		};
+
+		// All the readers of a column output share the same footprint query through the query cache
+		TVoxelMap<const FPin*, FVoxelPinRuntimeId> OutputPinToColumnPinId;
+
+		for (const auto& It : Nodes)
+		{
+			const FNode& Node = *It.Key;
+			if (GetColumnType(Node) == EColumnType::Column)
+			{
+				// Will be computed on the footprint directly
+				continue;
+			}
+
+			for (const FPin& InputPin : Node.GetInputPins())
+			{
+				if (InputPin.GetLinkedTo().Num() != 1 ||
+					!InputPin.Type.IsBuffer() ||
+					InputPin.Type.IsBufferArray())
+				{
+					continue;
+				}
+
+				const FPin& OutputPin = InputPin.GetLinkedTo()[0];
+				if (GetColumnType(OutputPin.Node) != EColumnType::Column ||
+					Cast<FVoxelFunctionNode>(*Nodes[&OutputPin.Node]))
+				{
+					// Nothing to save when reading the position directly
+					continue;
+				}
+
+				FVoxelNodeRuntime::FPinData& PinData = ConstCast(It.Value->GetNodeRuntime().GetPinData(InputPin.Name));
+				if (!ensure(PinData.Compute))
+				{
+					continue;
+				}
+
+				FVoxelPinRuntimeId& ColumnPinId = OutputPinToColumnPinId.FindOrAdd(&OutputPin);
+				if (!ColumnPinId.IsValid())
+				{
+					ColumnPinId = FVoxelPinRuntimeId::New();
+				}
+
+				PinData.Compute = MakeVoxelShared<FVoxelComputeValue>([
+					Compute = PinData.Compute.ToSharedRef(),
+					ColumnPinId,
+					Type = PinData.Type](const FVoxelQuery& Query) -> FVoxelFutureValue
+				{
+					const FVoxelPositionQueryParameter* PositionQueryParameter = Query.GetParameters().Find<FVoxelPositionQueryParameter>();
+					if (!PositionQueryParameter ||
+						!PositionQueryParameter->IsGrid() ||
+						PositionQueryParameter->IsGradient() ||
+						PositionQueryParameter->GetGrid().Size.Z <= 1 ||
+						Query.GetParameters().Find<FVoxelAnalyticGradientQueryParameter>())
+					{
+						return (*Compute)(Query);
+					}
+
+					FVoxelQueryCache::FEntry& Entry = Query.GetQueryCache().FindOrAddEntry(ColumnPinId);
+					VOXEL_SCOPE_LOCK(Entry.CriticalSection);
+
+					if (Entry.Value.IsValid())
+					{
+						return Entry.Value;
+					}
+
+					const FVoxelPositionQueryParameter::FGrid Grid = PositionQueryParameter->GetGrid();
+
+					const TSharedRef<FVoxelQueryParameters> Parameters = Query.CloneParameters();
+					Parameters->Add<FVoxelPositionQueryParameter>().InitializeGrid(
+						Grid.Start,
+						Grid.Step,
+						FIntVector(Grid.Size.X, Grid.Size.Y, 1));
+
+					const FVoxelFutureValue FootprintValue = (*Compute)(Query.MakeNewQuery(Parameters));
+
+					Entry.Value =
+						MakeVoxelTask(STATIC_FNAME("ColumnEvaluation"))
+						.Dependency(FootprintValue)
+						.Execute(Type, [=]() -> FVoxelFutureValue
+						{
+							const FVoxelRuntimePinValue& Value = FootprintValue.GetValue_CheckCompleted();
+							const FVoxelBuffer& Buffer = Value.Get<FVoxelBuffer>();
+
+							const int32 NumXY = Grid.Size.X * Grid.Size.Y;
+							if (Buffer.Num() != NumXY ||
+								Buffer.Num() == 1)
+							{
+								// Constant buffers are broadcast by the readers
+								return Value;
+							}
+
+							FVoxelInt32BufferStorage Indices;
+							Indices.Allocate(NumXY * Grid.Size.Z);
+
+							int32 WriteIndex = 0;
+							for (int32 Z = 0; Z < Grid.Size.Z; Z++)
+							{
+								for (int32 Index = 0; Index < NumXY; Index++)
+								{
+									Indices[WriteIndex++] = Index;
+								}
+							}
+							ensure(WriteIndex == Indices.Num());
+
+							const TSharedRef<const FVoxelBuffer> NewBuffer = FVoxelBufferUtilities::Gather(Buffer, FVoxelInt32Buffer::Make(Indices));
+							return FVoxelRuntimePinValue::Make(NewBuffer, Type);
+						});
+
+					return Entry.Value;
+				});
+
+				ColumnInputPins.Add(&InputPin);
+			}
+		}
+	}
+
+	if (GVoxelFuseISPCNodes)
+	{
+		VOXEL_SCOPE_COUNTER("Fuse ISPC nodes");
+
+		for (const auto& It : Nodes)
+		{
+			const FNode& Node = *It.Key;
+			const TSharedPtr<FVoxelISPCNode> ISPCNode = Cast<FVoxelISPCNode>(It.Value);
+			if (!ISPCNode)
+			{
+				continue;
+			}
+
+			for (const FPin& InputPin : Node.GetInputPins())
+			{
+				if (InputPin.GetLinkedTo().Num() != 1 ||
+					ColumnInputPins.Contains(&InputPin))
+				{
+					continue;
+				}
+
+				// Only fuse nodes used once, otherwise we would compute them multiple times
+				const FNode& InputNode = InputPin.GetLinkedTo()[0].Node;
+				if (InputNode.GetOutputPins().Num() != 1 ||
+					InputNode.GetOutputPin(0).GetLinkedTo().Num() != 1)
+				{
+					continue;
+				}
+
+				const TSharedPtr<FVoxelISPCNode> InputISPCNode = Cast<FVoxelISPCNode>(Nodes[&InputNode]);
+				if (!InputISPCNode)
+				{
+					continue;
+				}
+
+				ISPCNode->FuseInput(InputPin.Name, InputISPCNode.ToSharedRef());
+			}
+		}
+	}
+
 	for (const auto& It : Nodes)
 	{
 		It.Value->RemoveEditorData();
@@ -606,6 +855,7 @@ TSharedPtr<const Voxel::Graph::FGraph> UVoxelRuntimeGraph::CreateRootGraph() con
 	RUN_PASS(ReplaceTemplates);
 	RUN_PASS(RemovePassthroughs);
 	RUN_PASS(CheckForLoops);
+	RUN_PASS(RemoveDuplicatedNodes, *VoxelGraph);
 
 #undef RUN_PASS
 
@@ -74,4 +74,26 @@ bool FVoxelRuntimePinValue::IsValidValue_Slow() const
 	}
 
 	return Get<FVoxelBufferInterface>().IsValid_Slow();
+}
+
+uint64 FVoxelRuntimePinValue::GetContentHash() const
+{
+	if (!Type.IsValid())
+	{
+		return 0;
+	}
+
+	if (!Type.IsBuffer() &&
+		!Type.IsStruct())
+	{
+		return FVoxelUtilities::MurmurHash(Raw) | 1;
+	}
+
+	if (!SharedStruct ||
+		!SharedStructType->IsChildOf(StaticStructFast<FVoxelVirtualStruct>()))
+	{
+		return 0;
+	}
+
+	return reinterpret_cast<const FVoxelVirtualStruct&>(*SharedStruct).GetContentHash();
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "VoxelTaskExecutor.h"
 #include "VoxelMemoryScope.h"
+#include "RenderCore.h"
 #include "Engine/Engine.h"
 
 VOXEL_CONSOLE_VARIABLE(
@@ -40,6 +41,22 @@ VOXEL_CONSOLE_VARIABLE(
 	"voxel.threading.PriorityDuration",
 	"Task priorities will be recomputed with the new camera position every PriorityDuration seconds");
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, float, GVoxelThreadingGameTaskBudget, 4.f,
+	"voxel.threading.GameTaskBudget",
+	"Max time in milliseconds spent on voxel game thread tasks per frame. Tasks left are processed next frame, closest to the camera first");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, float, GVoxelThreadingGameTaskMinBudget, 0.5f,
+	"voxel.threading.GameTaskMinBudget",
+	"Min time in milliseconds spent on voxel game thread tasks per frame, even when above TargetFrameTime, so that voxel updates keep progressing");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, float, GVoxelThreadingTargetFrameTime, 0.f,
+	"voxel.threading.TargetFrameTime",
+	"If > 0, the game task budget will be reduced to keep the frame time under TargetFrameTime milliseconds, down to GameTaskMinBudget. "
+	"If 0, GameTaskBudget is always used");
+
 VOXEL_CONSOLE_VARIABLE(
 	VOXELGRAPHCORE_API, int32, GVoxelThreadingMaxConcurrentRenderTasks, 512,
 	"voxel.threading.MaxConcurrentRenderTasks",
@@ -58,6 +75,16 @@ VOXEL_CONSOLE_COMMAND(
 	GVoxelTaskExecutor->LogAllTasks();
 }
 
+DECLARE_VOXEL_FRAME_COUNTER(VOXELGRAPHCORE_API, STAT_VoxelNumGameTaskGroupsProcessed, "Num Game Task Groups Processed");
+DECLARE_VOXEL_FRAME_COUNTER(VOXELGRAPHCORE_API, STAT_VoxelNumGameTaskGroupsDeferred, "Num Game Task Groups Deferred");
+DECLARE_VOXEL_FRAME_COUNTER(VOXELGRAPHCORE_API, STAT_VoxelGameTaskBudgetUs, "Game Task Budget (us)");
+DECLARE_VOXEL_FRAME_COUNTER(VOXELGRAPHCORE_API, STAT_VoxelGameTaskTimeUs, "Game Task Time (us)");
+
+DEFINE_VOXEL_COUNTER(STAT_VoxelNumGameTaskGroupsProcessed);
+DEFINE_VOXEL_COUNTER(STAT_VoxelNumGameTaskGroupsDeferred);
+DEFINE_VOXEL_COUNTER(STAT_VoxelGameTaskBudgetUs);
+DEFINE_VOXEL_COUNTER(STAT_VoxelGameTaskTimeUs);
+
 FVoxelTaskExecutor* GVoxelTaskExecutor = MakeVoxelSingleton(FVoxelTaskExecutor);
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -92,6 +119,19 @@ void FVoxelTaskExecutor::AddGroup(const TSharedRef<FVoxelTaskGroup>& Group)
 	Event.Trigger();
 }
 
+void FVoxelTaskExecutor::AddRenderGroup(FVoxelTaskGroup& Group)
+{
+	check(IsInRenderingThread());
+
+	if (IsExiting() ||
+		Group.bIsInRenderQueue.Exchange(true))
+	{
+		return;
+	}
+
+	RenderGroupsQueue.Enqueue(Group.AsWeak());
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -185,49 +225,136 @@ void FVoxelTaskExecutor::Tick()
 		});
 	}
 
+	ProcessGameTasks();
+
+	if (!bIsGatheringGameGroups.Exchange(true))
+	{
+		AsyncVoxelTask([this]
+		{
+			GatherGameGroups();
+			bIsGatheringGameGroups.Store(false);
+		});
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+double FVoxelTaskExecutor::GetGameTasksBudget()
+{
+	// Never 0: voxel updates must keep progressing even when over TargetFrameTime
+	constexpr double MinBudgetFloor = 0.05 / 1000.;
+
+	const double MinBudget = FMath::Max(GVoxelThreadingGameTaskMinBudget / 1000., MinBudgetFloor);
+	const double MaxBudget = FMath::Max(GVoxelThreadingGameTaskBudget / 1000., MinBudget);
+
+	if (GVoxelThreadingTargetFrameTime <= 0.f)
 	{
-		VOXEL_SCOPE_COUNTER("Process game groups");
+		return MaxBudget;
+	}
 
-		// Max 100ms tick
-		const double EndTime = FPlatformTime::Seconds() + 0.1;
+	// Game thread work time of the last frame without our own game tasks, smoothed to not oscillate between two budgets
+	// Unlike the delta time, this excludes the time spent waiting for vsync or the frame rate limit
+	const double FrameTime = FMath::Max(FPlatformTime::ToSeconds(GGameThreadTime) - LastGameTasksTime, 0.);
+	SmoothedFrameTime = SmoothedFrameTime == 0. ? FrameTime : FMath::Lerp(SmoothedFrameTime, FrameTime, 0.1);
 
-		TWeakPtr<FVoxelTaskGroup> WeakGroup;
-		while (
-			FPlatformTime::Seconds() < EndTime &&
-			GameGroupsQueue.Dequeue(WeakGroup))
+	return FMath::Clamp(GVoxelThreadingTargetFrameTime / 1000. - SmoothedFrameTime, MinBudget, MaxBudget);
+}
+
+void FVoxelTaskExecutor::ProcessGameTasks()
+{
+	VOXEL_SCOPE_COUNTER("Process game groups");
+	check(IsInGameThread());
+
+	{
+		VOXEL_SCOPE_LOCK(GatheredGameGroupsCriticalSection);
+
+		if (bHasGatheredGameGroups_RequiresLock)
 		{
-			TSharedPtr<FVoxelTaskGroup> TmpGroup = WeakGroup.Pin();
-			if (!TmpGroup)
-			{
-				continue;
-			}
+			// Groups we didn't get to still have game tasks and are part of the new list, with up-to-date priorities
+			GameGroups = MoveTemp(GatheredGameGroups_RequiresLock);
+			GameGroupIndex = 0;
+			bHasGatheredGameGroups_RequiresLock = false;
+		}
+	}
 
-			FVoxelTaskGroupScope Scope;
-			if (!Scope.Initialize(*TmpGroup))
-			{
-				// Exiting
-				continue;
-			}
+	const double StartTime = FPlatformTime::Seconds();
+	const double Budget = GetGameTasksBudget();
+	const double EndTime = StartTime + Budget;
 
-			// Reset to only have one valid group ref for ShouldExit
-			TmpGroup.Reset();
+	// Always process at least one group so that voxel updates keep progressing, even when a single task is over budget
+	int32 NumProcessed = 0;
+	while (
+		GameGroupIndex < GameGroups.Num() &&
+		(NumProcessed == 0 || FPlatformTime::Seconds() < EndTime))
+	{
+		TSharedPtr<FVoxelTaskGroup> TmpGroup = GameGroups[GameGroupIndex++].Pin();
+		if (!TmpGroup)
+		{
+			continue;
+		}
 
-			Scope.GetGroup().ProcessGameTasks();
+		FVoxelTaskGroupScope Scope;
+		if (!Scope.Initialize(*TmpGroup))
+		{
+			// Exiting
+			continue;
+		}
+
+		// Reset to only have one valid group ref for ShouldExit
+		TmpGroup.Reset();
+
+		Scope.GetGroup().ProcessGameTasks(EndTime);
+		NumProcessed++;
+
+		if (Scope.GetGroup().HasGameTasks() &&
+			FPlatformTime::Seconds() >= EndTime)
+		{
+			// Out of budget: resume this group first next frame
+			GameGroupIndex--;
+			break;
 		}
 	}
 
-	AsyncVoxelTask([this]
+	LastGameTasksTime = FPlatformTime::Seconds() - StartTime;
+
+	INC_VOXEL_COUNTER_BY(STAT_VoxelNumGameTaskGroupsProcessed, NumProcessed);
+	INC_VOXEL_COUNTER_BY(STAT_VoxelNumGameTaskGroupsDeferred, GameGroups.Num() - GameGroupIndex);
+	INC_VOXEL_COUNTER_BY(STAT_VoxelGameTaskBudgetUs, int64(Budget * 1000000.));
+	INC_VOXEL_COUNTER_BY(STAT_VoxelGameTaskTimeUs, int64(LastGameTasksTime * 1000000.));
+}
+
+void FVoxelTaskExecutor::GatherGameGroups()
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	TVoxelArray<TPair<double, TWeakPtr<FVoxelTaskGroup>>> PriorityToGroups;
+	Groups.ForeachGroup([&](FVoxelTaskGroup& Group)
 	{
-		VOXEL_SCOPE_COUNTER("Gather game tasks");
-		Groups.ForeachGroup([&](FVoxelTaskGroup& Group)
+		if (Group.HasGameTasks())
 		{
-			if (Group.HasGameTasks())
-			{
-				GameGroupsQueue.Enqueue(Group.AsWeak());
-			}
-			return true;
-		});
+			PriorityToGroups.Add({ Group.Priority.GetPriority(), Group.AsWeak() });
+		}
+		return true;
 	});
+
+	// Priorities are computed when gathering and might be outdated by the time the groups are processed
+	PriorityToGroups.Sort([](const TPair<double, TWeakPtr<FVoxelTaskGroup>>& A, const TPair<double, TWeakPtr<FVoxelTaskGroup>>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	TVoxelArray<TWeakPtr<FVoxelTaskGroup>> NewGameGroups;
+	NewGameGroups.Reserve(PriorityToGroups.Num());
+	for (const auto& It : PriorityToGroups)
+	{
+		NewGameGroups.Add(It.Value);
+	}
+
+	VOXEL_SCOPE_LOCK(GatheredGameGroupsCriticalSection);
+	GatheredGameGroups_RequiresLock = MoveTemp(NewGameGroups);
+	bHasGatheredGameGroups_RequiresLock = true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -246,31 +373,27 @@ void FVoxelTaskExecutor::Tick_RenderThread(FRDGBuilder& GraphBuilder)
 	VOXEL_FUNCTION_COUNTER();
 	RDG_GPU_STAT_SCOPE(GraphBuilder, FVoxelTaskExecutor);
 
-	for (int32 Index = 0; Index < GVoxelThreadingMaxConcurrentRenderTasks; Index++)
+	// Groups left after MaxConcurrentRenderTasks stay queued for next frame
+	TWeakPtr<FVoxelTaskGroup> WeakGroup;
+	for (int32 Index = 0;
+		Index < GVoxelThreadingMaxConcurrentRenderTasks &&
+		RenderGroupsQueue.Dequeue(WeakGroup);
+		Index++)
 	{
-		TSharedPtr<FVoxelTaskGroup> GroupToProcess;
-		Groups.ForeachGroup([&](FVoxelTaskGroup& Group)
-		{
-			if (!Group.HasRenderTasks())
-			{
-				return true;
-			}
-
-			ensure(!GroupToProcess);
-			GroupToProcess = Group.AsShared();
-			return false;
-		});
-
+		TSharedPtr<FVoxelTaskGroup> GroupToProcess = WeakGroup.Pin();
 		if (!GroupToProcess)
 		{
-			return;
+			continue;
 		}
 
+		// Clear before processing: render tasks added from now on will queue the group again
+		GroupToProcess->bIsInRenderQueue.Store(false);
+
 		FVoxelTaskGroupScope Scope;
 		if (!Scope.Initialize(*GroupToProcess))
 		{
 			// Exiting
-			return;
+			continue;
 		}
 
 		// Reset to only have one valid group ref for ShouldExit
@@ -5,6 +5,11 @@
 #include "VoxelNodeStats.h"
 #include "EdGraph/EdGraphNode.h"
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHCORE_API, bool, GVoxelRenderTaskScopes, false,
+	"voxel.threading.RenderTaskScopes",
+	"If true, each render task will have its own RDG event & GPU stat scope. Useful to profile tasks individually, but adds overhead per task");
+
 #if WITH_EDITOR
 class FVoxelExecNodeStatManager
 	: public FVoxelSingleton
@@ -351,6 +356,7 @@ void FVoxelTaskGroup::ProcessTask(TVoxelUniquePtr<FVoxelTask> TaskPtr)
 			MakeWeakPtrLambda(this, [this, TaskPtrPtr = MakeUniqueCopy(MoveTemp(TaskPtr))](FRHICommandList& RHICmdList)
 			{
 				RenderTasks.Enqueue(MoveTemp(*TaskPtrPtr));
+				GVoxelTaskExecutor->AddRenderGroup(*this);
 			}));
 	}
 	break;
@@ -439,7 +445,7 @@ void FVoxelTaskGroup::LogTasks() const
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-void FVoxelTaskGroup::ProcessGameTasks()
+void FVoxelTaskGroup::ProcessGameTasks(const double EndTime)
 {
 	VOXEL_SCOPE_COUNTER_FNAME(Name);
 	VOXEL_SCOPE_COUNTER_FNAME(InstanceStatName);
@@ -449,12 +455,16 @@ void FVoxelTaskGroup::ProcessGameTasks()
 	check(&Get() == this);
 	const FVoxelQueryScope Scope(nullptr, &Context.Get());
 
+	// Always run at least one task, even if EndTime is already reached
+	int32 NumExecuted = 0;
 	TVoxelUniquePtr<FVoxelTask> Task;
 	while (
 		!ShouldExit() &&
+		(NumExecuted == 0 || FPlatformTime::Seconds() < EndTime) &&
 		GameTasks.Dequeue(Task))
 	{
 		Task->Execute();
+		NumExecuted++;
 	}
 }
 
@@ -473,11 +483,16 @@ void FVoxelTaskGroup::ProcessRenderTasks(FRDGBuilder& GraphBuilder)
 		!ShouldExit() &&
 		RenderTasks.Dequeue(Task))
 	{
-		RDG_EVENT_SCOPE(GraphBuilder, "%s", *Task->Name.ToString());
+		// Per-task scopes split the passes of a frame into as many GPU timer & event ranges as there are tasks
+		RDG_EVENT_SCOPE_CONDITIONAL(GraphBuilder, GVoxelRenderTaskScopes, "%s", *Task->Name.ToString());
 
 #if HAS_GPU_STATS
 		static FDrawCallCategoryName DrawCallCategoryName;
-		FRDGGPUStatScopeGuard StatScope(GraphBuilder, *Task->Name.ToString(), {}, nullptr, DrawCallCategoryName);
+		TOptional<FRDGGPUStatScopeGuard> StatScope;
+		if (GVoxelRenderTaskScopes)
+		{
+			StatScope.Emplace(GraphBuilder, *Task->Name.ToString(), FName(), nullptr, DrawCallCategoryName);
+		}
 #endif
 
 #if 0
@@ -153,7 +153,8 @@ void FVoxelWriteChannelExecNodeRuntime::Create()
 					}
 					return SharedValue;
 				});
-		});
+		},
+		ComputePersistentHash());
 
 	Channel->AddBrush(Brush, BrushRef);
 }
@@ -17,6 +17,11 @@ struct VOXELGRAPHCORE_API FVoxelComputedMaterialParameter
 	TVoxelMap<FName, TWeakObjectPtr<UTexture>> TextureParameters;
 	TVoxelMap<FName, TSharedPtr<FVoxelDynamicMaterialParameter>> DynamicParameters;
 	TVoxelArray<TSharedPtr<FVirtualDestructor>> Resources;
+	// Content hash of each resource, eg of the data uploaded to a detail texture allocation. 0 if unknown
+	TVoxelArray<uint64> ResourceHashes;
+	// Parameters whose value depends on where resources were allocated, eg detail texture indices
+	// Not part of the content hash: ResourceHashes already cover the allocated data
+	TVoxelSet<FName> AllocationParameters;
 
 	template<typename LambdaType>
 	void ForeachKey(LambdaType&& Lambda) const
@@ -39,6 +44,8 @@ struct VOXELGRAPHCORE_API FVoxelComputedMaterialParameter
 		}
 	}
 	void Append(const FVoxelComputedMaterialParameter& Other);
+	// 0 if unknown
+	uint64 GetContentHash() const;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -83,6 +90,8 @@ struct VOXELGRAPHCORE_API FVoxelComputedMaterial
 	FVoxelComputedMaterialParameter Parameters;
 
 	TSharedRef<FVoxelMaterialRef> MakeMaterial_GameThread() const;
+	// 0 if unknown
+	uint64 GetContentHash() const;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
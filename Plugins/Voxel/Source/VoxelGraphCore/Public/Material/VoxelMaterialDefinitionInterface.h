@@ -65,6 +65,11 @@ struct VOXELGRAPHCORE_API FVoxelMaterialDefinitionDynamicMaterialParameter : pub
 
 	virtual void Apply(FName Name, UMaterialInstanceDynamic& Instance) const override;
 	virtual void AddOnChanged(const FSimpleDelegate& OnChanged) override;
+	virtual uint64 GetContentHash() const override
+	{
+		// Always applies all the registered material definitions
+		return 1;
+	}
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -60,6 +60,8 @@ private:
 	FVoxelPointChunkProviderRef ChunkProviderRef;
 	TSharedPtr<FVoxelQueryContext> Context;
 	TSharedPtr<const TVoxelComputeValue<FVoxelPointSet>> ComputePoints;
+
+	FVoxelPointChunkRef GetChunkRef(const FIntVector& ChunkMin) const;
 };
 
 USTRUCT()
@@ -75,6 +75,10 @@ public:
 	int64 GetAllocatedSize() const;
 	const TVoxelAddOnlySet<FVoxelPointId>& GetPointIdToIndex() const;
 
+	//~ Begin FVoxelVirtualStruct Interface
+	virtual uint64 GetContentHash() const override;
+	//~ End FVoxelVirtualStruct Interface
+
 public:
 	static TSharedRef<const FVoxelPointSet> Merge(TVoxelArray<TSharedRef<const FVoxelPointSet>> PointSets);
 
@@ -61,6 +61,9 @@ public:
 	void ClearData();
 	void Serialize(FArchive& Ar);
 
+	// Hash of all the densities, stable across sessions
+	uint64 GetContentHash() const;
+
 private:
 	struct FOctree : TVoxelFastOctree<>
 	{
@@ -0,0 +1,34 @@
+// Copyright Voxel Plugin, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "VoxelMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VoxelBenchmarkCommandlet.generated.h"
+
+// Headless benchmark of the voxel pipeline, eg for performance regression tracking in CI
+// Loads a map or spawns a voxel actor with a graph in an empty world, moves the camera along a fixed path
+// and waits for all voxel tasks to be done at each waypoint. Per-stage timings & peak memory are written as JSON
+//
+// UnrealEditor-Cmd Project.uproject -run=VoxelBenchmark -nullrhi -unattended
+//		-Map=/Game/Maps/MyMap | -Graph=/Game/MyGraph.MyGraph
+//		[-Path="0,0,1000;10000,0,1000"] [-Output=Benchmark.json] [-Threads=8] [-Timeout=600] [-Repeat=1]
+//
+// Returns 0 on success, 1 if the world failed to load or a waypoint timed out
+UCLASS()
+class VOXELGRAPHCORE_API UVoxelBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UVoxelBenchmarkCommandlet();
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+
+private:
+	UWorld* CreateWorld(const FString& Params) const;
+	void TickWorld(UWorld& World, float DeltaTime) const;
+	void DestroyWorld(UWorld& World) const;
+};
\ No newline at end of file
@@ -67,6 +67,7 @@ public:
 	virtual int64 GetAllocatedSize() const;
 	virtual int32 Num_Slow() const override;
 	virtual bool IsValid_Slow() const final override;
+	virtual uint64 GetContentHash() const override;
 
 	FVoxelRuntimePinValue GetGenericConstant() const;
 
@@ -270,6 +271,7 @@ public:
 	virtual void CheckSlowImpl() const final override;
 	virtual int64 GetAllocatedSize() const final override;
 	virtual int32 Num_Slow() const override;
+	virtual uint64 GetContentHash() const final override;
 
 	TSharedRef<FVoxelBufferStorage> MakeNewStorage() const;
 	void SetStorage(const TSharedRef<const FVoxelBufferStorage>& Storage);
@@ -391,6 +393,7 @@ public:
 	virtual void CheckSlowImpl() const override;
 	virtual int64 GetAllocatedSize() const override;
 	virtual int32 Num_Slow() const override;
+	virtual uint64 GetContentHash() const override;
 	virtual void InitializeFromConstant(const FVoxelRuntimePinValue& Constant) override;
 	virtual FVoxelRuntimePinValue GetGeneric(int32 Index) const override;
 
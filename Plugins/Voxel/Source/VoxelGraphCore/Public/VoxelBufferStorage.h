@@ -338,6 +338,7 @@ public:
 	void AddZeroed(int32 NumToAdd);
 	void Append(const FVoxelBufferStorage& BufferStorage, int32 BufferNum);
 	void CopyTo(const TVoxelArrayView<uint8> OtherData) const;
+	uint64 GetHash() const;
 
 	FORCEINLINE int32 GetTypeSize() const
 	{
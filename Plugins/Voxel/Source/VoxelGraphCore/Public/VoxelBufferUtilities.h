@@ -87,6 +87,10 @@ public:
 
 	static FVoxelQuaternionBuffer Combine(const FVoxelQuaternionBuffer& A, const FVoxelQuaternionBuffer& B);
 
+public:
+	// Indices of the positions inside Bounds, using the same semantics as FVoxelBox::Contains
+	static FVoxelInt32Buffer GetIndicesInBounds(const FVoxelVectorBuffer& Positions, const FVoxelBox& Bounds);
+
 public:
 	static void MakePalette(
 		const FVoxelTerminalBuffer& Buffer,
@@ -139,6 +139,9 @@ public:
 	const FVoxelBox LocalBounds;
 	const FVoxelTransformRef LocalToWorld;
 	const FVoxelComputeValue Compute;
+	// Hash of everything Compute depends on besides LocalToWorld & other brushes, stable across sessions
+	// 0 if unknown, eg for brushes added from blueprints
+	const uint64 PersistentHash;
 
 	VOXEL_COUNT_INSTANCES();
 
@@ -147,12 +150,14 @@ public:
 		const FVoxelBrushPriority Priority,
 		const FVoxelBox& LocalBounds,
 		const FVoxelTransformRef& LocalToWorld,
-		FVoxelComputeValue&& Compute)
+		FVoxelComputeValue&& Compute,
+		const uint64 PersistentHash = 0)
 		: DebugName(DebugName)
 		, Priority(Priority)
 		, LocalBounds(LocalBounds)
 		, LocalToWorld(LocalToWorld)
 		, Compute(MoveTemp(Compute))
+		, PersistentHash(PersistentHash)
 	{
 	}
 };
@@ -320,6 +325,12 @@ public:
 	TSharedPtr<FVoxelWorldChannel> FindChannel(FName Name);
 	TArray<FName> GetValidChannelNames() const;
 
+	// Hash of the brushes of all channels intersecting WorldBounds, stable across sessions
+	// Returns false if one of them has no persistent hash
+	bool GetPersistentBrushesHash(
+		const FVoxelBox& WorldBounds,
+		uint64& OutHash) const;
+
 	//~ Begin IVoxelWorldSubsystem Interface
 	virtual void Tick() override;
 	//~ End IVoxelWorldSubsystem Interface
@@ -99,6 +99,9 @@ public:
 
 	// Returns false if already invalidated
 	bool TrySetOnInvalidated(TVoxelUniqueFunction<void()>&& NewOnInvalidated);
+	// Unlike OnInvalidated, can be set before all dependencies are added: used to cancel the computation using this tracker
+	// Returns false if already invalidated
+	bool TrySetOnInvalidatedWhileComputing(TVoxelUniqueFunction<void()>&& NewOnInvalidatedWhileComputing);
 
 	template<typename T>
 	void AddObjectToKeepAlive(const TSharedPtr<T>& ObjectToKeepAlive)
@@ -117,6 +120,7 @@ private:
 	FVoxelFastCriticalSection CriticalSection;
 	TVoxelAtomic<bool> bIsInvalidated;
 	TVoxelUniqueFunction<void()> OnInvalidated;
+	TVoxelUniqueFunction<void()> OnInvalidatedWhileComputing;
 	TVoxelChunkedArray<FDependencyRef> DependencyRefs;
 	TVoxelArray<FSharedVoidPtr> ObjectsToKeepAlive;
 	TVoxelSet<TWeakPtr<FVoxelDependency>> AddedDependencies;
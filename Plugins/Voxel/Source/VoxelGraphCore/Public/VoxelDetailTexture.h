@@ -229,9 +229,15 @@ struct VOXELGRAPHCORE_API FVoxelDetailTextureDynamicMaterialParameter : public F
 
 	TArray<TWeakObjectPtr<UTexture2D>> Textures;
 	FSimpleMulticastDelegate OnChangedMulticast;
+	// Hash of the allocator format. The texture contents are hashed by each allocation ResourceHash
+	uint64 ContentHash = 0;
 
 	virtual void Apply(FName Name, UMaterialInstanceDynamic& Instance) const override;
 	virtual void AddOnChanged(const FSimpleDelegate& OnChanged) override;
+	virtual uint64 GetContentHash() const override
+	{
+		return ContentHash;
+	}
 };
 
 class VOXELGRAPHCORE_API FVoxelDetailTextureAllocator : public TSharedFromThis<FVoxelDetailTextureAllocator>
@@ -264,7 +270,32 @@ private:
 	FVoxelFastCriticalSection CriticalSection;
 
 	int32 SizeInBlocks_RequiresLock = 0;
-	TVoxelArray<FVoxelDetailTextureAllocationRange> FreeRanges_RequiresLock;
+	int32 NumAllocatedBlocks_RequiresLock = 0;
+	bool bShrinkQueued_RequiresLock = false;
+	// Free ranges bucketed by FloorLog2(Num), sorted by decreasing GetRangePriority
+	TVoxelArray<TVoxelArray<FVoxelDetailTextureAllocationRange>> SizeClassToFreeRanges_RequiresLock;
+	// Freed ranges waiting to be coalesced
+	TVoxelArray<FVoxelDetailTextureAllocationRange> PendingFreeRanges_RequiresLock;
+
+	int32 GetMinSizeInBlocks() const;
+	TVoxelArray<FVoxelDetailTextureAllocationRange>& GetFreeRanges(int32 SizeClass);
+	void AddFreeRange(const FVoxelDetailTextureAllocationRange& Range);
+	// Appends all the ranges then sorts each size class once
+	void AddFreeRanges(TConstVoxelArrayView<FVoxelDetailTextureAllocationRange> Ranges);
+	bool PopFreeRange(int32 Num, bool bAllowPartial, FVoxelDetailTextureAllocationRange& OutRange);
+	void CoalesceFreeRanges();
+	bool Grow();
+	bool TryShrink();
+	void Deallocate(TConstVoxelArrayView<FVoxelDetailTextureAllocationRange> Ranges);
+
+	// Lower is better: ranges closest to the top-left corner are used first so that the atlas can shrink
+	FORCEINLINE static int64 GetRangePriority(const FVoxelDetailTextureAllocationRange& Range)
+	{
+		return
+			(int64(FMath::Max(Range.X, Range.Y)) << 32) |
+			(int64(Range.Y) << 16) |
+			int64(Range.X);
+	}
 
 	FORCEINLINE void CheckRange(const FVoxelDetailTextureAllocationRange& Range) const
 	{
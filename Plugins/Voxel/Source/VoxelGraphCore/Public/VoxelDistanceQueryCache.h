@@ -0,0 +1,101 @@
+// Copyright Voxel Plugin, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "VoxelMinimal.h"
+
+class FVoxelRuntimeInfo;
+class FVoxelDependencyTracker;
+struct FVoxelFloatBuffer;
+
+// Game thread cache of the distance & gradient of a surface or float channel at a few positions
+// Meant for gameplay queries that run every frame, eg character gravity or ground distance, without going through collision
+// Positions are snapped to cells: each cell is queried once at its center and values are extrapolated using the gradient
+// Missing cells are batched and queried together as an async voxel task, at most MaxCellsPerFrame at a time
+// A single batch is in flight at once, its cells are available from the first flush after it completes
+// Graph game tasks run within the executor game thread budget: querying never blocks the game thread
+// Failed batches (missing channel, query errors, timeouts) are retried with an exponential backoff
+class VOXELGRAPHCORE_API FVoxelDistanceQueryCache
+{
+public:
+	const TWeakObjectPtr<UWorld> World;
+	const FName ChannelName;
+	const float CellSize;
+	const int32 MaxCellsPerFrame;
+	const int32 MaxCachedCells;
+
+	FVoxelDistanceQueryCache(
+		UWorld* InWorld,
+		FName InChannelName,
+		float InCellSize = 50.f,
+		int32 InMaxCellsPerFrame = 8,
+		int32 InMaxCachedCells = 256);
+	~FVoxelDistanceQueryCache();
+	UE_NONCOPYABLE(FVoxelDistanceQueryCache);
+
+	// Returns false if the cell has never been computed. Invalidated cells return their previous value until they are recomputed
+	// Cells that are missing or invalidated will be computed by the next Flush
+	bool Query(
+		const FVector& Position,
+		float& OutDistance,
+		FVector& OutGradient);
+
+	// Queue the cell containing Position without reading it, eg to request where a character will be next frame
+	void Prefetch(const FVector& Position);
+
+	// Read the results of the last batch if it completed, and start a new one for pending cells
+	// Never waits on the graph. Called by the first Query/Prefetch of every frame
+	void Flush();
+	void Reset();
+
+private:
+	struct FCell
+	{
+		float Distance = 0.f;
+		FVector3f Gradient = FVector3f::ZeroVector;
+		uint64 LastUsedFrame = 0;
+		bool bIsValid = false;
+		bool bIsPending = false;
+		TSharedPtr<FVoxelDependencyTracker> DependencyTracker;
+	};
+
+	struct FBatch
+	{
+		uint64 Id = 0;
+		double StartTime = 0.;
+		float GradientStep = 0.f;
+		TVoxelArray<FIntVector> Keys;
+		TSharedPtr<FVoxelRuntimeInfo> RuntimeInfo;
+		// Shared by the whole batch: an edit anywhere in it will recompute all its cells
+		TSharedPtr<FVoxelDependencyTracker> DependencyTracker;
+	};
+	struct FBatchResult
+	{
+		uint64 BatchId = 0;
+		TSharedPtr<const FVoxelFloatBuffer> Distances;
+	};
+	using FBatchResults = TQueue<FBatchResult, EQueueMode::Mpsc>;
+
+	uint64 LastFlushFrame = 0;
+	TVoxelMap<FIntVector, FCell> Cells;
+	TVoxelArray<FIntVector> PendingCells;
+
+	uint64 LastBatchId = 0;
+	TOptional<FBatch> InFlightBatch;
+	// Written by the async tasks, read on the game thread
+	const TSharedRef<FBatchResults> BatchResults = MakeVoxelShared<FBatchResults>();
+
+	double NextRetryTime = 0.;
+	double RetryDelay = 0.;
+
+	FCell& FindOrQueueCell(const FVector& Position, FIntVector& OutKey);
+	void FlushIfNeeded();
+	// Returns false on failure, in which case no batch is in flight
+	bool StartBatch(TConstVoxelArrayView<FIntVector> Keys);
+	void ProcessBatchResults();
+	// Returns false on failure, in which case the cells are left untouched
+	bool FinishBatch(const FBatch& Batch, const FVoxelFloatBuffer& Distances);
+	void EndBatch(FBatch& Batch);
+	void OnBatchResult(bool bSuccess);
+	void Trim();
+};
\ No newline at end of file
@@ -97,6 +97,10 @@ public:
 	TSharedPtr<FVoxelRuntime> GetRuntime() const;
 	USceneComponent* GetRootComponent() const;
 
+	// Hash of the graph, its parameters, the content of the assets they reference, the node & the actor transform, stable across sessions
+	// Returns 0 if the graph can't be found. Game thread only
+	uint64 ComputePersistentHash() const;
+
 	virtual UScriptStruct* GetNodeType() const
 	{
 		return StaticStructFast<NodeType>();
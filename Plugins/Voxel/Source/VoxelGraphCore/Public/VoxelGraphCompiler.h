@@ -35,6 +35,7 @@ public:
 	static void DisconnectVirtualPins(FGraph& Graph);
 	static void RemoveUnusedNodes(FGraph& Graph);
 	static void CheckForLoops(FGraph& Graph);
+	static void RemoveDuplicatedNodes(FGraph& Graph, const UVoxelGraph& VoxelGraph);
 
 private:
 	static bool ReplaceTemplatesImpl(FGraph& Graph);
@@ -5,8 +5,13 @@
 #include "VoxelMinimal.h"
 #include "VoxelNode.h"
 #include "VoxelISPCNodeHelpers.h"
+#include "Buffer/VoxelFloatBuffers.h"
 #include "VoxelISPCNode.generated.h"
 
+extern VOXELGRAPHCORE_API bool GVoxelFuseISPCNodes;
+
+struct FVoxelAnalyticGradientQueryParameter;
+
 USTRUCT(meta = (Abstract))
 struct VOXELGRAPHCORE_API FVoxelISPCNode : public FVoxelNode
 {
@@ -25,16 +30,97 @@ public:
 	};
 	virtual FString GenerateCode(FCode& Code) const VOXEL_PURE_VIRTUAL({});
 
+public:
+	class FPartialDerivatives
+	{
+	public:
+		const int32 Num;
+
+		FPartialDerivatives(
+			const FVoxelISPCNode& Node,
+			const int32 Num,
+			const TConstVoxelArrayView<const FVoxelBuffer*> Buffers)
+			: Num(Num)
+			, Node(Node)
+			, Buffers(Buffers)
+		{
+		}
+
+		// Value of an input or output pin
+		template<typename T>
+		const T& Get(const FName PinName) const
+		{
+			const FVoxelBuffer& Buffer = GetBuffer(PinName);
+			checkVoxelSlow(Buffer.IsA<T>());
+			return static_cast<const T&>(Buffer);
+		}
+		const FVoxelBuffer& GetBuffer(FName PinName) const;
+
+		// Allocates Outputs and runs Kernel on the buffers of InputPins followed by Outputs
+		void RunKernel(
+			FVoxelNodeISPCPtr Kernel,
+			TConstVoxelArrayView<FName> InputPins,
+			TVoxelArrayView<FVoxelFloatBufferStorage> Outputs) const;
+
+		template<typename LambdaType>
+		FVoxelFloatBuffer MakeDerivative(LambdaType&& Lambda) const
+		{
+			FVoxelFloatBufferStorage Storage;
+			Storage.Allocate(Num);
+			for (int32 Index = 0; Index < Num; Index++)
+			{
+				Storage[Index] = Lambda(Index);
+			}
+			return FVoxelFloatBuffer::Make(Storage);
+		}
+
+		// Derivative of Output relative to Input, Input being a float input or a component of a vector input
+		void Add(
+			const FVoxelFloatBuffer& Output,
+			const FVoxelFloatBuffer& Input,
+			const FVoxelFloatBuffer& Derivative);
+
+	private:
+		const FVoxelISPCNode& Node;
+		const TConstVoxelArrayView<const FVoxelBuffer*> Buffers;
+
+		struct FTerm
+		{
+			const FVoxelFloatBuffer* Output = nullptr;
+			const FVoxelFloatBuffer* Input = nullptr;
+			FVoxelFloatBuffer Derivative;
+		};
+		TVoxelArray<FTerm, TVoxelInlineAllocator<6>> Terms;
+
+		friend FVoxelISPCNode;
+	};
+	// Used for analytic gradients, return false if not supported
+	// Inputs that are not in Derivatives are considered to have no effect on the outputs
+	virtual bool ComputePartialDerivatives(FPartialDerivatives& Derivatives) const
+	{
+		return false;
+	}
+
 public:
 	//~ Begin FVoxelNode Interface
 	virtual bool IsPureNode() const override
 	{
 		return true;
 	}
+	virtual bool IsPositionIndependent() const override
+	{
+		return true;
+	}
 	virtual void PreCompile() override;
 	virtual FVoxelComputeValue CompileCompute(FName PinName) const override;
 	//~ End FVoxelNode Interface
 
+public:
+	// InputNode must have a single output pin, only linked to PinName
+	// InputNode will then be run chunk by chunk in this node's task, with its outputs kept in a small per-chunk scratch
+	// instead of full-size buffers
+	void FuseInput(FName PinName, const TSharedRef<FVoxelISPCNode>& InputNode);
+
 private:
 	struct FCachedPin
 	{
@@ -42,8 +128,35 @@ private:
 		bool bIsInput = false;
 		FVoxelPinType PinType;
 		FVoxelPinRuntimeId PinId;
+
+		// Input pins only
+		TSharedPtr<const FVoxelISPCNode> FusedNode;
+		// Output pins of fused nodes only
+		TVoxelArray<int32, TVoxelInlineAllocator<4>> TerminalTypeSizes;
 	};
 
 	FVoxelNodeISPCPtr CachedPtr = nullptr;
 	TVoxelArray<FCachedPin> CachedPins;
+	bool bHasFusedInputs = false;
+
+	struct FFusedContext;
+
+	void GatherInputs(
+		const FVoxelQuery& Query,
+		bool bFuse,
+		TVoxelArray<FVoxelFutureValue, TVoxelInlineAllocator<16>>& OutInputValues) const;
+
+	void PropagateGradients(
+		const FVoxelAnalyticGradientQueryParameter& GradientQueryParameter,
+		int32 Num,
+		TConstVoxelArrayView<const FVoxelBuffer*> Buffers) const;
+
+	void ExecuteFused(
+		int32 Num,
+		TConstVoxelArrayView<FVoxelFutureValue> InputValues,
+		TConstVoxelArrayView<TSharedRef<FVoxelFutureValueStateImpl>> OutputStates) const;
+
+	TVoxelArray<int32, TVoxelInlineAllocator<4>> AddFusedKernel(
+		FFusedContext& Context,
+		TVoxelArray<TSharedRef<FVoxelBuffer>, TVoxelInlineAllocator<4>>* OutOutputBuffers) const;
 };
\ No newline at end of file
@@ -529,6 +529,12 @@ public:
 	{
 		return false;
 	}
+	// True if the node only reads the query position through its input pins
+	// Used to evaluate height-only subgraphs on the 2D footprint of grid queries
+	virtual bool IsPositionIndependent() const
+	{
+		return false;
+	}
 
 	virtual void ReturnToPool();
 
@@ -19,6 +19,17 @@ struct IVoxelNodeStatProvider
 	virtual FText GetText(const UEdGraphNode& Node) = 0;
 };
 extern VOXELGRAPHCORE_API TArray<IVoxelNodeStatProvider*> GVoxelNodeStatProviders;
+#else
+// Node stats for packaged builds, toggled with voxel.nodestats.Enable
+// Only one in voxel.nodestats.SampleRate scopes per thread is timed, totals are extrapolated from the samples
+extern VOXELGRAPHCORE_API bool GVoxelEnableRuntimeNodeStats;
+
+struct VOXELGRAPHCORE_API FVoxelRuntimeNodeStats
+{
+	static void Clear();
+	// Writes CSV if Path ends with .csv, JSON otherwise
+	static bool Export(const FString& Path);
+};
 #endif
 
 class VOXELGRAPHCORE_API FVoxelNodeStatScope
@@ -31,43 +42,54 @@ public:
 		{
 			return;
 		}
+#else
+		if (!GVoxelEnableRuntimeNodeStats ||
+			!ShouldSample())
+		{
+			return;
+		}
+#endif
 
 		Node = &InNode;
 		Count = InCount;
 		StartTime = FPlatformTime::Seconds();
-#endif
 	}
 	FORCEINLINE ~FVoxelNodeStatScope()
 	{
-#if WITH_EDITOR
 		if (IsEnabled())
 		{
-			RecordStats(FPlatformTime::Seconds() - StartTime);
+			RecordStats(*Node, FPlatformTime::Seconds() - StartTime, Count);
 		}
-#endif
 	}
 
 	FORCEINLINE bool IsEnabled() const
 	{
-#if WITH_EDITOR
 		return Node != nullptr;
-#else
-		return false;
-#endif
 	}
 	FORCEINLINE void SetCount(const int32 NewCount)
 	{
-#if WITH_EDITOR
 		Count = NewCount;
-#endif
+	}
+	// For scopes also running the work of other nodes, eg fused ISPC nodes
+	// The time is recorded for OtherNode and removed from this scope
+	FORCEINLINE void RecordOtherNode(const IVoxelNodeInterface& OtherNode, const double Duration, const int64 OtherCount)
+	{
+		if (!IsEnabled())
+		{
+			return;
+		}
+
+		StartTime += Duration;
+		RecordStats(OtherNode, Duration, OtherCount);
 	}
 
 private:
-#if WITH_EDITOR
 	const IVoxelNodeInterface* Node = nullptr;
 	int64 Count = 0;
 	double StartTime = 0;
 
-	void RecordStats(const double Duration) const;
+	static void RecordStats(const IVoxelNodeInterface& Node, double Duration, int64 Count);
+#if !WITH_EDITOR
+	static bool ShouldSample();
 #endif
 };
\ No newline at end of file
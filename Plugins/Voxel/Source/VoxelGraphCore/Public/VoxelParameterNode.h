@@ -19,4 +19,11 @@ struct FVoxelNode_Parameter : public FVoxelNode
 	FName ParameterName;
 
 	VOXEL_OUTPUT_PIN(FVoxelWildcard, Value);
+
+	//~ Begin FVoxelNode Interface
+	virtual bool IsPositionIndependent() const override
+	{
+		return true;
+	}
+	//~ End FVoxelNode Interface
 };
\ No newline at end of file
@@ -68,4 +68,38 @@ private:
 	mutable TOptional<FVoxelVectorBuffer> CachedPositions_RequiresLock;
 
 	void CheckBounds() const;
+};
+// Forward-mode gradients: maps float buffers to their gradient relative to the query position
+// Filled by GetGradient with the position buffers, then by the nodes supporting derivatives
+USTRUCT()
+struct VOXELGRAPHCORE_API FVoxelAnalyticGradientQueryParameter : public FVoxelQueryParameter
+{
+	GENERATED_BODY()
+	GENERATED_VOXEL_QUERY_PARAMETER_BODY()
+
+public:
+	void AddPositions(const FVoxelVectorBuffer& Positions) const;
+	int32 GetNumPositions() const;
+	void AddGradient(
+		const FVoxelFloatBuffer& Value,
+		const FVoxelVectorBuffer& Gradient) const;
+
+	// Constant values have a zero gradient, unless there is a single position: every buffer is then constant,
+	// so constant values not explicitly added are treated as unknown
+	// Returns false if Value was not computed from the positions by nodes supporting derivatives
+	bool FindGradient(
+		const FVoxelFloatBuffer& Value,
+		FVoxelVectorBuffer& OutGradient) const;
+
+private:
+	struct FEntry
+	{
+		// Keep the storage alive so that its address isn't reused
+		TSharedPtr<const FVoxelBufferStorage> Storage;
+		FVoxelVectorBuffer Gradient;
+	};
+
+	mutable FVoxelFastCriticalSection CriticalSection;
+	mutable int32 NumPositions_RequiresLock = 0;
+	mutable TVoxelMap<const FVoxelBufferStorage*, FEntry> StorageToEntry_RequiresLock;
 };
\ No newline at end of file
@@ -400,6 +400,10 @@ public:
 	FVoxelQuery EnterScope(const FVoxelNode& Node) const;
 	FVoxelQuery MakeNewQuery(const TSharedRef<FVoxelQueryContext>& NewContext) const;
 	FVoxelQuery MakeNewQuery(const TSharedRef<const FVoxelQueryParameters>& NewParameters) const;
+	// Dependencies of the new query will only be added to NewDependencyTracker
+	FVoxelQuery MakeNewQuery(
+		const TSharedRef<const FVoxelQueryParameters>& NewParameters,
+		const TSharedRef<FVoxelDependencyTracker>& NewDependencyTracker) const;
 
 public:
 	FORCEINLINE const FVoxelRuntimeInfo& GetInfo(const EVoxelQueryInfo Info) const
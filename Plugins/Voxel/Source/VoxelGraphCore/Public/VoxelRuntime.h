@@ -12,6 +12,15 @@ struct FVoxelSubsystem;
 
 using FOnChunkChanged = std::function<void(const FBox&, int32, int32)>;
 
+struct FVoxelChunkChange
+{
+	FBox Bounds = FBox(ForceInit);
+	int32 LOD = 0;
+	int32 ChunkSize = 0;
+};
+// Called once per runtime tick with all the chunks changed during that tick, in order
+using FOnChunksChanged = std::function<void(TConstVoxelArrayView<FVoxelChunkChange>)>;
+
 class VOXELGRAPHCORE_API FVoxelRuntime
 	: public TSharedFromThis<FVoxelRuntime>
 	, public TVoxelRuntimeInfo<FVoxelRuntime>
@@ -34,6 +43,9 @@ public:
 	FVoxelOptionalBox GetBounds() const;
 
 	TMap<uint8, FOnChunkChanged>OnChunkChangedMap;
+	TMap<uint8, FOnChunksChanged> OnChunksChangedMap;
+
+	void NotifyChunkChanged(const FBox& Bounds, int32 LOD, int32 ChunkSize);
 
 public:
 	FORCEINLINE const FVoxelRuntimeInfo& GetRuntimeInfoRef() const
@@ -76,6 +88,10 @@ private:
 	TVoxelSet<TWeakObjectPtr<USceneComponent>> Components;
 	TVoxelMap<UClass*, TArray<TWeakObjectPtr<USceneComponent>>> ComponentPools;
 
+	TVoxelArray<FVoxelChunkChange> PendingChunkChanges;
+
+	void FlushChunkChanges();
+
 #if WITH_EDITOR
 	struct FEditorTicker : public FVoxelTicker
 	{
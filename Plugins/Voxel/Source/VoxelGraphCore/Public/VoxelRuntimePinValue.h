@@ -184,6 +184,8 @@ public:
 		return Type.IsValid();
 	}
 	bool IsValidValue_Slow() const;
+	// See FVoxelVirtualStruct::GetContentHash, 0 if unknown
+	uint64 GetContentHash() const;
 
 public:
 	FORCEINLINE const FVoxelPinType& GetType() const
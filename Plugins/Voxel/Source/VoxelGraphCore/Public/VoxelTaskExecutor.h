@@ -32,6 +32,8 @@ public:
 	}
 	void LogAllTasks();
 	void AddGroup(const TSharedRef<FVoxelTaskGroup>& Group);
+	// Render thread only. Called when a render task is added to Group
+	void AddRenderGroup(FVoxelTaskGroup& Group);
 
 public:
 	//~ Begin FVoxelSingleton Interface
@@ -163,7 +165,24 @@ private:
 
 	FTaskGroupArray Groups;
 
-	TQueue<TWeakPtr<FVoxelTaskGroup>, EQueueMode::Mpsc> GameGroupsQueue;
+	// Groups with game tasks sorted by priority, written by the async gather task
+	FVoxelFastCriticalSection GatheredGameGroupsCriticalSection;
+	TVoxelArray<TWeakPtr<FVoxelTaskGroup>> GatheredGameGroups_RequiresLock;
+	bool bHasGatheredGameGroups_RequiresLock = false;
+	TVoxelAtomic<bool> bIsGatheringGameGroups = false;
+
+	// Game thread only: groups left to process from the last gather
+	TVoxelArray<TWeakPtr<FVoxelTaskGroup>> GameGroups;
+	int32 GameGroupIndex = 0;
+	double SmoothedFrameTime = 0;
+	double LastGameTasksTime = 0;
+
+	double GetGameTasksBudget();
+	void ProcessGameTasks();
+	void GatherGameGroups();
+
+	// Groups with pending render tasks, each group is in it at most once
+	TQueue<TWeakPtr<FVoxelTaskGroup>, EQueueMode::Mpsc> RenderGroupsQueue;
 
 	TSharedPtr<FVoxelTaskGroup> GetGroupToProcess(const FThread* Thread);
 };
\ No newline at end of file
@@ -118,12 +118,15 @@ public:
 
 public:
 	TVoxelAtomic<const void*> AsyncProcessor = nullptr;
+	// True if the group is in the executor render queue. Cleared by the render thread before processing its render tasks
+	TVoxelAtomic<bool> bIsInRenderQueue = false;
 
 	FORCEINLINE bool HasGameTasks() const { return !GameTasks.IsEmpty(); }
 	FORCEINLINE bool HasRenderTasks() const { return !RenderTasks.IsEmpty(); }
 	FORCEINLINE bool HasAsyncTasks() const { return !AsyncTasks.IsEmpty(); }
 
-	void ProcessGameTasks();
+	// Runs at least one task, then stops once EndTime is reached. The remaining tasks will be processed by the next call
+	void ProcessGameTasks(double EndTime = MAX_dbl);
 	void ProcessRenderTasks(FRDGBuilder& GraphBuilder);
 	void ProcessAsyncTasks();
 
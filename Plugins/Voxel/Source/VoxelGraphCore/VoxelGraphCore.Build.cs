@@ -15,6 +15,13 @@ public class VoxelGraphCore : ModuleRules_Voxel
 			}
 		);
 
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Json",
+			}
+		);
+
 		if (Target.bBuildEditor)
 		{
 			PublicDependencyModuleNames.AddRange(
@@ -77,6 +77,11 @@ FVoxelNodeAliases::TValue<FVoxelCollider> FVoxelMarchingCubeCollisionExecNode::C
 		{
 			return GetNodeRuntime().Get(PhysicalMaterialPin, Query);
 		};
+
+		VOXEL_CALL_NODE_BIND(SimplificationErrorPin)
+		{
+			return GetNodeRuntime().Get(SimplificationErrorPin, Query);
+		};
 	};
 }
 
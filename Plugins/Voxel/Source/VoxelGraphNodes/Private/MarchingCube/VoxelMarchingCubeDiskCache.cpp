@@ -0,0 +1,474 @@
+// Copyright Voxel Plugin, Inc. All Rights Reserved.
+
+#include "MarchingCube/VoxelMarchingCubeDiskCache.h"
+#include "MarchingCube/VoxelMarchingCubeNodes.h"
+#include "VoxelChannel.h"
+#include "VoxelExecNode.h"
+#include "Sculpt/VoxelSculptStorage.h"
+#include "Sculpt/VoxelSculptStorageData.h"
+#include "Hash/CityHash.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Compression.h"
+#include "HAL/FileManager.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHNODES_API, bool, GVoxelMarchingCubeDiskCache, false,
+	"voxel.marchingcube.DiskCache",
+	"If true, marching cube surfaces will be cached on disk & reused across sessions. Only enable for mostly static worlds");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHNODES_API, int32, GVoxelMarchingCubeDiskCacheMaxSizeMB, 2048,
+	"voxel.marchingcube.DiskCacheMaxSizeMB",
+	"Max size of the marching cube disk cache in MB. Least recently used entries are deleted when a runtime is created. 0 for no limit");
+
+VOXEL_CONSOLE_COMMAND(
+	ClearMarchingCubeDiskCache,
+	"voxel.marchingcube.ClearDiskCache",
+	"Delete all the marching cube surfaces cached on disk")
+{
+	FVoxelMarchingCubeDiskCache::ClearAll();
+}
+
+constexpr uint32 GVoxelMarchingCubeDiskCacheMagic = 0x4D435643;
+// Bump whenever FVoxelMarchingCubeSurface or the marching cube processor changes
+constexpr uint32 GVoxelMarchingCubeDiskCacheVersion = 2;
+
+TVoxelAtomic<bool> GVoxelMarchingCubeDiskCacheIsTrimming = false;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+namespace VoxelMarchingCubeDiskCache
+{
+	template<typename T>
+	void SerializeArray(FArchive& Ar, TVoxelArray<T>& Array)
+	{
+		checkStatic(std::is_trivially_copyable_v<T>);
+
+		int32 Num = Array.Num();
+		Ar << Num;
+
+		if (Ar.IsLoading())
+		{
+			if (Num < 0 ||
+				int64(Num) * sizeof(T) > Ar.TotalSize() - Ar.Tell())
+			{
+				Ar.SetError();
+				return;
+			}
+
+			FVoxelUtilities::SetNumFast(Array, Num);
+		}
+
+		Ar.Serialize(Array.GetData(), Num * sizeof(T));
+	}
+
+	void SerializeSurface(FArchive& Ar, FVoxelMarchingCubeSurface& Surface)
+	{
+		Ar << Surface.LOD;
+		Ar << Surface.ChunkSize;
+		Ar << Surface.ScaledVoxelSize;
+		Ar << Surface.ChunkBounds.Min;
+		Ar << Surface.ChunkBounds.Max;
+		Ar << Surface.NumEdgeVertices;
+
+		SerializeArray(Ar, Surface.Cells);
+		SerializeArray(Ar, Surface.Indices);
+		SerializeArray(Ar, Surface.Vertices);
+		SerializeArray(Ar, Surface.CellIndices);
+
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			SerializeArray(Ar, Surface.TransitionIndices[Direction]);
+			SerializeArray(Ar, Surface.TransitionVertices[Direction]);
+			SerializeArray(Ar, Surface.TransitionCellIndices[Direction]);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+TSharedPtr<FVoxelMarchingCubeDiskCache> FVoxelMarchingCubeDiskCache::Create(const FVoxelExecNodeRuntime& NodeRuntime)
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(IsInGameThread());
+
+	if (!GVoxelMarchingCubeDiskCache)
+	{
+		return nullptr;
+	}
+
+	// Scanning the directory can be slow, don't block runtime creation
+	if (!GVoxelMarchingCubeDiskCacheIsTrimming.Exchange(true))
+	{
+		AsyncVoxelTask([]
+		{
+			Trim();
+			GVoxelMarchingCubeDiskCacheIsTrimming.Store(false);
+		});
+	}
+
+	const uint64 PersistentHash = NodeRuntime.ComputePersistentHash();
+	if (PersistentHash == 0)
+	{
+		return nullptr;
+	}
+
+	uint64 SculptHash = 0;
+	if (const TSharedPtr<const FVoxelRuntimeParameter_SculptStorage> Parameter = NodeRuntime.FindParameter<FVoxelRuntimeParameter_SculptStorage>())
+	{
+		if (Parameter->Data)
+		{
+			SculptHash = Parameter->Data->GetContentHash();
+		}
+	}
+
+	const uint64 Hashes[] = { GVoxelMarchingCubeDiskCacheVersion, PersistentHash, SculptHash };
+	const uint64 RuntimeHash = CityHash64(reinterpret_cast<const char*>(Hashes), sizeof(Hashes));
+
+	FMatrix LocalToWorld = FMatrix::Identity;
+	if (const USceneComponent* RootComponent = NodeRuntime.GetRootComponent())
+	{
+		LocalToWorld = RootComponent->GetComponentTransform().ToMatrixWithScale();
+	}
+
+	LOG_VOXEL(Verbose, "Marching cube disk cache for %s: %016llx", *NodeRuntime.GetGraphPath(), RuntimeHash);
+
+	return MakeVoxelShared<FVoxelMarchingCubeDiskCache>(
+		RuntimeHash,
+		LocalToWorld,
+		FVoxelWorldChannelManager::Get(NodeRuntime.GetWorld()));
+}
+
+FString FVoxelMarchingCubeDiskCache::GetDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("VoxelMarchingCubeCache");
+}
+
+void FVoxelMarchingCubeDiskCache::ClearAll()
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (!IFileManager::Get().DeleteDirectory(*GetDirectory(), false, true))
+	{
+		LOG_VOXEL(Warning, "Failed to delete %s", *GetDirectory());
+	}
+}
+
+void FVoxelMarchingCubeDiskCache::Trim()
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	const int64 MaxSize = int64(GVoxelMarchingCubeDiskCacheMaxSizeMB) * 1024 * 1024;
+	if (MaxSize <= 0)
+	{
+		return;
+	}
+
+	struct FEntry
+	{
+		FString Path;
+		FDateTime LastUsed;
+		int64 Size = 0;
+	};
+	TVoxelArray<FEntry> Entries;
+	int64 TotalSize = 0;
+
+	IFileManager::Get().IterateDirectoryStat(*GetDirectory(), [&](const TCHAR* Path, const FFileStatData& StatData)
+	{
+		if (StatData.bIsDirectory ||
+			!FStringView(Path).EndsWith(TEXT(".voxelsurface")))
+		{
+			return true;
+		}
+
+		Entries.Add(FEntry
+		{
+			Path,
+			StatData.ModificationTime,
+			StatData.FileSize
+		});
+		TotalSize += StatData.FileSize;
+		return true;
+	});
+
+	if (TotalSize <= MaxSize)
+	{
+		return;
+	}
+
+	// Entries are touched when loaded, so the oldest modification time is the least recently used
+	Entries.Sort([](const FEntry& A, const FEntry& B)
+	{
+		return A.LastUsed < B.LastUsed;
+	});
+
+	int32 NumDeleted = 0;
+	for (const FEntry& Entry : Entries)
+	{
+		if (TotalSize <= MaxSize)
+		{
+			break;
+		}
+
+		if (IFileManager::Get().Delete(*Entry.Path, false, false, true))
+		{
+			TotalSize -= Entry.Size;
+			NumDeleted++;
+		}
+	}
+
+	LOG_VOXEL(Log, "Marching cube disk cache: deleted %d entries, %lldMB left", NumDeleted, TotalSize / (1024 * 1024));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool FVoxelMarchingCubeDiskCache::GetChunkKey(
+	const FVoxelBox& Bounds,
+	const int32 LOD,
+	const int32 ChunkSize,
+	const float VoxelSize,
+	uint64& OutKey) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	const TSharedPtr<FVoxelWorldChannelManager> ChannelManager = WeakChannelManager.Pin();
+	if (!ChannelManager)
+	{
+		return false;
+	}
+
+	uint64 BrushesHash = 0;
+	if (!ChannelManager->GetPersistentBrushesHash(Bounds.TransformBy(LocalToWorld), BrushesHash))
+	{
+		return false;
+	}
+
+	struct FKey
+	{
+		uint64 RuntimeHash;
+		uint64 BrushesHash;
+		FVector3d Min;
+		FVector3d Max;
+		int32 LOD;
+		int32 ChunkSize;
+		float VoxelSize;
+		uint32 Padding;
+	};
+
+	FKey Key;
+	FMemory::Memzero(Key);
+	Key.RuntimeHash = RuntimeHash;
+	Key.BrushesHash = BrushesHash;
+	Key.Min = Bounds.Min;
+	Key.Max = Bounds.Max;
+	Key.LOD = LOD;
+	Key.ChunkSize = ChunkSize;
+	Key.VoxelSize = VoxelSize;
+
+	OutKey = CityHash64(reinterpret_cast<const char*>(&Key), sizeof(Key));
+	return true;
+}
+
+TSharedPtr<const FVoxelMarchingCubeSurface> FVoxelMarchingCubeDiskCache::Load(
+	const uint64 Key,
+	const TConstVoxelArrayView<float> Probes,
+	const float Tolerance) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (!ensure(Probes.Num() == NumProbes) ||
+		IsInvalidated(Key))
+	{
+		return nullptr;
+	}
+
+	const FString Path = GetPath(Key);
+
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *Path, FILEREAD_Silent))
+	{
+		return nullptr;
+	}
+
+	FMemoryReader HeaderReader(FileData);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	uint64 FileKey = 0;
+	int32 UncompressedSize = 0;
+	HeaderReader << Magic;
+	HeaderReader << Version;
+	HeaderReader << FileKey;
+	HeaderReader << UncompressedSize;
+
+	if (HeaderReader.IsError() ||
+		Magic != GVoxelMarchingCubeDiskCacheMagic ||
+		Version != GVoxelMarchingCubeDiskCacheVersion ||
+		FileKey != Key ||
+		UncompressedSize <= 0)
+	{
+		LOG_VOXEL(Verbose, "Discarding invalid marching cube cache entry %s", *Path);
+		IFileManager::Get().Delete(*Path, false, false, true);
+		return nullptr;
+	}
+
+	TArray<uint8> Data;
+	Data.SetNumUninitialized(UncompressedSize);
+	{
+		VOXEL_SCOPE_COUNTER("Decompress");
+
+		const int32 HeaderSize = HeaderReader.Tell();
+		if (!FCompression::UncompressMemory(
+			NAME_Oodle,
+			Data.GetData(),
+			Data.Num(),
+			FileData.GetData() + HeaderSize,
+			FileData.Num() - HeaderSize))
+		{
+			LOG_VOXEL(Verbose, "Failed to decompress marching cube cache entry %s", *Path);
+			IFileManager::Get().Delete(*Path, false, false, true);
+			return nullptr;
+		}
+	}
+
+	FMemoryReader Reader(Data);
+
+	TVoxelArray<float> CachedProbes;
+	VoxelMarchingCubeDiskCache::SerializeArray(Reader, CachedProbes);
+
+	if (Reader.IsError() ||
+		CachedProbes.Num() != NumProbes)
+	{
+		return nullptr;
+	}
+
+	for (int32 Index = 0; Index < NumProbes; Index++)
+	{
+		if (FMath::Abs(CachedProbes[Index] - Probes[Index]) > Tolerance)
+		{
+			// Something not in the key changed, eg a brush or sculpt data
+			return nullptr;
+		}
+	}
+
+	const TSharedRef<FVoxelMarchingCubeSurface> Surface = MakeVoxelShared<FVoxelMarchingCubeSurface>();
+	VoxelMarchingCubeDiskCache::SerializeSurface(Reader, *Surface);
+
+	if (Reader.IsError())
+	{
+		return nullptr;
+	}
+
+	// Mark the entry as recently used for Trim
+	IFileManager::Get().SetTimeStamp(*Path, FDateTime::UtcNow());
+
+	return Surface;
+}
+
+void FVoxelMarchingCubeDiskCache::Save(
+	const uint64 Key,
+	const TConstVoxelArrayView<float> Probes,
+	const FVoxelMarchingCubeSurface& Surface) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (!ensure(Probes.Num() == NumProbes) ||
+		IsInvalidated(Key))
+	{
+		return;
+	}
+
+	TArray<uint8> Data;
+	{
+		FMemoryWriter Writer(Data);
+
+		TVoxelArray<float> ProbesCopy(Probes.GetData(), Probes.Num());
+		VoxelMarchingCubeDiskCache::SerializeArray(Writer, ProbesCopy);
+		VoxelMarchingCubeDiskCache::SerializeSurface(Writer, ConstCast(Surface));
+	}
+
+	TArray<uint8> FileData;
+	{
+		FMemoryWriter Writer(FileData);
+
+		uint32 Magic = GVoxelMarchingCubeDiskCacheMagic;
+		uint32 Version = GVoxelMarchingCubeDiskCacheVersion;
+		uint64 FileKey = Key;
+		int32 UncompressedSize = Data.Num();
+		Writer << Magic;
+		Writer << Version;
+		Writer << FileKey;
+		Writer << UncompressedSize;
+	}
+
+	{
+		VOXEL_SCOPE_COUNTER("Compress");
+
+		const int32 HeaderSize = FileData.Num();
+
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Oodle, Data.Num());
+		FileData.SetNumUninitialized(HeaderSize + CompressedSize);
+
+		if (!FCompression::CompressMemory(
+			NAME_Oodle,
+			FileData.GetData() + HeaderSize,
+			CompressedSize,
+			Data.GetData(),
+			Data.Num()))
+		{
+			ensure(false);
+			return;
+		}
+
+		FileData.SetNum(HeaderSize + CompressedSize);
+	}
+
+	// Write to a temporary file first so that a crash or a concurrent load never sees a partial entry
+	const FString Path = GetPath(Key);
+	const FString TempPath = Path + FString::Printf(TEXT(".%u.tmp"), FPlatformTLS::GetCurrentThreadId());
+
+	if (!FFileHelper::SaveArrayToFile(FileData, *TempPath) ||
+		!IFileManager::Get().Move(*Path, *TempPath, true, true, false, true))
+	{
+		LOG_VOXEL(Verbose, "Failed to write marching cube cache entry %s", *Path);
+		IFileManager::Get().Delete(*TempPath, false, false, true);
+	}
+}
+
+void FVoxelMarchingCubeDiskCache::Invalidate(const uint64 Key)
+{
+	{
+		VOXEL_SCOPE_LOCK(CriticalSection);
+
+		if (InvalidatedKeys_RequiresLock.Contains(Key))
+		{
+			return;
+		}
+		InvalidatedKeys_RequiresLock.Add(Key);
+	}
+
+	IFileManager::Get().Delete(*GetPath(Key), false, false, true);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+FString FVoxelMarchingCubeDiskCache::GetPath(const uint64 Key) const
+{
+	return GetDirectory() / FString::Printf(TEXT("%016llx.voxelsurface"), Key);
+}
+
+bool FVoxelMarchingCubeDiskCache::IsInvalidated(const uint64 Key) const
+{
+	VOXEL_SCOPE_LOCK(CriticalSection);
+	return InvalidatedKeys_RequiresLock.Contains(Key);
+}
\ No newline at end of file
@@ -3,19 +3,68 @@
 #include "MarchingCube/VoxelMarchingCubeExecNode.h"
 #include "MarchingCube/VoxelMarchingCubeNodes.h"
 #include "MarchingCube/VoxelMarchingCubeMesh.h"
+#include "MarchingCube/VoxelMarchingCubeDiskCache.h"
 #include "VoxelRuntime.h"
 #include "VoxelSettings.h"
 #include "VoxelDebugNode.h"
 #include "VoxelGradientNodes.h"
+#include "VoxelPositionQueryParameter.h"
 #include "VoxelDetailTextureNodes.h"
 #include "VoxelScreenSizeChunkSpawner.h"
 #include "Rendering/VoxelMeshComponent.h"
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHNODES_API, bool, GVoxelMarchingCubeDeferDistanceFields, true,
+	"voxel.marchingcube.DeferDistanceFields",
+	"If true, distance fields are computed after the chunk mesh is displayed, with a lower priority. Only read when the runtime is created");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHNODES_API, float, GVoxelMarchingCubeDistanceFieldPriorityOffset, 1000000.f,
+	"voxel.marchingcube.DistanceFieldPriorityOffset",
+	"Priority offset added to deferred distance field tasks. Closest tasks are computed first, so a high value computes distance fields after meshes");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHNODES_API, int32, GVoxelMarchingCubeMaxDistanceFieldUpdatesPerFrame, 16,
+	"voxel.marchingcube.MaxDistanceFieldUpdatesPerFrame",
+	"Max number of deferred distance fields to apply to chunk meshes per frame. Each update recreates the chunk render state");
+
+uint64 FVoxelMarchingCubeExecNodeMesh::GetContentHash() const
+{
+	if (!Mesh)
+	{
+		// Empty chunk
+		return Collider ? 0 : 1;
+	}
+
+	// If OnChanged is skipped the previous mesh & its detail texture allocations are kept alive, so the mesh hash
+	// only needs to cover the detail texture contents, not where they are allocated
+	const uint64 MeshHash = Mesh->GetContentHash();
+	const uint64 ColliderHash = Collider ? Collider->GetContentHash() : 1;
+	if (MeshHash == 0 ||
+		ColliderHash == 0)
+	{
+		return 0;
+	}
+
+	return FVoxelUtilities::MurmurHashMulti(
+		MeshHash,
+		ColliderHash,
+		MeshSettings.Get(),
+		BodyInstance.Get());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 FVoxelNodeAliases::TValue<FVoxelMarchingCubeExecNodeMesh> FVoxelMarchingCubeExecNode::CreateMesh(
 	const FVoxelQuery& InQuery,
 	const float VoxelSize,
 	const int32 ChunkSize,
-	const FVoxelBox& Bounds) const
+	const FVoxelBox& Bounds,
+	const TSharedPtr<FVoxelMarchingCubeDiskCache>& DiskCache,
+	const bool bIsInvalidation,
+	const bool bDeferDistanceField) const
 {
 	checkVoxelSlow(FVoxelTaskReferencer::Get().IsReferenced(this));
 
@@ -35,44 +84,10 @@ FVoxelNodeAliases::TValue<FVoxelMarchingCubeExecNodeMesh> FVoxelMarchingCubeExec
 		return GetNodeRuntime().Get(SurfacePin, Query.MakeNewQuery(Parameters));
 	};
 
-	const TValue<FVoxelMarchingCubeSurface> MarchingCubeSurface = VOXEL_CALL_NODE(FVoxelNode_GenerateMarchingCubeSurface, SurfacePin, Query)
-	{
-		VOXEL_CALL_NODE_BIND(DistancePin, FutureSurface)
-		{
-			return VOXEL_ON_COMPLETE(FutureSurface)
-			{
-				return FutureSurface->GetDistance(Query);
-			};
-		};
-		VOXEL_CALL_NODE_BIND(VoxelSizePin, VoxelSize)
-		{
-			return VoxelSize;
-		};
-		VOXEL_CALL_NODE_BIND(ChunkSizePin, ChunkSize)
-		{
-			return ChunkSize;
-		};
-		VOXEL_CALL_NODE_BIND(BoundsPin, Bounds)
-		{
-			return Bounds;
-		};
-		VOXEL_CALL_NODE_BIND(EnableTransitionsPin)
-		{
-			return true;
-		};
-		VOXEL_CALL_NODE_BIND(PerfectTransitionsPin)
-		{
-			return GetNodeRuntime().Get(PerfectTransitionsPin, Query);
-		};
-		VOXEL_CALL_NODE_BIND(EnableDistanceChecksPin)
-		{
-			return true;
-		};
-		VOXEL_CALL_NODE_BIND(DistanceChecksTolerancePin)
-		{
-			return GetNodeRuntime().Get(DistanceChecksTolerancePin, Query);
-		};
-	};
+	const TValue<FVoxelMarchingCubeSurface> MarchingCubeSurface =
+		DiskCache
+		? GenerateSurface_DiskCache(Query, FutureSurface, VoxelSize, ChunkSize, Bounds, DiskCache.ToSharedRef(), bIsInvalidation)
+		: GenerateSurface(Query, FutureSurface, VoxelSize, ChunkSize, Bounds);
 
 	const TValue<FVoxelMesh> Mesh = VOXEL_CALL_NODE(FVoxelNode_CreateMarchingCubeMesh, MeshPin, Query)
 	{
@@ -373,9 +388,23 @@ FVoxelNodeAliases::TValue<FVoxelMarchingCubeExecNodeMesh> FVoxelMarchingCubeExec
 			};
 		};
 
-		VOXEL_CALL_NODE_BIND(GenerateDistanceFieldPin)
+		VOXEL_CALL_NODE_BIND(GenerateDistanceFieldPin, bDeferDistanceField)
 		{
-			return GetNodeRuntime().Get(GenerateDistanceFieldsPin, Query);
+			if (bDeferDistanceField)
+			{
+				return false;
+			}
+
+			FindVoxelQueryParameter(FVoxelLODQueryParameter, LODQueryParameter);
+
+			const int32 LOD = LODQueryParameter->LOD;
+			const TValue<bool> GenerateDistanceFields = GetNodeRuntime().Get(GenerateDistanceFieldsPin, Query);
+			const TValue<int32> MaxDistanceFieldLOD = GetNodeRuntime().Get(MaxDistanceFieldLODPin, Query);
+
+			return VOXEL_ON_COMPLETE(LOD, GenerateDistanceFields, MaxDistanceFieldLOD)
+			{
+				return GenerateDistanceFields && LOD <= MaxDistanceFieldLOD;
+			};
 		};
 
 		VOXEL_CALL_NODE_BIND(DistanceFieldBiasPin)
@@ -421,6 +450,11 @@ FVoxelNodeAliases::TValue<FVoxelMarchingCubeExecNodeMesh> FVoxelMarchingCubeExec
 				{
 					return GetNodeRuntime().Get(PhysicalMaterialPin, Query);
 				};
+
+				VOXEL_CALL_NODE_BIND(SimplificationErrorPin)
+				{
+					return GetNodeRuntime().Get(CollisionSimplificationErrorPin, Query);
+				};
 			};
 
 			return
@@ -442,6 +476,191 @@ FVoxelNodeAliases::TValue<FVoxelMarchingCubeExecNodeMesh> FVoxelMarchingCubeExec
 		});
 }
 
+FVoxelNodeAliases::TValue<FVoxelMarchingCubeDistanceField> FVoxelMarchingCubeExecNode::CreateDistanceField(
+	const FVoxelQuery& InQuery,
+	const float VoxelSize,
+	const int32 ChunkSize,
+	const FVoxelBox& Bounds) const
+{
+	checkVoxelSlow(FVoxelTaskReferencer::Get().IsReferenced(this));
+
+	const FVoxelQuery Query = InQuery.EnterScope(*this);
+
+	FindVoxelQueryParameter(FVoxelLODQueryParameter, LODQueryParameter);
+
+	const int32 LOD = LODQueryParameter->LOD;
+	const TValue<bool> GenerateDistanceFields = GetNodeRuntime().Get(GenerateDistanceFieldsPin, Query);
+	const TValue<int32> MaxDistanceFieldLOD = GetNodeRuntime().Get(MaxDistanceFieldLODPin, Query);
+
+	return VOXEL_ON_COMPLETE(VoxelSize, ChunkSize, Bounds, LOD, GenerateDistanceFields, MaxDistanceFieldLOD)
+	{
+		if (!GenerateDistanceFields ||
+			LOD > MaxDistanceFieldLOD)
+		{
+			return {};
+		}
+
+		const TValue<FVoxelSurface> FutureSurface = INLINE_LAMBDA
+		{
+			const TSharedRef<FVoxelQueryParameters> Parameters = Query.CloneParameters();
+			Parameters->Add<FVoxelQueryChannelBoundsQueryParameter>().Bounds = Bounds;
+			return GetNodeRuntime().Get(SurfacePin, Query.MakeNewQuery(Parameters));
+		};
+
+		return VOXEL_CALL_NODE(FVoxelNode_CreateMarchingCubeDistanceField, DistanceFieldPin, Query)
+		{
+			VOXEL_CALL_NODE_BIND(DistancePin, FutureSurface)
+			{
+				return VOXEL_ON_COMPLETE(FutureSurface)
+				{
+					return FutureSurface->GetDistance(Query);
+				};
+			};
+			VOXEL_CALL_NODE_BIND(VoxelSizePin, VoxelSize, LOD)
+			{
+				return VoxelSize * (1 << LOD);
+			};
+			VOXEL_CALL_NODE_BIND(ChunkSizePin, ChunkSize)
+			{
+				return ChunkSize;
+			};
+			VOXEL_CALL_NODE_BIND(ChunkBoundsPin, Bounds)
+			{
+				return Bounds;
+			};
+			VOXEL_CALL_NODE_BIND(DistanceFieldBiasPin)
+			{
+				return GetNodeRuntime().Get(DistanceFieldBiasPin, Query);
+			};
+		};
+	};
+}
+
+FVoxelNodeAliases::TValue<FVoxelMarchingCubeSurface> FVoxelMarchingCubeExecNode::GenerateSurface(
+	const FVoxelQuery& Query,
+	const TValue<FVoxelSurface>& FutureSurface,
+	const float VoxelSize,
+	const int32 ChunkSize,
+	const FVoxelBox& Bounds) const
+{
+	return VOXEL_CALL_NODE(FVoxelNode_GenerateMarchingCubeSurface, SurfacePin, Query)
+	{
+		VOXEL_CALL_NODE_BIND(DistancePin, FutureSurface)
+		{
+			return VOXEL_ON_COMPLETE(FutureSurface)
+			{
+				return FutureSurface->GetDistance(Query);
+			};
+		};
+		VOXEL_CALL_NODE_BIND(VoxelSizePin, VoxelSize)
+		{
+			return VoxelSize;
+		};
+		VOXEL_CALL_NODE_BIND(ChunkSizePin, ChunkSize)
+		{
+			return ChunkSize;
+		};
+		VOXEL_CALL_NODE_BIND(BoundsPin, Bounds)
+		{
+			return Bounds;
+		};
+		VOXEL_CALL_NODE_BIND(EnableTransitionsPin)
+		{
+			return true;
+		};
+		VOXEL_CALL_NODE_BIND(PerfectTransitionsPin)
+		{
+			return GetNodeRuntime().Get(PerfectTransitionsPin, Query);
+		};
+		VOXEL_CALL_NODE_BIND(EnableDistanceChecksPin)
+		{
+			return true;
+		};
+		VOXEL_CALL_NODE_BIND(DistanceChecksTolerancePin)
+		{
+			return GetNodeRuntime().Get(DistanceChecksTolerancePin, Query);
+		};
+	};
+}
+
+FVoxelNodeAliases::TValue<FVoxelMarchingCubeSurface> FVoxelMarchingCubeExecNode::GenerateSurface_DiskCache(
+	const FVoxelQuery& Query,
+	const TValue<FVoxelSurface>& FutureSurface,
+	const float VoxelSize,
+	const int32 ChunkSize,
+	const FVoxelBox& Bounds,
+	const TSharedRef<FVoxelMarchingCubeDiskCache>& DiskCache,
+	const bool bIsInvalidation) const
+{
+	FindVoxelQueryParameter(FVoxelLODQueryParameter, LODQueryParameter);
+
+	const int32 LOD = LODQueryParameter->LOD;
+
+	uint64 Key = 0;
+	if (!DiskCache->GetChunkKey(Bounds, LOD, ChunkSize, VoxelSize, Key))
+	{
+		return GenerateSurface(Query, FutureSurface, VoxelSize, ChunkSize, Bounds);
+	}
+
+	if (bIsInvalidation)
+	{
+		DiskCache->Invalidate(Key);
+		return GenerateSurface(Query, FutureSurface, VoxelSize, ChunkSize, Bounds);
+	}
+
+	const float ScaledVoxelSize = VoxelSize * (1 << LOD);
+
+	// Also adds the chunk dependencies to the query, as the full distance query is skipped on cache hits
+	const TValue<FVoxelFloatBuffer> Probes = INLINE_LAMBDA
+	{
+		const TSharedRef<FVoxelQueryParameters> Parameters = Query.CloneParameters();
+		Parameters->Add<FVoxelGradientStepQueryParameter>().Step = ScaledVoxelSize;
+		Parameters->Add<FVoxelPositionQueryParameter>().InitializeGrid(
+			FVector3f(Bounds.Min),
+			float(Bounds.Size().GetMax() / (FVoxelMarchingCubeDiskCache::ProbeGridSize - 1)),
+			FIntVector(FVoxelMarchingCubeDiskCache::ProbeGridSize));
+
+		const FVoxelQuery ProbeQuery = Query.MakeNewQuery(Parameters);
+
+		return
+			MakeVoxelTask()
+			.Dependency(FutureSurface)
+			.Execute<FVoxelFloatBuffer>([=]
+			{
+				return FutureSurface.Get_CheckCompleted().GetDistance(ProbeQuery);
+			});
+	};
+
+	return
+		MakeVoxelTask(STATIC_FNAME("MarchingCubeSceneNode - Load From Disk"))
+		.Dependency(Probes)
+		.Execute<FVoxelMarchingCubeSurface>([=]() -> TValue<FVoxelMarchingCubeSurface>
+		{
+			TVoxelArray<float> ProbeValues;
+			FVoxelUtilities::SetNumFast(ProbeValues, FVoxelMarchingCubeDiskCache::NumProbes);
+			for (int32 Index = 0; Index < ProbeValues.Num(); Index++)
+			{
+				ProbeValues[Index] = Probes.Get_CheckCompleted()[Index];
+			}
+
+			if (const TSharedPtr<const FVoxelMarchingCubeSurface> CachedSurface = DiskCache->Load(Key, ProbeValues, ScaledVoxelSize * 1.e-3f))
+			{
+				return CachedSurface;
+			}
+
+			const TValue<FVoxelMarchingCubeSurface> Surface = GenerateSurface(Query, FutureSurface, VoxelSize, ChunkSize, Bounds);
+
+			return
+				MakeVoxelTask(STATIC_FNAME("MarchingCubeSceneNode - Save To Disk"))
+				.Dependency(Surface)
+				.Execute<FVoxelMarchingCubeSurface>([=]
+				{
+					DiskCache->Save(Key, ProbeValues, Surface.Get_CheckCompleted());
+					return Surface;
+				});
+		});
+}
+
 TVoxelUniquePtr<FVoxelExecNodeRuntime> FVoxelMarchingCubeExecNode::CreateExecRuntime(const TSharedRef<const FVoxelExecNode>& SharedThis) const
 {
 	if (!FApp::CanEverRender())
@@ -478,6 +697,9 @@ void FVoxelMarchingCubeExecNodeRuntime::Create()
 	}
 
 	ChunkSpawner->PrivateVoxelSize = VoxelSize;
+	bDeferDistanceFields = GVoxelMarchingCubeDeferDistanceFields;
+
+	DiskCache = FVoxelMarchingCubeDiskCache::Create(*this);
 	ChunkSpawner->PrivateCreateChunkLambda = MakeWeakPtrLambda(this, [this](
 		const int32 LOD,
 		const int32 ChunkSize,
@@ -506,6 +728,7 @@ void FVoxelMarchingCubeExecNodeRuntime::Destroy()
 		for (const auto& It : ChunkInfos)
 		{
 			It.Value->Mesh = {};
+			It.Value->DistanceField = {};
 			It.Value->MeshComponent = {};
 			It.Value->CollisionComponent = {};
 			It.Value->FlushOnComplete();
@@ -537,6 +760,7 @@ void FVoxelMarchingCubeExecNodeRuntime::Tick(FVoxelRuntime& Runtime)
 	ChunkSpawner->Tick(Runtime);
 
 	ProcessMeshes(Runtime);
+	ProcessDistanceFields();
 	ProcessActions(&Runtime, true);
 
 	if (ProcessActionsGraphEvent.IsValid())
@@ -610,6 +834,26 @@ void FVoxelMarchingCubeExecNodeRuntime::ProcessMeshes(FVoxelRuntime& Runtime)
 				ConstCast(CastChecked<FVoxelMarchingCubeMesh>(*Mesh)).SetTransitionMask_RenderThread(RHICmdList, TransitionMask);
 			});
 
+			if (bDeferDistanceFields)
+			{
+				if (!ChunkInfo->DistanceField.IsValid())
+				{
+					// First non-empty mesh, only now start computing the distance field
+					// Mesh is reset on BeginDestroy, don't start computing for chunks being destroyed
+					if (ChunkInfo->Mesh.IsValid())
+					{
+						ComputeDistanceField(*ChunkInfo);
+					}
+				}
+				else if (
+					ChunkInfo->LastDistanceField &&
+					ChunkInfo->LastDistanceField->DistanceFieldVolumeData)
+				{
+					// Not rendered yet, no need to mark the render state dirty
+					ConstCast(CastChecked<FVoxelMarchingCubeMesh>(*Mesh)).SetDistanceField(ChunkInfo->LastDistanceField->DistanceFieldVolumeData);
+				}
+			}
+
 			if (!ChunkInfo->MeshComponent.IsValid())
 			{
 				ChunkInfo->MeshComponent = Runtime.CreateComponent<UVoxelMeshComponent>();
@@ -623,18 +867,10 @@ void FVoxelMarchingCubeExecNodeRuntime::ProcessMeshes(FVoxelRuntime& Runtime)
 				QueuedMesh.Mesh->MeshSettings->ApplyToComponent(*Component);
 			}
 
-			const auto Box = ChunkInfo->Bounds.ToFBox();
-			for (const auto& Iter : Runtime.OnChunkChangedMap)
-			{
-				if (Iter.Value)
-				{
-					Iter.Value(
-						Box,
-						ChunkInfo->LOD,
-						ChunkInfo->ChunkSize
-					);
-				}
-			}
+			Runtime.NotifyChunkChanged(
+				ChunkInfo->Bounds.ToFBox(),
+				ChunkInfo->LOD,
+				ChunkInfo->ChunkSize);
 		}
 
 		if (!Collider)
@@ -666,6 +902,85 @@ void FVoxelMarchingCubeExecNodeRuntime::ProcessMeshes(FVoxelRuntime& Runtime)
 	}
 }
 
+void FVoxelMarchingCubeExecNodeRuntime::ProcessDistanceFields()
+{
+	VOXEL_FUNCTION_COUNTER();
+	VOXEL_SCOPE_LOCK(ChunkInfos_CriticalSection);
+
+	// Every update recreates the chunk proxy, budget them so that a large edit doesn't hitch
+	int32 NumUpdates = 0;
+
+	FQueuedDistanceField QueuedDistanceField;
+	while (
+		NumUpdates < GVoxelMarchingCubeMaxDistanceFieldUpdatesPerFrame &&
+		QueuedDistanceFields->Dequeue(QueuedDistanceField))
+	{
+		const TSharedPtr<FChunkInfo> ChunkInfo = ChunkInfos.FindRef(QueuedDistanceField.ChunkId);
+		if (!ChunkInfo ||
+			!ChunkInfo->DistanceField.IsValid())
+		{
+			continue;
+		}
+
+		ChunkInfo->LastDistanceField = QueuedDistanceField.DistanceField;
+
+		const UVoxelMeshComponent* Component = ChunkInfo->MeshComponent.Get();
+		if (!Component ||
+			!Component->GetMesh())
+		{
+			continue;
+		}
+
+		FVoxelMarchingCubeMesh& Mesh = ConstCast(CastChecked<FVoxelMarchingCubeMesh>(*Component->GetMesh()));
+		if (!Mesh.DistanceFieldVolumeData &&
+			!QueuedDistanceField.DistanceField->DistanceFieldVolumeData)
+		{
+			continue;
+		}
+
+		// The render thread never reads these directly: the current proxy keeps its own ref to the previous distance field
+		// until it's replaced by the one created from the new data
+		Mesh.SetDistanceField(QueuedDistanceField.DistanceField->DistanceFieldVolumeData);
+		Mesh.MarkRenderStateDirty_GameThread();
+
+		NumUpdates++;
+	}
+}
+
+void FVoxelMarchingCubeExecNodeRuntime::ComputeDistanceField(FChunkInfo& ChunkInfo)
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(IsInGameThread());
+	checkVoxelSlow(ChunkInfos_CriticalSection.IsLocked());
+
+	TVoxelDynamicValueFactory<FVoxelMarchingCubeDistanceField> Factory(STATIC_FNAME("Marching Cube Distance Field"), [
+		&Node = Node,
+		VoxelSize = VoxelSize,
+		ChunkSize = ChunkInfo.ChunkSize,
+		Bounds = ChunkInfo.Bounds](const FVoxelQuery& Query)
+	{
+		checkVoxelSlow(FVoxelTaskReferencer::Get().IsReferenced(&Node));
+		return Node.CreateDistanceField(Query, VoxelSize, ChunkSize, Bounds);
+	});
+
+	const TSharedRef<FVoxelQueryParameters> Parameters = MakeVoxelShared<FVoxelQueryParameters>();
+	Parameters->Add<FVoxelLODQueryParameter>().LOD = ChunkInfo.LOD;
+
+	ChunkInfo.DistanceField = Factory
+		.AddRef(NodeRef)
+		.Priority(FVoxelTaskPriority::MakeBounds(
+			ChunkInfo.Bounds,
+			GetConstantPin(Node.PriorityOffsetPin) + GVoxelMarchingCubeDistanceFieldPriorityOffset,
+			GetWorld(),
+			GetLocalToWorld()))
+		.Compute(GetContext(), Parameters);
+
+	ChunkInfo.DistanceField.OnChanged([QueuedDistanceFields = QueuedDistanceFields, ChunkId = ChunkInfo.ChunkId](const TSharedRef<const FVoxelMarchingCubeDistanceField>& NewDistanceField)
+	{
+		QueuedDistanceFields->Enqueue(FQueuedDistanceField{ ChunkId, NewDistanceField });
+	});
+}
+
 void FVoxelMarchingCubeExecNodeRuntime::ProcessActions(FVoxelRuntime* Runtime, const bool bIsInGameThread)
 {
 	VOXEL_FUNCTION_COUNTER();
@@ -708,10 +1023,16 @@ void FVoxelMarchingCubeExecNodeRuntime::ProcessAction(FVoxelRuntime* Runtime, co
 			&Node = Node,
 			VoxelSize = VoxelSize,
 			ChunkSize = ChunkInfo->ChunkSize,
-			Bounds = ChunkInfo->Bounds](const FVoxelQuery& Query)
+			Bounds = ChunkInfo->Bounds,
+			DiskCache = DiskCache,
+			bDeferDistanceFields = bDeferDistanceFields,
+			NumComputes = MakeVoxelShared<FThreadSafeCounter>()](const FVoxelQuery& Query)
 		{
 			checkVoxelSlow(FVoxelTaskReferencer::Get().IsReferenced(&Node));
-			return Node.CreateMesh(Query, VoxelSize, ChunkSize, Bounds);
+
+			// Any compute after the first one is caused by a dependency being invalidated
+			const bool bIsInvalidation = NumComputes->Increment() > 1;
+			return Node.CreateMesh(Query, VoxelSize, ChunkSize, Bounds, DiskCache, bIsInvalidation, bDeferDistanceFields);
 		});
 
 		const TSharedRef<FVoxelQueryParameters> Parameters = MakeVoxelShared<FVoxelQueryParameters>();
@@ -759,6 +1080,7 @@ void FVoxelMarchingCubeExecNodeRuntime::ProcessAction(FVoxelRuntime* Runtime, co
 		VOXEL_SCOPE_COUNTER("BeginDestroy");
 
 		ChunkInfo->Mesh = {};
+		ChunkInfo->DistanceField = {};
 	}
 	break;
 	case EVoxelChunkAction::Destroy:
@@ -768,6 +1090,7 @@ void FVoxelMarchingCubeExecNodeRuntime::ProcessAction(FVoxelRuntime* Runtime, co
 		check(Runtime);
 
 		ChunkInfo->Mesh = {};
+		ChunkInfo->DistanceField = {};
 
 		Runtime->DestroyComponent(ChunkInfo->MeshComponent);
 		Runtime->DestroyComponent(ChunkInfo->CollisionComponent);
@@ -14,6 +14,11 @@
 #include "MeshDrawShaderBindings.h"
 #include "GlobalRenderResources.h"
 #include "DataDrivenShaderPlatformInfo.h"
+// UE_ENABLE_INCLUDE_ORDER_DEPRECATED_IN_5_2=1 is broken for MeshCardBuild.h
+#undef UE_ENABLE_INCLUDE_ORDER_DEPRECATED_IN_5_2
+#define UE_ENABLE_INCLUDE_ORDER_DEPRECATED_IN_5_2 0
+#include "MeshCardBuild.h"
+#include "DistanceFieldAtlas.h"
 
 DEFINE_VOXEL_INSTANCE_COUNTER(FVoxelMarchingCubeVertexFactoryBase);
 
@@ -238,6 +243,42 @@ IMPLEMENT_VERTEX_FACTORY_TYPE(FVoxelMarchingCubeVertexFactory_WithVertexNormals,
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+void FVoxelMarchingCubeMesh::SetDistanceField(const TSharedPtr<FDistanceFieldVolumeData>& NewDistanceFieldVolumeData)
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(IsInGameThread());
+
+	DistanceFieldVolumeData = NewDistanceFieldVolumeData;
+	CardRepresentationData = nullptr;
+
+	if (!DistanceFieldVolumeData)
+	{
+		return;
+	}
+
+	CardRepresentationData = MakeVoxelShared<FCardRepresentationData>();
+	CardRepresentationData->MeshCardsBuildData.Bounds = Bounds.ToFBox();
+
+	for (int32 Index = 0; Index < 6; Index++)
+	{
+		FLumenCardBuildData& CardBuildData = CardRepresentationData->MeshCardsBuildData.CardBuildData.Emplace_GetRef();
+
+		const uint32 AxisIndex = Index / 2;
+		FVector3f Direction(0.0f, 0.0f, 0.0f);
+		Direction[AxisIndex] = Index & 1 ? 1.0f : -1.0f;
+
+		CardBuildData.OBB.AxisZ = Direction;
+		CardBuildData.OBB.AxisZ.FindBestAxisVectors(CardBuildData.OBB.AxisX, CardBuildData.OBB.AxisY);
+		CardBuildData.OBB.AxisX = FVector3f::CrossProduct(CardBuildData.OBB.AxisZ, CardBuildData.OBB.AxisY);
+		CardBuildData.OBB.AxisX.Normalize();
+
+		CardBuildData.OBB.Origin = FVector3f(Bounds.GetCenter());
+		CardBuildData.OBB.Extent = CardBuildData.OBB.RotateLocalToCard(FVector3f(Bounds.GetExtent()) + FVector3f(1.0f)).GetAbs();
+
+		CardBuildData.AxisAlignedDirectionIndex = Index;
+	}
+}
+
 void FVoxelMarchingCubeMesh::SetTransitionMask_GameThread(uint8 NewTransitionMask)
 {
 	VOXEL_ENQUEUE_RENDER_COMMAND(SetTransitionMask_RenderThread)(MakeWeakPtrLambda(this, [this, NewTransitionMask](FRHICommandList& RHICmdList)
@@ -614,6 +655,56 @@ void FVoxelMarchingCubeMesh::SetTransitionMask_RenderThread(FRHICommandList& RHI
 	VOXEL_INLINE_COUNTER("VertexFactory InitResource", VertexFactory->InitResource(UE_503_ONLY(RHICmdList)));
 }
 
+uint64 FVoxelMarchingCubeMesh::GetContentHash() const
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Vertices.Num(), 1024);
+
+	if (!ComputedMaterial ||
+		DistanceFieldVolumeData)
+	{
+		// Distance fields computed along with the mesh aren't hashed
+		return 0;
+	}
+
+	const uint64 MaterialHash = ComputedMaterial->GetContentHash();
+	if (MaterialHash == 0)
+	{
+		return 0;
+	}
+
+	uint64 Hash = FVoxelUtilities::MurmurHashMulti(
+		MaterialHash,
+		LOD,
+		Bounds,
+		VoxelSize,
+		ChunkSize,
+		NumCells,
+		NumEdgeVertices,
+		bHasVertexNormals);
+
+	const auto HashArray = [&](const auto& Array)
+	{
+		Hash = FVoxelUtilities::MurmurHash64(Hash ^ FVoxelUtilities::MurmurHashBytes(MakeByteVoxelArrayView(Array)));
+	};
+
+	HashArray(Indices);
+	HashArray(Vertices);
+	HashArray(VertexNormals);
+	HashArray(CellIndices);
+
+	for (int32 Direction = 0; Direction < 6; Direction++)
+	{
+		HashArray(TransitionIndices[Direction]);
+		HashArray(TransitionVertices[Direction]);
+		HashArray(TransitionCellIndices[Direction]);
+	}
+
+	HashArray(CellIndexToDirection);
+	// CellTextureCoordinates are skipped: they depend on where the detail textures were allocated, not on their content
+
+	return Hash;
+}
+
 int64 FVoxelMarchingCubeMesh::GetAllocatedSize() const
 {
 	int64 AllocatedSize =
@@ -6,9 +6,12 @@
 #include "VoxelGradientNodes.h"
 #include "VoxelDetailTextureNodes.h"
 #include "VoxelDistanceFieldWrapper.h"
+#include "VoxelBenchmarkStats.h"
 #include "VoxelPositionQueryParameter.h"
 #include "Collision/VoxelCollisionCooker.h"
 #include "Collision/VoxelTriangleMeshCollider.h"
+#include "MeshOptimizer.h"
+#include "Hash/CityHash.h"
 // UE_ENABLE_INCLUDE_ORDER_DEPRECATED_IN_5_2=1 is broken for MeshCardBuild.h
 #undef UE_ENABLE_INCLUDE_ORDER_DEPRECATED_IN_5_2
 #define UE_ENABLE_INCLUDE_ORDER_DEPRECATED_IN_5_2 0
@@ -36,6 +39,127 @@ VOXEL_CONSOLE_VARIABLE(
 	"Add padding to perfectly overlap chunks distance fields. "
 	"This might cause invalid entries into Lumen's surface cache and glitches in Lumen at chunk borders.");
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHNODES_API, int32, GVoxelMarchingCubeDistanceFieldBrickCacheSize, 16384,
+	"voxel.marchingcube.DistanceFieldBrickCacheSize",
+	"Number of distance field bricks to keep cached. Bricks are reused until an edit touches them, so that only the affected bricks of a chunk are recomputed. 0 to disable");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHNODES_API, bool, GVoxelCollisionLogSimplification, false,
+	"voxel.collision.LogSimplification",
+	"If true, will also cook the unsimplified collision and log triangle count, cook time & memory before/after simplification");
+
+class FVoxelMarchingCubeDistanceFieldBrickCache : public FVoxelSingleton
+{
+public:
+	using FBrick = FVoxelDistanceFieldWrapper::FBrick;
+
+	//~ Begin FVoxelSingleton Interface
+	virtual void Tick() override
+	{
+		VOXEL_FUNCTION_COUNTER();
+		VOXEL_SCOPE_LOCK(CriticalSection);
+
+		for (auto It = KeyToData_RequiresLock.CreateIterator(); It; ++It)
+		{
+			if (It.Value().DependencyTracker->IsInvalidated() ||
+				!It.Value().WeakContext.IsValid() ||
+				GVoxelMarchingCubeDistanceFieldBrickCacheSize <= 0)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+	//~ End FVoxelSingleton Interface
+
+	// Returns false if not cached. OutBrick is null if the brick is empty
+	bool Find(const uint64 Key, TSharedPtr<FBrick>& OutBrick)
+	{
+		VOXEL_SCOPE_LOCK(CriticalSection);
+
+		FData* Data = KeyToData_RequiresLock.Find(Key);
+		if (!Data)
+		{
+			return false;
+		}
+
+		if (Data->DependencyTracker->IsInvalidated() ||
+			!Data->WeakContext.IsValid())
+		{
+			KeyToData_RequiresLock.Remove(Key);
+			return false;
+		}
+
+		Data->LastAccess = ++AccessCounter_RequiresLock;
+		OutBrick = Data->Brick;
+		return true;
+	}
+	void Add(
+		const uint64 Key,
+		const TSharedPtr<FBrick>& Brick,
+		const TWeakPtr<FVoxelQueryContext>& WeakContext,
+		const TSharedRef<FVoxelDependencyTracker>& DependencyTracker)
+	{
+		if (GVoxelMarchingCubeDistanceFieldBrickCacheSize <= 0 ||
+			DependencyTracker->IsInvalidated())
+		{
+			return;
+		}
+
+		VOXEL_SCOPE_LOCK(CriticalSection);
+
+		FData& Data = KeyToData_RequiresLock.FindOrAdd(Key);
+		Data.Brick = Brick;
+		Data.WeakContext = WeakContext;
+		Data.DependencyTracker = DependencyTracker;
+		Data.LastAccess = ++AccessCounter_RequiresLock;
+
+		if (KeyToData_RequiresLock.Num() <= GVoxelMarchingCubeDistanceFieldBrickCacheSize)
+		{
+			return;
+		}
+
+		VOXEL_SCOPE_COUNTER("Evict");
+
+		// Bricks are added by whole chunks, evict a quarter of the cache at once to not sort on every add
+		TVoxelArray<TPair<uint64, uint64>> LastAccessAndKeys;
+		LastAccessAndKeys.Reserve(KeyToData_RequiresLock.Num());
+		for (const auto& It : KeyToData_RequiresLock)
+		{
+			LastAccessAndKeys.Add({ It.Value.LastAccess, It.Key });
+		}
+		LastAccessAndKeys.Sort([](const TPair<uint64, uint64>& A, const TPair<uint64, uint64>& B)
+		{
+			return A.Key < B.Key;
+		});
+
+		const int32 NumToRemove = LastAccessAndKeys.Num() - GVoxelMarchingCubeDistanceFieldBrickCacheSize * 3 / 4;
+		for (int32 Index = 0; Index < NumToRemove; Index++)
+		{
+			KeyToData_RequiresLock.Remove(LastAccessAndKeys[Index].Value);
+		}
+	}
+
+private:
+	struct FData
+	{
+		TSharedPtr<FBrick> Brick;
+		TWeakPtr<FVoxelQueryContext> WeakContext;
+		TSharedPtr<FVoxelDependencyTracker> DependencyTracker;
+		uint64 LastAccess = 0;
+	};
+
+	FVoxelFastCriticalSection CriticalSection;
+	uint64 AccessCounter_RequiresLock = 0;
+	TVoxelMap<uint64, FData> KeyToData_RequiresLock;
+};
+
+FVoxelMarchingCubeDistanceFieldBrickCache* GVoxelMarchingCubeDistanceFieldBrickCache = MakeVoxelSingleton(FVoxelMarchingCubeDistanceFieldBrickCache);
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_GenerateMarchingCubeSurface, Surface)
 {
 	FindVoxelQueryParameter(FVoxelLODQueryParameter, LODQueryParameter);
@@ -121,10 +245,17 @@ DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_GenerateMarchingCubeSurface, Surface)
 			Parameters->Add<FVoxelGradientStepQueryParameter>().Step = ScaledVoxelSize;
 			Parameters->Add<FVoxelPositionQueryParameter>().InitializeGrid(FVector3f(Bounds.Min), ScaledVoxelSize, FIntVector(DataSize));
 
+			// Latency of the graph evaluation, including the time spent waiting for worker threads
+			const double GraphStartTime = FVoxelBenchmarkStats::IsEnabled() ? FPlatformTime::Seconds() : 0.;
 			const TValue<FVoxelFloatBuffer> Distances = Get(DistancePin, Query.MakeNewQuery(Parameters));
 
-			return VOXEL_ON_COMPLETE(Bounds, LOD, ChunkSize, EnableTransitions, PerfectTransitions, DataSize, ScaledVoxelSize, Distances)
+			return VOXEL_ON_COMPLETE(Bounds, LOD, ChunkSize, EnableTransitions, PerfectTransitions, DataSize, ScaledVoxelSize, Distances, GraphStartTime)
 			{
+				if (GraphStartTime != 0.)
+				{
+					FVoxelBenchmarkStats::AddSample(STATIC_FNAME("Graph"), FPlatformTime::Seconds() - GraphStartTime);
+				}
+
 				if (Distances.IsConstant() ||
 					!ensure(Distances.Num() == DataSize * DataSize * DataSize))
 				{
@@ -143,7 +274,10 @@ DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_GenerateMarchingCubeSurface, Surface)
 					ConstCast(Distances.GetStorage()),
 					*Surface);
 				Processor->bPerfectTransitions = PerfectTransitions;
-				Processor->Generate(EnableTransitions);
+				{
+					VOXEL_BENCHMARK_SCOPE("MarchingCubes");
+					Processor->Generate(EnableTransitions);
+				}
 
 				if (Surface->Cells.Num() == 0)
 				{
@@ -222,11 +356,147 @@ DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_GenerateMarchingCubeSurface, Surface)
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+// Simplify each material separately so that triangles keep their material
+// Vertices on chunk faces & between materials are locked to keep neighbors watertight
+static void SimplifyMarchingCubeCollider(
+	const FVoxelMarchingCubeSurface& Surface,
+	const TConstVoxelArrayView<FVector3f> Positions,
+	const float SimplificationError,
+	TVoxelArray<int32>& Indices,
+	TVoxelArray<uint16>& MaterialIndices)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	// On mismatched data, keep the unoptimized mesh
+	if (!ensure(Indices.Num() % 3 == 0) ||
+		!ensure(Surface.Vertices.Num() == Positions.Num()))
+	{
+		return;
+	}
+
+	const int32 NumTriangles = Indices.Num() / 3;
+	const bool bHasMaterials = MaterialIndices.Num() > 0;
+	if (!ensure(!bHasMaterials || MaterialIndices.Num() == NumTriangles))
+	{
+		return;
+	}
+
+	TVoxelArray<bool> LockedVertices;
+	FVoxelUtilities::SetNumFast(LockedVertices, Positions.Num());
+
+	for (int32 Index = 0; Index < Positions.Num(); Index++)
+	{
+		const FVector3f& Vertex = Surface.Vertices[Index];
+		LockedVertices[Index] =
+			Vertex.GetMin() <= KINDA_SMALL_NUMBER ||
+			Vertex.GetMax() >= Surface.ChunkSize - KINDA_SMALL_NUMBER;
+	}
+
+	int32 NumMaterials = 1;
+	if (bHasMaterials)
+	{
+		VOXEL_SCOPE_COUNTER("Lock material borders");
+
+		TVoxelArray<int32> VertexToMaterial;
+		FVoxelUtilities::SetNumFast(VertexToMaterial, Positions.Num());
+		FVoxelUtilities::SetAll(VertexToMaterial, -1);
+
+		for (int32 Index = 0; Index < Indices.Num(); Index++)
+		{
+			const int32 Material = MaterialIndices[Index / 3];
+			NumMaterials = FMath::Max(NumMaterials, Material + 1);
+
+			int32& VertexMaterial = VertexToMaterial[Indices[Index]];
+			if (VertexMaterial == -1)
+			{
+				VertexMaterial = Material;
+			}
+			else if (VertexMaterial != Material)
+			{
+				LockedVertices[Indices[Index]] = true;
+			}
+		}
+	}
+
+	const float Scale = meshopt_simplifyScale(&Positions[0].X, Positions.Num(), sizeof(FVector3f));
+	if (Scale <= 0.f)
+	{
+		return;
+	}
+
+	TVoxelArray<int32> NewIndices;
+	TVoxelArray<uint16> NewMaterialIndices;
+	NewIndices.Reserve(Indices.Num());
+	NewMaterialIndices.Reserve(bHasMaterials ? NumTriangles : 0);
+
+	TVoxelArray<uint32> SourceIndices;
+	TVoxelArray<uint32> SimplifiedIndices;
+	for (int32 Material = 0; Material < NumMaterials; Material++)
+	{
+		SourceIndices.Reset();
+
+		if (bHasMaterials)
+		{
+			for (int32 Triangle = 0; Triangle < NumTriangles; Triangle++)
+			{
+				if (MaterialIndices[Triangle] != Material)
+				{
+					continue;
+				}
+
+				SourceIndices.Add(Indices[3 * Triangle + 0]);
+				SourceIndices.Add(Indices[3 * Triangle + 1]);
+				SourceIndices.Add(Indices[3 * Triangle + 2]);
+			}
+		}
+		else
+		{
+			SourceIndices = TVoxelArray<uint32>(ReinterpretCastVoxelArrayView<uint32>(TConstVoxelArrayView<int32>(Indices)));
+		}
+
+		if (SourceIndices.Num() == 0)
+		{
+			continue;
+		}
+
+		FVoxelUtilities::SetNumFast(SimplifiedIndices, SourceIndices.Num());
+
+		const int32 NumSimplifiedIndices = int32(meshopt_simplify(
+			SimplifiedIndices.GetData(),
+			SourceIndices.GetData(),
+			SourceIndices.Num(),
+			&Positions[0].X,
+			Positions.Num(),
+			sizeof(FVector3f),
+			0,
+			SimplificationError / Scale,
+			nullptr,
+			LockedVertices.GetData()));
+
+		for (int32 Index = 0; Index < NumSimplifiedIndices; Index++)
+		{
+			NewIndices.Add(SimplifiedIndices[Index]);
+		}
+
+		if (bHasMaterials)
+		{
+			for (int32 Index = 0; Index < NumSimplifiedIndices / 3; Index++)
+			{
+				NewMaterialIndices.Add(Material);
+			}
+		}
+	}
+
+	Indices = MoveTemp(NewIndices);
+	MaterialIndices = MoveTemp(NewMaterialIndices);
+}
+
 DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_CreateMarchingCubeCollider, Collider)
 {
 	const TValue<FVoxelMarchingCubeSurface> Surface = Get(SurfacePin, Query);
+	const TValue<float> SimplificationError = Get(SimplificationErrorPin, Query);
 
-	return VOXEL_ON_COMPLETE(Surface)
+	return VOXEL_ON_COMPLETE(Surface, SimplificationError)
 	{
 		if (Surface->Vertices.Num() == 0)
 		{
@@ -264,7 +534,7 @@ DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_CreateMarchingCubeCollider, Collider)
 			Materials = Get(PhysicalMaterialPin, Query.MakeNewQuery(Parameters));
 		}
 
-		return VOXEL_ON_COMPLETE(Surface, Materials)
+		return VOXEL_ON_COMPLETE(Surface, SimplificationError, Materials)
 		{
 			TVoxelArray<FVector3f> Positions;
 			FVoxelUtilities::SetNumFast(Positions, Surface->Vertices.Num());
@@ -274,41 +544,79 @@ DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_CreateMarchingCubeCollider, Collider)
 				Positions[Index] = Surface->Vertices[Index] * Surface->ScaledVoxelSize;
 			}
 
+			TVoxelArray<uint16> MaterialIndices;
+			TVoxelArray<TWeakObjectPtr<UPhysicalMaterial>> PhysicalMaterials;
+
 			if (Materials.IsConstant())
+			{
+				PhysicalMaterials.Add(Materials.GetConstant().Material);
+			}
+			else
+			{
+				TVoxelAddOnlyMap<uint64, uint16> MaterialToIndex;
+
+				for (const FVoxelPhysicalMaterial& Material : Materials)
+				{
+					uint16* IndexPtr = MaterialToIndex.Find(ReinterpretCastRef<uint64>(Material));
+					if (!IndexPtr)
+					{
+						IndexPtr = &MaterialToIndex.Add_CheckNew(ReinterpretCastRef<uint64>(Material));
+						*IndexPtr = PhysicalMaterials.Add(Material.Material);
+					}
+					MaterialIndices.Add(*IndexPtr);
+				}
+			}
+
+			if (SimplificationError <= 0.f)
 			{
 				const TSharedPtr<FVoxelTriangleMeshCollider> Collider = FVoxelCollisionCooker::CookTriangleMesh(
 					Surface->Indices,
 					Positions,
-					{});
+					MaterialIndices);
 
 				if (Collider)
 				{
 					Collider->Offset = Surface->ChunkBounds.Min;
-					Collider->PhysicalMaterials.Add(Materials.GetConstant().Material);
+					Collider->PhysicalMaterials = MoveTemp(PhysicalMaterials);
 				}
 				return Collider;
 			}
 
-			TVoxelArray<uint16> MaterialIndices;
-			TVoxelAddOnlyMap<uint64, uint16> MaterialToIndex;
-			TVoxelArray<TWeakObjectPtr<UPhysicalMaterial>> PhysicalMaterials;
-
-			for (const FVoxelPhysicalMaterial& Material : Materials)
+			if (GVoxelCollisionLogSimplification)
 			{
-				uint16* IndexPtr = MaterialToIndex.Find(ReinterpretCastRef<uint64>(Material));
-				if (!IndexPtr)
-				{
-					IndexPtr = &MaterialToIndex.Add_CheckNew(ReinterpretCastRef<uint64>(Material));
-					*IndexPtr = PhysicalMaterials.Add(Material.Material);
-				}
-				MaterialIndices.Add(*IndexPtr);
+				const double StartTime = FPlatformTime::Seconds();
+				const TSharedPtr<FVoxelTriangleMeshCollider> Collider = FVoxelCollisionCooker::CookTriangleMesh(
+					Surface->Indices,
+					Positions,
+					MaterialIndices);
+				const double EndTime = FPlatformTime::Seconds();
+
+				LOG_VOXEL(Log, "Collision before simplification: %d triangles, cooked in %.3fms, %lld bytes",
+					Surface->Indices.Num() / 3,
+					(EndTime - StartTime) * 1000.,
+					Collider ? Collider->GetAllocatedSize() : 0);
 			}
 
+			const double StartTime = FPlatformTime::Seconds();
+
+			TVoxelArray<int32> Indices = Surface->Indices;
+			SimplifyMarchingCubeCollider(*Surface, Positions, SimplificationError, Indices, MaterialIndices);
+
 			const TSharedPtr<FVoxelTriangleMeshCollider> Collider = FVoxelCollisionCooker::CookTriangleMesh(
-				Surface->Indices,
+				Indices,
 				Positions,
 				MaterialIndices);
 
+			if (GVoxelCollisionLogSimplification)
+			{
+				const double EndTime = FPlatformTime::Seconds();
+
+				LOG_VOXEL(Log, "Collision after simplification: %d triangles, simplified & cooked in %.3fms, %lld bytes",
+					Indices.Num() / 3,
+					(EndTime - StartTime) * 1000.,
+					Collider ? Collider->GetAllocatedSize() : 0);
+			}
+
 			if (Collider)
 			{
 				Collider->Offset = Surface->ChunkBounds.Min;
@@ -395,52 +703,47 @@ DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_CreateMarchingCubeMesh, Mesh)
 				VertexNormals = FVoxelVectorBuffer();
 			}
 
-			checkStatic(DistanceField::MeshDistanceFieldObjectBorder == 1);
-
-			const float ChunkWorldSize = Surface->ChunkSize * Surface->ScaledVoxelSize;
-			const int32 NumBricksPerChunk = GVoxelMarchingCubeNumDistanceFieldBricksPerChunk;
-			const int32 NumQueriesPerChunk = NumBricksPerChunk * DistanceField::UniqueDataBrickSize;
-			// 2 * MeshDistanceFieldObjectBorder, additional padding at the end to overlap chunks
-			const int32 NumQueriesInChunk = NumQueriesPerChunk - 2 - (GVoxelMarchingCubeEnableDistanceFieldPadding ? 1 : 0);
-			const float TexelSize = ChunkWorldSize / float(NumQueriesInChunk);
-
-			// +1 so we can query the last brick element
-			// +1 to be a multiple of 2
-			const int32 DenseQuerySize = NumQueriesPerChunk + 2;
-			const FVoxelBox QueryBounds(0, ChunkWorldSize + (GVoxelMarchingCubeEnableDistanceFieldPadding ? TexelSize : 0));
-
-			TValue<FVoxelFloatBuffer> Distances;
+			TValue<FVoxelMarchingCubeDistanceField> DistanceFieldData;
 			if (GenerateDistanceField)
 			{
-				const TSharedRef<FVoxelQueryParameters> Parameters = Query.CloneParameters();
-				Parameters->Add<FVoxelGradientStepQueryParameter>().Step = TexelSize;
-
-				Parameters->Add<FVoxelPositionQueryParameter>().InitializeGrid(
-					FVector3f(Surface->ChunkBounds.Min + QueryBounds.Min - TexelSize),
-					TexelSize,
-					FIntVector(DenseQuerySize));
-
-				Distances = Get(DistancePin, Query.MakeNewQuery(Parameters));
+				DistanceFieldData = VOXEL_CALL_NODE(FVoxelNode_CreateMarchingCubeDistanceField, DistanceFieldPin, Query)
+				{
+					VOXEL_CALL_NODE_BIND(DistancePin)
+					{
+						return GetNodeRuntime().Get(DistancePin, Query);
+					};
+					VOXEL_CALL_NODE_BIND(VoxelSizePin, Surface)
+					{
+						return Surface->ScaledVoxelSize;
+					};
+					VOXEL_CALL_NODE_BIND(ChunkSizePin, Surface)
+					{
+						return Surface->ChunkSize;
+					};
+					VOXEL_CALL_NODE_BIND(ChunkBoundsPin, Surface)
+					{
+						return Surface->ChunkBounds;
+					};
+					VOXEL_CALL_NODE_BIND(DistanceFieldBiasPin, DistanceFieldBias)
+					{
+						return DistanceFieldBias;
+					};
+				};
 			}
 			else
 			{
-				Distances = FVoxelFloatBuffer();
+				DistanceFieldData = FVoxelMarchingCubeDistanceField();
 			}
 
 			return VOXEL_ON_COMPLETE(
 				Surface,
-				GenerateDistanceField,
-				DistanceFieldBias,
 				LODQueryParameter,
 				DetailTextureHelper,
 				ComputedMaterial,
 				Bounds,
 				NumVertexNormals,
 				VertexNormals,
-				QueryBounds,
-				NumBricksPerChunk,
-				DenseQuerySize,
-				Distances)
+				DistanceFieldData)
 			{
 				const TSharedRef<FVoxelMarchingCubeMesh> Mesh = MakeVoxelMesh<FVoxelMarchingCubeMesh>();
 				Mesh->LOD = LODQueryParameter->LOD;
@@ -475,70 +778,187 @@ DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_CreateMarchingCubeMesh, Mesh)
 					}
 				}
 
-				if (GenerateDistanceField)
+				if (DistanceFieldData->DistanceFieldVolumeData)
 				{
-					{
-						VOXEL_SCOPE_COUNTER("Cards");
+					Mesh->SetDistanceField(DistanceFieldData->DistanceFieldVolumeData);
+				}
 
-						const FVoxelBox CardBounds = Bounds.Scale(Surface->ScaledVoxelSize);
+				return Mesh;
+			};
+		};
+	};
+}
 
-						Mesh->CardRepresentationData = MakeVoxelShared<FCardRepresentationData>();
-						Mesh->CardRepresentationData->MeshCardsBuildData.Bounds = CardBounds.ToFBox();
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
 
-						for (int32 Index = 0; Index < 6; Index++)
-						{
-							FLumenCardBuildData& CardBuildData = Mesh->CardRepresentationData->MeshCardsBuildData.CardBuildData.Emplace_GetRef();
+DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_CreateMarchingCubeDistanceField, DistanceField)
+{
+	const TValue<float> VoxelSize = Get(VoxelSizePin, Query);
+	const TValue<int32> ChunkSize = Get(ChunkSizePin, Query);
+	const TValue<FVoxelBox> ChunkBounds = Get(ChunkBoundsPin, Query);
+	const TValue<float> DistanceFieldBias = Get(DistanceFieldBiasPin, Query);
 
-							const uint32 AxisIndex = Index / 2;
-							FVector3f Direction(0.0f, 0.0f, 0.0f);
-							Direction[AxisIndex] = Index & 1 ? 1.0f : -1.0f;
+	return VOXEL_ON_COMPLETE(VoxelSize, ChunkSize, ChunkBounds, DistanceFieldBias)
+	{
+		FindVoxelQueryParameter(FVoxelLODQueryParameter, LODQueryParameter);
 
-							CardBuildData.OBB.AxisZ = Direction;
-							CardBuildData.OBB.AxisZ.FindBestAxisVectors(CardBuildData.OBB.AxisX, CardBuildData.OBB.AxisY);
-							CardBuildData.OBB.AxisX = FVector3f::CrossProduct(CardBuildData.OBB.AxisZ, CardBuildData.OBB.AxisY);
-							CardBuildData.OBB.AxisX.Normalize();
+		using FBrick = FVoxelDistanceFieldWrapper::FBrick;
+		checkStatic(DistanceField::MeshDistanceFieldObjectBorder == 1);
 
-							CardBuildData.OBB.Origin = FVector3f(CardBounds.GetCenter());
-							CardBuildData.OBB.Extent = CardBuildData.OBB.RotateLocalToCard(FVector3f(CardBounds.GetExtent()) + FVector3f(1.0f)).GetAbs();
+		const float ChunkWorldSize = ChunkSize * VoxelSize;
+		const int32 NumBricksPerChunk = FMath::Clamp(GVoxelMarchingCubeNumDistanceFieldBricksPerChunk, 1, 32);
+		const int32 NumQueriesPerChunk = NumBricksPerChunk * DistanceField::UniqueDataBrickSize;
+		// 2 * MeshDistanceFieldObjectBorder, additional padding at the end to overlap chunks
+		const int32 NumQueriesInChunk = NumQueriesPerChunk - 2 - (GVoxelMarchingCubeEnableDistanceFieldPadding ? 1 : 0);
+		const float TexelSize = ChunkWorldSize / float(NumQueriesInChunk);
 
-							CardBuildData.AxisAlignedDirectionIndex = Index;
-						}
-					}
+		const FVoxelBox QueryBounds(0, ChunkWorldSize + (GVoxelMarchingCubeEnableDistanceFieldPadding ? TexelSize : 0));
+		const FVector3f QueryStart = FVector3f(ChunkBounds.Min + QueryBounds.Min - TexelSize);
 
-					VOXEL_SCOPE_COUNTER("Distance Field");
+		const TSharedRef<FVoxelDistanceFieldWrapper> Wrapper = MakeVoxelShared<FVoxelDistanceFieldWrapper>(QueryBounds.ToFBox());
+		Wrapper->SetSize(FIntVector(NumBricksPerChunk));
 
-					FVoxelDistanceFieldWrapper Wrapper(QueryBounds.ToFBox());
-					Wrapper.SetSize(FIntVector(NumBricksPerChunk));
+		// Bricks are queried with their own dependency tracker so that an edit only recomputes the bricks it touches
+		// This probe adds the dependencies of the whole chunk to our own query, so that we still get invalidated
+		TVoxelArray<FVoxelFutureValue> Dependencies;
+		{
+			const TSharedRef<FVoxelQueryParameters> Parameters = Query.CloneParameters();
+			Parameters->Add<FVoxelGradientStepQueryParameter>().Step = TexelSize;
+			Parameters->Add<FVoxelPositionQueryParameter>().InitializeGrid(
+				QueryStart,
+				NumQueriesPerChunk * TexelSize,
+				FIntVector(2));
 
-					const FVoxelIntBox BrickBoundsA(0, NumBricksPerChunk);
-					const FVoxelIntBox BrickBoundsB(0, DistanceField::BrickSize);
+			Dependencies.Add(Get(DistancePin, Query.MakeNewQuery(Parameters)));
+		}
 
-					BrickBoundsA.Iterate([&](const FIntVector& BrickPositionA)
-					{
-						FVoxelDistanceFieldWrapper::FMip& Mip = Wrapper.Mips[0];
-						FVoxelDistanceFieldWrapper::FBrick& Brick = Mip.FindOrAddBrick(BrickPositionA);
-						BrickBoundsB.Iterate([&](const FIntVector& BrickPositionB)
-						{
-							// 7 unique voxel, and 1 voxel shared with the next brick
-							// Shader samples between [0.5, 7.5] for good interpolation
-							const FIntVector DistancePosition = BrickPositionA * DistanceField::UniqueDataBrickSize + BrickPositionB;
-							const int32 DistanceIndex = FVoxelUtilities::Get3DIndex<int32>(DenseQuerySize, DistancePosition);
-							const float Distance = Distances[DistanceIndex] + DistanceFieldBias;
-
-							const int32 BrickIndex = FVoxelUtilities::Get3DIndex<int32>(DistanceField::BrickSize, BrickPositionB);
-							Brick[BrickIndex] = Mip.QuantizeDistance(Distance);
-						});
-					});
-
-					Wrapper.Mips[1] = Wrapper.Mips[0];
-					Wrapper.Mips[2] = Wrapper.Mips[0];
-
-					Mesh->DistanceFieldVolumeData = Wrapper.Build();
-					//Mesh->DistanceFieldVolumeData->LocalSpaceMeshBounds = Mesh->DistanceFieldVolumeData->LocalSpaceMeshBounds.ShiftBy(-FVector(Surface->ScaledVoxelSize / 2.f));
-				}
+		uint64 CallstackHash = 0;
+		for (const FVoxelCallstack* Callstack = &Query.GetCallstack(); Callstack; Callstack = Callstack->Parent.Get())
+		{
+			CallstackHash = FVoxelUtilities::MurmurHash(CallstackHash ^ GetTypeHash(Callstack->Node));
+		}
 
-				return Mesh;
-			};
+		struct FKey
+		{
+			const void* Context;
+			uint64 CallstackHash;
+			FVector3d ChunkMin;
+			FIntVector BrickPosition;
+			int32 LOD;
+			int32 NumBricksPerChunk;
+			float TexelSize;
+			float QueryBoundsSize;
+			float DistanceFieldBias;
 		};
+
+		struct FPendingBrick
+		{
+			FIntVector Position;
+			uint64 Key = 0;
+			TSharedPtr<FVoxelDependencyTracker> DependencyTracker;
+			TValue<FVoxelFloatBuffer> Distances;
+		};
+		TVoxelArray<FPendingBrick> PendingBricks;
+
+		const TWeakPtr<FVoxelQueryContext> WeakContext = Query.GetSharedContext();
+
+		FVoxelIntBox(0, NumBricksPerChunk).Iterate([&](const FIntVector& BrickPosition)
+		{
+			FKey Key;
+			FMemory::Memzero(Key);
+			Key.Context = &Query.GetContext();
+			Key.CallstackHash = CallstackHash;
+			Key.ChunkMin = ChunkBounds.Min;
+			Key.BrickPosition = BrickPosition;
+			Key.LOD = LODQueryParameter->LOD;
+			Key.NumBricksPerChunk = NumBricksPerChunk;
+			Key.TexelSize = TexelSize;
+			Key.QueryBoundsSize = QueryBounds.Size().X;
+			Key.DistanceFieldBias = DistanceFieldBias;
+
+			const uint64 Hash = CityHash64(reinterpret_cast<const char*>(&Key), sizeof(Key));
+
+			TSharedPtr<FBrick> CachedBrick;
+			if (GVoxelMarchingCubeDistanceFieldBrickCache->Find(Hash, CachedBrick))
+			{
+				Wrapper->Mips[0].SetBrick(BrickPosition, CachedBrick);
+				return;
+			}
+
+			const TSharedRef<FVoxelDependencyTracker> DependencyTracker = FVoxelDependencyTracker::Create(STATIC_FNAME("MarchingCubeDistanceFieldBrick"));
+
+			const TSharedRef<FVoxelQueryParameters> Parameters = Query.CloneParameters();
+			Parameters->Add<FVoxelGradientStepQueryParameter>().Step = TexelSize;
+			// 7 unique voxel, and 1 voxel shared with the next brick
+			// Shader samples between [0.5, 7.5] for good interpolation
+			Parameters->Add<FVoxelPositionQueryParameter>().InitializeGrid(
+				QueryStart + FVector3f(BrickPosition * DistanceField::UniqueDataBrickSize) * TexelSize,
+				TexelSize,
+				FIntVector(DistanceField::BrickSize));
+
+			FPendingBrick& PendingBrick = PendingBricks.Emplace_GetRef();
+			PendingBrick.Position = BrickPosition;
+			PendingBrick.Key = Hash;
+			PendingBrick.DependencyTracker = DependencyTracker;
+			PendingBrick.Distances = Get(DistancePin, Query.MakeNewQuery(Parameters, DependencyTracker));
+
+			Dependencies.Add(PendingBrick.Distances);
+		});
+
+		return
+			MakeVoxelTask(STATIC_FNAME("MarchingCube - Distance Field"))
+			.Dependencies(Dependencies)
+			.Execute<FVoxelMarchingCubeDistanceField>([=]
+			{
+				constexpr int32 NumVoxelsPerBrick = DistanceField::BrickSize * DistanceField::BrickSize * DistanceField::BrickSize;
+
+				ParallelFor(PendingBricks.Num(), [&](const int32 Index)
+				{
+					VOXEL_SCOPE_COUNTER("Quantize");
+
+					const FPendingBrick& PendingBrick = PendingBricks[Index];
+					const FVoxelFloatBuffer& Distances = PendingBrick.Distances.Get_CheckCompleted();
+
+					if (!ensure(Distances.IsConstant() || Distances.Num() == NumVoxelsPerBrick))
+					{
+						return;
+					}
+
+					TSharedPtr<FBrick> Brick = MakeVoxelShared<FBrick>(NoInit);
+
+					bool bIsEmpty = true;
+					for (int32 VoxelIndex = 0; VoxelIndex < NumVoxelsPerBrick; VoxelIndex++)
+					{
+						const uint8 Value = Wrapper->Mips[0].QuantizeDistance(Distances[VoxelIndex] + DistanceFieldBias);
+						(*Brick)[VoxelIndex] = Value;
+						bIsEmpty &= Value == 255;
+					}
+
+					// Bricks entirely outside of the encoded band are left out of the indirection table,
+					// which the shader treats the same
+					if (bIsEmpty)
+					{
+						Brick.Reset();
+					}
+
+					// Each brick has its own indirection entry, safe to set in parallel
+					Wrapper->Mips[0].SetBrick(PendingBrick.Position, Brick);
+
+					GVoxelMarchingCubeDistanceFieldBrickCache->Add(
+						PendingBrick.Key,
+						Brick,
+						WeakContext,
+						PendingBrick.DependencyTracker.ToSharedRef());
+				}, PendingBricks.Num() > 1 ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+				Wrapper->Mips[1] = Wrapper->Mips[0];
+				Wrapper->Mips[2] = Wrapper->Mips[0];
+
+				const TSharedRef<FVoxelMarchingCubeDistanceField> Result = MakeVoxelShared<FVoxelMarchingCubeDistanceField>();
+				Result->DistanceFieldVolumeData = Wrapper->Build();
+				return Result;
+			});
 	};
 }
\ No newline at end of file
@@ -109,6 +109,11 @@ FVoxelNodeAliases::TValue<FVoxelMarchingCubeBrushPreviewMesh> FVoxelMarchingCube
 			{
 				return {};
 			};
+
+			VOXEL_CALL_NODE_BIND(SimplificationErrorPin)
+			{
+				return 0.f;
+			};
 		};
 
 	const TValue<bool> OnlyDrawIfSelected = GetNodeRuntime().Get(OnlyDrawIfSelectedPin, Query);
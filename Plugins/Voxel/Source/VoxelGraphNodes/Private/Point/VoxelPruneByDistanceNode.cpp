@@ -2,6 +2,11 @@
 
 #include "Point/VoxelPruneByDistanceNode.h"
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHNODES_API, int32, GVoxelPruneByDistanceMinParallelPoints, 16384,
+	"voxel.point.PruneByDistanceMinParallelPoints",
+	"Prune by distance will only run in parallel if there are more points than this");
+
 DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_PruneByDistance, Out)
 {
 	const TValue<FVoxelPointSet> Points = Get(InPin, Query);
@@ -23,72 +28,147 @@ DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_PruneByDistance, Out)
 
 		FindVoxelPointSetAttribute(*Points, FVoxelPointAttributes::Position, FVoxelVectorBuffer, PositionBuffer);
 
-		const float HalfDistance = Distance / 2;
+		const int32 NumPoints = Points->Num();
 		const float DistanceSquared = FMath::Square(Distance);
-		const float BucketSize = Distance;
-		const float InvBucketSize = 1. / BucketSize;
+		const float InvCellSize = 1.f / Distance;
+
+		// Points closer than Distance are always in neighboring cells
+		// Cells of the same color are at least one cell apart and can be processed in parallel
+		// Within a cell points are processed in index order, making the result independent of scheduling
+
+		TVoxelArray<int32> PointToCell;
+		FVoxelUtilities::SetNumFast(PointToCell, NumPoints);
 
-		struct FNode
+		TVoxelAddOnlyMap<FIntVector, int32> CellToIndex;
+		TVoxelArray<FIntVector> Cells;
+		TVoxelArray<int32> CellOffsets;
 		{
-			int32 Next = -1;
-			FVector3f Position = FVector3f(ForceInit);
-		};
-		TVoxelChunkedArray<FNode> Nodes;
+			VOXEL_SCOPE_COUNTER("Build cells");
+
+			CellToIndex.Reserve(NumPoints);
+
+			for (int32 Index = 0; Index < NumPoints; Index++)
+			{
+				const FIntVector Cell = FVoxelUtilities::FloorToInt(PositionBuffer[Index] * InvCellSize);
+
+				int32* CellIndexPtr = CellToIndex.Find(Cell);
+				if (!CellIndexPtr)
+				{
+					CellIndexPtr = &CellToIndex.Add_CheckNew(Cell);
+					*CellIndexPtr = Cells.Add(Cell);
+					CellOffsets.Add(0);
+				}
+
+				PointToCell[Index] = *CellIndexPtr;
+				CellOffsets[*CellIndexPtr]++;
+			}
 
-		struct FBucket
+			int32 Offset = 0;
+			for (int32& CellOffset : CellOffsets)
+			{
+				const int32 Count = CellOffset;
+				CellOffset = Offset;
+				Offset += Count;
+			}
+			CellOffsets.Add(Offset);
+		}
+
+		// Points sorted by cell, in increasing index order within each cell
+		TVoxelArray<int32> SortedPoints;
 		{
-			int32 NodeIndex = -1;
-		};
+			VOXEL_SCOPE_COUNTER("Sort points");
 
-		TVoxelAddOnlyChunkedMap<FIntVector, FBucket> Map;
-		Map.Reserve(8 * Points->Num());
+			FVoxelUtilities::SetNumFast(SortedPoints, NumPoints);
 
-		FVoxelInt32BufferStorage Indices;
-		Indices.Reserve(Points->Num());
+			TVoxelArray<int32> CellCounts;
+			FVoxelUtilities::SetNumZeroed(CellCounts, Cells.Num());
 
-		for (int32 Index = 0; Index < Points->Num(); Index++)
+			for (int32 Index = 0; Index < NumPoints; Index++)
+			{
+				const int32 CellIndex = PointToCell[Index];
+				SortedPoints[CellOffsets[CellIndex] + CellCounts[CellIndex]++] = Index;
+			}
+		}
+
+		TVoxelStaticArray<TVoxelArray<int32>, 27> ColorToCells;
+		for (int32 CellIndex = 0; CellIndex < Cells.Num(); CellIndex++)
 		{
-			const FVector3f Position = PositionBuffer[Index];
-
-			TVoxelArray<FIntVector, TFixedAllocator<8>> Keys;
-			Keys.AddUnique(FVoxelUtilities::FloorToInt((Position + FVector3f(-HalfDistance, -HalfDistance, -HalfDistance)) * InvBucketSize));
-			Keys.AddUnique(FVoxelUtilities::FloorToInt((Position + FVector3f(+HalfDistance, -HalfDistance, -HalfDistance)) * InvBucketSize));
-			Keys.AddUnique(FVoxelUtilities::FloorToInt((Position + FVector3f(-HalfDistance, +HalfDistance, -HalfDistance)) * InvBucketSize));
-			Keys.AddUnique(FVoxelUtilities::FloorToInt((Position + FVector3f(+HalfDistance, +HalfDistance, -HalfDistance)) * InvBucketSize));
-			Keys.AddUnique(FVoxelUtilities::FloorToInt((Position + FVector3f(-HalfDistance, -HalfDistance, +HalfDistance)) * InvBucketSize));
-			Keys.AddUnique(FVoxelUtilities::FloorToInt((Position + FVector3f(+HalfDistance, -HalfDistance, +HalfDistance)) * InvBucketSize));
-			Keys.AddUnique(FVoxelUtilities::FloorToInt((Position + FVector3f(-HalfDistance, +HalfDistance, +HalfDistance)) * InvBucketSize));
-			Keys.AddUnique(FVoxelUtilities::FloorToInt((Position + FVector3f(+HalfDistance, +HalfDistance, +HalfDistance)) * InvBucketSize));
-
-			TVoxelArray<FBucket*, TFixedAllocator<8>> Buckets;
-			for (const FIntVector& Key : Keys)
+			const FIntVector& Cell = Cells[CellIndex];
+			const int32 Color =
+				9 * FVoxelUtilities::PositiveMod(Cell.X, 3) +
+				3 * FVoxelUtilities::PositiveMod(Cell.Y, 3) +
+				FVoxelUtilities::PositiveMod(Cell.Z, 3);
+
+			ColorToCells[Color].Add(CellIndex);
+		}
+
+		// Only written by the thread owning the point cell
+		TVoxelArray<bool> IsKept;
+		FVoxelUtilities::SetNumZeroed(IsKept, NumPoints);
+
+		const auto ProcessCell = [&](const int32 CellIndex)
+		{
+			const FIntVector Cell = Cells[CellIndex];
+
+			TVoxelArray<int32, TFixedAllocator<27>> NeighborCells;
+			for (int32 Z = -1; Z <= 1; Z++)
 			{
-				FBucket& Bucket = Map.FindOrAdd(Key);
-				int32 NodeIndex = Bucket.NodeIndex;
-				while (NodeIndex != -1)
+				for (int32 Y = -1; Y <= 1; Y++)
 				{
-					const FNode& Node = Nodes[NodeIndex];
-					if (FVector3f::DistSquared(Node.Position, Position) < DistanceSquared)
+					for (int32 X = -1; X <= 1; X++)
 					{
-						goto Skip;
+						if (const int32* NeighborCellPtr = CellToIndex.Find(Cell + FIntVector(X, Y, Z)))
+						{
+							NeighborCells.Add(*NeighborCellPtr);
+						}
 					}
-					NodeIndex = Node.Next;
 				}
-				Buckets.Add(&Bucket);
 			}
 
-			for (FBucket* Bucket : Buckets)
+			for (int32 SortedIndex = CellOffsets[CellIndex]; SortedIndex < CellOffsets[CellIndex + 1]; SortedIndex++)
 			{
-				FNode NewNode;
-				NewNode.Next = Bucket->NodeIndex;
-				NewNode.Position = Position;
-				Bucket->NodeIndex = Nodes.Add(NewNode);
+				const int32 Index = SortedPoints[SortedIndex];
+				const FVector3f Position = PositionBuffer[Index];
+
+				for (const int32 NeighborCell : NeighborCells)
+				{
+					for (int32 NeighborSortedIndex = CellOffsets[NeighborCell]; NeighborSortedIndex < CellOffsets[NeighborCell + 1]; NeighborSortedIndex++)
+					{
+						const int32 NeighborIndex = SortedPoints[NeighborSortedIndex];
+						if (IsKept[NeighborIndex] &&
+							FVector3f::DistSquared(PositionBuffer[NeighborIndex], Position) < DistanceSquared)
+						{
+							goto Skip;
+						}
+					}
+				}
+
+				IsKept[Index] = true;
+
+			Skip:
+				;
 			}
+		};
+
+		for (const TVoxelArray<int32>& ColorCells : ColorToCells)
+		{
+			VOXEL_SCOPE_COUNTER_FORMAT("Process cells Num=%d", ColorCells.Num());
 
-			Indices.Add(Index);
+			ParallelFor(ColorCells.Num(), [&](const int32 Index)
+			{
+				ProcessCell(ColorCells[Index]);
+			}, NumPoints > GVoxelPruneByDistanceMinParallelPoints ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+		}
 
-		Skip:
-			;
+		FVoxelInt32BufferStorage Indices;
+		Indices.Reserve(NumPoints);
+
+		for (int32 Index = 0; Index < NumPoints; Index++)
+		{
+			if (IsKept[Index])
+			{
+				Indices.Add(Index);
+			}
 		}
 
 		return Points->Gather(FVoxelInt32Buffer::Make(Indices));
@@ -4,6 +4,66 @@
 #include "VoxelPositionQueryParameter.h"
 #include "VoxelGradientNodes.h"
 
+// Over-relaxation factor when sphere tracing, see Enhanced Sphere Tracing (Keinert et al. 2014)
+constexpr float GVoxelRaymarchOverRelaxation = 1.6f;
+constexpr int32 GVoxelRaymarchNumRaysPerChunk = 4096;
+
+// Runs Lambda(StartIndex, EndIndex) on chunks of rays, in parallel if there are several chunks
+template<typename LambdaType>
+static void ForeachRayChunk(const int32 Num, LambdaType&& Lambda)
+{
+	const int32 NumChunks = FMath::DivideAndRoundUp(Num, GVoxelRaymarchNumRaysPerChunk);
+
+	ParallelFor(NumChunks, [&](const int32 ChunkIndex)
+	{
+		const int32 StartIndex = ChunkIndex * GVoxelRaymarchNumRaysPerChunk;
+		const int32 EndIndex = FMath::Min(StartIndex + GVoxelRaymarchNumRaysPerChunk, Num);
+		Lambda(StartIndex, EndIndex);
+	}, NumChunks > 1 ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+}
+
+// Returns the sorted indices for which ShouldKeep is true
+template<typename LambdaType>
+static TVoxelArray<int32> FilterRays(const int32 Num, LambdaType&& ShouldKeep)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	TVoxelArray<TVoxelArray<int32>> ChunkIndices;
+	ChunkIndices.SetNum(FMath::DivideAndRoundUp(Num, GVoxelRaymarchNumRaysPerChunk));
+
+	ForeachRayChunk(Num, [&](const int32 StartIndex, const int32 EndIndex)
+	{
+		TVoxelArray<int32>& Indices = ChunkIndices[StartIndex / GVoxelRaymarchNumRaysPerChunk];
+		Indices.Reserve(EndIndex - StartIndex);
+
+		for (int32 Index = StartIndex; Index < EndIndex; Index++)
+		{
+			if (ShouldKeep(Index))
+			{
+				Indices.Add_NoGrow(Index);
+			}
+		}
+	});
+
+	int32 NumIndices = 0;
+	for (const TVoxelArray<int32>& Indices : ChunkIndices)
+	{
+		NumIndices += Indices.Num();
+	}
+
+	TVoxelArray<int32> Result;
+	Result.Reserve(NumIndices);
+	for (const TVoxelArray<int32>& Indices : ChunkIndices)
+	{
+		Result.Append(Indices);
+	}
+	return Result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 void FVoxelRaymarchDistanceFieldProcessor::Compute()
 {
 	VOXEL_FUNCTION_COUNTER();
@@ -71,59 +131,116 @@ TSharedRef<FVoxelPointSet> FVoxelRaymarchDistanceFieldProcessor::GetNewPoints()
 	return NewPoints->Gather(FVoxelInt32Buffer::Make(Indices));
 }
 
-void FVoxelRaymarchDistanceFieldProcessor::ProcessDistances(const FVoxelFloatBuffer& NewDistances)
+FVoxelVectorBuffer FVoxelRaymarchDistanceFieldProcessor::GetPositionsToProcess() const
 {
 	VOXEL_FUNCTION_COUNTER();
-	FVoxelNodeStatScope StatScope(Node, 0);
 
-	if (Step == 0)
-	{
-		const int32 Num = Points->Num();
-		IndicesToProcess.Reserve(Num);
-		Distances.Reserve(Num);
+	FVoxelFloatBufferStorage NewPositionX;
+	FVoxelFloatBufferStorage NewPositionY;
+	FVoxelFloatBufferStorage NewPositionZ;
+	NewPositionX.Allocate(IndicesToProcess.Num());
+	NewPositionY.Allocate(IndicesToProcess.Num());
+	NewPositionZ.Allocate(IndicesToProcess.Num());
 
-		if (!ensure(NewDistances.IsConstant() || NewDistances.Num() == Num))
+	ForeachRayChunk(IndicesToProcess.Num(), [&](const int32 StartIndex, const int32 EndIndex)
+	{
+		for (int32 Index = StartIndex; Index < EndIndex; Index++)
 		{
-			Finalize();
-			return;
+			const int32 IndexToProcess = IndicesToProcess[Index];
+			NewPositionX[Index] = (*PositionX)[IndexToProcess];
+			NewPositionY[Index] = (*PositionY)[IndexToProcess];
+			NewPositionZ[Index] = (*PositionZ)[IndexToProcess];
 		}
+	});
 
-		for (int32 Index = 0; Index < Num; Index++)
-		{
-			const float Distance = NewDistances[Index];
-			if (FMath::Abs(Distance) <= Tolerance)
-			{
-				continue;
-			}
+	return FVoxelVectorBuffer::Make(
+		NewPositionX,
+		NewPositionY,
+		NewPositionZ);
+}
 
-			IndicesToProcess.Add_NoGrow(Index);
-			Distances.Add_NoGrow(Distance);
-		}
+void FVoxelRaymarchDistanceFieldProcessor::QueryDistances()
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	const TSharedRef<FVoxelQueryParameters> Parameters = BaseQuery.CloneParameters();
+	Parameters->Add<FVoxelGradientStepQueryParameter>().Step = GradientStep;
+	Parameters->Add<FVoxelPositionQueryParameter>().Initialize(GetPositionsToProcess());
+
+	const TVoxelFutureValue<FVoxelFloatBuffer> NewDistances = Surface->GetDistance(BaseQuery.MakeNewQuery(Parameters));
+
+	MakeVoxelTask()
+	.Dependency(NewDistances)
+	.Execute(MakeWeakPtrLambda(this, [=]
+	{
+		ProcessDistances(NewDistances.Get_CheckCompleted());
+	}));
+}
+
+void FVoxelRaymarchDistanceFieldProcessor::ProcessDistances(const FVoxelFloatBuffer& NewDistances)
+{
+	VOXEL_FUNCTION_COUNTER();
+	FVoxelNodeStatScope StatScope(Node, 0);
+
+	// On the first step all the points are queried
+	const int32 Num = Step == 0 ? Points->Num() : IndicesToProcess.Num();
+	if (!ensure(NewDistances.IsConstant() || NewDistances.Num() == Num))
+	{
+		Finalize();
+		return;
 	}
-	else
+
+	// Compact the rays that haven't converged yet so that the next queries only include them
+	const TVoxelArray<int32> RaysToKeep = FilterRays(Num, [&](const int32 Index)
+	{
+		return FMath::Abs(NewDistances[Index]) > Tolerance;
+	});
+
 	{
-		const TVoxelArray<int32> OldIndicesToProcess = MoveTemp(IndicesToProcess);
+		VOXEL_SCOPE_COUNTER("Compact");
 
-		const int32 Num = OldIndicesToProcess.Num();
-		IndicesToProcess.Reset(Num);
-		Distances.Reset(Num);
+		const bool bCompactSphereTracing = LastSteps.Num() > 0;
 
-		if (!ensure(NewDistances.IsConstant() || NewDistances.Num() == Num))
+		TVoxelArray<int32> NewIndicesToProcess;
+		TVoxelArray<float> NewLastSteps;
+		TVoxelArray<float> NewLastStepDistances;
+		TVoxelArray<float> NewRelaxations;
+
+		FVoxelUtilities::SetNumFast(NewIndicesToProcess, RaysToKeep.Num());
+		FVoxelUtilities::SetNumFast(Distances, RaysToKeep.Num());
+
+		if (bCompactSphereTracing)
 		{
-			Finalize();
-			return;
+			FVoxelUtilities::SetNumFast(NewLastSteps, RaysToKeep.Num());
+			FVoxelUtilities::SetNumFast(NewLastStepDistances, RaysToKeep.Num());
+			FVoxelUtilities::SetNumFast(NewRelaxations, RaysToKeep.Num());
 		}
 
-		for (int32 Index = 0; Index < Num; Index++)
+		ForeachRayChunk(RaysToKeep.Num(), [&](const int32 StartIndex, const int32 EndIndex)
 		{
-			const float Distance = NewDistances[Index];
-			if (FMath::Abs(Distance) <= Tolerance)
+			for (int32 Index = StartIndex; Index < EndIndex; Index++)
 			{
-				continue;
+				const int32 RayIndex = RaysToKeep[Index];
+
+				NewIndicesToProcess[Index] = Step == 0 ? RayIndex : IndicesToProcess[RayIndex];
+				Distances[Index] = NewDistances[RayIndex];
+
+				if (bCompactSphereTracing)
+				{
+					NewLastSteps[Index] = LastSteps[RayIndex];
+					NewLastStepDistances[Index] = LastStepDistances[RayIndex];
+					NewRelaxations[Index] = Relaxations[RayIndex];
+				}
 			}
+		});
 
-			IndicesToProcess.Add_NoGrow(OldIndicesToProcess[Index]);
-			Distances.Add_NoGrow(Distance);
+		IndicesToProcess = MoveTemp(NewIndicesToProcess);
+
+		if (bCompactSphereTracing)
+		{
+			LastSteps = MoveTemp(NewLastSteps);
+			LastStepDistances = MoveTemp(NewLastStepDistances);
+			Relaxations = MoveTemp(NewRelaxations);
 		}
 	}
 
@@ -133,26 +250,15 @@ void FVoxelRaymarchDistanceFieldProcessor::ProcessDistances(const FVoxelFloatBuf
 		return;
 	}
 
-	FVoxelFloatBufferStorage NewPositionX;
-	FVoxelFloatBufferStorage NewPositionY;
-	FVoxelFloatBufferStorage NewPositionZ;
-	NewPositionX.Allocate(IndicesToProcess.Num());
-	NewPositionY.Allocate(IndicesToProcess.Num());
-	NewPositionZ.Allocate(IndicesToProcess.Num());
-	for (int32 Index = 0; Index < IndicesToProcess.Num(); Index++)
+	if (LipschitzBound > 0.f)
 	{
-		const int32 IndexToProcess = IndicesToProcess[Index];
-		NewPositionX[Index] = (*PositionX)[IndexToProcess];
-		NewPositionY[Index] = (*PositionY)[IndexToProcess];
-		NewPositionZ[Index] = (*PositionZ)[IndexToProcess];
+		SphereTrace();
+		return;
 	}
 
 	const TSharedRef<FVoxelQueryParameters> Parameters = BaseQuery.CloneParameters();
 	Parameters->Add<FVoxelGradientStepQueryParameter>().Step = GradientStep;
-	Parameters->Add<FVoxelPositionQueryParameter>().Initialize(FVoxelVectorBuffer::Make(
-		NewPositionX,
-		NewPositionY,
-		NewPositionZ));
+	Parameters->Add<FVoxelPositionQueryParameter>().Initialize(GetPositionsToProcess());
 
 	const TSharedRef<const FVoxelSurface> LocalSurface = Surface;
 
@@ -184,19 +290,22 @@ void FVoxelRaymarchDistanceFieldProcessor::ProcessGradient(const FVoxelVectorBuf
 		return;
 	}
 
-	for (int32 Index = 0; Index < IndicesToProcess.Num(); Index++)
+	ForeachRayChunk(IndicesToProcess.Num(), [&](const int32 StartIndex, const int32 EndIndex)
 	{
-		const int32 IndexToProcess = IndicesToProcess[Index];
-		const float Distance = Distances[Index];
-		const FVector3f Gradient = Gradients[Index];
-		const FVector3f Normal = Normals[IndexToProcess];
+		for (int32 Index = StartIndex; Index < EndIndex; Index++)
+		{
+			const int32 IndexToProcess = IndicesToProcess[Index];
+			const float Distance = Distances[Index];
+			const FVector3f Gradient = Gradients[Index];
+			const FVector3f Normal = Normals[IndexToProcess];
 
-		const float Value = FVector3f::DotProduct(Gradient.GetSafeNormal(), Normal.GetSafeNormal()) * Distance * Speed;
+			const float Value = FVector3f::DotProduct(Gradient.GetSafeNormal(), Normal.GetSafeNormal()) * Distance * Speed;
 
-		(*PositionX)[IndexToProcess] -= Normal.X * Value;
-		(*PositionY)[IndexToProcess] -= Normal.Y * Value;
-		(*PositionZ)[IndexToProcess] -= Normal.Z * Value;
-	}
+			(*PositionX)[IndexToProcess] -= Normal.X * Value;
+			(*PositionY)[IndexToProcess] -= Normal.Y * Value;
+			(*PositionZ)[IndexToProcess] -= Normal.Z * Value;
+		}
+	});
 
 	Step++;
 
@@ -206,35 +315,71 @@ void FVoxelRaymarchDistanceFieldProcessor::ProcessGradient(const FVoxelVectorBuf
 		return;
 	}
 
-	FVoxelFloatBufferStorage NewPositionX;
-	FVoxelFloatBufferStorage NewPositionY;
-	FVoxelFloatBufferStorage NewPositionZ;
-	NewPositionX.Allocate(IndicesToProcess.Num());
-	NewPositionY.Allocate(IndicesToProcess.Num());
-	NewPositionZ.Allocate(IndicesToProcess.Num());
-	for (int32 Index = 0; Index < IndicesToProcess.Num(); Index++)
+	QueryDistances();
+}
+
+void FVoxelRaymarchDistanceFieldProcessor::SphereTrace()
+{
+	VOXEL_FUNCTION_COUNTER();
+	ensure(IndicesToProcess.Num() > 0);
+	ensure(LipschitzBound > 0.f);
+	FVoxelNodeStatScope StatScope(Node, 0);
+
+	const int32 Num = IndicesToProcess.Num();
+	if (LastSteps.Num() == 0)
 	{
-		const int32 IndexToProcess = IndicesToProcess[Index];
-		NewPositionX[Index] = (*PositionX)[IndexToProcess];
-		NewPositionY[Index] = (*PositionY)[IndexToProcess];
-		NewPositionZ[Index] = (*PositionZ)[IndexToProcess];
+		LastSteps.SetNumZeroed(Num);
+		LastStepDistances.SetNumZeroed(Num);
+		Relaxations.Init(GVoxelRaymarchOverRelaxation, Num);
 	}
+	check(LastSteps.Num() == Num);
 
-	const TSharedRef<FVoxelQueryParameters> Parameters = BaseQuery.CloneParameters();
-	Parameters->Add<FVoxelGradientStepQueryParameter>().Step = GradientStep;
-	Parameters->Add<FVoxelPositionQueryParameter>().Initialize(FVoxelVectorBuffer::Make(
-		NewPositionX,
-		NewPositionY,
-		NewPositionZ));
+	// Distance can change by at most LipschitzBound per unit, so the ball of radius |Distance| / LipschitzBound
+	// around the point doesn't contain the surface and it's safe to move that far along the normal
+	ForeachRayChunk(Num, [&](const int32 StartIndex, const int32 EndIndex)
+	{
+		for (int32 Index = StartIndex; Index < EndIndex; Index++)
+		{
+			const int32 IndexToProcess = IndicesToProcess[Index];
+			const FVector3f Normal = Normals[IndexToProcess].GetSafeNormal();
 
-	const TVoxelFutureValue<FVoxelFloatBuffer> NewDistances = Surface->GetDistance(BaseQuery.MakeNewQuery(Parameters));
+			float Distance = Distances[Index];
+			float& LastStep = LastSteps[Index];
+			float& LastStepDistance = LastStepDistances[Index];
+			float& Relaxation = Relaxations[Index];
 
-	MakeVoxelTask()
-	.Dependency(NewDistances)
-	.Execute(MakeWeakPtrLambda(this, [=]
+			FVector3f Delta = FVector3f::ZeroVector;
+
+			if (FMath::Abs(LastStep) * LipschitzBound > FMath::Abs(LastStepDistance) + FMath::Abs(Distance))
+			{
+				// The last over-relaxed step went too far: the balls don't overlap and the surface might have been skipped
+				// Step back and stop over-relaxing this ray
+				Delta += Normal * LastStep;
+				Distance = LastStepDistance;
+				Relaxation = 1.f;
+			}
+
+			const float NewStep = Relaxation * Distance / LipschitzBound;
+			Delta -= Normal * NewStep;
+
+			LastStep = NewStep;
+			LastStepDistance = Distance;
+
+			(*PositionX)[IndexToProcess] += Delta.X;
+			(*PositionY)[IndexToProcess] += Delta.Y;
+			(*PositionZ)[IndexToProcess] += Delta.Z;
+		}
+	});
+
+	Step++;
+
+	if (Step == MaxSteps)
 	{
-		ProcessDistances(NewDistances.Get_CheckCompleted());
-	}));
+		Finalize();
+		return;
+	}
+
+	QueryDistances();
 }
 
 void FVoxelRaymarchDistanceFieldProcessor::Finalize()
@@ -299,8 +444,9 @@ DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_RaymarchDistanceField, Out)
 	const TValue<int32> MaxSteps = Get(MaxStepsPin, Query);
 	const TValue<float> Speed = Get(SpeedPin, Query);
 	const TValue<float> GradientStep = Get(GradientStepPin, Query);
+	const TValue<float> LipschitzBound = Get(LipschitzBoundPin, Query);
 
-	return VOXEL_ON_COMPLETE(Points, Surface, UpdateNormal, KillDistance, Tolerance, MaxSteps, Speed, GradientStep)
+	return VOXEL_ON_COMPLETE(Points, Surface, UpdateNormal, KillDistance, Tolerance, MaxSteps, Speed, GradientStep, LipschitzBound)
 	{
 		if (Points->Num() == 0)
 		{
@@ -327,6 +473,7 @@ DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_RaymarchDistanceField, Out)
 			MaxSteps,
 			Speed,
 			GradientStep,
+			LipschitzBound,
 			Points,
 			PositionBuffer,
 			NormalBuffer);
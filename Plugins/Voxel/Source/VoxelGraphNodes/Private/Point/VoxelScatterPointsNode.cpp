@@ -1,6 +1,7 @@
 ﻿// Copyright Voxel Plugin, Inc. All Rights Reserved.
 
 #include "Point/VoxelScatterPointsNode.h"
+#include "VoxelBenchmarkStats.h"
 
 DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_ScatterPoints, Out)
 {
@@ -20,6 +21,7 @@ DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_ScatterPoints, Out)
 		}
 
 		FVoxelNodeStatScope StatScope(*this, Points->Num());
+		VOXEL_BENCHMARK_SCOPE("PointScatter");
 		return PointSpawner->GeneratePoints(*Points);
 	};
 }
\ No newline at end of file
@@ -119,4 +119,123 @@ void FVoxelTemplateNode_CommutativeAssociativeOperator::FDefinition::AddInputPin
 		}
 	}
 }
-#endif
\ No newline at end of file
+#endif
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool FVoxelNode_Add_Float::ComputePartialDerivatives(FPartialDerivatives& Derivatives) const
+{
+	const FVoxelFloatBuffer& A = Derivatives.Get<FVoxelFloatBuffer>(APin);
+	const FVoxelFloatBuffer& B = Derivatives.Get<FVoxelFloatBuffer>(BPin);
+	const FVoxelFloatBuffer& ReturnValue = Derivatives.Get<FVoxelFloatBuffer>(ReturnValuePin);
+
+	Derivatives.Add(ReturnValue, A, FVoxelFloatBuffer::Make(1.f));
+	Derivatives.Add(ReturnValue, B, FVoxelFloatBuffer::Make(1.f));
+	return true;
+}
+
+bool FVoxelNode_Subtract_Float::ComputePartialDerivatives(FPartialDerivatives& Derivatives) const
+{
+	const FVoxelFloatBuffer& A = Derivatives.Get<FVoxelFloatBuffer>(APin);
+	const FVoxelFloatBuffer& B = Derivatives.Get<FVoxelFloatBuffer>(BPin);
+	const FVoxelFloatBuffer& ReturnValue = Derivatives.Get<FVoxelFloatBuffer>(ReturnValuePin);
+
+	Derivatives.Add(ReturnValue, A, FVoxelFloatBuffer::Make(1.f));
+	Derivatives.Add(ReturnValue, B, FVoxelFloatBuffer::Make(-1.f));
+	return true;
+}
+
+bool FVoxelNode_Multiply_Float::ComputePartialDerivatives(FPartialDerivatives& Derivatives) const
+{
+	const FVoxelFloatBuffer& A = Derivatives.Get<FVoxelFloatBuffer>(APin);
+	const FVoxelFloatBuffer& B = Derivatives.Get<FVoxelFloatBuffer>(BPin);
+	const FVoxelFloatBuffer& ReturnValue = Derivatives.Get<FVoxelFloatBuffer>(ReturnValuePin);
+
+	Derivatives.Add(ReturnValue, A, B);
+	Derivatives.Add(ReturnValue, B, A);
+	return true;
+}
+
+bool FVoxelNode_Divide_Float::ComputePartialDerivatives(FPartialDerivatives& Derivatives) const
+{
+	const FVoxelFloatBuffer& A = Derivatives.Get<FVoxelFloatBuffer>(APin);
+	const FVoxelFloatBuffer& B = Derivatives.Get<FVoxelFloatBuffer>(BPin);
+	const FVoxelFloatBuffer& ReturnValue = Derivatives.Get<FVoxelFloatBuffer>(ReturnValuePin);
+
+	// Division by zero returns a constant, see GenerateCode
+	Derivatives.Add(ReturnValue, A, Derivatives.MakeDerivative([&](const int32 Index)
+	{
+		return B[Index] != 0.f ? 1.f / B[Index] : 0.f;
+	}));
+
+	if (!B.IsConstant())
+	{
+		Derivatives.Add(ReturnValue, B, Derivatives.MakeDerivative([&](const int32 Index)
+		{
+			return B[Index] != 0.f ? -A[Index] / FMath::Square(B[Index]) : 0.f;
+		}));
+	}
+	return true;
+}
+
+bool FVoxelNode_Min_Float::ComputePartialDerivatives(FPartialDerivatives& Derivatives) const
+{
+	const FVoxelFloatBuffer& A = Derivatives.Get<FVoxelFloatBuffer>(APin);
+	const FVoxelFloatBuffer& B = Derivatives.Get<FVoxelFloatBuffer>(BPin);
+	const FVoxelFloatBuffer& ReturnValue = Derivatives.Get<FVoxelFloatBuffer>(ReturnValuePin);
+
+	const FVoxelFloatBuffer DerivativeA = Derivatives.MakeDerivative([&](const int32 Index)
+	{
+		return A[Index] < B[Index] ? 1.f : 0.f;
+	});
+	const FVoxelFloatBuffer DerivativeB = Derivatives.MakeDerivative([&](const int32 Index)
+	{
+		return 1.f - DerivativeA[Index];
+	});
+
+	Derivatives.Add(ReturnValue, A, DerivativeA);
+	Derivatives.Add(ReturnValue, B, DerivativeB);
+	return true;
+}
+
+bool FVoxelNode_Max_Float::ComputePartialDerivatives(FPartialDerivatives& Derivatives) const
+{
+	const FVoxelFloatBuffer& A = Derivatives.Get<FVoxelFloatBuffer>(APin);
+	const FVoxelFloatBuffer& B = Derivatives.Get<FVoxelFloatBuffer>(BPin);
+	const FVoxelFloatBuffer& ReturnValue = Derivatives.Get<FVoxelFloatBuffer>(ReturnValuePin);
+
+	const FVoxelFloatBuffer DerivativeA = Derivatives.MakeDerivative([&](const int32 Index)
+	{
+		return A[Index] > B[Index] ? 1.f : 0.f;
+	});
+	const FVoxelFloatBuffer DerivativeB = Derivatives.MakeDerivative([&](const int32 Index)
+	{
+		return 1.f - DerivativeA[Index];
+	});
+
+	Derivatives.Add(ReturnValue, A, DerivativeA);
+	Derivatives.Add(ReturnValue, B, DerivativeB);
+	return true;
+}
+
+bool FVoxelNode_Abs_Float::ComputePartialDerivatives(FPartialDerivatives& Derivatives) const
+{
+	const FVoxelFloatBuffer& Value = Derivatives.Get<FVoxelFloatBuffer>(ValuePin);
+	const FVoxelFloatBuffer& ReturnValue = Derivatives.Get<FVoxelFloatBuffer>(ReturnValuePin);
+
+	Derivatives.Add(ReturnValue, Value, Derivatives.MakeDerivative([&](const int32 Index)
+	{
+		return Value[Index] < 0.f ? -1.f : 1.f;
+	}));
+	return true;
+}
+
+bool FVoxelNode_OneMinus_Float::ComputePartialDerivatives(FPartialDerivatives& Derivatives) const
+{
+	const FVoxelFloatBuffer& Value = Derivatives.Get<FVoxelFloatBuffer>(ValuePin);
+	const FVoxelFloatBuffer& ReturnValue = Derivatives.Get<FVoxelFloatBuffer>(ReturnValuePin);
+
+	Derivatives.Add(ReturnValue, Value, FVoxelFloatBuffer::Make(-1.f));
+	return true;
+}
\ No newline at end of file
@@ -4,6 +4,21 @@
 #include "VoxelDependency.h"
 #include "VoxelCurveNodeImpl.ispc.generated.h"
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHNODES_API, bool, GVoxelCurveEnableLUT, true,
+	"voxel.curve.EnableLUT",
+	"If true, curves will be baked into a lookup table and sampled with ISPC, both with and without Fast Curve");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHNODES_API, float, GVoxelCurveLUTMaxError, 1.e-4f,
+	"voxel.curve.LUTMaxError",
+	"Max error of curve lookup tables, relative to the curve value range");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHNODES_API, int32, GVoxelCurveLUTMaxNumCells, 16384,
+	"voxel.curve.LUTMaxNumCells",
+	"Max number of cells in a curve lookup table. Curves that can't be baked within the error bound will not use a lookup table");
+
 void FVoxelCurve::ComputeRuntimeData()
 {
 	if (Wrapper)
@@ -29,8 +44,237 @@ struct FVoxelCurveData
 	FString Error;
 	float DefaultValue = 0.f;
 	TVoxelArray<ispc::FRichCurveKey> Keys;
+
+	bool bHasLUT = false;
+	ispc::FVoxelCurveLUT LUT{};
+	TVoxelArray<ispc::FVoxelCurveLUTCell> LUTCells;
+
+	void BuildLUT(const FRichCurve& Curve);
+	float SampleLUT(float Time) const;
+
+private:
+	bool TryBuildLUT(
+		const FRichCurve& Curve,
+		TConstVoxelArrayView<int32> SplitKeys,
+		int32 NumCells);
 };
 
+void FVoxelCurveData::BuildLUT(const FRichCurve& Curve)
+{
+	VOXEL_FUNCTION_COUNTER();
+	ensure(!bHasLUT);
+
+	const TArray<FRichCurveKey>& CurveKeys = Curve.Keys;
+	if (CurveKeys.Num() < 2)
+	{
+		return;
+	}
+
+	const auto IsSupportedExtrap = [](const ERichCurveExtrapolation Extrap)
+	{
+		return
+			Extrap == RCCE_Linear ||
+			Extrap == RCCE_Constant ||
+			Extrap == RCCE_None;
+	};
+	if (!IsSupportedExtrap(Curve.PreInfinityExtrap) ||
+		!IsSupportedExtrap(Curve.PostInfinityExtrap))
+	{
+		// Cycling curves are not baked
+		return;
+	}
+
+	const float MinTime = CurveKeys[0].Time;
+	const float MaxTime = CurveKeys.Last().Time;
+	if (!(MinTime < MaxTime))
+	{
+		return;
+	}
+
+	// Extrapolation is linear (or constant) outside of the keys: measure its slope directly
+	const float ExtrapDelta = FMath::Max(MaxTime - MinTime, 1.f);
+
+	LUT.MinTime = MinTime;
+	LUT.MaxTime = MaxTime;
+	LUT.MinValue = Curve.Eval(MinTime);
+	LUT.MaxValue = Curve.Eval(MaxTime);
+	LUT.PreSlope = (LUT.MinValue - Curve.Eval(MinTime - ExtrapDelta)) / ExtrapDelta;
+	LUT.PostSlope = (Curve.Eval(MaxTime + ExtrapDelta) - LUT.MaxValue) / ExtrapDelta;
+
+	// Keys where the curve isn't smooth are stored exactly in the cell containing them
+	TVoxelArray<int32> SplitKeys;
+	for (int32 KeyIndex = 1; KeyIndex < CurveKeys.Num(); KeyIndex++)
+	{
+		const FRichCurveKey& PreviousKey = CurveKeys[KeyIndex - 1];
+		const FRichCurveKey& Key = CurveKeys[KeyIndex];
+
+		if (KeyIndex < CurveKeys.Num() - 1 &&
+			PreviousKey.InterpMode == RCIM_Cubic &&
+			Key.InterpMode == RCIM_Cubic &&
+			Key.ArriveTangent == Key.LeaveTangent)
+		{
+			continue;
+		}
+
+		SplitKeys.Add(KeyIndex);
+	}
+
+	const int32 MaxNumCells = FMath::Max(GVoxelCurveLUTMaxNumCells, 1);
+	int32 NumCells = FMath::Min<int32>(FMath::RoundUpToPowerOfTwo(FMath::Max(64, 2 * CurveKeys.Num())), MaxNumCells);
+
+	while (true)
+	{
+		if (TryBuildLUT(Curve, SplitKeys, NumCells))
+		{
+			bHasLUT = true;
+			return;
+		}
+
+		if (NumCells >= MaxNumCells)
+		{
+			LUTCells.Empty();
+			return;
+		}
+
+		NumCells = FMath::Min(2 * NumCells, MaxNumCells);
+	}
+}
+
+bool FVoxelCurveData::TryBuildLUT(
+	const FRichCurve& Curve,
+	const TConstVoxelArrayView<int32> SplitKeys,
+	const int32 NumCells)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	LUT.NumCells = NumCells;
+	LUT.CellSize = (LUT.MaxTime - LUT.MinTime) / NumCells;
+	LUT.TimeToCell = NumCells / (LUT.MaxTime - LUT.MinTime);
+
+	const auto GetCellTime = [&](const int32 Cell)
+	{
+		return LUT.MinTime + Cell * LUT.CellSize;
+	};
+
+	FVoxelUtilities::SetNumFast(LUTCells, NumCells + 1);
+
+	for (int32 Cell = 0; Cell <= NumCells; Cell++)
+	{
+		LUTCells[Cell].Value = Curve.Eval(GetCellTime(Cell));
+	}
+	for (int32 Cell = 0; Cell <= NumCells; Cell++)
+	{
+		ispc::FVoxelCurveLUTCell& LUTCell = LUTCells[Cell];
+		const float NextValue = LUTCells[FMath::Min(Cell + 1, NumCells)].Value;
+
+		LUTCell.SplitTime = GetCellTime(Cell + 1);
+		LUTCell.SplitLeftValue = NextValue;
+		LUTCell.SplitRightValue = NextValue;
+	}
+
+	int32 LastSplitCell = -1;
+	for (const int32 KeyIndex : SplitKeys)
+	{
+		const FRichCurveKey& PreviousKey = Curve.Keys[KeyIndex - 1];
+		const FRichCurveKey& Key = Curve.Keys[KeyIndex];
+
+		// Find the cell such that StartTime < Key.Time <= EndTime
+		int32 Cell = FMath::Clamp(FMath::CeilToInt((Key.Time - LUT.MinTime) * LUT.TimeToCell) - 1, 0, NumCells - 1);
+		while (Cell > 0 && Key.Time <= GetCellTime(Cell))
+		{
+			Cell--;
+		}
+		while (Cell < NumCells - 1 && Key.Time > GetCellTime(Cell + 1))
+		{
+			Cell++;
+		}
+
+		if (Cell <= LastSplitCell)
+		{
+			// Several keys in the same cell, need a higher resolution
+			return false;
+		}
+		LastSplitCell = Cell;
+
+		ispc::FVoxelCurveLUTCell& LUTCell = LUTCells[Cell];
+		LUTCell.SplitTime = Key.Time;
+		LUTCell.SplitLeftValue = PreviousKey.InterpMode == RCIM_Constant ? PreviousKey.Value : Key.Value;
+		LUTCell.SplitRightValue = Key.Value;
+	}
+
+	float MinValue = MAX_flt;
+	float MaxValue = -MAX_flt;
+	for (const ispc::FVoxelCurveLUTCell& LUTCell : LUTCells)
+	{
+		MinValue = FMath::Min(MinValue, FMath::Min3(LUTCell.Value, LUTCell.SplitLeftValue, LUTCell.SplitRightValue));
+		MaxValue = FMath::Max(MaxValue, FMath::Max3(LUTCell.Value, LUTCell.SplitLeftValue, LUTCell.SplitRightValue));
+	}
+
+	const float MaxError = GVoxelCurveLUTMaxError * FMath::Max(MaxValue - MinValue, KINDA_SMALL_NUMBER);
+
+	// Constant and linear segments are exact, only cubic segments can fail here
+	for (int32 Cell = 0; Cell < NumCells; Cell++)
+	{
+		const float StartTime = GetCellTime(Cell);
+		const float EndTime = GetCellTime(Cell + 1);
+		const float SplitTime = LUTCells[Cell].SplitTime;
+
+		for (const float Alpha : { 0.25f, 0.5f, 0.75f })
+		{
+			for (const float Time : {
+				FMath::Lerp(StartTime, SplitTime, Alpha),
+				FMath::Lerp(SplitTime, EndTime, Alpha) })
+			{
+				if (Time <= StartTime ||
+					Time >= EndTime)
+				{
+					continue;
+				}
+
+				if (FMath::Abs(SampleLUT(Time) - Curve.Eval(Time)) > MaxError)
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+float FVoxelCurveData::SampleLUT(const float Time) const
+{
+	// Must match VoxelCurveFunctionLibrary_SampleCurveLUT
+
+	if (Time <= LUT.MinTime)
+	{
+		return LUT.MinValue + LUT.PreSlope * (Time - LUT.MinTime);
+	}
+	if (Time >= LUT.MaxTime)
+	{
+		return LUT.MaxValue + LUT.PostSlope * (Time - LUT.MaxTime);
+	}
+
+	const int32 Cell = int32(FMath::Clamp(FMath::FloorToFloat((Time - LUT.MinTime) * LUT.TimeToCell), 0.f, float(LUT.NumCells - 1)));
+	const float StartTime = LUT.MinTime + Cell * LUT.CellSize;
+	const float EndTime = LUT.MinTime + (Cell + 1) * LUT.CellSize;
+
+	const auto GetAlpha = [&](const float A, const float B)
+	{
+		return B - A > 0.f ? FMath::Clamp((Time - A) / (B - A), 0.f, 1.f) : 0.f;
+	};
+
+	const ispc::FVoxelCurveLUTCell& LUTCell = LUTCells[Cell];
+	if (Time < LUTCell.SplitTime)
+	{
+		return FMath::Lerp(LUTCell.Value, LUTCell.SplitLeftValue, GetAlpha(StartTime, LUTCell.SplitTime));
+	}
+	else
+	{
+		return FMath::Lerp(LUTCell.SplitRightValue, LUTCells[Cell + 1].Value, GetAlpha(LUTCell.SplitTime, EndTime));
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -224,6 +468,8 @@ void FVoxelCurveDataWrapper::Update(const FRichCurve& Curve)
 
 	Data->Error.RemoveFromEnd("\n");
 
+	Data->BuildLUT(Curve);
+
 	{
 		VOXEL_SCOPE_LOCK(CriticalSection);
 		Data_RequiresLock = Data;
@@ -290,6 +536,25 @@ FVoxelFloatBuffer UVoxelCurveFunctionLibrary::SampleCurve(
 
 	GetQuery().GetDependencyTracker().AddDependency(Curve.Wrapper->Dependency);
 
+	if (GVoxelCurveEnableLUT &&
+		Data->bHasLUT)
+	{
+		FVoxelFloatBufferStorage ReturnValue;
+		ReturnValue.Allocate(Value.Num());
+
+		ForeachVoxelBufferChunk(Value.Num(), [&](const FVoxelBufferIterator& Iterator)
+		{
+			ispc::VoxelCurveFunctionLibrary_SampleCurveLUT(
+				&Data->LUT,
+				Data->LUTCells.GetData(),
+				Value.GetData(Iterator),
+				Iterator.Num(),
+				ReturnValue.GetData(Iterator));
+		});
+
+		return FVoxelFloatBuffer::Make(ReturnValue);
+	}
+
 	if (!bFastCurve)
 	{
 		FVoxelFloatBufferStorage ReturnValue;
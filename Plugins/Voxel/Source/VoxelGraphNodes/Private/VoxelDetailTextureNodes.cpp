@@ -352,27 +352,42 @@ TVoxelFutureValue<FVoxelComputedMaterialParameter> FVoxelDetailTextureParameter:
 
 			const int32 CellCoordinatesTextureIndex = Helper->AddCellCoordinates(MoveTemp(CellCoordinates0));
 
+			// The texture data is entirely derived from Buffer, hash it instead of reading back the upload
+			const uint64 BufferHash = Buffer->GetContentHash();
+			const uint64 ContentHash =
+				BufferHash == 0
+				? 0
+				: FVoxelUtilities::MurmurHashMulti(
+					BufferHash,
+					GetStruct(),
+					TextureSize,
+					Allocation->PixelFormat,
+					Allocation->NumTextures);
+
 			TVoxelArray<FVoxelDummyFutureValue> UploadDummies;
 			for (const TSharedRef<FVoxelDetailTextureUpload>& Upload : Uploads)
 			{
 				UploadDummies.Add(Upload->Upload());
 			}
 
-			return VOXEL_ON_COMPLETE(TextureSize, Allocation, CellCoordinatesTextureIndex, UploadDummies)
+			return VOXEL_ON_COMPLETE(TextureSize, Allocation, CellCoordinatesTextureIndex, ContentHash, UploadDummies)
 			{
 				FVoxelComputedMaterialParameter MaterialParameters;
 				MaterialParameters.ScalarParameters.Add(Pool->Guid + "_TextureIndex", CellCoordinatesTextureIndex);
 				MaterialParameters.ScalarParameters.Add(Pool->Guid + "_TextureSize", TextureSize);
 				MaterialParameters.DynamicParameters.Add(Pool->Guid, Allocation->GetTexture());
+				MaterialParameters.AllocationParameters.Add(Pool->Guid + "_TextureIndex");
 
 				if (NameOverride.IsSet())
 				{
 					MaterialParameters.ScalarParameters.Add(NameOverride.GetValue() + "_TextureIndex", CellCoordinatesTextureIndex);
 					MaterialParameters.ScalarParameters.Add(NameOverride.GetValue() + "_TextureSize", TextureSize);
 					MaterialParameters.DynamicParameters.Add(NameOverride.GetValue(), Allocation->GetTexture());
+					MaterialParameters.AllocationParameters.Add(NameOverride.GetValue() + "_TextureIndex");
 				}
 
 				MaterialParameters.Resources.Add(Allocation);
+				MaterialParameters.ResourceHashes.Add(ContentHash);
 				return MaterialParameters;
 			};
 		};
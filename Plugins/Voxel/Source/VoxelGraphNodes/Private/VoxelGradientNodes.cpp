@@ -4,6 +4,11 @@
 #include "VoxelPositionQueryParameter.h"
 #include "VoxelGradientNodesImpl.ispc.generated.h"
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELGRAPHNODES_API, bool, GVoxelAnalyticGradients, true,
+	"voxel.graph.AnalyticGradients",
+	"If true, GetGradient will propagate derivatives through the nodes supporting it instead of querying 6 neighbors");
+
 DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_GetGradient, Gradient)
 {
 	FindVoxelQueryParameter(FVoxelPositionQueryParameter, PositionQueryParameter);
@@ -49,6 +54,51 @@ DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_GetGradient, Gradient)
 		};
 	}
 
+	if (!GVoxelAnalyticGradients ||
+		bAnalyticGradientFailed.Load())
+	{
+		return ComputeFiniteDifferences(Query);
+	}
+
+	return VOXEL_ON_COMPLETE(PositionQueryParameter)
+	{
+		const TSharedRef<FVoxelAnalyticGradientQueryParameter> GradientQueryParameter = MakeVoxelShared<FVoxelAnalyticGradientQueryParameter>();
+		GradientQueryParameter->AddPositions(PositionQueryParameter->GetPositions());
+
+		const TSharedRef<FVoxelQueryParameters> Parameters = Query.CloneParameters();
+		Parameters->Add(GradientQueryParameter);
+		const TValue<FVoxelFloatBuffer> Value = Get(ValuePin, Query.MakeNewQuery(Parameters));
+
+		return VOXEL_ON_COMPLETE(GradientQueryParameter, Value)
+		{
+			FVoxelVectorBuffer Gradient;
+			if (GradientQueryParameter->FindGradient(Value, Gradient))
+			{
+				return Gradient;
+			}
+
+			// Value depends on nodes without derivatives, don't try again
+			// Single position queries can also fail on plain constants, so they are not conclusive
+			if (GradientQueryParameter->GetNumPositions() > 1)
+			{
+				bAnalyticGradientFailed.Store(true);
+			}
+			return ComputeFiniteDifferences(Query);
+		};
+	};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+TVoxelFutureValue<FVoxelVectorBuffer> FVoxelNode_GetGradient::ComputeFiniteDifferences(const FVoxelQuery& Query) const
+{
+	VOXEL_SETUP_ON_COMPLETE(GradientPin);
+
+	FindVoxelQueryParameter(FVoxelPositionQueryParameter, PositionQueryParameter);
+	FindVoxelQueryParameter(FVoxelGradientStepQueryParameter, GradientStepQueryParameter);
+
 	return VOXEL_ON_COMPLETE(PositionQueryParameter, GradientStepQueryParameter)
 	{
 		const FVoxelVectorBuffer QueryPositions = PositionQueryParameter->GetPositions();
@@ -148,7 +198,7 @@ DEFINE_VOXEL_NODE_COMPUTE(FVoxelNode_GetGradient, Gradient)
 
 		const TSharedRef<FVoxelQueryParameters> Parameters = Query.CloneParameters();
 		Parameters->Add(NewPositionQueryParameter);
-		const TValue<FVoxelFloatBuffer> Value = Get(ValuePin, Query.MakeNewQuery(Parameters));
+		const TValue<FVoxelFloatBuffer> Value = GetNodeRuntime().Get(ValuePin, Query.MakeNewQuery(Parameters));
 
 		return VOXEL_ON_COMPLETE(GradientStepQueryParameter, InputNum, AlignedInputNum, GradientChunkPadding, GradientNum, NewPositionQueryParameter, Value)
 		{
@@ -1,6 +1,7 @@
 // Copyright Voxel Plugin, Inc. All Rights Reserved.
 
 #include "VoxelNoiseNodes.h"
+#include "VoxelNoiseNodesImpl.ispc.generated.h"
 
 FVoxelComputeValue FVoxelNode_MakeSeeds::CompileCompute(const FName PinName) const
 {
@@ -89,4 +90,41 @@ void FVoxelNode_MakeSeeds::FixupSeedPins()
 			);
 		}
 	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool FVoxelNode_PerlinNoise2D::ComputePartialDerivatives(FPartialDerivatives& Derivatives) const
+{
+	TVoxelStaticArray<FVoxelFloatBufferStorage, 2> Outputs;
+	Derivatives.RunKernel(
+		ispc::VoxelNode_PerlinNoise2D_Derivatives,
+		{ PositionPin, SeedPin },
+		Outputs);
+
+	const FVoxelVector2DBuffer& Position = Derivatives.Get<FVoxelVector2DBuffer>(PositionPin);
+	const FVoxelFloatBuffer& Value = Derivatives.Get<FVoxelFloatBuffer>(ValuePin);
+
+	Derivatives.Add(Value, Position.X, FVoxelFloatBuffer::Make(Outputs[0]));
+	Derivatives.Add(Value, Position.Y, FVoxelFloatBuffer::Make(Outputs[1]));
+	return true;
+}
+
+bool FVoxelNode_PerlinNoise3D::ComputePartialDerivatives(FPartialDerivatives& Derivatives) const
+{
+	TVoxelStaticArray<FVoxelFloatBufferStorage, 3> Outputs;
+	Derivatives.RunKernel(
+		ispc::VoxelNode_PerlinNoise3D_Derivatives,
+		{ PositionPin, SeedPin },
+		Outputs);
+
+	const FVoxelVectorBuffer& Position = Derivatives.Get<FVoxelVectorBuffer>(PositionPin);
+	const FVoxelFloatBuffer& Value = Derivatives.Get<FVoxelFloatBuffer>(ValuePin);
+
+	Derivatives.Add(Value, Position.X, FVoxelFloatBuffer::Make(Outputs[0]));
+	Derivatives.Add(Value, Position.Y, FVoxelFloatBuffer::Make(Outputs[1]));
+	Derivatives.Add(Value, Position.Z, FVoxelFloatBuffer::Make(Outputs[2]));
+	return true;
 }
\ No newline at end of file
@@ -15,10 +15,11 @@ void FVoxelWriteVolumeTextureExecNodeRuntime::Create()
 	VOXEL_FUNCTION_COUNTER();
 	ensure(IsInGameThread());
 
-	const TWeakObjectPtr<UVolumeTexture> WeakTexture = GetConstantPin(Node.TexturePin).Texture;
+	WeakTexture = GetConstantPin(Node.TexturePin).Texture;
 	const FVector Start = GetConstantPin(Node.StartPin);
 	const FIntVector Size = GetConstantPin(Node.SizePin);
 	const float VoxelSize = GetConstantPin(Node.VoxelSizePin);
+	bHalfPrecision = GetConstantPin(Node.HalfPrecisionPin);
 
 	if (int64(Size.X) *
 		int64(Size.Y) *
@@ -35,18 +36,19 @@ void FVoxelWriteVolumeTextureExecNodeRuntime::Create()
 		return;
 	}
 
-	const TSharedRef<FVoxelQueryParameters> Parameters = MakeVoxelShared<FVoxelQueryParameters>();
-	Parameters->Add<FVoxelGradientStepQueryParameter>().Step = VoxelSize;
-	Parameters->Add<FVoxelPositionQueryParameter>().InitializeGrid(FVector3f(Start), VoxelSize, Size);
+	const EPixelFormat PixelFormat = bHalfPrecision ? PF_R16F : PF_R32_FLOAT;
+	BytesPerPixel = bHalfPrecision ? sizeof(FFloat16) : sizeof(float);
 
-	DistanceValue = GetNodeRuntime().MakeDynamicValueFactory(Node.DistancePin).Compute(GetContext(), Parameters);
-	DistanceValue.OnChanged_GameThread([=](const FVoxelFloatBuffer& Distance)
+	UVolumeTexture* Texture = WeakTexture.Get();
+	if (!Texture)
 	{
-		UVolumeTexture* Texture = WeakTexture.Get();
-		if (!Texture)
-		{
-			return;
-		}
+		return;
+	}
+
+	// Allocate the texture once, bricks are then written into it with region updates
+	// The CPU copy is only needed for the initial upload: if the resource is recreated, Tick uploads all the bricks again
+	{
+		VOXEL_SCOPE_COUNTER("Allocate texture");
 
 #if WITH_EDITOR
 		const FTextureSource Source;
@@ -57,7 +59,7 @@ void FVoxelWriteVolumeTextureExecNodeRuntime::Create()
 		PlatformData->SizeX = Size.X;
 		PlatformData->SizeY = Size.Y;
 		PlatformData->SetNumSlices(Size.Z);
-		PlatformData->PixelFormat = PF_R32_FLOAT;
+		PlatformData->PixelFormat = PixelFormat;
 
 		FTexture2DMipMap* Mip = new FTexture2DMipMap();
 		Mip->SizeX = Size.X;
@@ -65,9 +67,9 @@ void FVoxelWriteVolumeTextureExecNodeRuntime::Create()
 		Mip->SizeZ = Size.Z;
 		Mip->BulkData.Lock(LOCK_READ_WRITE);
 		{
-			void* Data = Mip->BulkData.Realloc(sizeof(float) * Size.X * Size.Y * Size.Z);
-			const TVoxelArrayView<float> OutData(static_cast<float*>(Data), Size.X * Size.Y * Size.Z);
-			Distance.GetStorage().CopyTo(OutData);
+			const int64 NumBytes = int64(BytesPerPixel) * Size.X * Size.Y * Size.Z;
+			void* Data = Mip->BulkData.Realloc(NumBytes);
+			FMemory::Memzero(Data, NumBytes);
 		}
 		Mip->BulkData.Unlock();
 		PlatformData->Mips.Add(Mip);
@@ -81,10 +83,221 @@ void FVoxelWriteVolumeTextureExecNodeRuntime::Create()
 		check(!Texture->GetPlatformData());
 		Texture->SetPlatformData(PlatformData);
 		Texture->UpdateResource();
+
+		UploadedResource = Texture->GetResource();
+
+		// Make sure the resource is initialized before clearing bulk data
+		VOXEL_ENQUEUE_RENDER_COMMAND(RemoveBulkData)([WeakTexture = WeakTexture](FRHICommandListImmediate& RHICmdList)
+		{
+			FVoxelUtilities::RunOnGameThread([=]
+			{
+				UVolumeTexture* LocalTexture = WeakTexture.Get();
+				if (!LocalTexture)
+				{
+					return;
+				}
+
+				FTexturePlatformData* LocalPlatformData = LocalTexture->GetPlatformData();
+				if (!ensure(LocalPlatformData) ||
+					!ensure(LocalPlatformData->Mips.Num() == 1))
+				{
+					return;
+				}
+
+				LocalPlatformData->Mips[0].BulkData.RemoveBulkData();
+			});
+		});
+	}
+
+	int32 BrickSize = FMath::Clamp(GetConstantPin(Node.BrickSizePin), 4, 1024);
+	// Each brick is a dynamic value, keep their count reasonable for huge volumes
+	while (int64(FVoxelUtilities::DivideCeil_Positive(Size.X, BrickSize)) *
+		int64(FVoxelUtilities::DivideCeil_Positive(Size.Y, BrickSize)) *
+		int64(FVoxelUtilities::DivideCeil_Positive(Size.Z, BrickSize)) > 32768)
+	{
+		BrickSize *= 2;
+	}
+
+	const FIntVector NumBricks(
+		FVoxelUtilities::DivideCeil_Positive(Size.X, BrickSize),
+		FVoxelUtilities::DivideCeil_Positive(Size.Y, BrickSize),
+		FVoxelUtilities::DivideCeil_Positive(Size.Z, BrickSize));
+
+	BrickValues.Reserve(NumBricks.X * NumBricks.Y * NumBricks.Z);
+	Bricks.Reserve(NumBricks.X * NumBricks.Y * NumBricks.Z);
+
+	FVoxelIntBox(0, NumBricks).Iterate([&](const FIntVector& BrickPosition)
+	{
+		const FIntVector Offset = BrickPosition * BrickSize;
+		const FIntVector BrickQuerySize = FVoxelUtilities::ComponentMin(FIntVector(BrickSize), Size - Offset);
+
+		const int32 BrickIndex = Bricks.Add(FBrick
+		{
+			Offset,
+			BrickQuerySize
+		});
+
+		const TSharedRef<FVoxelQueryParameters> Parameters = MakeVoxelShared<FVoxelQueryParameters>();
+		Parameters->Add<FVoxelGradientStepQueryParameter>().Step = VoxelSize;
+		Parameters->Add<FVoxelPositionQueryParameter>().InitializeGrid(
+			FVector3f(Start) + FVector3f(Offset) * VoxelSize,
+			VoxelSize,
+			BrickQuerySize);
+
+		// Each brick has its own dependency tracker: edits only invalidate the bricks they overlap
+		TVoxelDynamicValue<FVoxelFloatBuffer>& BrickValue = BrickValues.Emplace_GetRef();
+		BrickValue = GetNodeRuntime().MakeDynamicValueFactory(Node.DistancePin).Compute(GetContext(), Parameters);
+		BrickValue.OnChanged([QueuedBricks = QueuedBricks, BrickIndex, BrickQuerySize, bHalfPrecision = bHalfPrecision](const TSharedRef<const FVoxelFloatBuffer>& Distance)
+		{
+			const int32 Num = BrickQuerySize.X * BrickQuerySize.Y * BrickQuerySize.Z;
+			if (!ensure(Distance->IsConstant() || Distance->Num() == Num))
+			{
+				return;
+			}
+
+			FQueuedBrick QueuedBrick;
+			QueuedBrick.BrickIndex = BrickIndex;
+			QueuedBrick.Distance = Distance;
+			ConvertBrick(*Distance, Num, bHalfPrecision, QueuedBrick.Data);
+
+			QueuedBricks->Enqueue(MoveTemp(QueuedBrick));
+		});
 	});
 }
 
 void FVoxelWriteVolumeTextureExecNodeRuntime::Destroy()
 {
-	DistanceValue = {};
-}
\ No newline at end of file
+	BrickValues.Empty();
+	Bricks.Empty();
+	UploadedResource = nullptr;
+}
+
+void FVoxelWriteVolumeTextureExecNodeRuntime::Tick(FVoxelRuntime& Runtime)
+{
+	UVolumeTexture* Texture = WeakTexture.Get();
+	FTextureResource* Resource = Texture ? Texture->GetResource() : nullptr;
+
+	if (QueuedBricks->IsEmpty() &&
+		Resource == UploadedResource)
+	{
+		return;
+	}
+
+	VOXEL_FUNCTION_COUNTER();
+
+	struct FUpload
+	{
+		FIntVector Offset;
+		FIntVector Size;
+		TVoxelArray<uint8> Data;
+	};
+	TVoxelArray<FUpload> Uploads;
+	{
+		FQueuedBrick QueuedBrick;
+		while (QueuedBricks->Dequeue(QueuedBrick))
+		{
+			FBrick& Brick = Bricks[QueuedBrick.BrickIndex];
+			Brick.Distance = QueuedBrick.Distance;
+
+			Uploads.Add(FUpload
+			{
+				Brick.Offset,
+				Brick.Size,
+				MoveTemp(QueuedBrick.Data)
+			});
+		}
+	}
+
+	if (!Texture ||
+		!ensure(Resource))
+	{
+		return;
+	}
+
+	if (Resource != UploadedResource)
+	{
+		VOXEL_SCOPE_COUNTER("Upload all bricks");
+
+		// The resource was recreated (eg, UpdateResource) from the platform data, which doesn't have the bricks
+		UploadedResource = Resource;
+		Uploads.Reset();
+
+		for (const FBrick& Brick : Bricks)
+		{
+			if (!Brick.Distance)
+			{
+				continue;
+			}
+
+			FUpload& Upload = Uploads.Add_GetRef(FUpload
+			{
+				Brick.Offset,
+				Brick.Size
+			});
+			ConvertBrick(*Brick.Distance, Brick.Size.X * Brick.Size.Y * Brick.Size.Z, bHalfPrecision, Upload.Data);
+		}
+
+		if (Uploads.Num() == 0)
+		{
+			return;
+		}
+	}
+
+	// Batch all the bricks received this frame in a single render command
+	VOXEL_ENQUEUE_RENDER_COMMAND(WriteVolumeTexture_UpdateBricks)([Resource, Uploads = MoveTemp(Uploads), BytesPerPixel = BytesPerPixel](FRHICommandListImmediate& RHICmdList)
+	{
+		FRHITexture* TextureRHI = Resource->GetTextureRHI();
+		if (!ensure(TextureRHI))
+		{
+			return;
+		}
+
+		const FIntVector TextureSize = TextureRHI->GetSizeXYZ();
+		for (const FUpload& Brick : Uploads)
+		{
+			if (!ensure(Brick.Offset.X + Brick.Size.X <= TextureSize.X) ||
+				!ensure(Brick.Offset.Y + Brick.Size.Y <= TextureSize.Y) ||
+				!ensure(Brick.Offset.Z + Brick.Size.Z <= TextureSize.Z))
+			{
+				continue;
+			}
+
+			const FUpdateTextureRegion3D UpdateRegion(
+				Brick.Offset,
+				FIntVector::ZeroValue,
+				Brick.Size);
+
+			RHICmdList.UpdateTexture3D(
+				TextureRHI,
+				0,
+				UpdateRegion,
+				Brick.Size.X * BytesPerPixel,
+				Brick.Size.X * Brick.Size.Y * BytesPerPixel,
+				Brick.Data.GetData());
+		}
+	});
+}
+
+void FVoxelWriteVolumeTextureExecNodeRuntime::ConvertBrick(
+	const FVoxelFloatBuffer& Distance,
+	const int32 Num,
+	const bool bHalfPrecision,
+	TVoxelArray<uint8>& OutData)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Num, 1024);
+
+	if (bHalfPrecision)
+	{
+		FVoxelUtilities::SetNumFast(OutData, Num * sizeof(FFloat16));
+		FFloat16* Data = reinterpret_cast<FFloat16*>(OutData.GetData());
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			Data[Index] = FFloat16(Distance[Index]);
+		}
+	}
+	else
+	{
+		FVoxelUtilities::SetNumFast(OutData, Num * sizeof(float));
+		Distance.GetStorage().CopyTo(TVoxelArrayView<float>(reinterpret_cast<float*>(OutData.GetData()), Num));
+	}
+}
@@ -29,6 +29,10 @@ struct VOXELGRAPHNODES_API FVoxelMarchingCubeCollisionExecNode : public FVoxelEx
 
 	VOXEL_INPUT_PIN(FVoxelPhysicalMaterialBuffer, PhysicalMaterial, nullptr, VirtualPin, AdvancedDisplay);
 	VOXEL_INPUT_PIN(float, DistanceChecksTolerance, 1.f, VirtualPin, AdvancedDisplay);
+	// Max distance in cm the collision & navmesh are allowed to deviate from the surface
+	// Reduces cook time & memory, chunk borders and physical material borders are preserved
+	// Set to 0 to disable simplification
+	VOXEL_INPUT_PIN(float, SimplificationError, 0.f, VirtualPin, AdvancedDisplay);
 	VOXEL_INPUT_PIN(int32, ChunkSize, 32, ConstantPin, AdvancedDisplay);
 	// Priority offset, added to the task distance from camera
 	// Closest tasks are computed first, so set this to a very low value (eg, -1000000) if you want it to be computed first
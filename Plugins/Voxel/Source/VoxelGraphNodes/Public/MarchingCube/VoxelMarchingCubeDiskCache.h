@@ -0,0 +1,80 @@
+// Copyright Voxel Plugin, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "VoxelMinimal.h"
+
+class FVoxelExecNodeRuntime;
+class FVoxelWorldChannelManager;
+struct FVoxelMarchingCubeSurface;
+
+extern VOXELGRAPHNODES_API bool GVoxelMarchingCubeDiskCache;
+
+// Persistent cache of marching cube surfaces, used to skip graph evaluation & meshing of static terrain on startup
+// Entries are keyed by a hash of the graph, its parameters, the actor transform & the sculpt data, by the brushes
+// intersecting the chunk and by the chunk bounds & LOD. Chunks touched by a brush without a persistent hash are never cached
+// A few distances are also probed across the chunk when loading as a sanity check: this registers the chunk dependencies,
+// so later edits still invalidate it
+// The cache is capped to voxel.marchingcube.DiskCacheMaxSizeMB, least recently loaded or saved entries are deleted first
+class VOXELGRAPHNODES_API FVoxelMarchingCubeDiskCache
+{
+public:
+	// Probes are queried on a ProbeGridSize^3 grid spanning the chunk
+	static constexpr int32 ProbeGridSize = 3;
+	static constexpr int32 NumProbes = ProbeGridSize * ProbeGridSize * ProbeGridSize;
+
+	const uint64 RuntimeHash;
+	const FMatrix LocalToWorld;
+	const TWeakPtr<FVoxelWorldChannelManager> WeakChannelManager;
+
+	// Returns null if the cache is disabled. Game thread only
+	static TSharedPtr<FVoxelMarchingCubeDiskCache> Create(const FVoxelExecNodeRuntime& NodeRuntime);
+
+	static FString GetDirectory();
+	static void ClearAll();
+	// Delete the least recently used entries until the cache fits in its max size. Does blocking IO
+	static void Trim();
+
+	FVoxelMarchingCubeDiskCache(
+		const uint64 RuntimeHash,
+		const FMatrix& LocalToWorld,
+		const TWeakPtr<FVoxelWorldChannelManager>& WeakChannelManager)
+		: RuntimeHash(RuntimeHash)
+		, LocalToWorld(LocalToWorld)
+		, WeakChannelManager(WeakChannelManager)
+	{
+	}
+
+public:
+	// Returns false if the chunk can't be cached
+	bool GetChunkKey(
+		const FVoxelBox& Bounds,
+		int32 LOD,
+		int32 ChunkSize,
+		float VoxelSize,
+		uint64& OutKey) const;
+
+	// Returns null if there's no entry or if its probes don't match anymore
+	// Can be called from any thread, does blocking IO
+	TSharedPtr<const FVoxelMarchingCubeSurface> Load(
+		uint64 Key,
+		TConstVoxelArrayView<float> Probes,
+		float Tolerance) const;
+
+	// Can be called from any thread, does blocking IO
+	void Save(
+		uint64 Key,
+		TConstVoxelArrayView<float> Probes,
+		const FVoxelMarchingCubeSurface& Surface) const;
+
+	// Called when a chunk is recomputed because one of its dependencies changed
+	// Its entry is deleted and won't be saved again until the next session, as the edit might not be persistent
+	void Invalidate(uint64 Key);
+
+private:
+	mutable FVoxelFastCriticalSection CriticalSection;
+	TVoxelSet<uint64> InvalidatedKeys_RequiresLock;
+
+	FString GetPath(uint64 Key) const;
+	bool IsInvalidated(uint64 Key) const;
+};
\ No newline at end of file
@@ -12,20 +12,27 @@
 #include "Rendering/VoxelMeshSettings.h"
 #include "Collision/VoxelCollider.h"
 #include "Collision/VoxelCollisionComponent.h"
+#include "MarchingCube/VoxelMarchingCubeNodes.h"
 #include "VoxelMarchingCubeExecNode.generated.h"
 
 struct FVoxelMesh;
 class UVoxelMeshComponent;
+class FVoxelMarchingCubeDiskCache;
 
 USTRUCT()
-struct VOXELGRAPHNODES_API FVoxelMarchingCubeExecNodeMesh
+struct VOXELGRAPHNODES_API FVoxelMarchingCubeExecNodeMesh : public FVoxelVirtualStruct
 {
 	GENERATED_BODY()
+	GENERATED_VIRTUAL_STRUCT_BODY()
 
 	TSharedPtr<const FVoxelMesh> Mesh;
 	TSharedPtr<const FVoxelMeshSettings> MeshSettings;
 	TSharedPtr<const FVoxelCollider> Collider;
 	TSharedPtr<const FBodyInstance> BodyInstance;
+
+	//~ Begin FVoxelVirtualStruct Interface
+	virtual uint64 GetContentHash() const override;
+	//~ End FVoxelVirtualStruct Interface
 };
 
 // This node is entirely disabled on dedicated servers
@@ -50,6 +57,10 @@ struct VOXELGRAPHNODES_API FVoxelMarchingCubeExecNode : public FVoxelExecNode
 	// https://docs.voxelplugin.com/basics/navmesh-and-collision
 	VOXEL_INPUT_PIN(FBodyInstance, BodyInstance, nullptr, VirtualPin);
 	VOXEL_INPUT_PIN(FVoxelPhysicalMaterialBuffer, PhysicalMaterial, nullptr, VirtualPin);
+	// Max distance in cm the collision is allowed to deviate from the rendered surface
+	// Collision will be simplified to reduce cook time & memory, chunk borders and physical material borders are preserved
+	// Set to 0 to disable simplification
+	VOXEL_INPUT_PIN(float, CollisionSimplificationError, 0.f, VirtualPin, AdvancedDisplay);
 
 	// Mesh settings, used to tune mesh component settings like CastShadow, ReceiveDecals...
 	VOXEL_INPUT_PIN(FVoxelMeshSettings, MeshSettings, nullptr, VirtualPin, AdvancedDisplay);
@@ -65,16 +76,45 @@ struct VOXELGRAPHNODES_API FVoxelMarchingCubeExecNode : public FVoxelExecNode
 	VOXEL_INPUT_PIN(bool, PerfectTransitions, false, VirtualPin, AdvancedDisplay);
 	VOXEL_INPUT_PIN(bool, GenerateDistanceFields, false, VirtualPin, AdvancedDisplay);
 	VOXEL_INPUT_PIN(float, DistanceFieldBias, 0.f, VirtualPin, AdvancedDisplay);
+	// Distance fields are only generated for chunks with a LOD lower or equal to this
+	VOXEL_INPUT_PIN(int32, MaxDistanceFieldLOD, 32, VirtualPin, AdvancedDisplay);
 	// Priority offset, added to the task distance from camera
 	// Closest tasks are computed first, so set this to a very low value (eg, -1000000) if you want it to be computed first
 	VOXEL_INPUT_PIN(double, PriorityOffset, 0, ConstantPin, AdvancedDisplay);
 
+	// bIsInvalidation: true if the mesh is recomputed because one of its dependencies changed
 	TValue<FVoxelMarchingCubeExecNodeMesh> CreateMesh(
+		const FVoxelQuery& InQuery,
+		float VoxelSize,
+		int32 ChunkSize,
+		const FVoxelBox& Bounds,
+		const TSharedPtr<FVoxelMarchingCubeDiskCache>& DiskCache = nullptr,
+		bool bIsInvalidation = false,
+		bool bDeferDistanceField = false) const;
+	// Used when distance fields are deferred: computed separately from the mesh, with a lower priority
+	TValue<FVoxelMarchingCubeDistanceField> CreateDistanceField(
 		const FVoxelQuery& InQuery,
 		float VoxelSize,
 		int32 ChunkSize,
 		const FVoxelBox& Bounds) const;
 	virtual TVoxelUniquePtr<FVoxelExecNodeRuntime> CreateExecRuntime(const TSharedRef<const FVoxelExecNode>& SharedThis) const override;
+
+private:
+	TValue<FVoxelMarchingCubeSurface> GenerateSurface(
+		const FVoxelQuery& Query,
+		const TValue<FVoxelSurface>& FutureSurface,
+		float VoxelSize,
+		int32 ChunkSize,
+		const FVoxelBox& Bounds) const;
+
+	TValue<FVoxelMarchingCubeSurface> GenerateSurface_DiskCache(
+		const FVoxelQuery& Query,
+		const TValue<FVoxelSurface>& FutureSurface,
+		float VoxelSize,
+		int32 ChunkSize,
+		const FVoxelBox& Bounds,
+		const TSharedRef<FVoxelMarchingCubeDiskCache>& DiskCache,
+		bool bIsInvalidation) const;
 };
 
 class VOXELGRAPHNODES_API FVoxelMarchingCubeExecNodeRuntime : public TVoxelExecNodeRuntime<FVoxelMarchingCubeExecNode>
@@ -92,7 +132,9 @@ private:
 	const TSharedRef<FVoxelChunkActionQueue> ChunkActionQueue = MakeVoxelShared<FVoxelChunkActionQueue>();
 
 	TSharedPtr<FVoxelChunkSpawner> ChunkSpawner;
+	TSharedPtr<FVoxelMarchingCubeDiskCache> DiskCache;
 	float VoxelSize = 0.f;
+	bool bDeferDistanceFields = false;
 
 	struct FChunkInfo
 	{
@@ -113,12 +155,17 @@ private:
 		~FChunkInfo()
 		{
 			ensure(!Mesh.IsValid());
+			ensure(!DistanceField.IsValid());
 			ensure(!MeshComponent.IsValid());
 			ensure(!CollisionComponent.IsValid());
 			ensure(OnCompleteArray.Num() == 0);
 		}
 
 		TVoxelDynamicValue<FVoxelMarchingCubeExecNodeMesh> Mesh;
+		// Only used if distance fields are deferred
+		TVoxelDynamicValue<FVoxelMarchingCubeDistanceField> DistanceField;
+		// Last distance field received, applied to new meshes
+		TSharedPtr<const FVoxelMarchingCubeDistanceField> LastDistanceField;
 		uint8 TransitionMask = 0;
 		TWeakObjectPtr<UVoxelMeshComponent> MeshComponent;
 		TWeakObjectPtr<UVoxelCollisionComponent> CollisionComponent;
@@ -138,9 +185,19 @@ private:
 	using FQueuedMeshes = TQueue<FQueuedMesh, EQueueMode::Mpsc>;
 	const TSharedRef<FQueuedMeshes> QueuedMeshes = MakeVoxelShared<FQueuedMeshes>();
 
+	struct FQueuedDistanceField
+	{
+		FVoxelChunkId ChunkId;
+		TSharedPtr<const FVoxelMarchingCubeDistanceField> DistanceField;
+	};
+	using FQueuedDistanceFields = TQueue<FQueuedDistanceField, EQueueMode::Mpsc>;
+	const TSharedRef<FQueuedDistanceFields> QueuedDistanceFields = MakeVoxelShared<FQueuedDistanceFields>();
+
 	FGraphEventRef ProcessActionsGraphEvent;
 
 	void ProcessMeshes(FVoxelRuntime& Runtime);
+	void ProcessDistanceFields();
+	void ComputeDistanceField(FChunkInfo& ChunkInfo);
 	void ProcessActions(FVoxelRuntime* Runtime, bool bIsInGameThread);
 	void ProcessAction(FVoxelRuntime* Runtime, const FVoxelChunkAction& Action);
 };
\ No newline at end of file
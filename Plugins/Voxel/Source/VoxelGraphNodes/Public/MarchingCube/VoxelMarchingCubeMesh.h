@@ -152,9 +152,17 @@ struct VOXELGRAPHNODES_API FVoxelMarchingCubeMesh : public FVoxelMesh
 	TSharedPtr<FCardRepresentationData> CardRepresentationData;
 	TSharedPtr<FDistanceFieldVolumeData> DistanceFieldVolumeData;
 
+	// Also builds the lumen cards from Bounds
+	// Game thread only. If the mesh is already rendered, call MarkRenderStateDirty_GameThread afterwards:
+	// existing proxies keep the previous distance field alive until they are destroyed
+	void SetDistanceField(const TSharedPtr<FDistanceFieldVolumeData>& NewDistanceFieldVolumeData);
 	void SetTransitionMask_GameThread(uint8 NewTransitionMask);
 	void SetTransitionMask_RenderThread(FRHICommandList& RHICmdList, uint8 NewTransitionMask);
 
+	//~ Begin FVoxelVirtualStruct Interface
+	virtual uint64 GetContentHash() const override;
+	//~ End FVoxelVirtualStruct Interface
+
 	virtual FVoxelBox GetBounds() const override { return Bounds; }
 	virtual int64 GetAllocatedSize() const override;
 	virtual int64 GetGpuAllocatedSize() const override;
@@ -167,13 +175,13 @@ struct VOXELGRAPHNODES_API FVoxelMarchingCubeMesh : public FVoxelMesh
 
 	virtual bool Draw_RenderThread(const FPrimitiveSceneProxy& Proxy, FMeshBatch& MeshBatch) const override;
 
-	virtual const FCardRepresentationData* GetCardRepresentationData() const override
+	virtual TSharedPtr<const FCardRepresentationData> GetCardRepresentationData() const override
 	{
-		return CardRepresentationData.Get();
+		return CardRepresentationData;
 	}
-	virtual const FDistanceFieldVolumeData* GetDistanceFieldVolumeData() const override
+	virtual TSharedPtr<const FDistanceFieldVolumeData> GetDistanceFieldVolumeData() const override
 	{
-		return DistanceFieldVolumeData.Get();
+		return DistanceFieldVolumeData;
 	}
 
 private:
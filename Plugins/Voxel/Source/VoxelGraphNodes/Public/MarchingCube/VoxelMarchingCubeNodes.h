@@ -55,6 +55,16 @@ struct VOXELGRAPHNODES_API FVoxelMarchingCubeSurface
 	TVoxelStaticArray<TVoxelArray<int32>, 6> TransitionCellIndices;
 };
 
+USTRUCT()
+struct VOXELGRAPHNODES_API FVoxelMarchingCubeDistanceField : public FVoxelVirtualStruct
+{
+	GENERATED_BODY()
+	GENERATED_VIRTUAL_STRUCT_BODY()
+
+	// Null if the chunk has no distance field
+	TSharedPtr<FDistanceFieldVolumeData> DistanceFieldVolumeData;
+};
+
 USTRUCT(meta = (Internal))
 struct VOXELGRAPHNODES_API FVoxelNode_GenerateMarchingCubeSurface : public FVoxelNode
 {
@@ -80,6 +90,8 @@ struct VOXELGRAPHNODES_API FVoxelNode_CreateMarchingCubeCollider : public FVoxel
 
 	VOXEL_INPUT_PIN(FVoxelMarchingCubeSurface, Surface, nullptr);
 	VOXEL_INPUT_PIN(FVoxelPhysicalMaterialBuffer, PhysicalMaterial, nullptr);
+	// Max distance in cm the simplified collision is allowed to deviate from the surface, 0 to disable
+	VOXEL_INPUT_PIN(float, SimplificationError, nullptr);
 	VOXEL_OUTPUT_PIN(FVoxelCollider, Collider);
 };
 
@@ -95,4 +107,19 @@ struct VOXELGRAPHNODES_API FVoxelNode_CreateMarchingCubeMesh : public FVoxelNode
 	VOXEL_INPUT_PIN(bool, GenerateDistanceField, nullptr);
 	VOXEL_INPUT_PIN(float, DistanceFieldBias, nullptr);
 	VOXEL_OUTPUT_PIN(FVoxelMesh, Mesh);
+};
+
+USTRUCT(meta = (Internal))
+struct VOXELGRAPHNODES_API FVoxelNode_CreateMarchingCubeDistanceField : public FVoxelNode
+{
+	GENERATED_BODY()
+	GENERATED_VOXEL_NODE_BODY()
+
+	VOXEL_INPUT_PIN(FVoxelFloatBuffer, Distance, nullptr);
+	// Voxel size of the chunk, including its LOD
+	VOXEL_INPUT_PIN(float, VoxelSize, nullptr);
+	VOXEL_INPUT_PIN(int32, ChunkSize, nullptr);
+	VOXEL_INPUT_PIN(FVoxelBox, ChunkBounds, nullptr);
+	VOXEL_INPUT_PIN(float, DistanceFieldBias, nullptr);
+	VOXEL_OUTPUT_PIN(FVoxelMarchingCubeDistanceField, DistanceField);
 };
\ No newline at end of file
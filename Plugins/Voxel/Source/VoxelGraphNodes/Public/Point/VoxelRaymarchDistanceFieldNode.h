@@ -23,6 +23,7 @@ public:
 	const int32 MaxSteps;
 	const float Speed;
 	const float GradientStep;
+	const float LipschitzBound;
 	const TSharedRef<const FVoxelPointSet> Points;
 	const FVoxelVectorBuffer Normals;
 
@@ -37,6 +38,7 @@ public:
 		const int32 MaxSteps,
 		const float Speed,
 		const float GradientStep,
+		const float LipschitzBound,
 		const TSharedRef<const FVoxelPointSet>& Points,
 		const FVoxelVectorBuffer& Positions,
 		const FVoxelVectorBuffer& Normals)
@@ -50,6 +52,7 @@ public:
 		, MaxSteps(FMath::Min(MaxSteps, 32))
 		, Speed(Speed)
 		, GradientStep(GradientStep)
+		, LipschitzBound(LipschitzBound)
 		, Points(Points)
 		, Normals(Normals)
 		, PositionX(Positions.X.GetStorage().Clone())
@@ -73,8 +76,16 @@ private:
 	TOptional<FVoxelVectorBuffer> NewPointNormals;
 	TVoxelArray<int32> PointsToRemove;
 
+	// Sphere tracing only, same layout as IndicesToProcess
+	TVoxelArray<float> LastSteps;
+	TVoxelArray<float> LastStepDistances;
+	TVoxelArray<float> Relaxations;
+
+	FVoxelVectorBuffer GetPositionsToProcess() const;
+	void QueryDistances();
 	void ProcessDistances(const FVoxelFloatBuffer& NewDistances);
 	void ProcessGradient(const FVoxelVectorBuffer& Gradients);
+	void SphereTrace();
 	void Finalize();
 };
 
@@ -105,5 +116,9 @@ struct VOXELGRAPHNODES_API FVoxelNode_RaymarchDistanceField : public FVoxelNode
 	VOXEL_INPUT_PIN(float, Speed, 0.8f, AdvancedDisplay);
 	// Distance between points when sampling gradients
 	VOXEL_INPUT_PIN(float, GradientStep, 100.f, AdvancedDisplay);
+	// If above 0, points will be sphere traced along their normal instead of querying the gradient at every step
+	// This is the max rate of change of the distance field, 1 for exact distances
+	// Normals need to point away from the surface, Speed is ignored
+	VOXEL_INPUT_PIN(float, LipschitzBound, 0.f, AdvancedDisplay);
 	VOXEL_OUTPUT_PIN(FVoxelPointSet, Out);
 };
\ No newline at end of file
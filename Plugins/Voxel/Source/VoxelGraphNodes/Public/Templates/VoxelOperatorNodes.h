@@ -99,6 +99,7 @@ struct FVoxelNode_Add_Float : public FVoxelISPCNode
 	{
 		return "{ReturnValue} = {A} + {B}";
 	}
+	virtual bool ComputePartialDerivatives(FPartialDerivatives& Derivatives) const override;
 };
 
 USTRUCT(meta = (Internal))
@@ -172,6 +173,7 @@ struct FVoxelNode_Subtract_Float : public FVoxelISPCNode
 	{
 		return "{ReturnValue} = {A} - {B}";
 	}
+	virtual bool ComputePartialDerivatives(FPartialDerivatives& Derivatives) const override;
 };
 
 USTRUCT(meta = (Internal))
@@ -245,6 +247,7 @@ struct FVoxelNode_Multiply_Float : public FVoxelISPCNode
 	{
 		return "{ReturnValue} = {A} * {B}";
 	}
+	virtual bool ComputePartialDerivatives(FPartialDerivatives& Derivatives) const override;
 };
 
 USTRUCT(meta = (Internal))
@@ -330,6 +333,7 @@ struct FVoxelNode_Divide_Float : public FVoxelISPCNode
 			// 0 / 0 = 1
 			": 1.f";
 	}
+	virtual bool ComputePartialDerivatives(FPartialDerivatives& Derivatives) const override;
 };
 
 USTRUCT(meta = (Internal))
@@ -443,6 +447,7 @@ struct FVoxelNode_Min_Float : public FVoxelISPCNode
 	{
 		return "{ReturnValue} = min({A}, {B})";
 	}
+	virtual bool ComputePartialDerivatives(FPartialDerivatives& Derivatives) const override;
 };
 
 USTRUCT(meta = (Internal))
@@ -515,6 +520,7 @@ struct FVoxelNode_Max_Float : public FVoxelISPCNode
 	{
 		return "{ReturnValue} = max({A}, {B})";
 	}
+	virtual bool ComputePartialDerivatives(FPartialDerivatives& Derivatives) const override;
 };
 
 USTRUCT(meta = (Internal))
@@ -586,6 +592,7 @@ struct FVoxelNode_Abs_Float : public FVoxelISPCNode
 	{
 		return "{ReturnValue} = abs({Value})";
 	}
+	virtual bool ComputePartialDerivatives(FPartialDerivatives& Derivatives) const override;
 };
 
 USTRUCT(meta = (Internal))
@@ -656,6 +663,7 @@ struct FVoxelNode_OneMinus_Float : public FVoxelISPCNode
 	{
 		return "{ReturnValue} = 1 - {Value}";
 	}
+	virtual bool ComputePartialDerivatives(FPartialDerivatives& Derivatives) const override;
 };
 
 USTRUCT(meta = (Internal))
@@ -52,4 +52,11 @@ public:
 
 	// Result of all octaves being added together
 	VOXEL_OUTPUT_PIN(FVoxelFloatBuffer, Value);
+
+	//~ Begin FVoxelNode Interface
+	virtual bool IsPositionIndependent() const override
+	{
+		return true;
+	}
+	//~ End FVoxelNode Interface
 };
\ No newline at end of file
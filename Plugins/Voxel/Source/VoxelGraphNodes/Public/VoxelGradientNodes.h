@@ -15,4 +15,10 @@ struct VOXELGRAPHNODES_API FVoxelNode_GetGradient : public FVoxelNode
 
 	VOXEL_INPUT_PIN(FVoxelFloatBuffer, Value, nullptr);
 	VOXEL_OUTPUT_PIN(FVoxelVectorBuffer, Gradient);
+
+public:
+	TVoxelFutureValue<FVoxelVectorBuffer> ComputeFiniteDifferences(const FVoxelQuery& Query) const;
+
+	// Set once Value is found to depend on nodes without derivatives
+	mutable TVoxelAtomic<bool> bAnalyticGradientFailed = false;
 };
\ No newline at end of file
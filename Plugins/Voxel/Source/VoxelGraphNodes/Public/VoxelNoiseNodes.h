@@ -37,6 +37,10 @@ struct VOXELGRAPHNODES_API FVoxelNode_MakeSeeds : public FVoxelNode
 	}
 
 	virtual FVoxelComputeValue CompileCompute(FName PinName) const override;
+	virtual bool IsPositionIndependent() const override
+	{
+		return true;
+	}
 
 	virtual void PostSerialize() override
 	{
@@ -99,6 +103,7 @@ struct VOXELGRAPHNODES_API FVoxelNode_PerlinNoise2D : public FVoxelISPCNode
 		Code.AddInclude("VoxelNoiseNodesImpl.isph");
 		return "{Value} = GetPerlin2D({Seed}, {Position})";
 	}
+	virtual bool ComputePartialDerivatives(FPartialDerivatives& Derivatives) const override;
 };
 
 USTRUCT(Category = "Noise")
@@ -116,6 +121,7 @@ struct VOXELGRAPHNODES_API FVoxelNode_PerlinNoise3D : public FVoxelISPCNode
 		Code.AddInclude("VoxelNoiseNodesImpl.isph");
 		return "{Value} = GetPerlin3D({Seed}, {Position})";
 	}
+	virtual bool ComputePartialDerivatives(FPartialDerivatives& Derivatives) const override;
 };
 
 // Two dimensional cellular noise
@@ -48,6 +48,11 @@ struct VOXELGRAPHNODES_API FVoxelWriteVolumeTextureExecNode : public FVoxelExecN
 	VOXEL_INPUT_PIN(FIntVector, Size, FIntVector(128), ConstantPin);
 	VOXEL_INPUT_PIN(float, VoxelSize, 100.f, ConstantPin);
 	VOXEL_INPUT_PIN(FVoxelFloatBuffer, Distance, nullptr, VirtualPin);
+	// The volume is split into bricks of this size, each queried separately
+	// A brick is only recomputed & uploaded when one of its dependencies changes
+	VOXEL_INPUT_PIN(int32, BrickSize, 32, ConstantPin, AdvancedDisplay);
+	// If true, the texture will be R16F instead of R32F: half the memory & upload bandwidth, at the cost of precision
+	VOXEL_INPUT_PIN(bool, HalfPrecision, false, ConstantPin, AdvancedDisplay);
 
 	virtual TVoxelUniquePtr<FVoxelExecNodeRuntime> CreateExecRuntime(const TSharedRef<const FVoxelExecNode>& SharedThis) const override;
 };
@@ -60,8 +65,38 @@ public:
 	//~ Begin FVoxelExecNodeRuntime Interface
 	virtual void Create() override;
 	virtual void Destroy() override;
+	virtual void Tick(FVoxelRuntime& Runtime) override;
 	//~ End FVoxelExecNodeRuntime Interface
 
 private:
-	TVoxelDynamicValue<FVoxelFloatBuffer> DistanceValue;
+	TWeakObjectPtr<UVolumeTexture> WeakTexture;
+	bool bHalfPrecision = false;
+	int32 BytesPerPixel = 0;
+	TVoxelArray<TVoxelDynamicValue<FVoxelFloatBuffer>> BrickValues;
+
+	struct FBrick
+	{
+		FIntVector Offset = FIntVector::ZeroValue;
+		FIntVector Size = FIntVector::ZeroValue;
+		// Last computed value, uploaded again if the texture resource is recreated
+		TSharedPtr<const FVoxelFloatBuffer> Distance;
+	};
+	TVoxelArray<FBrick> Bricks;
+	// Resource the bricks were uploaded to, the platform data doesn't hold them
+	const FTextureResource* UploadedResource = nullptr;
+
+	struct FQueuedBrick
+	{
+		int32 BrickIndex = -1;
+		TSharedPtr<const FVoxelFloatBuffer> Distance;
+		TVoxelArray<uint8> Data;
+	};
+	using FQueuedBricks = TQueue<FQueuedBrick, EQueueMode::Mpsc>;
+	const TSharedRef<FQueuedBricks> QueuedBricks = MakeVoxelShared<FQueuedBricks>();
+
+	static void ConvertBrick(
+		const FVoxelFloatBuffer& Distance,
+		int32 Num,
+		bool bHalfPrecision,
+		TVoxelArray<uint8>& OutData);
 };
\ No newline at end of file
@@ -14,6 +14,45 @@ DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelHierarchicalMeshDataMemory);
 DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelHierarchicalMeshMemory);
 DEFINE_VOXEL_COUNTER(STAT_VoxelHierarchicalMeshNumInstances);
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELSPAWNER_API, bool, GVoxelHierarchicalMeshPartialUpdates, true,
+	"voxel.spawner.HierarchicalMeshPartialUpdates",
+	"If true, hiding or showing hierarchical mesh instances will only patch the changed instances instead of recreating the render state");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELSPAWNER_API, int32, GVoxelHierarchicalMeshMinParallelInstances, 4096,
+	"voxel.spawner.HierarchicalMeshMinParallelInstances",
+	"Hierarchical mesh builds will fill their instance buffers in parallel if they have more instances than this");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELSPAWNER_API, int32, GVoxelHierarchicalMeshParallelTreeBuildSize, 16384,
+	"voxel.spawner.HierarchicalMeshParallelTreeBuildSize",
+	"Hierarchical mesh cluster trees with more instances than this are split spatially, and each split is built in parallel. 0 to disable");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELSPAWNER_API, bool, GVoxelHierarchicalMeshReuseTrees, true,
+	"voxel.spawner.HierarchicalMeshReuseTrees",
+	"If true, hierarchical mesh rebuilds will reuse the previous cluster tree and only grow the clusters of added or moved instances");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELSPAWNER_API, float, GVoxelHierarchicalMeshMaxTreeFragmentation, 0.2f,
+	"voxel.spawner.HierarchicalMeshMaxTreeFragmentation",
+	"Fraction of added, moved or empty instances above which a reused hierarchical mesh cluster tree is fully rebuilt");
+
+int64 FVoxelHierarchicalMeshTree::GetAllocatedSize() const
+{
+	int64 AllocatedSize = InstanceReorderTable.GetAllocatedSize();
+	if (ClusterTree)
+	{
+		AllocatedSize += ClusterTree->GetAllocatedSize();
+	}
+	return AllocatedSize;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 void FVoxelHierarchicalMeshData::Build()
 {
 	VOXEL_FUNCTION_COUNTER();
@@ -30,20 +69,37 @@ void FVoxelHierarchicalMeshData::Build()
 		Mesh.GetMeshInfo().DesiredInstancesPerLeaf,
 		*this);
 
-	if (ensure(NewBuiltData->ClusterTree.Num() > 0))
+	FinishBuild(NewBuiltData, 0);
+}
+
+void FVoxelHierarchicalMeshData::Build(
+	const FVoxelHierarchicalMeshData& PreviousMeshData,
+	const TConstVoxelArrayView<int32> PreviousIndices)
+{
+	VOXEL_FUNCTION_COUNTER();
+	ensure(!BuiltData);
+	ensure(CustomDatas_Transient.Num() == NumCustomDatas);
+	ensure(PointIds_Transient.Num() == Transforms.Num());
+
+	const TSharedRef<FVoxelHierarchicalMeshBuiltData> NewBuiltData = MakeVoxelShared<FVoxelHierarchicalMeshBuiltData>();
+
+	int32 NumFragmentedInstances = 0;
+	if (!GVoxelHierarchicalMeshReuseTrees ||
+		!UVoxelHierarchicalMeshComponent::AsyncTreeReuse(
+			*NewBuiltData,
+			NumFragmentedInstances,
+			Mesh.GetMeshInfo().MeshBox,
+			PreviousMeshData,
+			PreviousIndices,
+			*this))
 	{
-		ensure(!Bounds.IsValid());
-		Bounds = FVoxelBox(
-			FVector(NewBuiltData->ClusterTree[0].BoundMin),
-			FVector(NewBuiltData->ClusterTree[0].BoundMax));
+		Build();
+		return;
 	}
 
-	CustomDatas_Transient.Empty();
-
-	ensure(!BuiltData);
-	BuiltData = NewBuiltData;
+	PointIds_Transient.Empty();
 
-	UpdateStats();
+	FinishBuild(NewBuiltData, NumFragmentedInstances);
 }
 
 int64 FVoxelHierarchicalMeshData::GetAllocatedSize() const
@@ -55,9 +111,46 @@ int64 FVoxelHierarchicalMeshData::GetAllocatedSize() const
 		AllocatedSize += BuiltData->CustomDatas.GetAllocatedSize();
 		AllocatedSize += BuiltData->InstanceReorderTable.GetAllocatedSize();
 	}
+	if (Tree)
+	{
+		AllocatedSize += Tree->GetAllocatedSize();
+	}
 	return AllocatedSize;
 }
 
+void FVoxelHierarchicalMeshData::FinishBuild(
+	const TSharedRef<FVoxelHierarchicalMeshBuiltData>& NewBuiltData,
+	const int32 NumFragmentedInstances)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (ensure(NewBuiltData->ClusterTree.Num() > 0))
+	{
+		ensure(!Bounds.IsValid());
+		Bounds = FVoxelBox(
+			FVector(NewBuiltData->ClusterTree[0].BoundMin),
+			FVector(NewBuiltData->ClusterTree[0].BoundMax));
+	}
+
+	if (GVoxelHierarchicalMeshReuseTrees)
+	{
+		// Move instead of copying: the component shares the cluster tree & reads the reorder table from the tree
+		const TSharedRef<FVoxelHierarchicalMeshTree> NewTree = MakeVoxelShared<FVoxelHierarchicalMeshTree>();
+		NewTree->ClusterTree = MakeShared<TArray<FClusterNode>, ESPMode::ThreadSafe>(MoveTemp(NewBuiltData->ClusterTree));
+		NewTree->OcclusionLayerNum = NewBuiltData->OcclusionLayerNum;
+		NewTree->InstanceReorderTable = MoveTemp(NewBuiltData->InstanceReorderTable);
+		NewTree->NumFragmentedInstances = NumFragmentedInstances;
+		Tree = NewTree;
+	}
+
+	CustomDatas_Transient.Empty();
+
+	ensure(!BuiltData);
+	BuiltData = NewBuiltData;
+
+	UpdateStats();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -152,6 +245,103 @@ VOXEL_RUN_ON_STARTUP_EDITOR(MakeVoxelHierarchicalMeshComponentTicker)
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+VOXEL_CONSOLE_WORLD_COMMAND(
+	BenchmarkHierarchicalMeshHide,
+	"voxel.spawner.BenchmarkHierarchicalMeshHide",
+	"Hide & show single instances of the largest voxel hierarchical mesh component, with and without partial updates. Args: NumIterations (default 100)")
+{
+	int32 NumIterations = 100;
+	if (Args.Num() > 0)
+	{
+		LexFromString(NumIterations, *Args[0]);
+	}
+	NumIterations = FMath::Max(NumIterations, 1);
+
+	UVoxelHierarchicalMeshComponent* Component = nullptr;
+	ForEachObjectOfClass<UVoxelHierarchicalMeshComponent>([&](UVoxelHierarchicalMeshComponent* It)
+	{
+		if (It->GetWorld() != World ||
+			!It->GetMeshData() ||
+			!It->IsRenderStateCreated())
+		{
+			return;
+		}
+
+		if (!Component ||
+			Component->GetMeshData()->Num() < It->GetMeshData()->Num())
+		{
+			Component = It;
+		}
+	});
+
+	if (!Component)
+	{
+		LOG_VOXEL(Error, "No rendered voxel hierarchical mesh component found");
+		return;
+	}
+
+	const int32 NumComponentInstances = Component->GetMeshData()->Num();
+
+	// Only cycle instances that are currently visible: showing an instance hidden by gameplay (eg harvested foliage)
+	// would leave it visible after the benchmark. Hidden & padding instances have a zero scale in PerInstanceSMData
+	TVoxelArray<int32> VisibleIndices;
+	for (int32 Index = 0; Index < NumComponentInstances; Index++)
+	{
+		if (Component->PerInstanceSMData.IsValidIndex(Index) &&
+			!Component->PerInstanceSMData[Index].Transform.GetScaleVector().IsNearlyZero())
+		{
+			VisibleIndices.Add(Index);
+		}
+	}
+
+	if (VisibleIndices.Num() == 0)
+	{
+		LOG_VOXEL(Error, "%s has no visible instance", *Component->GetPathName());
+		return;
+	}
+
+	const auto Benchmark = [&](const bool bPartialUpdates)
+	{
+		const bool bOldPartialUpdates = GVoxelHierarchicalMeshPartialUpdates;
+		GVoxelHierarchicalMeshPartialUpdates = bPartialUpdates;
+		ON_SCOPE_EXIT
+		{
+			GVoxelHierarchicalMeshPartialUpdates = bOldPartialUpdates;
+		};
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			const int32 Index = VisibleIndices[Iteration % VisibleIndices.Num()];
+
+			// Render updates are normally sent at the end of the frame, send them right away
+			// and flush so that the render thread cost is included
+			Component->HideInstances(MakeVoxelArrayView(&Index, 1));
+			Component->DoDeferredRenderUpdates_Concurrent();
+			FlushRenderingCommands();
+
+			Component->ShowInstances(MakeVoxelArrayView(&Index, 1));
+			Component->DoDeferredRenderUpdates_Concurrent();
+			FlushRenderingCommands();
+		}
+		return (FPlatformTime::Seconds() - StartTime) / (2 * NumIterations);
+	};
+
+	const double PartialTime = Benchmark(true);
+	const double FullTime = Benchmark(false);
+
+	LOG_VOXEL(Log, "%s: %d visible instances, %d iterations. Partial update: %.3fms per hide/show. Render state recreate: %.3fms per hide/show",
+		*Component->GetPathName(),
+		VisibleIndices.Num(),
+		NumIterations,
+		PartialTime * 1000,
+		FullTime * 1000);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 UVoxelHierarchicalMeshComponent::UVoxelHierarchicalMeshComponent()
 {
 	bDisableCollision = true;
@@ -201,26 +391,55 @@ void UVoxelHierarchicalMeshComponent::ReturnToPool()
 
 void UVoxelHierarchicalMeshComponent::HideInstances(const TConstVoxelArrayView<int32> Indices)
 {
-	VOXEL_FUNCTION_COUNTER();
+	VOXEL_FUNCTION_COUNTER_NUM(Indices.Num(), 1);
+	UpdateInstances(Indices, false);
+}
+
+void UVoxelHierarchicalMeshComponent::ShowInstances(const TConstVoxelArrayView<int32> Indices)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Indices.Num(), 1);
+	UpdateInstances(Indices, true);
+}
+
+TConstVoxelArrayView<int32> UVoxelHierarchicalMeshComponent::GetInstanceReorderTable() const
+{
+	if (MeshData &&
+		MeshData->Tree)
+	{
+		return MakeVoxelArrayView(MeshData->Tree->InstanceReorderTable);
+	}
+	return MakeVoxelArrayView(InstanceReorderTable);
+}
 
+void UVoxelHierarchicalMeshComponent::UpdateInstances(const TConstVoxelArrayView<int32> Indices, const bool bVisible)
+{
 	if (!ensure(MeshData))
 	{
 		return;
 	}
 
 	const FMatrix EmptyMatrix = FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector).ToMatrixWithScale();
-	const FMatrix44f EmptyMatrixFloat = FMatrix44f(EmptyMatrix);
+
+	const auto GetMatrix = [&](const int32 Index)
+	{
+		return bVisible ? FMatrix(MeshData->Transforms[Index].ToMatrixWithScale()) : EmptyMatrix;
+	};
+	const auto IsValidIndex = [&](const int32 Index)
+	{
+		return !bVisible || ensure(MeshData->Transforms.IsValidIndex(Index));
+	};
 
 	if (PerInstanceSMData.Num() > 0)
 	{
 		for (const int32 Index : Indices)
 		{
-			if (!ensure(PerInstanceSMData.IsValidIndex(Index)))
+			if (!ensure(PerInstanceSMData.IsValidIndex(Index)) ||
+				!IsValidIndex(Index))
 			{
 				continue;
 			}
 
-			PerInstanceSMData[Index].Transform = EmptyMatrix;
+			PerInstanceSMData[Index].Transform = GetMatrix(Index);
 		}
 	}
 
@@ -235,77 +454,66 @@ void UVoxelHierarchicalMeshComponent::HideInstances(const TConstVoxelArrayView<i
 		return;
 	}
 
-	for (const int32 Index : Indices)
-	{
-		if (!ensure(InstanceReorderTable.IsValidIndex(Index)))
-		{
-			continue;
-		}
-
-		const int32 BuiltIndex = InstanceReorderTable[Index];
-		if (!ensure(0 <= BuiltIndex && BuiltIndex < InstanceBuffer->GetNumInstances()))
-		{
-			continue;
-		}
-
-		InstanceBuffer->SetInstance(BuiltIndex, EmptyMatrixFloat, 0);
-	}
-
-	MarkRenderStateDirty();
-}
-
-void UVoxelHierarchicalMeshComponent::ShowInstances(const TConstVoxelArrayView<int32> Indices)
-{
-	VOXEL_FUNCTION_COUNTER();
-
-	if (!ensure(MeshData))
-	{
-		return;
-	}
+	const TConstVoxelArrayView<int32> ReorderTable = GetInstanceReorderTable();
 
-	if (PerInstanceSMData.Num() > 0)
+	// Nanite proxies build their instance data from PerInstanceSMData when created, always recreate them
+	if (!GVoxelHierarchicalMeshPartialUpdates ||
+		ShouldCreateNaniteProxy())
 	{
 		for (const int32 Index : Indices)
 		{
-			if (!ensure(PerInstanceSMData.IsValidIndex(Index)) ||
-				!ensure(MeshData->Transforms.IsValidIndex(Index)))
+			if (!ensure(ReorderTable.IsValidIndex(Index)) ||
+				!IsValidIndex(Index))
 			{
 				continue;
 			}
 
-			PerInstanceSMData[Index].Transform = FMatrix(MeshData->Transforms[Index].ToMatrixWithScale());
-		}
-	}
+			const int32 BuiltIndex = ReorderTable[Index];
+			if (!ensure(0 <= BuiltIndex && BuiltIndex < InstanceBuffer->GetNumInstances()))
+			{
+				continue;
+			}
 
-	if (!ensure(PerInstanceRenderData))
-	{
-		return;
-	}
+			InstanceBuffer->SetInstance(BuiltIndex, FMatrix44f(GetMatrix(Index)), 0);
+		}
 
-	const TSharedPtr<FStaticMeshInstanceData> InstanceBuffer = PerInstanceRenderData->InstanceBuffer_GameThread;
-	if (!ensure(InstanceBuffer))
-	{
+		MarkRenderStateDirty();
 		return;
 	}
 
+	// InstanceBuffer is shared with the render thread: only write to it through the command buffer,
+	// which is applied by UpdateFromCommandBuffer once the render thread is done with the previous frame
+	FInstanceUpdateCmdBuffer CmdBuffer;
 	for (const int32 Index : Indices)
 	{
-		if (!ensure(InstanceReorderTable.IsValidIndex(Index)) ||
-			!ensure(MeshData->Transforms.IsValidIndex(Index)))
+		if (!ensure(ReorderTable.IsValidIndex(Index)) ||
+			!IsValidIndex(Index))
 		{
 			continue;
 		}
 
-		const int32 BuiltIndex = InstanceReorderTable[Index];
+		const int32 BuiltIndex = ReorderTable[Index];
 		if (!ensure(0 <= BuiltIndex && BuiltIndex < InstanceBuffer->GetNumInstances()))
 		{
 			continue;
 		}
 
-		InstanceBuffer->SetInstance(BuiltIndex, MeshData->Transforms[Index].ToMatrixWithScale(), 0);
+		const FMatrix Matrix = GetMatrix(Index);
+		CmdBuffer.UpdateInstance(BuiltIndex, Matrix);
+		InstanceUpdateCmdBuffer.UpdateInstance(BuiltIndex, Matrix);
 	}
 
-	MarkRenderStateDirty();
+	if (CmdBuffer.NumInlineCommands() == 0)
+	{
+		return;
+	}
+
+	// Patch the changed instances of the instance vertex buffer
+	PerInstanceRenderData->UpdateFromCommandBuffer(CmdBuffer);
+
+	// Patch the proxy instance scene data at the end of the frame
+	// The proxy and its cluster tree are kept: hidden instances are scaled to zero and left in their cluster
+	MarkRenderInstancesDirty();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -315,8 +523,10 @@ void UVoxelHierarchicalMeshComponent::ShowInstances(const TConstVoxelArrayView<i
 int64 UVoxelHierarchicalMeshComponent::GetAllocatedSize() const
 {
 	int64 AllocatedSize = 0;
-	if (ClusterTreePtr)
+	if (ClusterTreePtr &&
+		!(MeshData && MeshData->Tree && MeshData->Tree->ClusterTree == ClusterTreePtr))
 	{
+		// Otherwise counted by the mesh data
 		AllocatedSize += ClusterTreePtr->GetAllocatedSize();
 	}
 	if (PerInstanceRenderData &&
@@ -419,22 +629,394 @@ void UVoxelHierarchicalMeshComponent::AsyncTreeBuild(
 	const int32 NumInstances = InMeshData.Transforms.Num();
 	check(NumInstances > 0);
 
+	TCompatibleVoxelArray<FMatrix> Matrices;
+	AsyncSetInstances(OutBuiltData, Matrices, InMeshData, {});
+
+	OutBuiltData.InstanceDatas = ReinterpretCastVoxelArray<FInstancedStaticMeshInstanceData>(Matrices);
+
+	TCompatibleVoxelArray<int32> SortedInstances;
+	TCompatibleVoxelArray<int32> InstanceReorderTable;
+
+	const int32 MaxInstancesPerLeaf = FMath::Max(InDesiredInstancesPerLeaf, 1);
+	if (GVoxelHierarchicalMeshParallelTreeBuildSize <= 0 ||
+		NumInstances <= GVoxelHierarchicalMeshParallelTreeBuildSize ||
+		!AsyncParallelTreeBuild(
+			Matrices,
+			MeshBox,
+			MaxInstancesPerLeaf,
+			OutBuiltData.ClusterTree,
+			SortedInstances,
+			InstanceReorderTable,
+			OutBuiltData.OcclusionLayerNum))
+	{
+		VOXEL_SCOPE_COUNTER("BuildTreeAnyThread");
+		TArray<float> CustomDataFloats;
+		// TODO
+		PRAGMA_DISABLE_DEPRECATION_WARNINGS
+		BuildTreeAnyThread(
+			Matrices,
+			// Done manually
+			CustomDataFloats,
+			0,
+			MeshBox,
+			OutBuiltData.ClusterTree,
+			SortedInstances,
+			InstanceReorderTable,
+			OutBuiltData.OcclusionLayerNum,
+			MaxInstancesPerLeaf,
+			false
+		);
+		PRAGMA_ENABLE_DEPRECATION_WARNINGS
+	}
+
+	OutBuiltData.InstanceReorderTable = InstanceReorderTable;
+
+	// In-place sort the instances
+	{
+		VOXEL_SCOPE_COUNTER("Sort Instances");
+		for (int32 FirstUnfixedIndex = 0; FirstUnfixedIndex < NumInstances; FirstUnfixedIndex++)
+		{
+			const int32 LoadFrom = SortedInstances[FirstUnfixedIndex];
+			if (LoadFrom == FirstUnfixedIndex)
+			{
+				continue;
+			}
+
+			check(LoadFrom > FirstUnfixedIndex);
+			OutBuiltData.InstanceBuffer->SwapInstance(FirstUnfixedIndex, LoadFrom);
+			const int32 SwapGoesTo = InstanceReorderTable[FirstUnfixedIndex];
+			checkVoxelSlow(SwapGoesTo > FirstUnfixedIndex);
+			checkVoxelSlow(SortedInstances[SwapGoesTo] == FirstUnfixedIndex);
+			SortedInstances[SwapGoesTo] = LoadFrom;
+			InstanceReorderTable[LoadFrom] = SwapGoesTo;
+			InstanceReorderTable[FirstUnfixedIndex] = FirstUnfixedIndex;
+			SortedInstances[FirstUnfixedIndex] = FirstUnfixedIndex;
+		}
+	}
+}
+
+bool UVoxelHierarchicalMeshComponent::AsyncTreeReuse(
+	FVoxelHierarchicalMeshBuiltData& OutBuiltData,
+	int32& OutNumFragmentedInstances,
+	const FBox& MeshBox,
+	const FVoxelHierarchicalMeshData& PreviousMeshData,
+	const TConstVoxelArrayView<int32> PreviousIndices,
+	FVoxelHierarchicalMeshData& InMeshData)
+{
+	VOXEL_SCOPE_COUNTER_FORMAT("UVoxelHierarchicalMeshComponent::AsyncTreeReuse Num=%d", InMeshData.Transforms.Num());
+
+	if (!PreviousMeshData.Tree ||
+		!ensure(PreviousMeshData.Tree->ClusterTree))
+	{
+		return false;
+	}
+
+	const FVoxelHierarchicalMeshTree& PreviousTree = *PreviousMeshData.Tree;
+	const TArray<FClusterNode>& PreviousClusterTree = *PreviousTree.ClusterTree;
+
+	const int32 NumInstances = InMeshData.Transforms.Num();
+	const int32 NumSlots = PreviousMeshData.Transforms.Num();
+
+	if (!ensure(PreviousIndices.Num() == NumInstances) ||
+		!ensure(PreviousTree.InstanceReorderTable.Num() == NumSlots) ||
+		!ensure(PreviousClusterTree.Num() > 0) ||
+		NumInstances == 0 ||
+		// Instances are never added to the tree, only moved into empty slots
+		NumInstances > NumSlots)
+	{
+		return false;
+	}
+
+	// Built index of each instance, -1 if it needs an empty slot
+	TCompatibleVoxelArray<int32> BuiltIndices;
+	FVoxelUtilities::SetNumFast(BuiltIndices, NumInstances);
+
+	TVoxelArray<int32> SlotToIndex;
+	SlotToIndex.Init(-1, NumSlots);
+
+	TVoxelArray<int32> AddedIndices;
+	TVoxelArray<int32> MovedIndices;
+	{
+		VOXEL_SCOPE_COUNTER("Find previous slots");
+
+		for (int32 Index = 0; Index < NumInstances; Index++)
+		{
+			const int32 PreviousIndex = PreviousIndices[Index];
+			if (PreviousIndex == -1)
+			{
+				BuiltIndices[Index] = -1;
+				AddedIndices.Add(Index);
+				continue;
+			}
+
+			if (!ensure(PreviousMeshData.Transforms.IsValidIndex(PreviousIndex)))
+			{
+				return false;
+			}
+
+			const int32 Slot = PreviousTree.InstanceReorderTable[PreviousIndex];
+			if (!ensure(SlotToIndex.IsValidIndex(Slot)) ||
+				!ensure(SlotToIndex[Slot] == -1))
+			{
+				return false;
+			}
+
+			SlotToIndex[Slot] = Index;
+			BuiltIndices[Index] = Slot;
+
+			if (!InMeshData.Transforms[Index].Equals(PreviousMeshData.Transforms[PreviousIndex], 0.f))
+			{
+				MovedIndices.Add(Index);
+			}
+		}
+	}
+
+	// Empty slots are filled with zero-scale instances. They are still drawn as degenerate geometry when their cluster is visible
+	const int32 NumFragmentedInstances = PreviousTree.NumFragmentedInstances + AddedIndices.Num() + MovedIndices.Num();
+	const int32 NumEmptySlots = NumSlots - NumInstances;
+	if (NumFragmentedInstances + NumEmptySlots > GVoxelHierarchicalMeshMaxTreeFragmentation * NumSlots)
+	{
+		return false;
+	}
+
+	TArray<FClusterNode> ClusterTree = PreviousClusterTree;
+
+	TVoxelArray<int32> NodeToParent;
+	TVoxelArray<int32> SlotToLeaf;
+	{
+		VOXEL_SCOPE_COUNTER("NodeToParent");
+
+		NodeToParent.Init(-1, ClusterTree.Num());
+		FVoxelUtilities::SetNumFast(SlotToLeaf, NumSlots);
+
+		for (int32 NodeIndex = 0; NodeIndex < ClusterTree.Num(); NodeIndex++)
+		{
+			const FClusterNode& Node = ClusterTree[NodeIndex];
+			if (Node.FirstChild < 0)
+			{
+				if (!ensure(0 <= Node.FirstInstance && Node.LastInstance < NumSlots))
+				{
+					return false;
+				}
+
+				for (int32 Slot = Node.FirstInstance; Slot <= Node.LastInstance; Slot++)
+				{
+					SlotToLeaf[Slot] = NodeIndex;
+				}
+				continue;
+			}
+
+			if (!ensure(0 < Node.FirstChild && Node.LastChild < ClusterTree.Num()))
+			{
+				return false;
+			}
+
+			for (int32 ChildIndex = Node.FirstChild; ChildIndex <= Node.LastChild; ChildIndex++)
+			{
+				NodeToParent[ChildIndex] = NodeIndex;
+			}
+		}
+	}
+
+	if (AddedIndices.Num() > 0)
+	{
+		VOXEL_SCOPE_COUNTER("Assign empty slots");
+
+		TVoxelArray<int32> NodeToNumEmptySlots;
+		NodeToNumEmptySlots.SetNumZeroed(ClusterTree.Num());
+
+		TVoxelAddOnlyMap<int32, TVoxelArray<int32>> LeafToEmptySlots;
+		for (int32 Slot = 0; Slot < NumSlots; Slot++)
+		{
+			if (SlotToIndex[Slot] != -1)
+			{
+				continue;
+			}
+
+			const int32 Leaf = SlotToLeaf[Slot];
+			LeafToEmptySlots.FindOrAdd(Leaf).Add(Slot);
+
+			for (int32 NodeIndex = Leaf; NodeIndex != -1; NodeIndex = NodeToParent[NodeIndex])
+			{
+				NodeToNumEmptySlots[NodeIndex]++;
+			}
+		}
+
+		for (const int32 Index : AddedIndices)
+		{
+			const FVector3f Position = InMeshData.Transforms[Index].GetTranslation();
+
+			// Walk down the tree towards the closest cluster that still has empty slots
+			int32 NodeIndex = 0;
+			while (ClusterTree[NodeIndex].FirstChild >= 0)
+			{
+				checkVoxelSlow(NodeToNumEmptySlots[NodeIndex] > 0);
+				NodeToNumEmptySlots[NodeIndex]--;
+
+				int32 BestChildIndex = -1;
+				float BestDistance = MAX_flt;
+				for (int32 ChildIndex = ClusterTree[NodeIndex].FirstChild; ChildIndex <= ClusterTree[NodeIndex].LastChild; ChildIndex++)
+				{
+					if (NodeToNumEmptySlots[ChildIndex] == 0)
+					{
+						continue;
+					}
+
+					const FClusterNode& Child = ClusterTree[ChildIndex];
+					const float Distance = FBox3f(Child.BoundMin, Child.BoundMax).ComputeSquaredDistanceToPoint(Position);
+					if (Distance < BestDistance)
+					{
+						BestChildIndex = ChildIndex;
+						BestDistance = Distance;
+					}
+				}
+
+				if (!ensure(BestChildIndex != -1))
+				{
+					return false;
+				}
+				NodeIndex = BestChildIndex;
+			}
+			NodeToNumEmptySlots[NodeIndex]--;
+
+			TVoxelArray<int32>* EmptySlots = LeafToEmptySlots.Find(NodeIndex);
+			if (!ensure(EmptySlots) ||
+				!ensure(EmptySlots->Num() > 0))
+			{
+				return false;
+			}
+
+			const int32 Slot = EmptySlots->Pop(false);
+			SlotToIndex[Slot] = Index;
+			BuiltIndices[Index] = Slot;
+		}
+	}
+
+	{
+		VOXEL_SCOPE_COUNTER("Grow clusters");
+
+		const auto GrowClusters = [&](const int32 Index)
+		{
+			FTransform3f Transform = InMeshData.Transforms[Index];
+			Transform.NormalizeRotation();
+			const FMatrix Matrix = FMatrix(Transform.ToMatrixWithScale());
+			const FBox3f InstanceBounds = FBox3f(MeshBox.TransformBy(Matrix));
+			// Same as the tree builder, used by the LOD & distance culling of the cluster
+			const FVector3f InstanceScale = FVector3f(Matrix.GetScaleVector());
+
+			for (int32 NodeIndex = SlotToLeaf[BuiltIndices[Index]]; NodeIndex != -1; NodeIndex = NodeToParent[NodeIndex])
+			{
+				FClusterNode& Node = ClusterTree[NodeIndex];
+
+				const FVector3f NewBoundMin = FVector3f::Min(Node.BoundMin, InstanceBounds.Min);
+				const FVector3f NewBoundMax = FVector3f::Max(Node.BoundMax, InstanceBounds.Max);
+				const FVector3f NewMinInstanceScale = FVector3f::Min(Node.MinInstanceScale, InstanceScale);
+				const FVector3f NewMaxInstanceScale = FVector3f::Max(Node.MaxInstanceScale, InstanceScale);
+				if (NewBoundMin == Node.BoundMin &&
+					NewBoundMax == Node.BoundMax &&
+					NewMinInstanceScale == Node.MinInstanceScale &&
+					NewMaxInstanceScale == Node.MaxInstanceScale)
+				{
+					// Parents already contain this node
+					break;
+				}
+
+				Node.BoundMin = NewBoundMin;
+				Node.BoundMax = NewBoundMax;
+				Node.MinInstanceScale = NewMinInstanceScale;
+				Node.MaxInstanceScale = NewMaxInstanceScale;
+			}
+		};
+
+		for (const int32 Index : AddedIndices)
+		{
+			GrowClusters(Index);
+		}
+		for (const int32 Index : MovedIndices)
+		{
+			GrowClusters(Index);
+		}
+	}
+
+	{
+		VOXEL_SCOPE_COUNTER("Fill empty slots");
+
+		const FTransform3f HiddenTransform(FQuat4f::Identity, FVector3f::ZeroVector, FVector3f::ZeroVector);
+
+		for (int32 Slot = 0; Slot < NumSlots; Slot++)
+		{
+			if (SlotToIndex[Slot] != -1)
+			{
+				continue;
+			}
+
+			InMeshData.Transforms.Add(HiddenTransform);
+			BuiltIndices.Add(Slot);
+
+			for (TVoxelArray<float>& CustomData : InMeshData.CustomDatas_Transient)
+			{
+				CustomData.Add(0.f);
+			}
+		}
+		ensure(InMeshData.Transforms.Num() == NumSlots);
+	}
+
+	TCompatibleVoxelArray<FMatrix> Matrices;
+	AsyncSetInstances(OutBuiltData, Matrices, InMeshData, BuiltIndices);
+
+	OutBuiltData.ClusterTree = MoveTemp(ClusterTree);
+	OutBuiltData.OcclusionLayerNum = PreviousTree.OcclusionLayerNum;
+	OutBuiltData.InstanceDatas = ReinterpretCastVoxelArray<FInstancedStaticMeshInstanceData>(Matrices);
+	OutBuiltData.InstanceReorderTable = MoveTemp(BuiltIndices);
+
+	OutNumFragmentedInstances = NumFragmentedInstances;
+	return true;
+}
+
+void UVoxelHierarchicalMeshComponent::AsyncSetInstances(
+	FVoxelHierarchicalMeshBuiltData& OutBuiltData,
+	TCompatibleVoxelArray<FMatrix>& OutMatrices,
+	const FVoxelHierarchicalMeshData& InMeshData,
+	const TConstVoxelArrayView<int32> BuiltIndices)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(InMeshData.Transforms.Num(), 1);
+
+	const int32 NumInstances = InMeshData.Transforms.Num();
+	const int32 NumCustomDatas = InMeshData.CustomDatas_Transient.Num();
+	ensure(BuiltIndices.Num() == 0 || BuiltIndices.Num() == NumInstances);
+
 	OutBuiltData.InstanceBuffer = MakeUnique<FStaticMeshInstanceData>(false);
 	{
 		VOXEL_SCOPE_COUNTER("AllocateInstances");
 		OutBuiltData.InstanceBuffer->AllocateInstances(
 			NumInstances,
-			InMeshData.CustomDatas_Transient.Num(),
+			NumCustomDatas,
 			EResizeBufferFlags::None,
 			true);
 	}
 
-	TCompatibleVoxelArray<FMatrix> Matrices;
-	FVoxelUtilities::SetNumFast(Matrices, NumInstances);
+	FVoxelUtilities::SetNumFast(OutMatrices, NumInstances);
+	FVoxelUtilities::SetNumFast(OutBuiltData.CustomDatas, NumCustomDatas * NumInstances);
+
+	TVoxelArray<bool> IsCustomDataValid;
+	for (const TVoxelArray<float>& CustomData : InMeshData.CustomDatas_Transient)
+	{
+		IsCustomDataValid.Add(ensure(CustomData.Num() == NumInstances));
+	}
+
+	// Each instance only writes to its own slot, blocks can be filled in parallel
+	constexpr int32 BlockSize = 1024;
+	ParallelFor(FVoxelUtilities::DivideCeil(NumInstances, BlockSize), [&](const int32 Block)
 	{
 		VOXEL_SCOPE_COUNTER("SetInstances");
-		for (int32 Index = 0; Index < NumInstances; Index++)
+
+		FStaticMeshInstanceData& InstanceBuffer = *OutBuiltData.InstanceBuffer;
+
+		const int32 EndIndex = FMath::Min((Block + 1) * BlockSize, NumInstances);
+		for (int32 Index = Block * BlockSize; Index < EndIndex; Index++)
 		{
+			const int32 BuiltIndex = BuiltIndices.Num() > 0 ? BuiltIndices[Index] : Index;
+
 			FTransform3f Transform = InMeshData.Transforms[Index];
 			Transform.NormalizeRotation();
 			const FMatrix44f Matrix = Transform.ToMatrixWithScale();
@@ -442,80 +1024,316 @@ void UVoxelHierarchicalMeshComponent::AsyncTreeBuild(
 			const uint64 Seed = FVoxelUtilities::MurmurHash(Transform.GetTranslation());
 			const FRandomStream RandomStream(Seed);
 
-			Matrices[Index] = FMatrix(Matrix);
-			OutBuiltData.InstanceBuffer->SetInstance(Index, Matrix, RandomStream.GetFraction());
+			OutMatrices[Index] = FMatrix(Matrix);
+			InstanceBuffer.SetInstance(BuiltIndex, Matrix, RandomStream.GetFraction());
+
+			for (int32 CustomDataIndex = 0; CustomDataIndex < NumCustomDatas; CustomDataIndex++)
+			{
+				if (!IsCustomDataValid[CustomDataIndex])
+				{
+					continue;
+				}
+
+				const float Value = InMeshData.CustomDatas_Transient[CustomDataIndex][Index];
+				OutBuiltData.CustomDatas[Index * NumCustomDatas + CustomDataIndex] = Value;
+				InstanceBuffer.SetInstanceCustomData(BuiltIndex, CustomDataIndex, Value);
+			}
 		}
+	}, NumInstances > GVoxelHierarchicalMeshMinParallelInstances ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+}
+
+bool UVoxelHierarchicalMeshComponent::AsyncParallelTreeBuild(
+	const TCompatibleVoxelArray<FMatrix>& Matrices,
+	const FBox& MeshBox,
+	const int32 MaxInstancesPerLeaf,
+	TArray<FClusterNode>& OutClusterTree,
+	TCompatibleVoxelArray<int32>& OutSortedInstances,
+	TCompatibleVoxelArray<int32>& OutInstanceReorderTable,
+	int32& OutOcclusionLayerNum)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Matrices.Num(), 1);
+
+	const int32 NumInstances = Matrices.Num();
+
+	// The root of the merged tree has one child per subtree, don't exceed the usual branching factor
+	constexpr int32 MaxNumSubtrees = 16;
+	const int32 NumSubtrees = FMath::Min<int32>(
+		FMath::RoundUpToPowerOfTwo(FVoxelUtilities::DivideCeil(NumInstances, FMath::Max(GVoxelHierarchicalMeshParallelTreeBuildSize, 1))),
+		MaxNumSubtrees);
+
+	if (NumSubtrees < 2)
+	{
+		return false;
 	}
 
-	OutBuiltData.InstanceDatas = ReinterpretCastVoxelArray<FInstancedStaticMeshInstanceData>(Matrices);
+	struct FSubtree
+	{
+		TCompatibleVoxelArray<int32> Indices;
+
+		TArray<FClusterNode> ClusterTree;
+		TCompatibleVoxelArray<int32> SortedInstances;
+		TCompatibleVoxelArray<int32> InstanceReorderTable;
+		int32 OcclusionLayerNum = 0;
 
-	FVoxelUtilities::SetNumFast(OutBuiltData.CustomDatas, InMeshData.CustomDatas_Transient.Num() * NumInstances);
+		// First node of each level, and the number of nodes as last element
+		TVoxelArray<int32> LevelStarts;
+		int32 InstanceOffset = 0;
 
+		int32 NumLevels() const
+		{
+			return LevelStarts.Num() - 1;
+		}
+		int32 LevelSize(const int32 Level) const
+		{
+			return Level < NumLevels() ? LevelStarts[Level + 1] - LevelStarts[Level] : 0;
+		}
+	};
+	TVoxelArray<FSubtree> Subtrees;
+	Subtrees.SetNum(NumSubtrees);
+
+	// Split the instances in halves along their largest axis, the same way the tree builder does
 	{
-		VOXEL_SCOPE_COUNTER("Set Custom Data");
-		for (int32 CustomDataIndex = 0; CustomDataIndex < InMeshData.CustomDatas_Transient.Num(); CustomDataIndex++)
+		VOXEL_SCOPE_COUNTER("Split instances");
+
+		TVoxelArray<TCompatibleVoxelArray<int32>> Splits;
+		Splits.Emplace();
+		FVoxelUtilities::SetNumFast(Splits[0], NumInstances);
+		for (int32 Index = 0; Index < NumInstances; Index++)
 		{
-			const TVoxelArray<float>& CustomData = InMeshData.CustomDatas_Transient[CustomDataIndex];
-			if (!ensure(CustomData.Num() == NumInstances))
-			{
-				continue;
-			}
+			Splits[0][Index] = Index;
+		}
 
-			for (int32 InstanceIndex = 0; InstanceIndex < NumInstances; InstanceIndex++)
+		while (Splits.Num() < NumSubtrees)
+		{
+			TVoxelArray<TCompatibleVoxelArray<int32>> NewSplits;
+			NewSplits.SetNum(2 * Splits.Num());
+
+			ParallelFor(Splits.Num(), [&](const int32 SplitIndex)
 			{
-				OutBuiltData.CustomDatas[InstanceIndex * InMeshData.CustomDatas_Transient.Num() + CustomDataIndex] = CustomData[InstanceIndex];
-				OutBuiltData.InstanceBuffer->SetInstanceCustomData(InstanceIndex, CustomDataIndex, CustomData[InstanceIndex]);
-			}
+				TCompatibleVoxelArray<int32>& Indices = Splits[SplitIndex];
+
+				FBox Bounds(ForceInit);
+				for (const int32 Index : Indices)
+				{
+					Bounds += Matrices[Index].GetOrigin();
+				}
+
+				const FVector Size = Bounds.GetSize();
+				const int32 Axis = Size.X >= Size.Y && Size.X >= Size.Z ? 0 : Size.Y >= Size.Z ? 1 : 2;
+
+				Indices.Sort([&](const int32 A, const int32 B)
+				{
+					return Matrices[A].M[3][Axis] < Matrices[B].M[3][Axis];
+				});
+
+				const int32 Half = Indices.Num() / 2;
+				NewSplits[2 * SplitIndex + 0] = TCompatibleVoxelArray<int32>(Indices.GetData(), Half);
+				NewSplits[2 * SplitIndex + 1] = TCompatibleVoxelArray<int32>(Indices.GetData() + Half, Indices.Num() - Half);
+			});
+
+			Splits = MoveTemp(NewSplits);
+		}
+
+		for (int32 Index = 0; Index < NumSubtrees; Index++)
+		{
+			Subtrees[Index].Indices = MoveTemp(Splits[Index]);
 		}
 	}
 
-	TCompatibleVoxelArray<int32> SortedInstances;
-	TCompatibleVoxelArray<int32> InstanceReorderTable;
+	TVoxelAtomic<bool> bIsValid = true;
+	ParallelFor(NumSubtrees, [&](const int32 SubtreeIndex)
 	{
 		VOXEL_SCOPE_COUNTER("BuildTreeAnyThread");
+
+		FSubtree& Subtree = Subtrees[SubtreeIndex];
+		if (Subtree.Indices.Num() == 0)
+		{
+			bIsValid.Store(false);
+			return;
+		}
+
+		TCompatibleVoxelArray<FMatrix> SubtreeMatrices;
+		FVoxelUtilities::SetNumFast(SubtreeMatrices, Subtree.Indices.Num());
+		for (int32 Index = 0; Index < Subtree.Indices.Num(); Index++)
+		{
+			SubtreeMatrices[Index] = Matrices[Subtree.Indices[Index]];
+		}
+
 		TArray<float> CustomDataFloats;
-		// TODO
 		PRAGMA_DISABLE_DEPRECATION_WARNINGS
 		BuildTreeAnyThread(
-			Matrices,
+			SubtreeMatrices,
 			// Done manually
 			CustomDataFloats,
 			0,
 			MeshBox,
-			OutBuiltData.ClusterTree,
-			SortedInstances,
-			InstanceReorderTable,
-			OutBuiltData.OcclusionLayerNum,
-			FMath::Max(InDesiredInstancesPerLeaf, 1),
+			Subtree.ClusterTree,
+			Subtree.SortedInstances,
+			Subtree.InstanceReorderTable,
+			Subtree.OcclusionLayerNum,
+			MaxInstancesPerLeaf,
 			false
 		);
 		PRAGMA_ENABLE_DEPRECATION_WARNINGS
+
+		// Trees are built level by level: each level is a contiguous range of nodes
+		const TArray<FClusterNode>& ClusterTree = Subtree.ClusterTree;
+		if (!ensure(ClusterTree.Num() > 0))
+		{
+			bIsValid.Store(false);
+			return;
+		}
+
+		Subtree.LevelStarts.Add(0);
+
+		int32 FirstNode = 0;
+		int32 LastNode = 0;
+		while (true)
+		{
+			Subtree.LevelStarts.Add(LastNode + 1);
+
+			if (ClusterTree[FirstNode].FirstChild < 0)
+			{
+				break;
+			}
+
+			if (ClusterTree[FirstNode].FirstChild != LastNode + 1 ||
+				ClusterTree[LastNode].LastChild < LastNode + 1)
+			{
+				bIsValid.Store(false);
+				return;
+			}
+
+			FirstNode = ClusterTree[FirstNode].FirstChild;
+			LastNode = ClusterTree[LastNode].LastChild;
+		}
+
+		if (Subtree.LevelStarts.Last() != ClusterTree.Num())
+		{
+			bIsValid.Store(false);
+		}
+	});
+
+	if (!ensureVoxelSlow(bIsValid.Load()))
+	{
+		return false;
 	}
 
-	OutBuiltData.InstanceReorderTable = InstanceReorderTable;
+	VOXEL_SCOPE_COUNTER("Merge subtrees");
 
-	// In-place sort the instances
+	int32 NumLevels = 0;
+	int32 NumNodes = 1;
 	{
-		VOXEL_SCOPE_COUNTER("Sort Instances");
-		for (int32 FirstUnfixedIndex = 0; FirstUnfixedIndex < NumInstances; FirstUnfixedIndex++)
+		int32 InstanceOffset = 0;
+		for (FSubtree& Subtree : Subtrees)
 		{
-			const int32 LoadFrom = SortedInstances[FirstUnfixedIndex];
-			if (LoadFrom == FirstUnfixedIndex)
+			Subtree.InstanceOffset = InstanceOffset;
+			InstanceOffset += Subtree.Indices.Num();
+
+			NumLevels = FMath::Max(NumLevels, Subtree.NumLevels());
+			NumNodes += Subtree.ClusterTree.Num();
+		}
+		ensure(InstanceOffset == NumInstances);
+	}
+
+	// Level L of each subtree is level L + 1 of the merged tree, after the same level of the previous subtrees
+	TVoxelArray<TVoxelArray<int32>> SubtreeToLevelToMergedStart;
+	SubtreeToLevelToMergedStart.SetNum(NumSubtrees);
+	{
+		int32 MergedStart = 1;
+		for (int32 Level = 0; Level < NumLevels; Level++)
+		{
+			for (int32 SubtreeIndex = 0; SubtreeIndex < NumSubtrees; SubtreeIndex++)
 			{
-				continue;
+				SubtreeToLevelToMergedStart[SubtreeIndex].Add(MergedStart);
+				MergedStart += Subtrees[SubtreeIndex].LevelSize(Level);
 			}
+		}
+		ensure(MergedStart == NumNodes);
+	}
 
-			check(LoadFrom > FirstUnfixedIndex);
-			OutBuiltData.InstanceBuffer->SwapInstance(FirstUnfixedIndex, LoadFrom);
-			const int32 SwapGoesTo = InstanceReorderTable[FirstUnfixedIndex];
-			checkVoxelSlow(SwapGoesTo > FirstUnfixedIndex);
-			checkVoxelSlow(SortedInstances[SwapGoesTo] == FirstUnfixedIndex);
-			SortedInstances[SwapGoesTo] = LoadFrom;
-			InstanceReorderTable[LoadFrom] = SwapGoesTo;
-			InstanceReorderTable[FirstUnfixedIndex] = FirstUnfixedIndex;
-			SortedInstances[FirstUnfixedIndex] = FirstUnfixedIndex;
+	OutClusterTree.SetNum(NumNodes);
+	FVoxelUtilities::SetNumFast(OutSortedInstances, NumInstances);
+	FVoxelUtilities::SetNumFast(OutInstanceReorderTable, NumInstances);
+
+	ParallelFor(NumSubtrees, [&](const int32 SubtreeIndex)
+	{
+		const FSubtree& Subtree = Subtrees[SubtreeIndex];
+		const TVoxelArray<int32>& LevelToMergedStart = SubtreeToLevelToMergedStart[SubtreeIndex];
+
+		for (int32 Level = 0; Level < Subtree.NumLevels(); Level++)
+		{
+			for (int32 NodeIndex = Subtree.LevelStarts[Level]; NodeIndex < Subtree.LevelStarts[Level + 1]; NodeIndex++)
+			{
+				FClusterNode Node = Subtree.ClusterTree[NodeIndex];
+				if (Node.FirstChild >= 0)
+				{
+					const int32 ChildOffset = LevelToMergedStart[Level + 1] - Subtree.LevelStarts[Level + 1];
+					Node.FirstChild += ChildOffset;
+					Node.LastChild += ChildOffset;
+				}
+				Node.FirstInstance += Subtree.InstanceOffset;
+				Node.LastInstance += Subtree.InstanceOffset;
+
+				OutClusterTree[LevelToMergedStart[Level] + NodeIndex - Subtree.LevelStarts[Level]] = Node;
+			}
+		}
+
+		for (int32 Index = 0; Index < Subtree.Indices.Num(); Index++)
+		{
+			OutSortedInstances[Subtree.InstanceOffset + Index] = Subtree.Indices[Subtree.SortedInstances[Index]];
+			OutInstanceReorderTable[Subtree.Indices[Index]] = Subtree.InstanceOffset + Subtree.InstanceReorderTable[Index];
+		}
+	});
+
+	FClusterNode& Root = OutClusterTree[0];
+	Root = Subtrees[0].ClusterTree[0];
+	Root.FirstChild = 1;
+	Root.LastChild = NumSubtrees;
+	Root.FirstInstance = 0;
+	Root.LastInstance = NumInstances - 1;
+
+	for (const FSubtree& Subtree : Subtrees)
+	{
+		const FClusterNode& SubtreeRoot = Subtree.ClusterTree[0];
+		Root.BoundMin = FVector3f::Min(Root.BoundMin, SubtreeRoot.BoundMin);
+		Root.BoundMax = FVector3f::Max(Root.BoundMax, SubtreeRoot.BoundMax);
+		Root.MinInstanceScale = FVector3f::Min(Root.MinInstanceScale, SubtreeRoot.MinInstanceScale);
+		Root.MaxInstanceScale = FVector3f::Max(Root.MaxInstanceScale, SubtreeRoot.MaxInstanceScale);
+	}
+
+	// Subtrees can pick their occlusion layer at different depths, so recompute it on the merged tree
+	// The scene proxy walks down from the root while levels have at most OcclusionLayerNum nodes:
+	// use the size of the deepest level that fits in the max number of occlusion queries
+	OutOcclusionLayerNum = 0;
+	{
+		static IConsoleVariable* CVarMaxOcclusionQueriesPerComponent = IConsoleManager::Get().FindConsoleVariable(TEXT("foliage.MaxOcclusionQueriesPerComponent"));
+		check(CVarMaxOcclusionQueriesPerComponent);
+
+		const int32 MaxOcclusionQueries = CVarMaxOcclusionQueriesPerComponent->GetInt();
+		if (MaxOcclusionQueries > 0)
+		{
+			OutOcclusionLayerNum = 1;
+
+			// Level L of each subtree is level L + 1 of the merged tree
+			for (int32 Level = 0; Level < NumLevels; Level++)
+			{
+				int32 LevelSize = 0;
+				for (const FSubtree& Subtree : Subtrees)
+				{
+					LevelSize += Subtree.LevelSize(Level);
+				}
+
+				if (LevelSize > MaxOcclusionQueries)
+				{
+					break;
+				}
+				OutOcclusionLayerNum = LevelSize;
+			}
 		}
 	}
+
+	return true;
 }
 
 void UVoxelHierarchicalMeshComponent::SetBuiltData(FVoxelHierarchicalMeshBuiltData&& BuiltData)
@@ -535,6 +1353,24 @@ void UVoxelHierarchicalMeshComponent::SetBuiltData(FVoxelHierarchicalMeshBuiltDa
 		InitPerInstanceRenderData(true, BuiltData.InstanceBuffer.Get(), bRequireCPUAccess);
 	}
 
+	const TSharedPtr<const FVoxelHierarchicalMeshTree> Tree = MeshData->Tree;
+	if (Tree &&
+		ensure(Tree->ClusterTree) &&
+		ensure(Tree->ClusterTree->Num() > 0))
+	{
+		VOXEL_SCOPE_COUNTER("AcceptPrebuiltTree");
+
+		// AcceptPrebuiltTree only reads the root bounds before wrapping the array in ClusterTreePtr:
+		// give it the root only, then share the full tree with the mesh data instead of copying it
+		TArray<FClusterNode> RootNode = { (*Tree->ClusterTree)[0] };
+
+		PRAGMA_DISABLE_DEPRECATION_WARNINGS
+		AcceptPrebuiltTree(BuiltData.InstanceDatas, RootNode, Tree->OcclusionLayerNum, NewNumInstances);
+		PRAGMA_ENABLE_DEPRECATION_WARNINGS
+
+		ClusterTreePtr = Tree->ClusterTree;
+	}
+	else
 	{
 		VOXEL_SCOPE_COUNTER("AcceptPrebuiltTree");
 		PRAGMA_DISABLE_DEPRECATION_WARNINGS
@@ -555,5 +1391,15 @@ void UVoxelHierarchicalMeshComponent::SetBuiltData(FVoxelHierarchicalMeshBuiltDa
 
 	NumCustomDataFloats = MeshData->NumCustomDatas;
 	PerInstanceSMCustomData = MoveTemp(BuiltData.CustomDatas);
-	InstanceReorderTable = MoveTemp(BuiltData.InstanceReorderTable);
+
+	if (Tree)
+	{
+		// Read from the tree, see GetInstanceReorderTable
+		ensure(BuiltData.InstanceReorderTable.Num() == 0);
+		InstanceReorderTable.Empty();
+	}
+	else
+	{
+		InstanceReorderTable = MoveTemp(BuiltData.InstanceReorderTable);
+	}
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 // Copyright Voxel Plugin, Inc. All Rights Reserved.
 
 #include "VoxelInstancedCollisionComponent.h"
+#include "VoxelInvoker.h"
 #include "Point/VoxelPointOverrideManager.h"
+#include "EngineUtils.h"
 #include "SceneManagement.h"
 #include "Engine/StaticMesh.h"
 #include "PrimitiveSceneProxy.h"
@@ -12,6 +14,21 @@ VOXEL_CONSOLE_VARIABLE(
 	"voxel.foliage.ShowInstancesCollisions",
 	"");
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELSPAWNER_API, bool, GVoxelFoliageLazyCollision, false,
+	"voxel.foliage.LazyCollision",
+	"If true, foliage instance bodies will only be created around pawns, invokers & actors registered to FVoxelInstancedCollisionManager");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELSPAWNER_API, float, GVoxelFoliageLazyCollisionRadius, 2000.f,
+	"voxel.foliage.LazyCollisionRadius",
+	"Distance around pawns, invokers & registered actors in which foliage instance bodies are created. Bodies are released 25% further");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELSPAWNER_API, int32, GVoxelFoliageLazyCollisionMaxChangesPerFrame, 256,
+	"voxel.foliage.LazyCollisionMaxChangesPerFrame",
+	"Max number of foliage instance bodies created or released per frame when using lazy collision");
+
 DEFINE_VOXEL_COUNTER(STAT_VoxelNumCollisionInstances);
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -36,6 +53,116 @@ void FVoxelInstancedCollisionDataImpl::FlushInstanceBodiesToDelete()
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+void FVoxelInstancedCollisionManager::RegisterActor(const AActor* Actor)
+{
+	ensure(IsInGameThread());
+	Actors.Add(Actor);
+}
+
+void FVoxelInstancedCollisionManager::UnregisterActor(const AActor* Actor)
+{
+	ensure(IsInGameThread());
+	Actors.Remove(Actor);
+}
+
+void FVoxelInstancedCollisionManager::AddComponent(UVoxelInstancedCollisionComponent& Component)
+{
+	ensure(IsInGameThread());
+	ensure(!Components.Contains(&Component));
+	Components.Add(&Component);
+}
+
+void FVoxelInstancedCollisionManager::RemoveComponent(UVoxelInstancedCollisionComponent& Component)
+{
+	ensure(IsInGameThread());
+	Components.RemoveSwap(&Component);
+}
+
+void FVoxelInstancedCollisionManager::Tick()
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	for (int32 Index = 0; Index < Components.Num(); Index++)
+	{
+		if (!Components[Index].IsValid())
+		{
+			Components.RemoveAtSwap(Index);
+			Index--;
+		}
+	}
+
+	if (!GVoxelFoliageLazyCollision)
+	{
+		if (bWasLazy)
+		{
+			bWasLazy = false;
+
+			for (const TWeakObjectPtr<UVoxelInstancedCollisionComponent>& Component : Components)
+			{
+				Component->CreateAllBodies();
+			}
+		}
+		return;
+	}
+	bWasLazy = true;
+
+	if (Components.Num() == 0)
+	{
+		return;
+	}
+
+	const TVoxelArray<FVector> Sources = GatherSources();
+
+	// Round robin so that all components get updated even if the budget is spent every frame
+	int32 Budget = FMath::Max(GVoxelFoliageLazyCollisionMaxChangesPerFrame, 1);
+	for (int32 Iteration = 0; Iteration < Components.Num() && Budget > 0; Iteration++)
+	{
+		NextComponentIndex = NextComponentIndex % Components.Num();
+		UVoxelInstancedCollisionComponent* Component = Components[NextComponentIndex].Get();
+		NextComponentIndex++;
+
+		Budget -= Component->UpdateLazyBodies(Sources, Budget);
+	}
+}
+
+TVoxelArray<FVector> FVoxelInstancedCollisionManager::GatherSources() const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	UWorld* World = GetWorld();
+
+	TVoxelArray<FVector> Sources;
+	for (TActorIterator<APawn> It(World); It; ++It)
+	{
+		Sources.Add(It->GetActorLocation());
+	}
+
+	ForEachObjectOfClass<UVoxelInvokerComponent>([&](const UVoxelInvokerComponent* Invoker)
+	{
+		if (Invoker->GetWorld() != World ||
+			!Invoker->bEnabled)
+		{
+			return;
+		}
+
+		Sources.Add(Invoker->GetComponentLocation());
+	});
+
+	for (const TWeakObjectPtr<const AActor>& WeakActor : Actors)
+	{
+		if (const AActor* Actor = WeakActor.Get())
+		{
+			Sources.Add(Actor->GetActorLocation());
+		}
+	}
+
+	return Sources;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 UVoxelInstancedCollisionComponent::UVoxelInstancedCollisionComponent()
 {
 	SetGenerateOverlapEvents(false);
@@ -294,6 +421,8 @@ void UVoxelInstancedCollisionComponent::SetData(const TSharedRef<FVoxelInstanced
 	ensure(!OverrideChunkDelegatePtr);
 	OverrideChunkDelegatePtr = MakeSharedVoid();
 
+	FVoxelInstancedCollisionManager::Get(GetWorld())->AddComponent(*this);
+
 	{
 		VOXEL_SCOPE_LOCK(OverrideChunk->CriticalSection);
 
@@ -375,10 +504,210 @@ void UVoxelInstancedCollisionComponent::ReturnToPool()
 	OverrideChunk = {};
 	OverrideChunkDelegatePtr = {};
 
+	// Stale components are also removed by the manager tick
+	if (const UWorld* World = GetWorld())
+	{
+		FVoxelInstancedCollisionManager::Get(World)->RemoveComponent(*this);
+	}
+
+	LazySources.Empty();
+	bHasLazyBodyIndices = false;
+	LazyBodyIndices.Empty();
+	bLazySpatialIndexDirty = true;
+	LazyCellToIndices.Empty();
+
 	MarkRenderStateDirty();
 }
 
 void UVoxelInstancedCollisionComponent::Update()
+{
+	UpdateImpl(true);
+}
+
+int32 UVoxelInstancedCollisionComponent::UpdateLazyBodies(
+	const TConstVoxelArrayView<FVector> Sources,
+	const int32 MaxChanges)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (!ensure(Data) ||
+		!ensure(OverrideChunk))
+	{
+		return 0;
+	}
+
+	const float Radius = FMath::Max(GVoxelFoliageLazyCollisionRadius, 1.f);
+	// Release bodies further than they are created to not thrash at the boundary
+	const float ReleaseRadius = Radius * 1.25f;
+
+	int32 NumChanges = 0;
+	{
+		VOXEL_SCOPE_LOCK(Data->CriticalSection);
+		FVoxelInstancedCollisionDataImpl& DataImpl = Data->GetDataImpl_RequiresLock();
+
+		const FBox Bounds = Data->ChunkRef.GetBounds().ToFBox();
+
+		if (!bHasLazyBodyIndices)
+		{
+			VOXEL_SCOPE_COUNTER("Gather existing bodies");
+
+			bHasLazyBodyIndices = true;
+			for (int32 Index = 0; Index < DataImpl.InstanceBodies.Num(); Index++)
+			{
+				if (DataImpl.InstanceBodies[Index])
+				{
+					LazyBodyIndices.Add(Index);
+				}
+			}
+		}
+
+		LazySources.Reset();
+		for (const FVector& Source : Sources)
+		{
+			if (Bounds.ComputeSquaredDistanceToPoint(Source) <= FMath::Square(ReleaseRadius))
+			{
+				LazySources.Add(Source);
+			}
+		}
+
+		if (LazySources.Num() == 0 &&
+			LazyBodyIndices.Num() == 0)
+		{
+			return 0;
+		}
+
+		{
+			VOXEL_SCOPE_COUNTER("Release bodies");
+
+			TVoxelArray<int32> IndicesToRemove;
+			for (const int32 Index : LazyBodyIndices)
+			{
+				if (!DataImpl.InstanceBodies.IsValidIndex(Index) ||
+					!DataImpl.InstanceBodies[Index])
+				{
+					// Released by UpdateImpl, eg hidden
+					IndicesToRemove.Add(Index);
+					continue;
+				}
+
+				if (NumChanges >= MaxChanges ||
+					IsNearLazySource(FVector(DataImpl.Transforms[Index].GetTranslation()), ReleaseRadius))
+				{
+					continue;
+				}
+
+				DataImpl.InstanceBodiesToDelete.Add(MoveTemp(DataImpl.InstanceBodies[Index]));
+				IndicesToRemove.Add(Index);
+				NumChanges++;
+			}
+
+			for (const int32 Index : IndicesToRemove)
+			{
+				LazyBodyIndices.Remove(Index);
+			}
+		}
+
+		if (LazySources.Num() > 0 &&
+			NumChanges < MaxChanges)
+		{
+			VOXEL_SCOPE_COUNTER("Find bodies to create");
+
+			if (bLazySpatialIndexDirty ||
+				LazyCellSize != Radius)
+			{
+				BuildLazySpatialIndex(DataImpl, Radius);
+			}
+
+			VOXEL_SCOPE_LOCK(OverrideChunk->CriticalSection);
+
+			TVoxelSet<int32> IndicesToCreate;
+			for (const FVector& Source : LazySources)
+			{
+				const FIntVector Min = FVoxelUtilities::FloorToInt((Source - Radius) / LazyCellSize);
+				const FIntVector Max = FVoxelUtilities::FloorToInt((Source + Radius) / LazyCellSize);
+
+				for (int32 X = Min.X; X <= Max.X; X++)
+				{
+					for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+					{
+						for (int32 Z = Min.Z; Z <= Max.Z; Z++)
+						{
+							const TVoxelArray<int32>* Indices = LazyCellToIndices.Find(FIntVector(X, Y, Z));
+							if (!Indices)
+							{
+								continue;
+							}
+
+							for (const int32 Index : *Indices)
+							{
+								if (NumChanges >= MaxChanges)
+								{
+									break;
+								}
+
+								const FVoxelPointId PointId = DataImpl.PointIds[Index];
+								if (!PointId.IsValid() ||
+									DataImpl.InstanceBodies[Index] ||
+									IndicesToCreate.Contains(Index) ||
+									OverrideChunk->PointIdsToHide_RequiresLock.Contains(PointId) ||
+									FVector::DistSquared(FVector(DataImpl.Transforms[Index].GetTranslation()), Source) > FMath::Square(Radius))
+								{
+									continue;
+								}
+
+								IndicesToCreate.Add(Index);
+								DataImpl.InstanceBodiesToUpdate.Add(Index);
+								NumChanges++;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (NumChanges > 0)
+	{
+		UpdateImpl(false);
+	}
+
+	return NumChanges;
+}
+
+void UVoxelInstancedCollisionComponent::CreateAllBodies()
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (!Data)
+	{
+		return;
+	}
+
+	bHasLazyBodyIndices = false;
+	LazyBodyIndices.Empty();
+
+	{
+		VOXEL_SCOPE_LOCK(Data->CriticalSection);
+		FVoxelInstancedCollisionDataImpl& DataImpl = Data->GetDataImpl_RequiresLock();
+
+		for (int32 Index = 0; Index < DataImpl.PointIds.Num(); Index++)
+		{
+			if (DataImpl.PointIds[Index].IsValid() &&
+				!DataImpl.InstanceBodies[Index])
+			{
+				DataImpl.InstanceBodiesToUpdate.Add(Index);
+			}
+		}
+	}
+
+	UpdateImpl(false);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void UVoxelInstancedCollisionComponent::UpdateImpl(const bool bTransformsChanged)
 {
 	VOXEL_FUNCTION_COUNTER();
 
@@ -395,6 +724,11 @@ void UVoxelInstancedCollisionComponent::Update()
 
 	NumInstances = DataImpl.PointIdToIndex.Num();
 
+	if (bTransformsChanged)
+	{
+		bLazySpatialIndexDirty = true;
+	}
+
 	if (DataImpl.InstanceBodiesToUpdate.Num() == 0 &&
 		DataImpl.InstanceBodiesToDelete.Num() == 0)
 	{
@@ -455,8 +789,20 @@ void UVoxelInstancedCollisionComponent::Update()
 				continue;
 			}
 
+			// Will be created by UpdateLazyBodies once something gets close enough
+			if (GVoxelFoliageLazyCollision &&
+				!IsNearLazySource(Transform.GetLocation(), GVoxelFoliageLazyCollisionRadius))
+			{
+				continue;
+			}
+
 			Body = MakeBodyInstance(Index);
 
+			if (bHasLazyBodyIndices)
+			{
+				LazyBodyIndices.Add(Index);
+			}
+
 			checkVoxelSlow(DataImpl.CriticalSection.IsLocked());
 			DataImpl.AllBodyInstances_RequiresLock.Add(Body);
 
@@ -482,6 +828,40 @@ void UVoxelInstancedCollisionComponent::Update()
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+bool UVoxelInstancedCollisionComponent::IsNearLazySource(const FVector& Position, const float Radius) const
+{
+	for (const FVector& Source : LazySources)
+	{
+		if (FVector::DistSquared(Position, Source) <= FMath::Square(Radius))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UVoxelInstancedCollisionComponent::BuildLazySpatialIndex(const FVoxelInstancedCollisionDataImpl& DataImpl, const float CellSize)
+{
+	VOXEL_SCOPE_COUNTER_FORMAT("BuildLazySpatialIndex Num=%d", DataImpl.PointIds.Num());
+
+	bLazySpatialIndexDirty = false;
+	LazyCellSize = CellSize;
+	LazyCellToIndices.Reset();
+
+	for (int32 Index = 0; Index < DataImpl.PointIds.Num(); Index++)
+	{
+		const FTransform3f& Transform = DataImpl.Transforms[Index];
+		if (!DataImpl.PointIds[Index].IsValid() ||
+			Transform.GetScale3D().IsNearlyZero())
+		{
+			continue;
+		}
+
+		const FIntVector Cell = FVoxelUtilities::FloorToInt(FVector(Transform.GetTranslation()) / CellSize);
+		LazyCellToIndices.FindOrAdd(Cell).Add(Index);
+	}
+}
+
 TSharedRef<FBodyInstance> UVoxelInstancedCollisionComponent::MakeBodyInstance(const int32 Index) const
 {
 	const TSharedRef<FBodyInstance> Body = TSharedPtr<FBodyInstance>(
@@ -14,6 +14,16 @@ VOXEL_CONSOLE_VARIABLE(
 	"voxel.MaxInstancesToAddAtOnce",
 	"");
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELSPAWNER_API, int32, GVoxelRenderMeshChunkMinParallelPoints, 8192,
+	"voxel.spawner.RenderMeshChunkMinParallelPoints",
+	"Render mesh chunks will diff & build their instances in parallel if they have more points than this");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELSPAWNER_API, float, GVoxelRenderMeshChunkGameThreadBudget, 2.f,
+	"voxel.spawner.RenderMeshChunkGameThreadBudget",
+	"Time in milliseconds render mesh chunks can spend applying their updates on the game thread each frame. Remaining updates are applied in order on the next frames. 0 to disable");
+
 DEFINE_VOXEL_INSTANCE_COUNTER(FVoxelRenderMeshChunk);
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -63,6 +73,8 @@ void FVoxelRenderMeshChunk::Destroy(FVoxelRuntime& Runtime)
 	VOXEL_SCOPE_LOCK(CriticalSection);
 	check(IsInGameThread());
 
+	GameThreadUpdates.Empty();
+
 	for (const auto& It : MeshToComponents_RequiresLock)
 	{
 		Runtime.DestroyComponent(It.Value->InstancedMeshComponent);
@@ -114,22 +126,55 @@ void FVoxelRenderMeshChunk::UpdatePoints(const TSharedRef<const FVoxelPointSet>&
 	FindVoxelPointSetOptionalAttribute(*NewPoints, FVoxelPointAttributes::Scale, FVoxelVectorBuffer, NewScales, FVector::OneVector);
 	const TVoxelArray<FVoxelFloatBuffer> NewCustomDatas = NewPoints->FindCustomDatas(GetNodeRef());
 
-	TVoxelAddOnlyMap<FVoxelPointId, int32> NewPointIdToIndex;
+	const int32 NumPoints = NewPoints->Num();
+	const EParallelForFlags ParallelForFlags = NumPoints > GVoxelRenderMeshChunkMinParallelPoints ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread;
+
+	TVoxelStaticArray<TVoxelArray<int32>, NumPointIdShards> ShardToIndices;
 	{
-		VOXEL_SCOPE_COUNTER("PointIdToIndex");
+		VOXEL_SCOPE_COUNTER("ShardToIndices");
+
+		for (TVoxelArray<int32>& Indices : ShardToIndices)
+		{
+			Indices.Reserve(NumPoints / NumPointIdShards);
+		}
+
+		for (int32 Index = 0; Index < NumPoints; Index++)
+		{
+			ShardToIndices[GetPointIdShard(NewIds[Index])].Add(Index);
+		}
+	}
+
+	// -1 if the point is new, -2 if its id is a duplicate
+	TVoxelArray<int32> NewToOldIndex;
+	FVoxelUtilities::SetNumFast(NewToOldIndex, NumPoints);
 
-		NewPointIdToIndex.Reserve(NewPoints->Num());
+	FPointIdToIndexShards NewPointIdToIndex;
+	{
+		VOXEL_SCOPE_COUNTER("PointIdToIndex");
 
-		for (int32 Index = 0; Index < NewPoints->Num(); Index++)
+		TVoxelAtomic<bool> bHasDuplicates = false;
+		ParallelFor(NumPointIdShards, [&](const int32 Shard)
 		{
-			const FVoxelPointId PointId = NewIds[Index];
-			if (NewPointIdToIndex.Contains(PointId))
+			TVoxelAddOnlyMap<FVoxelPointId, int32>& PointIdToIndex = NewPointIdToIndex[Shard];
+			PointIdToIndex.Reserve(ShardToIndices[Shard].Num());
+
+			for (const int32 Index : ShardToIndices[Shard])
 			{
-				VOXEL_MESSAGE(Error, "{0}: PointIds duplicates!", this);
-				continue;
+				const FVoxelPointId PointId = NewIds[Index];
+				if (PointIdToIndex.Contains(PointId))
+				{
+					bHasDuplicates.Store(true);
+					NewToOldIndex[Index] = -2;
+					continue;
+				}
+
+				PointIdToIndex.Add_CheckNew_NoRehash(PointId, Index);
 			}
+		}, ParallelForFlags);
 
-			NewPointIdToIndex.Add_CheckNew_NoRehash(PointId, Index);
+		if (bHasDuplicates.Load())
+		{
+			VOXEL_MESSAGE(Error, "{0}: PointIds duplicates!", this);
 		}
 	}
 
@@ -137,7 +182,10 @@ void FVoxelRenderMeshChunk::UpdatePoints(const TSharedRef<const FVoxelPointSet>&
 
 	ON_SCOPE_EXIT
 	{
-		PointIdToIndex_RequiresLock = MoveTemp(NewPointIdToIndex);
+		for (int32 Shard = 0; Shard < NumPointIdShards; Shard++)
+		{
+			PointIdToIndex_RequiresLock[Shard] = MoveTemp(NewPointIdToIndex[Shard]);
+		}
 
 		const TSharedRef<FVoxelPointSet> CleanNewPoints = MakeVoxelShared<FVoxelPointSet>();
 		if (NewPoints->Num() > 0)
@@ -180,97 +228,142 @@ void FVoxelRenderMeshChunk::UpdatePoints(const TSharedRef<const FVoxelPointSet>&
 	}
 	const int32 NumCustomDatas = NewCustomDatas.Num();
 
-	TVoxelArray<int32> NewToOldIndex;
-	FVoxelUtilities::SetNumFast(NewToOldIndex, NewPointIdToIndex.Num());
+	TVoxelStaticArray<TVoxelArray<FVoxelPointId>, NumPointIdShards> ShardToRemovedPointIds;
 	{
 		VOXEL_SCOPE_COUNTER("NewToOldIndex");
 
-		for (const auto& It : NewPointIdToIndex)
+		ParallelFor(NumPointIdShards, [&](const int32 Shard)
 		{
-			if (const int32* IndexPtr = PointIdToIndex_RequiresLock.Find(It.Key))
+			const TVoxelAddOnlyMap<FVoxelPointId, int32>& OldPointIdToIndex = PointIdToIndex_RequiresLock[Shard];
+			const TVoxelAddOnlyMap<FVoxelPointId, int32>& PointIdToIndex = NewPointIdToIndex[Shard];
+
+			for (const auto& It : PointIdToIndex)
 			{
-				NewToOldIndex[It.Value] = *IndexPtr;
+				if (const int32* IndexPtr = OldPointIdToIndex.Find(It.Key))
+				{
+					NewToOldIndex[It.Value] = *IndexPtr;
+				}
+				else
+				{
+					NewToOldIndex[It.Value] = -1;
+				}
 			}
-			else
+
+			for (const auto& It : OldPointIdToIndex)
 			{
-				NewToOldIndex[It.Value] = -1;
+				if (!PointIdToIndex.Contains(It.Key))
+				{
+					ShardToRemovedPointIds[Shard].Add(It.Key);
+				}
 			}
-		}
+		}, ParallelForFlags);
 	}
 
-	int32 NumNewInstances = 0;
-	TVoxelChunkedArray<FVoxelPointId> PointIdsToRemove;
-	TVoxelAddOnlyMap<FVoxelStaticMesh, TSharedPtr<FVoxelInstancedMeshData>> MeshToMeshData;
+	// Blocks stop early once there are too many changes for them to be applied incrementally
+	constexpr int32 BlockSize = 4096;
+	FThreadSafeCounter NumChangedPoints;
+	TVoxelArray<TVoxelArray<int32>> BlockToChangedIndices;
+	BlockToChangedIndices.SetNum(FVoxelUtilities::DivideCeil(NumPoints, BlockSize));
 	{
-		VOXEL_SCOPE_COUNTER("MeshToMeshData")
+		VOXEL_SCOPE_COUNTER("Find changed points");
 
-		for (int32 NewIndex = 0; NewIndex < NewToOldIndex.Num(); NewIndex++)
+		ParallelFor(BlockToChangedIndices.Num(), [&](const int32 Block)
 		{
-			const FVoxelStaticMesh Mesh = NewMeshes[NewIndex];
-			const FVector3f Position = NewPositions[NewIndex];
-			const FQuat4f Rotation = NewRotations[NewIndex];
-			const FVector3f Scale = NewScales[NewIndex];
-
-			const int32 OldIndex = NewToOldIndex[NewIndex];
-			if (OldIndex != -1)
+			if (NumChangedPoints.GetValue() > GVoxelMaxInstancesToAddAtOnce)
 			{
-				checkVoxelSlow(OldIds[OldIndex] == NewIds[NewIndex]);
+				return;
+			}
 
-				const FVoxelStaticMesh OldMesh = OldMeshes[OldIndex];
-				const FVector3f OldPosition = OldPositions[OldIndex];
-				const FQuat4f OldRotation = OldRotations[OldIndex];
-				const FVector3f OldScale = OldScales[OldIndex];
+			TVoxelArray<int32>& ChangedIndices = BlockToChangedIndices[Block];
 
-				if (OldMesh != Mesh)
+			const int32 EndIndex = FMath::Min((Block + 1) * BlockSize, NumPoints);
+			for (int32 NewIndex = Block * BlockSize; NewIndex < EndIndex; NewIndex++)
+			{
+				const int32 OldIndex = NewToOldIndex[NewIndex];
+				if (OldIndex == -2)
 				{
-					goto DifferentData;
+					continue;
 				}
 
-				if (OldPosition != Position ||
-					OldRotation != Rotation ||
-					OldScale != Scale)
+				if (OldIndex != -1)
 				{
-					goto DifferentData;
-				}
+					checkVoxelSlow(OldIds[OldIndex] == NewIds[NewIndex]);
 
-				for (int32 Index = 0; Index < NumCustomDatas; Index++)
-				{
-					if (OldCustomDatas[Index][OldIndex] != NewCustomDatas[Index][NewIndex])
+					bool bChanged =
+						OldMeshes[OldIndex] != NewMeshes[NewIndex] ||
+						OldPositions[OldIndex] != NewPositions[NewIndex] ||
+						OldRotations[OldIndex] != NewRotations[NewIndex] ||
+						OldScales[OldIndex] != NewScales[NewIndex];
+
+					for (int32 Index = 0; !bChanged && Index < NumCustomDatas; Index++)
+					{
+						bChanged = OldCustomDatas[Index][OldIndex] != NewCustomDatas[Index][NewIndex];
+					}
+
+					if (!bChanged)
 					{
-						goto DifferentData;
+						continue;
 					}
 				}
 
-				continue;
+				ChangedIndices.Add(NewIndex);
 
-			DifferentData:
-				PointIdsToRemove.Add(OldIds[OldIndex]);
+				if (ChangedIndices.Num() > GVoxelMaxInstancesToAddAtOnce)
+				{
+					break;
+				}
 			}
 
-			NumNewInstances++;
+			NumChangedPoints.Add(ChangedIndices.Num());
+		}, ParallelForFlags);
+	}
 
-			if (NumNewInstances > GVoxelMaxInstancesToAddAtOnce)
-			{
-				UpdatePoints_Hierarchical_AssumeLocked(NewPoints);
-				return;
-			}
+	if (NumChangedPoints.GetValue() > GVoxelMaxInstancesToAddAtOnce)
+	{
+		UpdatePoints_Hierarchical_AssumeLocked(NewPoints);
+		return;
+	}
 
-			const FVoxelPointId PointId = NewIds[NewIndex];
+	TVoxelChunkedArray<FVoxelPointId> PointIdsToRemove;
+	TVoxelAddOnlyMap<FVoxelStaticMesh, TSharedPtr<FVoxelInstancedMeshData>> MeshToMeshData;
+	{
+		VOXEL_SCOPE_COUNTER("MeshToMeshData")
 
-			TSharedPtr<FVoxelInstancedMeshData>& MeshData = MeshToMeshData.FindOrAdd(Mesh);
-			if (!MeshData)
+		for (const TVoxelArray<int32>& ChangedIndices : BlockToChangedIndices)
+		{
+			for (const int32 NewIndex : ChangedIndices)
 			{
-				MeshData = MakeVoxelShared<FVoxelInstancedMeshData>(Mesh, ChunkRef);
-				MeshData->NumCustomDatas = NumCustomDatas;
-				MeshData->CustomDatas_Transient.SetNum(NumCustomDatas);
-			}
+				const int32 OldIndex = NewToOldIndex[NewIndex];
+				if (OldIndex != -1)
+				{
+					PointIdsToRemove.Add(OldIds[OldIndex]);
+				}
 
-			MeshData->PointIds_Transient.Add(PointId);
-			MeshData->Transforms.Add(FTransform3f(Rotation, Position, Scale));
+				const FVoxelStaticMesh Mesh = NewMeshes[NewIndex];
 
-			for (int32 Index = 0; Index < NumCustomDatas; Index++)
+				TSharedPtr<FVoxelInstancedMeshData>& MeshData = MeshToMeshData.FindOrAdd(Mesh);
+				if (!MeshData)
+				{
+					MeshData = MakeVoxelShared<FVoxelInstancedMeshData>(Mesh, ChunkRef);
+					MeshData->NumCustomDatas = NumCustomDatas;
+					MeshData->CustomDatas_Transient.SetNum(NumCustomDatas);
+				}
+
+				MeshData->PointIds_Transient.Add(NewIds[NewIndex]);
+				MeshData->Transforms.Add(FTransform3f(NewRotations[NewIndex], NewPositions[NewIndex], NewScales[NewIndex]));
+
+				for (int32 Index = 0; Index < NumCustomDatas; Index++)
+				{
+					MeshData->CustomDatas_Transient[Index].Add(NewCustomDatas[Index][NewIndex]);
+				}
+			}
+		}
+
+		for (const TVoxelArray<FVoxelPointId>& RemovedPointIds : ShardToRemovedPointIds)
+		{
+			for (const FVoxelPointId PointId : RemovedPointIds)
 			{
-				MeshData->CustomDatas_Transient[Index].Add(NewCustomDatas[Index][NewIndex]);
+				PointIdsToRemove.Add(PointId);
 			}
 		}
 	}
@@ -280,17 +373,9 @@ void FVoxelRenderMeshChunk::UpdatePoints(const TSharedRef<const FVoxelPointSet>&
 	{
 		VOXEL_SCOPE_COUNTER("PointIdsToRemove");
 
-		for (const auto& It : PointIdToIndex_RequiresLock)
-		{
-			if (!NewPointIdToIndex.Contains(It.Key))
-			{
-				PointIdsToRemove.Add(It.Key);
-			}
-		}
-
 		for (const FVoxelPointId PointId : PointIdsToRemove)
 		{
-			const int32* OldIndexPtr = PointIdToIndex_RequiresLock.Find(PointId);
+			const int32* OldIndexPtr = PointIdToIndex_RequiresLock[GetPointIdShard(PointId)].Find(PointId);
 			if (!ensure(OldIndexPtr))
 			{
 				continue;
@@ -379,7 +464,7 @@ void FVoxelRenderMeshChunk::UpdatePoints(const TSharedRef<const FVoxelPointSet>&
 		It.Value->Build();
 	}
 
-	FVoxelUtilities::RunOnGameThread_Async(MakeWeakPtrLambda(this, [
+	EnqueueGameThreadUpdate([
 		this,
 		MeshToMeshData = MoveTemp(MeshToMeshData),
 		MeshToInstancedInstancesToRemove = MoveTemp(MeshToInstancedInstancesToRemove),
@@ -469,7 +554,7 @@ void FVoxelRenderMeshChunk::UpdatePoints(const TSharedRef<const FVoxelPointSet>&
 			Component->InstanceStartCullDistance = RenderDistance - FadeDistance;
 			Component->InstanceEndCullDistance = RenderDistance;
 		}
-	}));
+	});
 
 	// CriticalSection will be locked when PointIdsToHide_RequiresLock will be accessed
 	UpdatePointOverrides_AssumeLocked(OverrideChunk->PointIdsToHide_RequiresLock);
@@ -480,9 +565,25 @@ void FVoxelRenderMeshChunk::UpdatePoints_Hierarchical_AssumeLocked(const TShared
 	VOXEL_FUNCTION_COUNTER();
 	check(CriticalSection.IsLocked());
 
+	// Keep the previous hierarchical datas so that their cluster trees can be reused
+	struct FPreviousHierarchicalData
+	{
+		TSharedPtr<const FVoxelHierarchicalMeshData> MeshData;
+		TVoxelAddOnlyMap<FVoxelPointId, FIndexInfo> PointIdToIndexInfo;
+	};
+	TVoxelAddOnlyMap<FVoxelStaticMesh, FPreviousHierarchicalData> MeshToPreviousHierarchicalData;
+
 	// Clear existing data
 	for (auto& It : MeshToComponents_RequiresLock)
 	{
+		if (It.Value->HierarchicalMeshData)
+		{
+			FPreviousHierarchicalData& PreviousData = MeshToPreviousHierarchicalData.Add_CheckNew(It.Key);
+			PreviousData.MeshData = MoveTemp(It.Value->HierarchicalMeshData);
+			PreviousData.PointIdToIndexInfo = MoveTemp(It.Value->PointIdToIndexInfo);
+		}
+
+		It.Value->HierarchicalMeshData.Reset();
 		It.Value->PointIdToIndexInfo.Reset();
 		It.Value->FreeInstancedIndices.Reset();
 		It.Value->NumInstancedInstances = 0;
@@ -490,13 +591,13 @@ void FVoxelRenderMeshChunk::UpdatePoints_Hierarchical_AssumeLocked(const TShared
 
 	if (Points->Num() == 0)
 	{
-		FVoxelUtilities::RunOnGameThread_Async(MakeWeakPtrLambda(this, [this]
-		{
-			SetHierarchicalDatas_GameThread({});
-		}));
+		SetHierarchicalDatas_AssumeLocked({});
 		return;
 	}
 
+	const int32 NumPoints = Points->Num();
+	const EParallelForFlags ParallelForFlags = NumPoints > GVoxelRenderMeshChunkMinParallelPoints ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread;
+
 	FindVoxelPointSetAttributeVoid(*Points, FVoxelPointAttributes::Mesh, FVoxelStaticMeshBuffer, Meshes);
 
 	FVoxelInt32Buffer MeshIndices;
@@ -511,183 +612,310 @@ void FVoxelRenderMeshChunk::UpdatePoints_Hierarchical_AssumeLocked(const TShared
 		}
 	}
 
+	// Index of each point in its mesh data, so that mesh datas can be filled in parallel
+	TVoxelArray<int32> PointToMeshDataIndex;
+	FVoxelUtilities::SetNumFast(PointToMeshDataIndex, NumPoints);
+
 	TVoxelArray<int32> MeshIndexToNumInstances;
 	MeshIndexToNumInstances.SetNum(MeshPalette.Num());
 	{
 		VOXEL_SCOPE_COUNTER("MeshIndexToNumInstances");
 
-		for (int32 Index = 0; Index < Points->Num(); Index++)
+		for (int32 Index = 0; Index < NumPoints; Index++)
 		{
-			MeshIndexToNumInstances[MeshIndices[Index]]++;
+			PointToMeshDataIndex[Index] = MeshIndexToNumInstances[MeshIndices[Index]]++;
 		}
 	}
 
-	TVoxelArray<TSharedPtr<FVoxelHierarchicalMeshData>> HierarchicalMeshDatas;
-	for (const FVoxelStaticMesh& Mesh : MeshPalette)
-	{
-		HierarchicalMeshDatas.Add(MakeVoxelShared<FVoxelHierarchicalMeshData>(Mesh, ChunkRef));
-	}
+	const TVoxelArray<FVoxelFloatBuffer> CustomDatas = Points->FindCustomDatas(GetNodeRef());
 
+	TVoxelArray<TSharedPtr<FVoxelHierarchicalMeshData>> HierarchicalMeshDatas;
+	for (int32 MeshIndex = 0; MeshIndex < MeshPalette.Num(); MeshIndex++)
 	{
-		VOXEL_SCOPE_COUNTER("PointIds & Transforms");
+		const TSharedRef<FVoxelHierarchicalMeshData> MeshData = MakeVoxelShared<FVoxelHierarchicalMeshData>(MeshPalette[MeshIndex], ChunkRef);
+		const int32 NumInstances = MeshIndexToNumInstances[MeshIndex];
 
-		FindVoxelPointSetAttributeVoid(*Points, FVoxelPointAttributes::Id, FVoxelPointIdBuffer, Ids);
+		FVoxelUtilities::SetNumFast(MeshData->PointIds_Transient, NumInstances);
+		FVoxelUtilities::SetNumFast(MeshData->Transforms, NumInstances);
 
-		for (int32 MeshIndex = 0; MeshIndex < HierarchicalMeshDatas.Num(); MeshIndex++)
+		MeshData->NumCustomDatas = CustomDatas.Num();
+		MeshData->CustomDatas_Transient.SetNum(CustomDatas.Num());
+		for (TVoxelArray<float>& CustomData : MeshData->CustomDatas_Transient)
 		{
-			FVoxelHierarchicalMeshData& MeshData = *HierarchicalMeshDatas[MeshIndex];
-			const int32 NumInstances = MeshIndexToNumInstances[MeshIndex];
-
-			MeshData.PointIds_Transient.Reserve(NumInstances);
-			MeshData.Transforms.Reserve(NumInstances);
+			FVoxelUtilities::SetNumFast(CustomData, NumInstances);
 		}
 
-		FindVoxelPointSetAttributeVoid(*Points, FVoxelPointAttributes::Position, FVoxelVectorBuffer, Positions);
-		FindVoxelPointSetOptionalAttribute(*Points, FVoxelPointAttributes::Rotation, FVoxelQuaternionBuffer, Rotations, FQuat::Identity);
-		FindVoxelPointSetOptionalAttribute(*Points, FVoxelPointAttributes::Scale, FVoxelVectorBuffer, Scales, FVector::OneVector);
-
-		for (int32 Index = 0; Index < Points->Num(); Index++)
-		{
-			FVoxelHierarchicalMeshData& MeshData = *HierarchicalMeshDatas[MeshIndices[Index]].Get();
-			MeshData.PointIds_Transient.Add_NoGrow(Ids[Index]);
-			MeshData.Transforms.Add_NoGrow(FTransform3f(Rotations[Index], Positions[Index], Scales[Index]));
-		}
+		HierarchicalMeshDatas.Add(MeshData);
 	}
 
 	{
-		VOXEL_SCOPE_COUNTER("CustomDatas");
+		VOXEL_SCOPE_COUNTER("PointIds & Transforms & CustomDatas");
 
-		const TVoxelArray<FVoxelFloatBuffer> CustomDatas = Points->FindCustomDatas(GetNodeRef());
+		FindVoxelPointSetAttributeVoid(*Points, FVoxelPointAttributes::Id, FVoxelPointIdBuffer, Ids);
+		FindVoxelPointSetAttributeVoid(*Points, FVoxelPointAttributes::Position, FVoxelVectorBuffer, Positions);
+		FindVoxelPointSetOptionalAttribute(*Points, FVoxelPointAttributes::Rotation, FVoxelQuaternionBuffer, Rotations, FQuat::Identity);
+		FindVoxelPointSetOptionalAttribute(*Points, FVoxelPointAttributes::Scale, FVoxelVectorBuffer, Scales, FVector::OneVector);
 
-		for (int32 MeshIndex = 0; MeshIndex < HierarchicalMeshDatas.Num(); MeshIndex++)
+		constexpr int32 BlockSize = 4096;
+		ParallelFor(FVoxelUtilities::DivideCeil(NumPoints, BlockSize), [&](const int32 Block)
 		{
-			FVoxelHierarchicalMeshData& MeshData = *HierarchicalMeshDatas[MeshIndex];
-			const int32 NumInstances = MeshIndexToNumInstances[MeshIndex];
-
-			MeshData.NumCustomDatas = CustomDatas.Num();
-			MeshData.CustomDatas_Transient.SetNum(CustomDatas.Num());
-			for (TVoxelArray<float>& CustomData : MeshData.CustomDatas_Transient)
+			const int32 EndIndex = FMath::Min((Block + 1) * BlockSize, NumPoints);
+			for (int32 Index = Block * BlockSize; Index < EndIndex; Index++)
 			{
-				CustomData.Reserve(NumInstances);
-			}
-		}
+				FVoxelHierarchicalMeshData& MeshData = *HierarchicalMeshDatas[MeshIndices[Index]].Get();
+				const int32 MeshDataIndex = PointToMeshDataIndex[Index];
 
-		for (int32 CustomDataIndex = 0; CustomDataIndex < CustomDatas.Num(); CustomDataIndex++)
-		{
-			const FVoxelFloatBuffer& CustomDataBuffer = CustomDatas[CustomDataIndex];
+				MeshData.PointIds_Transient[MeshDataIndex] = Ids[Index];
+				MeshData.Transforms[MeshDataIndex] = FTransform3f(Rotations[Index], Positions[Index], Scales[Index]);
 
-			for (int32 Index = 0; Index < Points->Num(); Index++)
-			{
-				FVoxelHierarchicalMeshData& MeshData = *HierarchicalMeshDatas[MeshIndices[Index]].Get();
-				MeshData.CustomDatas_Transient[CustomDataIndex].Add_NoGrow(CustomDataBuffer[Index]);
+				for (int32 CustomDataIndex = 0; CustomDataIndex < CustomDatas.Num(); CustomDataIndex++)
+				{
+					MeshData.CustomDatas_Transient[CustomDataIndex][MeshDataIndex] = CustomDatas[CustomDataIndex][Index];
+				}
 			}
-		}
+		}, ParallelForFlags);
 	}
 
+	TVoxelArray<FComponents*> MeshIndexToComponents;
 	for (const TSharedPtr<FVoxelHierarchicalMeshData>& HierarchicalMeshData : HierarchicalMeshDatas)
 	{
-		VOXEL_SCOPE_COUNTER("PointIdToIndexInfo");
-
 		TSharedPtr<FComponents>& ComponentsPtr = MeshToComponents_RequiresLock.FindOrAdd(HierarchicalMeshData->Mesh);
 		if (!ComponentsPtr)
 		{
 			ComponentsPtr = MakeVoxelShared<FComponents>();
 		}
-		FComponents& Components = *ComponentsPtr;
+		MeshIndexToComponents.Add(ComponentsPtr.Get());
+	}
+
+	// Each mesh has its own components, they can be processed independently
+	ParallelFor(HierarchicalMeshDatas.Num(), [&](const int32 MeshIndex)
+	{
+		FVoxelHierarchicalMeshData& HierarchicalMeshData = *HierarchicalMeshDatas[MeshIndex];
+		FComponents& Components = *MeshIndexToComponents[MeshIndex];
 
-		ensure(Components.PointIdToIndexInfo.Num() == 0);
-		Components.PointIdToIndexInfo.Reserve(HierarchicalMeshData->Num());
+		const FPreviousHierarchicalData* PreviousData = MeshToPreviousHierarchicalData.Find(HierarchicalMeshData.Mesh);
 
-		const TVoxelArray<FVoxelPointId>& PointIds = HierarchicalMeshData->PointIds_Transient;
-		for (int32 Index = 0; Index < PointIds.Num(); Index++)
+		// Index of each instance in the previous mesh data, -1 if new
+		TVoxelArray<int32> PreviousIndices;
+		if (PreviousData)
 		{
-			const FVoxelPointId PointId = PointIds[Index];
-			FIndexInfo& IndexInfo = Components.PointIdToIndexInfo.FindOrAdd(PointId);
-			if (!ensureVoxelSlow(!IndexInfo.bIsValid))
+			FVoxelUtilities::SetNumFast(PreviousIndices, HierarchicalMeshData.Num());
+		}
+
+		{
+			VOXEL_SCOPE_COUNTER("PointIdToIndexInfo");
+
+			ensure(Components.PointIdToIndexInfo.Num() == 0);
+			Components.PointIdToIndexInfo.Reserve(HierarchicalMeshData.Num());
+
+			const TVoxelArray<FVoxelPointId>& PointIds = HierarchicalMeshData.PointIds_Transient;
+			for (int32 Index = 0; Index < PointIds.Num(); Index++)
 			{
-				continue;
+				if (PreviousData)
+				{
+					PreviousIndices[Index] = -1;
+				}
+
+				const FVoxelPointId PointId = PointIds[Index];
+				FIndexInfo& IndexInfo = Components.PointIdToIndexInfo.FindOrAdd(PointId);
+				if (!ensureVoxelSlow(!IndexInfo.bIsValid))
+				{
+					continue;
+				}
+
+				IndexInfo.bIsValid = true;
+				IndexInfo.bIsHierarchical = true;
+				IndexInfo.Index = Index;
+
+				if (!PreviousData)
+				{
+					continue;
+				}
+
+				// Points moved to the instanced component are not in the previous tree anymore
+				const FIndexInfo* PreviousIndexInfo = PreviousData->PointIdToIndexInfo.Find(PointId);
+				if (PreviousIndexInfo &&
+					PreviousIndexInfo->bIsValid &&
+					PreviousIndexInfo->bIsHierarchical)
+				{
+					PreviousIndices[Index] = PreviousIndexInfo->Index;
+				}
 			}
+		}
 
-			IndexInfo.bIsValid = true;
-			IndexInfo.bIsHierarchical = true;
-			IndexInfo.Index = Index;
+		if (PreviousData)
+		{
+			HierarchicalMeshData.Build(*PreviousData->MeshData, PreviousIndices);
+		}
+		else
+		{
+			HierarchicalMeshData.Build();
 		}
-	}
 
-	for (const TSharedPtr<FVoxelHierarchicalMeshData>& HierarchicalMeshData : HierarchicalMeshDatas)
-	{
-		HierarchicalMeshData->Build();
-	}
+		Components.HierarchicalMeshData = HierarchicalMeshDatas[MeshIndex];
+	}, ParallelForFlags);
 
-	FVoxelUtilities::RunOnGameThread_Async(MakeWeakPtrLambda(this, [this, HierarchicalMeshDatas]
-	{
-		SetHierarchicalDatas_GameThread(HierarchicalMeshDatas);
-	}));
+	SetHierarchicalDatas_AssumeLocked(HierarchicalMeshDatas);
 
 	// CriticalSection will be locked when PointIdsToHide_RequiresLock will be accessed
 	UpdatePointOverrides_AssumeLocked(OverrideChunk->PointIdsToHide_RequiresLock);
 }
 
-void FVoxelRenderMeshChunk::SetHierarchicalDatas_GameThread(
+void FVoxelRenderMeshChunk::SetHierarchicalDatas_AssumeLocked(
 	const TVoxelArray<TSharedPtr<FVoxelHierarchicalMeshData>>& NewHierarchicalMeshDatas)
 {
 	VOXEL_FUNCTION_COUNTER();
-	ensure(IsInGameThread());
+	checkVoxelSlow(CriticalSection.IsLocked());
 
-	const TSharedPtr<FVoxelRuntime> Runtime = GetRuntime();
-	if (!ensure(Runtime))
+	TVoxelSet<FVoxelStaticMesh> NewMeshes;
+	for (const TSharedPtr<FVoxelHierarchicalMeshData>& HierarchicalData : NewHierarchicalMeshDatas)
 	{
-		return;
+		if (HierarchicalData->Mesh.StaticMesh.IsValid())
+		{
+			NewMeshes.Add(HierarchicalData->Mesh);
+		}
 	}
 
-	VOXEL_SCOPE_LOCK(CriticalSection);
-
-	// Clear existing meshes
-	for (const auto& It : MeshToComponents_RequiresLock)
+	// Clear meshes that are not used anymore
+	EnqueueGameThreadUpdate([this, NewMeshes = MoveTemp(NewMeshes)]
 	{
-		ensure(It.Value->FreeInstancedIndices.Num() == 0);
-		ensure(It.Value->NumInstancedInstances == 0);
+		VOXEL_SCOPE_COUNTER("Clear meshes");
+		VOXEL_SCOPE_LOCK(CriticalSection);
 
-		if (UVoxelInstancedMeshComponent* Component = It.Value->InstancedMeshComponent.Get())
-		{
-			Component->ClearInstances();
-		}
-		if (UVoxelHierarchicalMeshComponent* Component = It.Value->HierarchicalMeshComponent.Get())
+		for (const auto& It : MeshToComponents_RequiresLock)
 		{
-			Component->ClearInstances();
+			if (NewMeshes.Contains(It.Key))
+			{
+				continue;
+			}
+
+			if (UVoxelInstancedMeshComponent* Component = It.Value->InstancedMeshComponent.Get())
+			{
+				Component->ClearInstances();
+			}
+			if (UVoxelHierarchicalMeshComponent* Component = It.Value->HierarchicalMeshComponent.Get())
+			{
+				Component->ClearInstances();
+			}
 		}
-	}
+	});
 
+	// Then set each mesh separately so that big chunks can be spread over several frames
 	for (const TSharedPtr<FVoxelHierarchicalMeshData>& HierarchicalData : NewHierarchicalMeshDatas)
 	{
-		const FVoxelStaticMesh Mesh = HierarchicalData->Mesh;
-		if (!Mesh.StaticMesh.IsValid())
+		if (!HierarchicalData->Mesh.StaticMesh.IsValid())
 		{
 			continue;
 		}
 
-		const TSharedPtr<FComponents> Components = MeshToComponents_RequiresLock.FindRef(Mesh);
-		if (!ensure(Components))
+		EnqueueGameThreadUpdate([this, HierarchicalData]
 		{
-			continue;
-		}
+			VOXEL_SCOPE_COUNTER("Set mesh data");
 
-		UVoxelHierarchicalMeshComponent* Component = Components->HierarchicalMeshComponent.Get();
-		if (!Component)
+			const TSharedPtr<FVoxelRuntime> Runtime = GetRuntime();
+			if (!ensure(Runtime))
+			{
+				return;
+			}
+
+			VOXEL_SCOPE_LOCK(CriticalSection);
+
+			const TSharedPtr<FComponents> Components = MeshToComponents_RequiresLock.FindRef(HierarchicalData->Mesh);
+			if (!ensure(Components))
+			{
+				return;
+			}
+
+			if (UVoxelInstancedMeshComponent* Component = Components->InstancedMeshComponent.Get())
+			{
+				Component->ClearInstances();
+			}
+
+			UVoxelHierarchicalMeshComponent* Component = Components->HierarchicalMeshComponent.Get();
+			if (!Component)
+			{
+				Component = Runtime->CreateComponent<UVoxelHierarchicalMeshComponent>();
+				Components->HierarchicalMeshComponent = Component;
+			}
+			if (!ensure(Component))
+			{
+				return;
+			}
+
+			Component->SetMeshData(HierarchicalData.ToSharedRef());
+			FoliageSettings->ApplyToComponent(*Component);
+
+			Component->InstanceStartCullDistance = RenderDistance - FadeDistance;
+			Component->InstanceEndCullDistance = RenderDistance;
+		});
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelRenderMeshChunk::EnqueueGameThreadUpdate(TVoxelUniqueFunction<void()> Update)
+{
+	GameThreadUpdates.Enqueue(MoveTemp(Update));
+
+	if (!bIsProcessGameThreadUpdatesQueued.Exchange(true))
+	{
+		FVoxelUtilities::RunOnGameThread_Async(MakeWeakPtrLambda(this, [this]
 		{
-			Component = Runtime->CreateComponent<UVoxelHierarchicalMeshComponent>();
-			Components->HierarchicalMeshComponent = Component;
+			ProcessGameThreadUpdates();
+		}));
+	}
+}
+
+void FVoxelRenderMeshChunk::ProcessGameThreadUpdates()
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(IsInGameThread());
+
+	// Budget is shared by all the chunks
+	static uint64 BudgetFrame = 0;
+	static double BudgetTimeSpent = 0;
+	if (BudgetFrame != GFrameCounter)
+	{
+		BudgetFrame = GFrameCounter;
+		BudgetTimeSpent = 0;
+	}
+
+	TVoxelUniqueFunction<void()> Update;
+	while (true)
+	{
+		if (GVoxelRenderMeshChunkGameThreadBudget > 0 &&
+			BudgetTimeSpent * 1000 > GVoxelRenderMeshChunkGameThreadBudget)
+		{
+			// Resume next frame
+			FVoxelSystemUtilities::DelayedCall(MakeWeakPtrLambda(this, [this]
+			{
+				ProcessGameThreadUpdates();
+			}));
+			return;
 		}
-		if (!ensure(Component))
+
+		if (!GameThreadUpdates.Dequeue(Update))
 		{
-			continue;
+			break;
 		}
 
-		Component->SetMeshData(HierarchicalData.ToSharedRef());
-		FoliageSettings->ApplyToComponent(*Component);
+		const double StartTime = FPlatformTime::Seconds();
+		Update();
+		BudgetTimeSpent += FPlatformTime::Seconds() - StartTime;
+	}
+
+	bIsProcessGameThreadUpdatesQueued.Store(false);
 
-		Component->InstanceStartCullDistance = RenderDistance - FadeDistance;
-		Component->InstanceEndCullDistance = RenderDistance;
+	// An update might have been enqueued before the flag was cleared
+	if (!GameThreadUpdates.IsEmpty() &&
+		!bIsProcessGameThreadUpdatesQueued.Exchange(true))
+	{
+		FVoxelUtilities::RunOnGameThread_Async(MakeWeakPtrLambda(this, [this]
+		{
+			ProcessGameThreadUpdates();
+		}));
 	}
 }
 
@@ -753,8 +981,8 @@ void FVoxelRenderMeshChunk::UpdatePointOverrides_AssumeLocked(const PointIdsType
 			continue;
 		}
 
-		// _Async to ensure scheduling with other game thread tasks is correct
-		FVoxelUtilities::RunOnGameThread_Async(MakeWeakPtrLambda(this, [=, Components = It.Value]
+		// Queued to ensure it's applied after the mesh datas these indices refer to
+		EnqueueGameThreadUpdate([=, Components = It.Value]
 		{
 			if (UVoxelInstancedMeshComponent* Component = Components->InstancedMeshComponent.Get())
 			{
@@ -779,6 +1007,6 @@ void FVoxelRenderMeshChunk::UpdatePointOverrides_AssumeLocked(const PointIdsType
 					Component->ShowInstances(HierarchicalInstancesToShow);
 				}
 			}
-		}));
+		});
 	}
 }
\ No newline at end of file
@@ -58,10 +58,23 @@ public:
 	//~ End IVoxelNodeInterface Interface
 
 private:
+	// Point ids are sharded by hash so that shards can be diffed in parallel
+	static constexpr int32 NumPointIdShards = 16;
+	using FPointIdToIndexShards = TVoxelStaticArray<TVoxelAddOnlyMap<FVoxelPointId, int32>, NumPointIdShards>;
+
+	FORCEINLINE static int32 GetPointIdShard(const FVoxelPointId PointId)
+	{
+		return FVoxelUtilities::MurmurHash64(PointId.PointId) % NumPointIdShards;
+	}
+
 	mutable FVoxelFastCriticalSection CriticalSection;
-	TVoxelAddOnlyMap<FVoxelPointId, int32> PointIdToIndex_RequiresLock;
+	FPointIdToIndexShards PointIdToIndex_RequiresLock;
 	TSharedPtr<const FVoxelPointSet> Points_RequiresLock;
 
+	// Game thread updates are applied in order, and across several frames if they exceed the budget
+	TQueue<TVoxelUniqueFunction<void()>, EQueueMode::Mpsc> GameThreadUpdates;
+	TVoxelAtomic<bool> bIsProcessGameThreadUpdatesQueued = false;
+
 	struct FIndexInfo
 	{
 		union
@@ -82,6 +95,9 @@ private:
 		TVoxelArray<int32> FreeInstancedIndices;
 		int32 NumInstancedInstances = 0;
 
+		// Hierarchical indices of PointIdToIndexInfo are indices in this mesh data
+		TSharedPtr<const FVoxelHierarchicalMeshData> HierarchicalMeshData;
+
 		TWeakObjectPtr<UVoxelInstancedMeshComponent> InstancedMeshComponent;
 		TWeakObjectPtr<UVoxelHierarchicalMeshComponent> HierarchicalMeshComponent;
 	};
@@ -89,7 +105,10 @@ private:
 
 	void UpdatePoints(const TSharedRef<const FVoxelPointSet>& NewPoints);
 	void UpdatePoints_Hierarchical_AssumeLocked(const TSharedRef<const FVoxelPointSet>& Points);
-	void SetHierarchicalDatas_GameThread(const TVoxelArray<TSharedPtr<FVoxelHierarchicalMeshData>>& NewHierarchicalMeshDatas);
+	void SetHierarchicalDatas_AssumeLocked(const TVoxelArray<TSharedPtr<FVoxelHierarchicalMeshData>>& NewHierarchicalMeshDatas);
+
+	void EnqueueGameThreadUpdate(TVoxelUniqueFunction<void()> Update);
+	void ProcessGameThreadUpdates();
 
 	template<typename PointIdsType>
 	void UpdatePointOverrides_AssumeLocked(const PointIdsType& PointIdsToUpdate);
@@ -11,6 +11,7 @@ DECLARE_VOXEL_MEMORY_STAT(VOXELSPAWNER_API, STAT_VoxelHierarchicalMeshDataMemory
 DECLARE_VOXEL_MEMORY_STAT(VOXELSPAWNER_API, STAT_VoxelHierarchicalMeshMemory, "Voxel Hierarchical Mesh Memory");
 DECLARE_VOXEL_COUNTER(VOXELSPAWNER_API, STAT_VoxelHierarchicalMeshNumInstances, "Num Hierarchical Mesh Instances");
 
+// When trees are reused, ClusterTree & InstanceReorderTable are moved to FVoxelHierarchicalMeshData::Tree
 struct VOXELSPAWNER_API FVoxelHierarchicalMeshBuiltData
 {
 	TUniquePtr<FStaticMeshInstanceData> InstanceBuffer;
@@ -22,16 +23,44 @@ struct VOXELSPAWNER_API FVoxelHierarchicalMeshBuiltData
 	TCompatibleVoxelArray<int32> InstanceReorderTable;
 };
 
+// Kept once the built data is consumed, so that the next build can reuse the cluster tree
+struct VOXELSPAWNER_API FVoxelHierarchicalMeshTree
+{
+	// Shared with the ClusterTreePtr of the component rendering it, never modified once built
+	TSharedPtr<TArray<FClusterNode>, ESPMode::ThreadSafe> ClusterTree;
+	int32 OcclusionLayerNum = 0;
+	// Read by the component rendering it instead of its own InstanceReorderTable
+	TCompatibleVoxelArray<int32> InstanceReorderTable;
+
+	// Instances added or moved since the tree was last fully built
+	// Their clusters were grown to fit them, making culling less efficient
+	int32 NumFragmentedInstances = 0;
+
+	int64 GetAllocatedSize() const;
+};
+
 struct VOXELSPAWNER_API FVoxelHierarchicalMeshData : public FVoxelMeshDataBase
 {
 	using FVoxelMeshDataBase::FVoxelMeshDataBase;
 
 	mutable TSharedPtr<FVoxelHierarchicalMeshBuiltData> BuiltData;
+	TSharedPtr<const FVoxelHierarchicalMeshTree> Tree;
 
 	VOXEL_ALLOCATED_SIZE_TRACKER(STAT_VoxelHierarchicalMeshDataMemory);
 
 	void Build();
+	// PreviousIndices is the index of each instance in PreviousMeshData, -1 if the instance is new
+	// Reuses the cluster tree of PreviousMeshData if it's not too fragmented, otherwise does a full build
+	void Build(
+		const FVoxelHierarchicalMeshData& PreviousMeshData,
+		TConstVoxelArrayView<int32> PreviousIndices);
+
 	int64 GetAllocatedSize() const;
+
+private:
+	void FinishBuild(
+		const TSharedRef<FVoxelHierarchicalMeshBuiltData>& NewBuiltData,
+		int32 NumFragmentedInstances);
 };
 
 UCLASS()
@@ -66,11 +95,41 @@ public:
 		int32 InDesiredInstancesPerLeaf,
 		const FVoxelHierarchicalMeshData& InMeshData);
 
+	// Returns false if the previous tree cannot be reused or would be too fragmented, InMeshData is then left untouched
+	// Otherwise InMeshData is padded with hidden instances for the slots of the previous tree that are now empty
+	static bool AsyncTreeReuse(
+		FVoxelHierarchicalMeshBuiltData& OutBuiltData,
+		int32& OutNumFragmentedInstances,
+		const FBox& MeshBox,
+		const FVoxelHierarchicalMeshData& PreviousMeshData,
+		TConstVoxelArrayView<int32> PreviousIndices,
+		FVoxelHierarchicalMeshData& InMeshData);
+
 private:
 	VOXEL_COUNTER_HELPER(STAT_VoxelHierarchicalMeshNumInstances, NumInstances);
 	VOXEL_ALLOCATED_SIZE_TRACKER(STAT_VoxelHierarchicalMeshMemory);
 
 	TSharedPtr<const FVoxelHierarchicalMeshData> MeshData;
 
+	TConstVoxelArrayView<int32> GetInstanceReorderTable() const;
+	void UpdateInstances(TConstVoxelArrayView<int32> Indices, bool bVisible);
 	void SetBuiltData(FVoxelHierarchicalMeshBuiltData&& BuiltData);
+
+	// BuiltIndices is the built index of each instance, empty if instances are not sorted yet
+	static void AsyncSetInstances(
+		FVoxelHierarchicalMeshBuiltData& OutBuiltData,
+		TCompatibleVoxelArray<FMatrix>& OutMatrices,
+		const FVoxelHierarchicalMeshData& InMeshData,
+		TConstVoxelArrayView<int32> BuiltIndices);
+
+	// Splits the instances spatially and builds a subtree per split in parallel
+	// Returns false if the subtrees could not be merged, in which case a single tree should be built
+	static bool AsyncParallelTreeBuild(
+		const TCompatibleVoxelArray<FMatrix>& Matrices,
+		const FBox& MeshBox,
+		int32 MaxInstancesPerLeaf,
+		TArray<FClusterNode>& OutClusterTree,
+		TCompatibleVoxelArray<int32>& OutSortedInstances,
+		TCompatibleVoxelArray<int32>& OutInstanceReorderTable,
+		int32& OutOcclusionLayerNum);
 };
\ No newline at end of file
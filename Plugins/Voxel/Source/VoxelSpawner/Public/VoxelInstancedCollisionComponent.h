@@ -55,6 +55,33 @@ private:
 	FVoxelInstancedCollisionDataImpl DataImpl;
 };
 
+// Used when voxel.foliage.LazyCollision is true: instance bodies are only created around pawns, invokers & registered actors
+// Bodies are created & released over a few frames as these move, see voxel.foliage.LazyCollisionMaxChangesPerFrame
+class VOXELSPAWNER_API FVoxelInstancedCollisionManager : public IVoxelWorldSubsystem
+{
+public:
+	GENERATED_VOXEL_WORLD_SUBSYSTEM_BODY(FVoxelInstancedCollisionManager);
+
+	// Register an actor that needs instance collisions around it, eg a physics object that isn't a pawn
+	void RegisterActor(const AActor* Actor);
+	void UnregisterActor(const AActor* Actor);
+
+	void AddComponent(UVoxelInstancedCollisionComponent& Component);
+	void RemoveComponent(UVoxelInstancedCollisionComponent& Component);
+
+	//~ Begin IVoxelWorldSubsystem Interface
+	virtual void Tick() override;
+	//~ End IVoxelWorldSubsystem Interface
+
+private:
+	bool bWasLazy = false;
+	int32 NextComponentIndex = 0;
+	TVoxelSet<TWeakObjectPtr<const AActor>> Actors;
+	TVoxelArray<TWeakObjectPtr<UVoxelInstancedCollisionComponent>> Components;
+
+	TVoxelArray<FVector> GatherSources() const;
+};
+
 UCLASS()
 class VOXELSPAWNER_API UVoxelInstancedCollisionComponent
 	: public UPrimitiveComponent
@@ -86,6 +113,15 @@ public:
 	void ReturnToPool();
 	void Update();
 
+	// Only used if voxel.foliage.LazyCollision is true
+	// Creates bodies close to Sources & releases the ones that are too far, at most MaxChanges
+	// Returns the number of bodies created or released
+	int32 UpdateLazyBodies(
+		TConstVoxelArrayView<FVector> Sources,
+		int32 MaxChanges);
+	// Create the bodies skipped by UpdateLazyBodies, used when lazy collision is disabled
+	void CreateAllBodies();
+
 	TSharedRef<FBodyInstance> MakeBodyInstance(int32 Index) const;
 
 	FORCEINLINE TSharedPtr<FVoxelInstancedCollisionData> GetData() const
@@ -100,5 +136,19 @@ private:
 
 	VOXEL_COUNTER_HELPER(STAT_VoxelNumCollisionInstances, NumInstances);
 
+	// Sources within range of this component, as of the last UpdateLazyBodies
+	TVoxelArray<FVector> LazySources;
+	// Instances with a body while lazy collision is enabled, so that releasing bodies doesn't scan every instance
+	// Filled from the existing bodies by the first UpdateLazyBodies, as they might have been created before lazy collision was enabled
+	bool bHasLazyBodyIndices = false;
+	TVoxelSet<int32> LazyBodyIndices;
+	bool bLazySpatialIndexDirty = true;
+	float LazyCellSize = 0.f;
+	TVoxelMap<FIntVector, TVoxelArray<int32>> LazyCellToIndices;
+
+	void UpdateImpl(bool bTransformsChanged);
+	bool IsNearLazySource(const FVector& Position, float Radius) const;
+	void BuildLazySpatialIndex(const FVoxelInstancedCollisionDataImpl& DataImpl, float CellSize);
+
 	friend class FVoxelInstancedCollisionSceneProxy;
 };
\ No newline at end of file
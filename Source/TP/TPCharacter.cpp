@@ -13,6 +13,8 @@
 #include "Kismet/GameplayStatics.h"
 #include "DrawDebugHelpers.h"
 #include "Engine/StaticMeshActor.h"
+#include "Engine/Level.h"
+#include "EngineUtils.h"
 #include <Runtime/Engine/Classes/Kismet/KismetMathLibrary.h>
 
 #include "VoxelMinimal.h"
@@ -20,6 +22,7 @@
 #include "VoxelChunkSpawner.h"
 #include "VoxelRuntime.h"
 #include "TPCharacterMovementComponent.h"
+#include "TPChunkVisibilityIndex.h"
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -103,6 +106,17 @@ void ATPCharacter::BeginPlay()
         }
     }
 
+    ChunkVisibilityIndex = MakeShared<FTPChunkVisibilityIndex>(ChunkVisibilityCellSize, MaxStaticMeshVisibleLOD);
+    for (TActorIterator<AStaticMeshActor> It(GetWorld()); It; ++It)
+    {
+        ChunkVisibilityIndex->AddActor(**It);
+    }
+
+    OnActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &ATPCharacter::OnActorSpawned));
+    OnActorDestroyedHandle = GetWorld()->AddOnActorDestroyedHandler(FOnActorDestroyed::FDelegate::CreateUObject(this, &ATPCharacter::OnActorDestroyed));
+    OnLevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &ATPCharacter::OnLevelAddedToWorld);
+    OnLevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &ATPCharacter::OnLevelRemovedFromWorld);
+
     TArray<AActor*>ActorAry;
     UGameplayStatics::GetAllActorsOfClassWithTag(this, AVoxelActor::StaticClass(), TEXT("Main"), ActorAry);
     for (auto Iter : ActorAry)
@@ -110,109 +124,176 @@ void ATPCharacter::BeginPlay()
         auto VoxelActor = Cast<AVoxelActor>(Iter);
         if (VoxelActor)
         {
-            auto VRTSPtr = VoxelActor->GetRuntime();
-            VRTSPtr->OnChunkChangedMap.Add(0, std::bind(
-                &ThisClass::OnChunkChanged, this,
-                std::placeholders::_1, std::placeholders::_2,
-                std::placeholders::_3
-            ));
+            VisibilityVoxelActors.Add(VoxelActor);
+
+            // A full rebuild recreates the runtime: drop the hidden state of the old chunks and listen to the new ones
+            VoxelActor->OnRuntimeDestroyed.AddWeakLambda(this, [this]
+            {
+                if (ChunkVisibilityIndex)
+                {
+                    ChunkVisibilityIndex->ResetHiddenState();
+                }
+            });
+            VoxelActor->OnRuntimeCreated.AddWeakLambda(this, [this, WeakVoxelActor = TWeakObjectPtr<AVoxelActor>(VoxelActor)]
+            {
+                if (AVoxelActor* LocalVoxelActor = WeakVoxelActor.Get())
+                {
+                    BindVoxelRuntime(*LocalVoxelActor);
+                }
+            });
+
+            BindVoxelRuntime(*VoxelActor);
         }
     }
 }
 
-void ATPCharacter::Tick(float DeltaSeconds)
+void ATPCharacter::BindVoxelRuntime(AVoxelActor& VoxelActor)
 {
-    Super::Tick(DeltaSeconds);
+    const TSharedPtr<FVoxelRuntime> Runtime = VoxelActor.GetRuntime();
+    if (!Runtime)
+    {
+        return;
+    }
 
-    GetCharacterMovement()->SetGravityDirection(-GetActorLocation().GetSafeNormal());
+    // Resolved off the game thread, only the visibility flips are applied back
+    Runtime->OnChunksChangedMap.Add(0, [WeakIndex = TWeakPtr<FTPChunkVisibilityIndex>(ChunkVisibilityIndex)](TConstVoxelArrayView<FVoxelChunkChange> ChunkChanges)
+    {
+        if (const TSharedPtr<FTPChunkVisibilityIndex> Index = WeakIndex.Pin())
+        {
+            Index->OnChunksChanged(ChunkChanges);
+        }
+    });
 }
 
-FRotator ATPCharacter::GetViewRotation() const
+void ATPCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-    if (Controller != nullptr)
+    if (UWorld* World = GetWorld())
     {
-        const auto ControlRotation = Controller->GetControlRotation().Quaternion();
-        const auto Rot = GetGravityTransform() * ControlRotation;
-
-        return Rot.Rotator();
+        World->RemoveOnActorSpawnedHandler(OnActorSpawnedHandle);
+        World->RemoveOnActorDestroyededHandler(OnActorDestroyedHandle);
     }
-    else if (GetLocalRole() < ROLE_Authority)
+    FWorldDelegates::LevelAddedToWorld.Remove(OnLevelAddedHandle);
+    FWorldDelegates::LevelRemovedFromWorld.Remove(OnLevelRemovedHandle);
+
+    for (const TWeakObjectPtr<AVoxelActor>& WeakVoxelActor : VisibilityVoxelActors)
     {
-        // check if being spectated
-        for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+        if (AVoxelActor* VoxelActor = WeakVoxelActor.Get())
         {
-            APlayerController* PlayerController = Iterator->Get();
-            if (PlayerController &&
-                PlayerController->PlayerCameraManager &&
-                PlayerController->PlayerCameraManager->GetViewTargetPawn() == this)
-            {
-                return PlayerController->BlendedTargetViewRotation;
-            }
+            VoxelActor->OnRuntimeCreated.RemoveAll(this);
+            VoxelActor->OnRuntimeDestroyed.RemoveAll(this);
         }
     }
+    VisibilityVoxelActors.Reset();
 
-    return GetActorRotation();
+    ChunkVisibilityIndex.Reset();
+
+    Super::EndPlay(EndPlayReason);
 }
 
-void ATPCharacter::OnChunkChanged(const FBox& Box, int32 LOD, int32 Size)
+void ATPCharacter::OnActorSpawned(AActor* Actor)
 {
-    switch (LOD)
-    {
-    case 0:
+    if (ChunkVisibilityIndex &&
+        Actor &&
+        Actor->IsA<AStaticMeshActor>())
     {
-  //      DrawDebugBox(GetWorld(), Box.GetCenter(), Box.GetExtent(), FColor::Blue, false, 3.f);
+        ChunkVisibilityIndex->AddActor(*Actor);
     }
-    case 1:
+}
+
+void ATPCharacter::OnActorDestroyed(AActor* Actor)
+{
+    if (ChunkVisibilityIndex &&
+        Actor &&
+        Actor->IsA<AStaticMeshActor>())
     {
-   //     DrawDebugBox(GetWorld(), Box.GetCenter(), Box.GetExtent(), FColor::Green, false, 3.f);
+        ChunkVisibilityIndex->RemoveActor(*Actor);
     }
-    case 2:
+}
+
+void ATPCharacter::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+    if (!ChunkVisibilityIndex ||
+        !Level ||
+        World != GetWorld())
     {
-   //     DrawDebugBox(GetWorld(), Box.GetCenter(), Box.GetExtent(), FColor::Purple, false, 3.f);
+        return;
     }
-    case 3:
+
+    for (AActor* Actor : Level->Actors)
     {
-  //      DrawDebugBox(GetWorld(), Box.GetCenter(), Box.GetExtent(), FColor::Orange, false, 3.f);
+        if (Actor &&
+            Actor->IsA<AStaticMeshActor>())
+        {
+            ChunkVisibilityIndex->AddActor(*Actor);
+        }
     }
-    case 4:
-    {
-   //     DrawDebugBox(GetWorld(), Box.GetCenter(), Box.GetExtent(), FColor::Red, false, 3.f);
-        const auto Box_ = FCollisionShape::MakeBox(Box.GetExtent());
-
-        FCollisionObjectQueryParams ObjectQueryParams;
+}
 
-        TArray<struct FOverlapResult> OutOverlaps;
-        GetWorld()->OverlapMultiByObjectType(OutOverlaps, Box.GetCenter(), FQuat::Identity, ObjectQueryParams, Box_);
+void ATPCharacter::OnLevelRemovedFromWorld(ULevel* Level, UWorld* World)
+{
+    // A null level means the whole world is being cleaned up
+    if (!ChunkVisibilityIndex ||
+        !Level ||
+        World != GetWorld())
+    {
+        return;
+    }
 
-        for (auto Iter : OutOverlaps)
+    for (AActor* Actor : Level->Actors)
+    {
+        if (Actor &&
+            Actor->IsA<AStaticMeshActor>())
         {
-            if (Iter.GetActor()->IsA(AStaticMeshActor::StaticClass()))
-            {
-                Iter.GetActor()->SetActorHiddenInGame(false);
-            }
+            ChunkVisibilityIndex->RemoveActor(*Actor);
         }
     }
-    break;
-    default:
+}
+
+void ATPCharacter::Tick(float DeltaSeconds)
+{
+    Super::Tick(DeltaSeconds);
+
+    if (ChunkVisibilityIndex)
     {
-        const auto Box_ = FCollisionShape::MakeBox(Box.GetExtent());
+        // Actors spawned or destroyed this frame are sent to the index pipe in a single task
+        ChunkVisibilityIndex->Flush();
+    }
 
-        FCollisionObjectQueryParams ObjectQueryParams;
+    if (const UTPCharacterMovementComponent* MovementComponent = Cast<UTPCharacterMovementComponent>(GetCharacterMovement()))
+    {
+        GetCharacterMovement()->SetGravityDirection(MovementComponent->ComputeGravityDirection());
+    }
+    else
+    {
+        GetCharacterMovement()->SetGravityDirection(-GetActorLocation().GetSafeNormal());
+    }
+}
 
-        TArray<struct FOverlapResult> OutOverlaps;
-        GetWorld()->OverlapMultiByObjectType(OutOverlaps, Box.GetCenter(), FQuat::Identity, ObjectQueryParams, Box_);
+FRotator ATPCharacter::GetViewRotation() const
+{
+    if (Controller != nullptr)
+    {
+        const auto ControlRotation = Controller->GetControlRotation().Quaternion();
+        const auto Rot = GetGravityTransform() * ControlRotation;
 
-        for (auto Iter : OutOverlaps)
+        return Rot.Rotator();
+    }
+    else if (GetLocalRole() < ROLE_Authority)
+    {
+        // check if being spectated
+        for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
         {
-            if (Iter.GetActor()->IsA(AStaticMeshActor::StaticClass()))
+            APlayerController* PlayerController = Iterator->Get();
+            if (PlayerController &&
+                PlayerController->PlayerCameraManager &&
+                PlayerController->PlayerCameraManager->GetViewTargetPawn() == this)
             {
-                Iter.GetActor()->SetActorHiddenInGame(true);
+                return PlayerController->BlendedTargetViewRotation;
             }
         }
- //       DrawDebugBox(GetWorld(), Box.GetCenter(), Box.GetExtent(), FColor::Yellow, false, 3.f);
     }
-    break;
-    };
+
+    return GetActorRotation();
 }
 
 //////////////////////////////////////////////////////////////////////////
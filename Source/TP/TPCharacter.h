@@ -8,6 +8,8 @@
 #include "TPCharacter.generated.h"
 
 enum class EVoxelChunkAction;
+class AVoxelActor;
+class FTPChunkVisibilityIndex;
 
 UCLASS(config = Game)
 class ATPCharacter : public ACharacter
@@ -62,6 +64,8 @@ protected:
     // To add mapping context
     virtual void BeginPlay()override;
 
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason)override;
+
     virtual void Tick(float DeltaSeconds)override;
 
     virtual FRotator GetViewRotation() const override;
@@ -72,7 +76,32 @@ public:
     /** Returns FollowCamera subobject **/
     FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
 
-    void OnChunkChanged(const FBox& Box, int32 LOD, int32 Size);
+private:
+    /** Static mesh actors are hidden when the voxel chunks overlapping them are above this LOD */
+    UPROPERTY(EditAnywhere, Category = Voxel, meta = (AllowPrivateAccess = "true"))
+    int32 MaxStaticMeshVisibleLOD = 4;
+
+    /** Cell size of the grid used to find the static mesh actors overlapping changed chunks */
+    UPROPERTY(EditAnywhere, Category = Voxel, meta = (AllowPrivateAccess = "true"))
+    double ChunkVisibilityCellSize = 3200.;
+
+    TSharedPtr<FTPChunkVisibilityIndex> ChunkVisibilityIndex;
+
+    /** Keep the index in sync with static mesh actors spawned, destroyed or streamed after BeginPlay */
+    FDelegateHandle OnActorSpawnedHandle;
+    FDelegateHandle OnActorDestroyedHandle;
+    FDelegateHandle OnLevelAddedHandle;
+    FDelegateHandle OnLevelRemovedHandle;
+
+    void OnActorSpawned(AActor* Actor);
+    void OnActorDestroyed(AActor* Actor);
+    void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+    void OnLevelRemovedFromWorld(ULevel* Level, UWorld* World);
+
+    /** Voxel actors whose chunk changes drive the index, rebound when their runtime is recreated */
+    TArray<TWeakObjectPtr<AVoxelActor>> VisibilityVoxelActors;
+
+    void BindVoxelRuntime(AVoxelActor& VoxelActor);
 
 };
 
@@ -6,6 +6,8 @@
 #include <IXRCamera.h>
 #include <Kismet/KismetMathLibrary.h>
 
+#include "VoxelDistanceQueryCache.h"
+
 void UTPCharacterMovementComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
     Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
@@ -536,3 +538,85 @@ void UTPCharacterMovementComponent::PhysWalking(float deltaTime, int32 Iteration
         MaintainHorizontalGroundVelocity();
     }
 }
+
+void UTPCharacterMovementComponent::FindFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult, bool bCanUseCachedLocation, const FHitResult* DownwardSweepResult) const
+{
+    float GroundDistance = 0.f;
+    if (SkipFloorSweepVoxelDistance > 0.f &&
+        GetVoxelGroundDistance(CapsuleLocation, GroundDistance) &&
+        GroundDistance > SkipFloorSweepVoxelDistance)
+    {
+        // Clearly airborne, no need to sweep
+        OutFloorResult.Clear();
+        return;
+    }
+
+    Super::FindFloor(CapsuleLocation, OutFloorResult, bCanUseCachedLocation, DownwardSweepResult);
+}
+
+FVector UTPCharacterMovementComponent::ComputeGravityDirection() const
+{
+    const FVector Location = UpdatedComponent ? UpdatedComponent->GetComponentLocation() : FVector::ZeroVector;
+    const FVector FallbackDirection = -Location.GetSafeNormal();
+
+    FVoxelDistanceQueryCache* Cache = GetDistanceQueryCache();
+    if (!Cache)
+    {
+        return FallbackDirection;
+    }
+
+    // Request the cell we'll be in next frame so its async query starts early
+    Cache->Prefetch(Location + Velocity * GetWorld()->GetDeltaSeconds());
+
+    float Distance = 0.f;
+    FVector Gradient = FVector::ZeroVector;
+    if (!Cache->Query(Location, Distance, Gradient) ||
+        Gradient.IsNearlyZero())
+    {
+        return FallbackDirection;
+    }
+
+    // The distance increases away from the surface
+    return -Gradient.GetSafeNormal();
+}
+
+bool UTPCharacterMovementComponent::GetVoxelGroundDistance(const FVector& CapsuleLocation, float& OutDistance) const
+{
+    FVoxelDistanceQueryCache* Cache = GetDistanceQueryCache();
+    if (!Cache)
+    {
+        return false;
+    }
+
+    float Distance = 0.f;
+    FVector Gradient = FVector::ZeroVector;
+    if (!Cache->Query(CapsuleLocation, Distance, Gradient))
+    {
+        return false;
+    }
+
+    const float HalfHeight = CharacterOwner ? CharacterOwner->GetSimpleCollisionHalfHeight() : 0.f;
+    OutDistance = Distance - HalfHeight;
+    return true;
+}
+
+FVoxelDistanceQueryCache* UTPCharacterMovementComponent::GetDistanceQueryCache() const
+{
+    if (!bUseVoxelGravity)
+    {
+        return nullptr;
+    }
+
+    if (!DistanceQueryCache)
+    {
+        UWorld* World = GetWorld();
+        if (!World)
+        {
+            return nullptr;
+        }
+
+        DistanceQueryCache = MakeShared<FVoxelDistanceQueryCache>(World, VoxelChannelName, VoxelQueryCellSize, VoxelQueryMaxCellsPerFrame);
+    }
+
+    return DistanceQueryCache.Get();
+}
@@ -8,6 +8,8 @@
 
 #include "TPCharacterMovementComponent.generated.h"
 
+class FVoxelDistanceQueryCache;
+
 UCLASS(config = Game)
 class UTPCharacterMovementComponent : public UCharacterMovementComponent
 {
@@ -40,8 +42,47 @@ public:
 
     virtual void PhysWalking(float deltaTime, int32 Iterations)override;
 
+    virtual void FindFloor(
+        const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult, bool bCanUseCachedLocation, const FHitResult* DownwardSweepResult = nullptr
+    ) const override;
+
+    /** Gravity along the voxel surface gradient, falls back to pointing towards the world origin until the surface has been queried */
+    FVector ComputeGravityDirection() const;
+
+    /** Distance from the bottom of the capsule to the voxel surface, false if it hasn't been queried yet */
+    bool GetVoxelGroundDistance(const FVector& CapsuleLocation, float& OutDistance) const;
+
+    /**
+     * Query gravity & ground distance from the voxel distance field instead of assuming a sphere centered on the origin
+     * Cells are queried asynchronously: the spherical gravity is used until the cell the character is in has been computed
+     */
+    UPROPERTY(EditAnywhere, Category = "Voxel")
+    bool bUseVoxelGravity = true;
+
+    UPROPERTY(EditAnywhere, Category = "Voxel")
+    FName VoxelChannelName = "Surface";
+
+    /** Size of the cells the distance field is sampled & cached at */
+    UPROPERTY(EditAnywhere, Category = "Voxel", meta = (ClampMin = 1))
+    float VoxelQueryCellSize = 50.f;
+
+    /** Max number of cells queried by a single async batch */
+    UPROPERTY(EditAnywhere, Category = "Voxel", meta = (ClampMin = 1))
+    int32 VoxelQueryMaxCellsPerFrame = 4;
+
+    /**
+     * Skip floor sweeps while the voxel surface is further than this below the capsule, 0 to disable.
+     * Only safe when nothing but voxels can be walked on.
+     */
+    UPROPERTY(EditAnywhere, Category = "Voxel", meta = (ClampMin = 0))
+    float SkipFloorSweepVoxelDistance = 0.f;
+
 private:
 
     float VelocityScale = 1.f;
 
+    mutable TSharedPtr<FVoxelDistanceQueryCache> DistanceQueryCache;
+
+    FVoxelDistanceQueryCache* GetDistanceQueryCache() const;
+
 };
\ No newline at end of file
@@ -0,0 +1,293 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "TPChunkVisibilityIndex.h"
+
+#include "Async/Async.h"
+#include "GameFramework/Actor.h"
+#include "UObject/ObjectKey.h"
+
+FTPChunkVisibilityIndex::FTPChunkVisibilityIndex(double InCellSize, int32 InMaxVisibleLOD)
+    : CellSize(FMath::Max(InCellSize, 1.))
+    , MaxVisibleLOD(InMaxVisibleLOD)
+{
+}
+
+template<typename LambdaType>
+void FTPChunkVisibilityIndex::ForeachCell(const FBox& Bounds, LambdaType&& Lambda) const
+{
+    const FIntVector Min = GetCell(Bounds.Min);
+    const FIntVector Max = GetCell(Bounds.Max);
+    for (int32 Z = Min.Z; Z <= Max.Z; Z++)
+    {
+        for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+        {
+            for (int32 X = Min.X; X <= Max.X; X++)
+            {
+                Lambda(FIntVector(X, Y, Z));
+            }
+        }
+    }
+}
+
+void FTPChunkVisibilityIndex::AddActor(AActor& Actor)
+{
+    check(IsInGameThread());
+
+    FVector Origin;
+    FVector Extent;
+    Actor.GetActorBounds(false, Origin, Extent);
+
+    QueuedActorChanges.Add({ &Actor, FObjectKey(&Actor), FBox::BuildAABB(Origin, Extent), Actor.IsHidden() });
+}
+
+void FTPChunkVisibilityIndex::RemoveActor(const AActor& Actor)
+{
+    check(IsInGameThread());
+
+    QueuedActorChanges.Add({ nullptr, FObjectKey(&Actor) });
+}
+
+void FTPChunkVisibilityIndex::OnChunksChanged(TConstArrayView<FVoxelChunkChange> ChunkChanges)
+{
+    check(IsInGameThread());
+
+    if (ChunkChanges.Num() == 0)
+    {
+        return;
+    }
+
+    LaunchTask(TArray<FVoxelChunkChange>(ChunkChanges), false);
+}
+
+void FTPChunkVisibilityIndex::ResetHiddenState()
+{
+    check(IsInGameThread());
+
+    LaunchTask({}, true);
+}
+
+void FTPChunkVisibilityIndex::Flush()
+{
+    check(IsInGameThread());
+
+    if (QueuedActorChanges.Num() == 0)
+    {
+        return;
+    }
+
+    LaunchTask({}, false);
+}
+
+void FTPChunkVisibilityIndex::LaunchTask(TArray<FVoxelChunkChange>&& ChunkChanges, const bool bResetHiddenState)
+{
+    check(IsInGameThread());
+
+    Pipe.Launch(TEXT("TPChunkVisibilityIndex_Update"), [
+        WeakThis = AsWeak(),
+        ActorChanges = MoveTemp(QueuedActorChanges),
+        ChunkChanges = MoveTemp(ChunkChanges),
+        bResetHiddenState]
+    {
+        const TSharedPtr<FTPChunkVisibilityIndex> This = WeakThis.Pin();
+        if (!This)
+        {
+            return;
+        }
+
+        for (const FActorChange& ActorChange : ActorChanges)
+        {
+            This->ProcessActorChange(ActorChange);
+        }
+
+        if (bResetHiddenState)
+        {
+            for (EHiddenState& HiddenState : This->EntryHiddenStates)
+            {
+                HiddenState = EHiddenState::Unknown;
+            }
+        }
+
+        if (ChunkChanges.Num() == 0)
+        {
+            return;
+        }
+
+        TArray<FFlip> Flips;
+        This->ProcessChunkChanges(ChunkChanges, Flips);
+
+        if (Flips.Num() == 0)
+        {
+            return;
+        }
+
+        AsyncTask(ENamedThreads::GameThread, [Flips = MoveTemp(Flips)]
+        {
+            ApplyFlips(Flips);
+        });
+    });
+
+    QueuedActorChanges.Reset();
+}
+
+void FTPChunkVisibilityIndex::ProcessActorChange(const FActorChange& ActorChange)
+{
+    check(Pipe.IsInContext());
+
+    if (ActorChange.Bounds.IsValid)
+    {
+        if (ActorToEntry.Contains(ActorChange.ActorKey))
+        {
+            return;
+        }
+
+        const FEntry NewEntry{ ActorChange.Actor, ActorChange.Bounds };
+        const EHiddenState HiddenState = ActorChange.bHidden ? EHiddenState::Hidden : EHiddenState::Visible;
+
+        int32 EntryIndex;
+        if (FreeEntries.Num() > 0)
+        {
+            EntryIndex = FreeEntries.Pop();
+            Entries[EntryIndex] = NewEntry;
+            EntryHiddenStates[EntryIndex] = HiddenState;
+        }
+        else
+        {
+            EntryIndex = Entries.Add(NewEntry);
+            EntryHiddenStates.Add(HiddenState);
+            EntryVisitStamps.Add(0);
+        }
+        ActorToEntry.Add(ActorChange.ActorKey, EntryIndex);
+
+        ForeachCell(NewEntry.Bounds, [&](const FIntVector& Cell)
+        {
+            Cells.FindOrAdd(Cell).Add(EntryIndex);
+        });
+        return;
+    }
+
+    int32 EntryIndex;
+    if (!ActorToEntry.RemoveAndCopyValue(ActorChange.ActorKey, EntryIndex))
+    {
+        return;
+    }
+
+    FEntry& Entry = Entries[EntryIndex];
+    ForeachCell(Entry.Bounds, [&](const FIntVector& Cell)
+    {
+        TArray<int32>* EntryIndices = Cells.Find(Cell);
+        if (!ensure(EntryIndices))
+        {
+            return;
+        }
+
+        EntryIndices->RemoveSingleSwap(EntryIndex);
+        if (EntryIndices->Num() == 0)
+        {
+            Cells.Remove(Cell);
+        }
+    });
+
+    Entry = {};
+    FreeEntries.Add(EntryIndex);
+}
+
+FIntVector FTPChunkVisibilityIndex::GetCell(const FVector& Position) const
+{
+    return FIntVector(
+        FMath::FloorToInt32(Position.X / CellSize),
+        FMath::FloorToInt32(Position.Y / CellSize),
+        FMath::FloorToInt32(Position.Z / CellSize));
+}
+
+void FTPChunkVisibilityIndex::ProcessChunkChanges(const TArray<FVoxelChunkChange>& ChunkChanges, TArray<FFlip>& OutFlips)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(FTPChunkVisibilityIndex::ProcessChunkChanges);
+    check(Pipe.IsInContext());
+
+    const int32 NumEntries = Entries.Num();
+    check(EntryHiddenStates.Num() == NumEntries);
+    check(EntryVisitStamps.Num() == NumEntries);
+
+    // Last change wins, same as handling the changes one by one
+    TMap<int32, bool> EntryToHidden;
+
+    for (const FVoxelChunkChange& ChunkChange : ChunkChanges)
+    {
+        const bool bHidden = ChunkChange.LOD > MaxVisibleLOD;
+        VisitStamp++;
+
+        const auto VisitEntry = [&](const int32 EntryIndex)
+        {
+            if (EntryVisitStamps[EntryIndex] == VisitStamp)
+            {
+                return;
+            }
+            EntryVisitStamps[EntryIndex] = VisitStamp;
+
+            // Removed entries have invalid bounds
+            const FBox& Bounds = Entries[EntryIndex].Bounds;
+            if (Bounds.IsValid &&
+                Bounds.Intersect(ChunkChange.Bounds))
+            {
+                EntryToHidden.Add(EntryIndex, bHidden);
+            }
+        };
+
+        const FIntVector Min = GetCell(ChunkChange.Bounds.Min);
+        const FIntVector Max = GetCell(ChunkChange.Bounds.Max);
+        const int64 NumCellsInBox = int64(Max.X - Min.X + 1) * int64(Max.Y - Min.Y + 1) * int64(Max.Z - Min.Z + 1);
+
+        // Large chunks at high LODs can cover more cells than there are actors
+        if (NumCellsInBox > NumEntries)
+        {
+            for (int32 EntryIndex = 0; EntryIndex < NumEntries; EntryIndex++)
+            {
+                VisitEntry(EntryIndex);
+            }
+            continue;
+        }
+
+        for (int32 Z = Min.Z; Z <= Max.Z; Z++)
+        {
+            for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+            {
+                for (int32 X = Min.X; X <= Max.X; X++)
+                {
+                    if (const TArray<int32>* EntryIndices = Cells.Find(FIntVector(X, Y, Z)))
+                    {
+                        for (const int32 EntryIndex : *EntryIndices)
+                        {
+                            VisitEntry(EntryIndex);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    for (const TPair<int32, bool>& It : EntryToHidden)
+    {
+        const EHiddenState NewHiddenState = It.Value ? EHiddenState::Hidden : EHiddenState::Visible;
+        if (EntryHiddenStates[It.Key] == NewHiddenState)
+        {
+            continue;
+        }
+
+        EntryHiddenStates[It.Key] = NewHiddenState;
+        OutFlips.Add({ Entries[It.Key].Actor, It.Value });
+    }
+}
+
+void FTPChunkVisibilityIndex::ApplyFlips(const TArray<FFlip>& Flips)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(FTPChunkVisibilityIndex::ApplyFlips);
+    check(IsInGameThread());
+
+    for (const FFlip& Flip : Flips)
+    {
+        if (AActor* Actor = Flip.Actor.Get())
+        {
+            Actor->SetActorHiddenInGame(Flip.bHidden);
+        }
+    }
+}
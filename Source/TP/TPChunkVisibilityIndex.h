@@ -0,0 +1,92 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Pipe.h"
+#include "VoxelRuntime.h"
+
+/**
+ * Grid of the actors whose visibility depends on the LOD of the voxel chunks overlapping them.
+ * Chunk changes are resolved on a background pipe and only the visibility flips are applied on the game thread.
+ * The index is only accessed from the pipe: game thread changes are queued and sent along with the next task.
+ */
+class FTPChunkVisibilityIndex : public TSharedFromThis<FTPChunkVisibilityIndex>
+{
+public:
+    FTPChunkVisibilityIndex(double InCellSize, int32 InMaxVisibleLOD);
+
+    /** Game thread only, adding an actor twice is a no-op */
+    void AddActor(AActor& Actor);
+
+    /** Game thread only */
+    void RemoveActor(const AActor& Actor);
+
+    /** Game thread only, ChunkChanges are processed in order */
+    void OnChunksChanged(TConstArrayView<FVoxelChunkChange> ChunkChanges);
+
+    /**
+     * Game thread only, call when the voxel runtime is destroyed.
+     * The tracked hidden state is dropped, and rebuilt from the chunk changes of the next runtime.
+     */
+    void ResetHiddenState();
+
+    /** Game thread only, sends the queued actor changes to the pipe */
+    void Flush();
+
+private:
+    struct FEntry
+    {
+        TWeakObjectPtr<AActor> Actor;
+        FBox Bounds = FBox(ForceInit);
+    };
+
+    struct FFlip
+    {
+        TWeakObjectPtr<AActor> Actor;
+        bool bHidden = false;
+    };
+
+    struct FActorChange
+    {
+        TWeakObjectPtr<AActor> Actor;
+        FObjectKey ActorKey;
+        /** Invalid for removals */
+        FBox Bounds = FBox(ForceInit);
+        bool bHidden = false;
+    };
+
+    enum class EHiddenState : uint8
+    {
+        /** Always flipped on the next chunk change overlapping the actor */
+        Unknown,
+        Visible,
+        Hidden
+    };
+
+    const double CellSize;
+    const int32 MaxVisibleLOD;
+
+    UE::Tasks::FPipe Pipe{ TEXT("TPChunkVisibilityIndex") };
+
+    /** Game thread only */
+    TArray<FActorChange> QueuedActorChanges;
+
+    /** Pipe only */
+    TArray<FEntry> Entries;
+    TArray<int32> FreeEntries;
+    TMap<FObjectKey, int32> ActorToEntry;
+    TMap<FIntVector, TArray<int32>> Cells;
+
+    TArray<EHiddenState> EntryHiddenStates;
+    TArray<uint32> EntryVisitStamps;
+    uint32 VisitStamp = 0;
+
+    FIntVector GetCell(const FVector& Position) const;
+    template<typename LambdaType>
+    void ForeachCell(const FBox& Bounds, LambdaType&& Lambda) const;
+    void LaunchTask(TArray<FVoxelChunkChange>&& ChunkChanges, bool bResetHiddenState);
+    void ProcessActorChange(const FActorChange& ActorChange);
+    void ProcessChunkChanges(const TArray<FVoxelChunkChange>& ChunkChanges, TArray<FFlip>& OutFlips);
+    static void ApplyFlips(const TArray<FFlip>& Flips);
+};